@@ -30,8 +30,6 @@ __import ShaderCommon;
 __import Polygon;
 __import Shading;
 
-#define NUM_VERTICES 4
-
 struct PsOut
 {
     float4 fragColor0 : SV_TARGET0;
@@ -44,41 +42,13 @@ cbuffer PolygonData
 {
     float4x4 transMat;
     float4x4 transMatIT;
-    float4 polygon[NUM_VERTICES];
+    float4 polygon[MaxPolygonVertices];
+    float4 polygonEdges[MaxPolygonVertices];
+    uint polygonVertexCount;
+    uint polygonConvex;
 };
 
 
-bool isInside(float2 p)
-{
-
-    // Create a point for line segment from p to infinite 
-    float2 extreme = float2(3.402823466e+38F, p.y);
-
-    // Count intersections of the above line with sides of polygon 
-    int count = 0, i = 0;
-    do
-    {
-        int next = (i + 1) % NUM_VERTICES;
-
-        // Check if the line segment from 'p' to 'extreme' intersects 
-        // with the line segment from 'polygon[i]' to 'polygon[next]' 
-        if (doIntersect(polygon[i].xy, polygon[next].xy, p, extreme))
-        {
-            // If the point 'p' is colinear with line segment 'i-next', 
-            // then check if it lies on segment. If it lies, return true, 
-            // otherwise false 
-            if (orientation(polygon[i].xy, p, polygon[next].xy) == 0)
-                return onSegment(polygon[i].xy, p, polygon[next].xy);
-
-            count++;
-        }
-        i = next;
-    } while (i != 0);
-
-    // Return true if count is odd, false otherwise 
-    return count & 1;  // Same as (count%2 == 1) 
-}
-
 bool intersectRayPlane(float3 rayOrigin, float3 rayDirection, float3 posOnPlane, float3 planeNormal, inout float3 intersectionPoint)
 {
     float RdotN = dot(rayDirection, planeNormal);
@@ -108,7 +78,7 @@ bool isInAreaLight(in float3 objPosW, in float3 camPosW, out float3 isectPosW)
 
     if (!intersectRayPlane(camPosL, transV, polygon[0].xyz, lightDir, intersectionPoint) && !intersectRayPlane(camPosL, transV, polygon[0].xyz, -lightDir, intersectionPoint)) return false;
 
-    if (!isInside(intersectionPoint.xy)) return false;
+    if (!IsInsidePolygon(intersectionPoint.xy, polygon, polygonEdges, polygonVertexCount, polygonConvex != 0)) return false;
 
     // check if polygon is behind scene geometry
     if (length(intersectionPoint - camPosL) > length(objPosL - camPosL)) return false;
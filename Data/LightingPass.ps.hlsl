@@ -33,10 +33,11 @@ __import LTSH;
 __import LTSHn2;
 __import Lights;
 __import BRDF;
+__import Polygon;
+__import FastMath;
 
 #define NumSamples 4096
-#define SampleReductionFactor 4
-#define NumVertices 4
+#define NumSampleSets 4
 
 cbuffer PerImageCB
 {
@@ -54,17 +55,52 @@ cbuffer PerImageCB
     uint gDebugMode;
     uint gAreaLightRenderMode;
 
-    // Vertices of the area light polygon
-    float4 gAreaLightPosW[NumVertices];
+    // Number of lights in gAreaLights
+    uint gAreaLightCount;
 
     // Pseudo random seed from CPU
     float gSeed;
+
+    // Cells along theta and alpha of the lookup tables
+    uint gLutResolution;
+
+    // LtshDithered or LtshBilinear
+    uint gLtshLookup;
+
+    // TrigExact, TrigMedium or TrigFast for the edge integrals of the current render mode
+    uint gTrigPrecision;
+
+    // Samples of the ground truth modes: gSampleCount samples from gSampleFirst of the pixel's set + gSampleSetShift,
+    // the first NumSamples / 4 of the set without progressive accumulation
+    uint gSampleFirst;
+    uint gSampleCount;
+    uint gSampleSetShift;
+
+    // AccumulateOff, AccumulateAdd or AccumulateShow, and the frames already averaged into gAccumulation
+    uint gAccumulate;
+    uint gAccumulatedFrames;
 };
 
-cbuffer SampleCB0 { float4 lightSamples0[NumSamples]; };
-cbuffer SampleCB1 { float4 lightSamples1[NumSamples]; };
-cbuffer SampleCB2 { float4 lightSamples2[NumSamples]; };
-cbuffer SampleCB3 { float4 lightSamples3[NumSamples]; };
+// Element of the area light buffer, same layout as PackedAreaLight in Source/AreaLightCollection.h
+struct PackedAreaLight
+{
+    float4 posW[MaxPolygonVertices];   // the first numVertices are used
+    float3 intensity;
+    float surfaceArea;
+    float3 dirW;
+    uint numVertices;
+};
+
+// All area lights, the analytic render modes sum up the contributions of every light. The ground truth modes
+// only shade gAreaLight (light 0), the samples exist for that light only.
+StructuredBuffer<PackedAreaLight> gAreaLights;
+
+// NumSampleSets sets of NumSamples world space samples of gAreaLight, set s starts at s * NumSamples. The CPU only
+// uploads them when the light changed, see AreaLightSamples.
+StructuredBuffer<float4> gLightSamples;
+
+// Running mean of the progressive ground truth, see Source/ProgressiveAccumulation.h
+RWTexture2D<float4> gAccumulation;
 
 SamplerState gSampler;
 Texture2D<float4> gLtcMinv;
@@ -91,9 +127,20 @@ Texture2D<float4> gLtshCoeffN2;
 #define LtshBrdf        5
 #define LTSH_N2         6
 
-// for unbiased texture access
-static const float m = 63.f / 64.f;
-static const float b = .5f / 64.f;
+// LTSH lookup modes
+#define LtshDithered    0
+#define LtshBilinear    1
+
+// Progressive accumulation
+#define AccumulateOff   0
+#define AccumulateAdd   1
+#define AccumulateShow  2
+
+// maps [0,1] to the texel centers of the first and last cell for unbiased texture access
+float2 unbiasedLutUv(float2 uv)
+{
+    return (uv * (gLutResolution - 1) + .5f) / gLutResolution;
+}
 
 // returns a random float in [0,1] based on a 2d point (texC)
 // taken from Golden Noise: https://stackoverflow.com/questions/4200224/random-noise-functions-for-glsl
@@ -130,6 +177,41 @@ int2 dither(float2 uv, float2 texC)
     return view_alpha;
 }
 
+// LTSH matrix and coefficients for a [0,1] uv, either from one of the neighboring cells picked by dither()
+// or bilinearly filtered between them, which removes the dithering noise
+void getLtsh(float2 uv, float2 texC, out float3x3 MInv, out float coeffs[25])
+{
+    if (gLtshLookup == LtshBilinear)
+    {
+        float2 tableUv = unbiasedLutUv(uv);
+        MInv = getLtshMatrixFiltered(tableUv);
+        getLtshCoeffsFiltered(tableUv, coeffs);
+    }
+    else
+    {
+        // translate from [0,1] to [0,gLutResolution-1]
+        int2 view_alpha = dither(uv * (gLutResolution - 1), texC);
+        MInv = getLtshMatrix(view_alpha);
+        getLtshCoeffs(view_alpha, gLutResolution, coeffs);
+    }
+}
+
+void getLtshN2(float2 uv, float2 texC, out float3x3 MInv, out float coeffs[9])
+{
+    if (gLtshLookup == LtshBilinear)
+    {
+        float2 tableUv = unbiasedLutUv(uv);
+        MInv = getLtshMatrixN2Filtered(tableUv);
+        getLtshCoeffsN2Filtered(tableUv, coeffs);
+    }
+    else
+    {
+        int2 view_alpha = dither(uv * (gLutResolution - 1), texC);
+        MInv = getLtshMatrixN2(view_alpha);
+        getLtshCoeffsN2(view_alpha, gLutResolution, coeffs);
+    }
+}
+
 // normally lightPosW is stored in the LightData but for our ground truth sampling we need to set manually
 LightSample calculateAreaLightSample(inout ShadingData sd, in LightData light, in float3 lightPosW)
 {
@@ -161,7 +243,7 @@ LightSample calculateAreaLightSample(inout ShadingData sd, in LightData light, i
 }
 
 
-float3 evalDiffuseAreaLight(ShadingData sd, LightData light) {
+float3 evalDiffuseAreaLight(ShadingData sd, LightData light, float4 polygonW[MaxPolygonVertices], int numVertices) {
     // diffuse lighting
     float3x3 Identity = float3x3(
         1, 0, 0,
@@ -169,25 +251,25 @@ float3 evalDiffuseAreaLight(ShadingData sd, LightData light) {
         0, 0, 1
         );
 
-    return LTC_Evaluate(sd.N, sd.V, sd.posW, Identity, gAreaLightPosW, true, light.intensity) * sd.diffuse / 2.0 / 3.14159;
+    return LTC_Evaluate(sd.N, sd.V, sd.posW, Identity, polygonW, numVertices, true, light.intensity, gTrigPrecision) * sd.diffuse / 2.0 / 3.14159;
 }
 
 
-ShadingResult evalMaterialAreaLightLTC(ShadingData sd, LightData light, float3 specularColor)
+ShadingResult evalMaterialAreaLightLTC(ShadingData sd, LightData light, float4 polygonW[MaxPolygonVertices], int numVertices, float3 specularColor)
 {
     ShadingResult sr = initShadingResult();
 
-    sr.diffuse = evalDiffuseAreaLight(sd, light);
+    sr.diffuse = evalDiffuseAreaLight(sd, light, polygonW, numVertices);
 
     float2 uv = cos_theta_roughness_to_uv(sd.NdotV, sd.roughness);
 
     // unbiased access
-    uv = m * uv + b;
+    uv = unbiasedLutUv(uv);
 
     float3x3 MInv = getLtcMatrix(uv);
     float coeff = getCoeff(uv);
 
-    sr.specular = LTC_Evaluate(sd.N, sd.V, sd.posW, MInv, gAreaLightPosW, true, light.intensity) * specularColor * coeff;
+    sr.specular = LTC_Evaluate(sd.N, sd.V, sd.posW, MInv, polygonW, numVertices, true, light.intensity, gTrigPrecision) * specularColor * coeff;
     // Normalization
     sr.specular /= 2 * 3.14159;
 
@@ -195,20 +277,18 @@ ShadingResult evalMaterialAreaLightLTC(ShadingData sd, LightData light, float3 s
     return sr;
 }
 
-ShadingResult evalMaterialAreaLightLTSH(ShadingData sd, LightData light, float3 specularColor, float2 texC)
+ShadingResult evalMaterialAreaLightLTSH(ShadingData sd, LightData light, float4 polygonW[MaxPolygonVertices], int numVertices, float3 specularColor, float2 texC)
 {
     ShadingResult sr = initShadingResult();
 
-    sr.diffuse = evalDiffuseAreaLight(sd, light);
+    sr.diffuse = evalDiffuseAreaLight(sd, light, polygonW, numVertices);
 
     float2 uv = cos_theta_roughness_to_uv(sd.NdotV, sd.roughness);
-    // translate from [0,1] to [0,63]
-    uv *= 63.f;
-
-    int2 view_alpha = dither(uv, texC);
 
     // specular lighting
-    float3x3 MInv = getLtshMatrix(view_alpha);
+    float3x3 MInv;
+    float coeffs[25];
+    getLtsh(uv, texC, MInv, coeffs);
     
     // construct orthonormal basis around N
     float3 T1, T2;
@@ -218,30 +298,24 @@ ShadingResult evalMaterialAreaLightLTSH(ShadingData sd, LightData light, float3
     // rotate area light in (T1, T2, R) basis
     float3x3 baseMat = float3x3(T1, T2, sd.N);
 
-    float3 L[5];
-    L[0] = mul(baseMat, gAreaLightPosW[0].xyz - sd.posW);
-    L[1] = mul(baseMat, gAreaLightPosW[1].xyz - sd.posW);
-    L[2] = mul(baseMat, gAreaLightPosW[2].xyz - sd.posW);
-    L[3] = mul(baseMat, gAreaLightPosW[3].xyz - sd.posW);
-    L[4] = L[3];
+    float3 polygon[MaxPolygonVertices];
+    for (int i = 0; i < MaxPolygonVertices; i++) {
+        polygon[i] = mul(baseMat, polygonW[i].xyz - sd.posW);
+    }
 
-    int n = 4;
-    ClipQuadToHorizon(L, n);
+    float3 L[MaxClippedVertices];
+    int n = ClipPolygonToHorizon(polygon, numVertices, L);
 
     float result = 0;
 
     if (n != 0) {
-        L[0] = normalize(mul(MInv, L[0]));
-        L[1] = normalize(mul(MInv, L[1]));
-        L[2] = normalize(mul(MInv, L[2]));
-        L[3] = normalize(mul(MInv, L[3]));
-        L[4] = normalize(mul(MInv, L[4]));
+        for (int i = 0; i < n; i++) {
+            L[i] = normalize(mul(MInv, L[i]));
+        }
 
         float Lc[25];
-        polygonSH(L, n, Lc);
+        polygonSH(L, n, Lc, gTrigPrecision);
 
-        float coeffs[25];
-        getLtshCoeffs(view_alpha, coeffs);
         for (int i = 0; i < 25; i++)
         {
             result += Lc[i] * coeffs[i];
@@ -253,20 +327,18 @@ ShadingResult evalMaterialAreaLightLTSH(ShadingData sd, LightData light, float3
     return sr;
 }
 
-ShadingResult evalMaterialAreaLightLTSH_N2(ShadingData sd, LightData light, float3 specularColor, float2 texC)
+ShadingResult evalMaterialAreaLightLTSH_N2(ShadingData sd, LightData light, float4 polygonW[MaxPolygonVertices], int numVertices, float3 specularColor, float2 texC)
 {
     ShadingResult sr = initShadingResult();
 
-    sr.diffuse = evalDiffuseAreaLight(sd, light);
+    sr.diffuse = evalDiffuseAreaLight(sd, light, polygonW, numVertices);
 
     float2 uv = cos_theta_roughness_to_uv(sd.NdotV, sd.roughness);
-    // translate from [0,1] to [0,63]
-    uv *= 63.f;
-
-    int2 view_alpha = dither(uv, texC);
 
     // specular lighting
-    float3x3 MInv = getLtshMatrixN2(view_alpha);
+    float3x3 MInv;
+    float coeffs[9];
+    getLtshN2(uv, texC, MInv, coeffs);
 
     // construct orthonormal basis around N
     float3 T1, T2;
@@ -276,30 +348,24 @@ ShadingResult evalMaterialAreaLightLTSH_N2(ShadingData sd, LightData light, floa
     // rotate area light in (T1, T2, R) basis
     float3x3 baseMat = float3x3(T1, T2, sd.N);
 
-    float3 L[5];
-    L[0] = mul(baseMat, gAreaLightPosW[0].xyz - sd.posW);
-    L[1] = mul(baseMat, gAreaLightPosW[1].xyz - sd.posW);
-    L[2] = mul(baseMat, gAreaLightPosW[2].xyz - sd.posW);
-    L[3] = mul(baseMat, gAreaLightPosW[3].xyz - sd.posW);
-    L[4] = L[3];
+    float3 polygon[MaxPolygonVertices];
+    for (int i = 0; i < MaxPolygonVertices; i++) {
+        polygon[i] = mul(baseMat, polygonW[i].xyz - sd.posW);
+    }
 
-    int n = 4;
-    ClipQuadToHorizon(L, n);
+    float3 L[MaxClippedVertices];
+    int n = ClipPolygonToHorizon(polygon, numVertices, L);
 
     float result = 0;
 
     if (n != 0) {
-        L[0] = normalize(mul(MInv, L[0]));
-        L[1] = normalize(mul(MInv, L[1]));
-        L[2] = normalize(mul(MInv, L[2]));
-        L[3] = normalize(mul(MInv, L[3]));
-        L[4] = normalize(mul(MInv, L[4]));
+        for (int i = 0; i < n; i++) {
+            L[i] = normalize(mul(MInv, L[i]));
+        }
 
         float Lc[9];
-        polygonSHN2(L, n, Lc);
+        polygonSHN2(L, n, Lc, gTrigPrecision);
 
-        float coeffs[9];
-        getLtshCoeffsN2(view_alpha, coeffs);
         for (int i = 0; i < 9; i++)
         {
             result += Lc[i] * coeffs[i];
@@ -318,17 +384,12 @@ ShadingResult evalMaterialAreaLightGroundTruth(ShadingData sd, LightData light,
     float2 uv = cos_theta_roughness_to_uv(sd.NdotV, sd.roughness);
 
     // unbiased access
-    float2 cos_uv = m * uv + b;
-
-    uv *= 63.f;
-
-    int2 view_alpha = dither(uv, texC);
+    float2 cos_uv = unbiasedLutUv(uv);
 
     float3x3 MInv_cos = getLtcMatrix(cos_uv);
-    float3x3 MInv_sh = getLtshMatrix(view_alpha);
-
+    float3x3 MInv_sh;
     float ltshCoeffs[25];
-    getLtshCoeffs(view_alpha, ltshCoeffs);
+    getLtsh(uv, texC, MInv_sh, ltshCoeffs);
     float cosCoeff = getCoeff(cos_uv);
 
     float3 T1, T2;
@@ -340,22 +401,14 @@ ShadingResult evalMaterialAreaLightGroundTruth(ShadingData sd, LightData light,
     MInv_cos = mul(MInv_cos, baseMat);
     MInv_sh = mul(MInv_sh, baseMat);
 
-    // decide, which set of point lights to sample
-    int sampleSet = round(rand(texC) * 4);
+    // decide, which set of point lights to sample, round() can give NumSampleSets which uses the last set
+    uint sampleSet = (min((uint)round(rand(texC) * NumSampleSets), (uint)NumSampleSets - 1) + gSampleSetShift) % NumSampleSets;
+    uint sampleOffset = sampleSet * NumSamples + gSampleFirst;
 
     // Do Lighting for every Sample
-    for (int i = 0; i < NumSamples / SampleReductionFactor; i++)
+    for (uint i = 0; i < gSampleCount; i++)
     {
-        float3 lightPosW;
-        // use different sample set dependent on random value
-        if (sampleSet == 0)
-            lightPosW = lightSamples0[i].xyz;
-        else if (sampleSet == 1)
-            lightPosW = lightSamples1[i].xyz;
-        else if (sampleSet == 2)
-            lightPosW = lightSamples2[i].xyz;
-        else
-            lightPosW = lightSamples3[i].xyz;
+        float3 lightPosW = gLightSamples[sampleOffset + i].xyz;
 
         LightSample ls = calculateAreaLightSample(sd, light, lightPosW);
 
@@ -373,8 +426,8 @@ ShadingResult evalMaterialAreaLightGroundTruth(ShadingData sd, LightData light,
         else if (gAreaLightRenderMode == GroundTruth)   sr.specularBrdf = evalSpecularBrdf(sd, ls) * ls.NdotL;
         sr.specular += ls.specular * sr.specularBrdf;
     }
-    sr.diffuse = sr.diffuse * SampleReductionFactor / (float)NumSamples * light.surfaceArea * light.intensity;
-    sr.specular = sr.specular * SampleReductionFactor / (float)NumSamples * light.surfaceArea * light.intensity * specularColor;
+    sr.diffuse = sr.diffuse / (float)gSampleCount * light.surfaceArea * light.intensity;
+    sr.specular = sr.specular / (float)gSampleCount * light.surfaceArea * light.intensity * specularColor;
     sr.color.rgb = sr.diffuse + sr.specular;
 
     return sr;
@@ -408,17 +461,32 @@ float3 shade(float3 posW, float3 normalW, float linearRoughness, float4 albedo,
     /* Do lighting */
     ShadingResult dirResult = evalMaterial(sd, gDirLight, 1);
     ShadingResult pointResult = evalMaterial(sd, gPointLight, 1);
-    ShadingResult areaResult;
+    ShadingResult areaResult = initShadingResult();
     if (gAreaLightRenderMode == GroundTruth || gAreaLightRenderMode == LtcBrdf || gAreaLightRenderMode == LtshBrdf)
         areaResult = evalMaterialAreaLightGroundTruth(sd, gAreaLight, specular, texC);
-    else if (gAreaLightRenderMode == LTC)
-        areaResult = evalMaterialAreaLightLTC(sd, gAreaLight, specular);
-    else if (gAreaLightRenderMode == LTSH)
-        areaResult = evalMaterialAreaLightLTSH(sd, gAreaLight, specular, texC);
-    else if (gAreaLightRenderMode == LTSH_N2)
-        areaResult = evalMaterialAreaLightLTSH_N2(sd, gAreaLight, specular, texC);
-    else if (gAreaLightRenderMode == None)
-        areaResult = initShadingResult();
+    else if (gAreaLightRenderMode != None)
+    {
+        for (uint i = 0; i < gAreaLightCount; i++)
+        {
+            PackedAreaLight packed = gAreaLights[i];
+            LightData light = gAreaLight;
+            light.intensity = packed.intensity;
+            light.dirW = packed.dirW;
+            light.surfaceArea = packed.surfaceArea;
+
+            ShadingResult lightResult;
+            if (gAreaLightRenderMode == LTC)
+                lightResult = evalMaterialAreaLightLTC(sd, light, packed.posW, int(packed.numVertices), specular);
+            else if (gAreaLightRenderMode == LTSH)
+                lightResult = evalMaterialAreaLightLTSH(sd, light, packed.posW, int(packed.numVertices), specular, texC);
+            else
+                lightResult = evalMaterialAreaLightLTSH_N2(sd, light, packed.posW, int(packed.numVertices), specular, texC);
+
+            areaResult.diffuse += lightResult.diffuse;
+            areaResult.specular += lightResult.specular;
+            areaResult.color += lightResult.color;
+        }
+    }
 
     float3 result;
 
@@ -467,6 +535,21 @@ float4 main(float2 texC : TEXCOORD, float4 pos : SV_POSITION) : SV_TARGET
         return float4(gAreaLight.intensity / maxIntensity, 1);
     };
 
+    // the history is final or the frame is rendered a second time for a screenshot
+    uint2 pixel = uint2(pos.xy);
+    if (gAccumulate == AccumulateShow)
+    {
+        if (albedo.a <= 0) discard;
+        return float4(gAccumulation[pixel].rgb, 1);
+    }
+
     float3 color = shade(posW, normalW, linearRoughness, albedo, specular, roughness, texC);
+
+    // progressive ground truth, the first frame replaces the history
+    if (gAccumulate == AccumulateAdd)
+    {
+        if (gAccumulatedFrames > 0) color = lerp(gAccumulation[pixel].rgb, color, 1.f / (gAccumulatedFrames + 1));
+        gAccumulation[pixel] = float4(color, 1);
+    }
     return float4(color, 1);
 }
@@ -0,0 +1,137 @@
+#include "AreaLightCollection.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    inline uint32_t countTrailingZeros(uint64_t x)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return uint32_t(index);
+#else
+        return uint32_t(__builtin_ctzll(x));
+#endif
+    }
+
+    /** First index >= i below count whose bit equals value, count if there is none. Skips 64 lights per step.
+    */
+    uint32_t findNextBit(const std::vector<uint64_t>& bits, uint32_t i, uint32_t count, bool value)
+    {
+        while (i < count)
+        {
+            uint64_t word = value ? bits[i >> 6] : ~bits[i >> 6];
+            word >>= (i & 63);
+            if (word) return std::min(count, i + countTrailingZeros(word));
+            i = (i | 63) + 1;
+        }
+        return count;
+    }
+}
+
+uint32_t AreaLightCollection::add(const PackedAreaLight& light)
+{
+    uint32_t index = getCount();
+    mLights.push_back(light);
+    mDirtyBits.resize((mLights.size() + 63) / 64, 0);
+    markDirty(index);
+    return index;
+}
+
+void AreaLightCollection::set(uint32_t index, const PackedAreaLight& light)
+{
+    if (std::memcmp(&mLights[index], &light, sizeof(PackedAreaLight)) == 0) return;
+    mLights[index] = light;
+    markDirty(index);
+}
+
+void AreaLightCollection::setIntensity(uint32_t index, const float intensity[3])
+{
+    if (std::memcmp(mLights[index].intensity, intensity, sizeof(mLights[index].intensity)) == 0) return;
+    std::memcpy(mLights[index].intensity, intensity, sizeof(mLights[index].intensity));
+    markDirty(index);
+}
+
+uint32_t AreaLightCollection::remove(uint32_t index)
+{
+    uint32_t last = getCount() - 1;
+    // the slot of the last light disappears, its dirty bit with it
+    uint64_t& lastWord = mDirtyBits[last >> 6];
+    uint64_t lastBit = uint64_t(1) << (last & 63);
+    if (lastWord & lastBit)
+    {
+        lastWord &= ~lastBit;
+        mDirtyCount--;
+    }
+
+    if (index != last)
+    {
+        mLights[index] = mLights[last];
+        markDirty(index);
+    }
+    mLights.pop_back();
+    mDirtyBits.resize((mLights.size() + 63) / 64);
+    return last;
+}
+
+void AreaLightCollection::clear()
+{
+    mLights.clear();
+    mDirtyBits.clear();
+    mDirtyCount = 0;
+}
+
+std::vector<AreaLightCollection::Range> AreaLightCollection::getDirtyRanges(uint32_t maxGap) const
+{
+    std::vector<Range> ranges;
+    if (mDirtyCount == 0) return ranges;
+
+    uint32_t count = getCount();
+    uint32_t first = findNextBit(mDirtyBits, 0, count, true);
+    while (first < count)
+    {
+        uint32_t end = findNextBit(mDirtyBits, first, count, false);
+        if (!ranges.empty() && first - (ranges.back().first + ranges.back().count) <= maxGap)
+        {
+            ranges.back().count = end - ranges.back().first;
+        }
+        else
+        {
+            ranges.push_back({ first, end - first });
+        }
+        first = findNextBit(mDirtyBits, end, count, true);
+    }
+    return ranges;
+}
+
+void AreaLightCollection::clearDirty()
+{
+    std::fill(mDirtyBits.begin(), mDirtyBits.end(), uint64_t(0));
+    mDirtyCount = 0;
+}
+
+void AreaLightCollection::markAllDirty()
+{
+    uint32_t count = getCount();
+    std::fill(mDirtyBits.begin(), mDirtyBits.end(), ~uint64_t(0));
+    // keep the bits past the last light clear, findNextBit relies on it
+    if (count & 63) mDirtyBits.back() = (uint64_t(1) << (count & 63)) - 1;
+    mDirtyCount = count;
+}
+
+void AreaLightCollection::markDirty(uint32_t index)
+{
+    uint64_t& word = mDirtyBits[index >> 6];
+    uint64_t bit = uint64_t(1) << (index & 63);
+    if (!(word & bit))
+    {
+        word |= bit;
+        mDirtyCount++;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+// CPU side of the area light structured buffer of the lighting pass. All lights are packed into one contiguous
+// array with the element layout of gAreaLights in LightingPass.ps.hlsl. Every change marks the light dirty, so
+// after the first upload only the ranges of lights that changed since the last upload have to be copied.
+// Does not depend on Falcor, the app uploads the dirty ranges and the CPU lighting pass reads the array directly.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// maximum number of polygon vertices, MaxPolygonVertices in Data/Polygon.slang
+#define AREA_LIGHT_MAX_VERTICES 8
+
+/** One element of the structured buffer, 16 byte aligned rows like the HLSL struct
+*/
+struct PackedAreaLight
+{
+    float posW[AREA_LIGHT_MAX_VERTICES][4] = {};    // world space vertices in CCW order, w unused, unused vertices stay zero
+    float intensity[3];
+    float surfaceArea;
+    float dirW[3];                                  // normal of the polygon
+    uint32_t numVertices = 0;                       // 3 to AREA_LIGHT_MAX_VERTICES, convex or concave
+};
+
+static_assert(sizeof(PackedAreaLight) == 160, "PackedAreaLight must match the layout of the shader struct");
+
+class AreaLightCollection
+{
+public:
+    /** Lights first .. first + count - 1
+    */
+    struct Range
+    {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    /** Append a light, it is dirty until the next clearDirty()
+        \return Index of the light
+    */
+    uint32_t add(const PackedAreaLight& light);
+
+    /** Replace a light. Only marks it dirty if the data actually changed, so it is fine to call this every frame.
+    */
+    void set(uint32_t index, const PackedAreaLight& light);
+
+    /** Change only the intensity of a light
+    */
+    void setIntensity(uint32_t index, const float intensity[3]);
+
+    /** Remove a light by moving the last light into its slot
+        \return Previous index of the light that now is at index, or the new count if the last light was removed
+    */
+    uint32_t remove(uint32_t index);
+
+    void clear();
+
+    uint32_t getCount() const { return uint32_t(mLights.size()); }
+    const PackedAreaLight& get(uint32_t index) const { return mLights[index]; }
+    const PackedAreaLight* getData() const { return mLights.data(); }
+    size_t getSizeInBytes() const { return mLights.size() * sizeof(PackedAreaLight); }
+
+    bool isDirty() const { return mDirtyCount > 0; }
+    uint32_t getDirtyCount() const { return mDirtyCount; }
+
+    /** Sorted, disjoint ranges that cover all dirty lights
+        \param[in] maxGap Ranges separated by at most maxGap clean lights are merged, one larger copy is usually
+            cheaper than several small ones
+    */
+    std::vector<Range> getDirtyRanges(uint32_t maxGap = 0) const;
+
+    /** Call after the dirty ranges were uploaded
+    */
+    void clearDirty();
+
+    /** Mark every light dirty, e.g. after the GPU buffer was recreated
+    */
+    void markAllDirty();
+
+private:
+    void markDirty(uint32_t index);
+
+    std::vector<PackedAreaLight> mLights;
+    std::vector<uint64_t> mDirtyBits;   // one bit per light
+    uint32_t mDirtyCount = 0;
+};
@@ -0,0 +1,59 @@
+#include "AreaLightSamples.h"
+#include "PolygonSampler.h"
+
+#include <algorithm>
+
+AreaLightSamples::AreaLightSamples()
+    : mModel(size_t(NUM_SAMPLE_SETS) * NUM_SAMPLES * 4), mWorld(size_t(NUM_SAMPLE_SETS) * NUM_SAMPLES * 4)
+{
+}
+
+// stratified samples on the triangle fan of the polygon, every set is a differently scrambled Sobol sequence
+bool AreaLightSamples::update(const float* vertices2d, uint32_t numVertices, uint32_t seed, const float* transform)
+{
+    if (!mModelValid || mSampledSeed != seed || mSampledVertices.size() != 2 * numVertices ||
+        !std::equal(mSampledVertices.begin(), mSampledVertices.end(), vertices2d))
+    {
+        PolygonSampler sampler(vertices2d, (int)numVertices, 2);
+        for (uint32_t i = 0; i < NUM_SAMPLE_SETS; i++)
+        {
+            float* set = &mModel[size_t(i) * NUM_SAMPLES * 4];
+            sampler.generate(SampleSequence::Sobol, seed * NUM_SAMPLE_SETS + i, 0, NUM_SAMPLES, set, 4);
+            for (uint32_t j = 0; j < NUM_SAMPLES; j++)
+            {
+                set[4 * j + 2] = 0.f;
+                set[4 * j + 3] = 1.f;
+            }
+        }
+        mSampledVertices.assign(vertices2d, vertices2d + 2 * numVertices);
+        mSampledSeed = seed;
+        mModelValid = true;
+        mWorldValid = false;
+    }
+
+    if (!mWorldValid || !std::equal(mSampledTransform, mSampledTransform + 16, transform))
+    {
+        transformPoints(transform, mModel.data(), NUM_SAMPLE_SETS * NUM_SAMPLES, mWorld.data());
+        std::copy(transform, transform + 16, mSampledTransform);
+        mWorldValid = true;
+        mGeneration++;
+        return true;
+    }
+    return false;
+}
+
+void CountingUploadSink::upload(const void*, size_t, size_t size)
+{
+    mFrameBytes += size;
+    mTotalBytes += size;
+    mUploadCount++;
+}
+
+bool SampleBufferUploader::update(const AreaLightSamples& samples, SampleUploadSink& sink)
+{
+    if (mValid && mGeneration == samples.getGeneration()) return false;
+    sink.upload(samples.getWorldSamples(), 0, samples.getByteSize());
+    mGeneration = samples.getGeneration();
+    mValid = true;
+    return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+// Ground truth samples of an area light: NUM_SAMPLE_SETS sets of NUM_SAMPLES points on the polygon, created in model
+// space by PolygonSampler and transformed to world space. Only a change of the polygon or the seed regenerates them,
+// a change of the transform only re-transforms them. Every change of the world space samples increments a generation
+// counter, so SampleBufferUploader copies them to the persistent sample buffer of the lighting pass (gLightSamples)
+// only in the frames where they changed instead of every frame.
+// Does not depend on Falcor, the app uploads through a SampleUploadSink on top of a StructuredBuffer.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// samples per set, NumSamples in LightingPass.ps.hlsl
+#define NUM_SAMPLES 4096
+#define NUM_SAMPLE_SETS 4
+
+class AreaLightSamples
+{
+public:
+    AreaLightSamples();
+
+    /** Bring the samples up to date with the light
+        \param[in] vertices2d numVertices (x, y) pairs of the polygon in model space
+        \param[in] transform Column major model to world matrix
+        \return True if the world space samples changed, the generation was incremented then
+    */
+    bool update(const float* vertices2d, uint32_t numVertices, uint32_t seed, const float* transform);
+
+    /** Regenerate the samples in the next update()
+    */
+    void invalidate() { mModelValid = false; }
+
+    /** World space samples as (x, y, z, 1), set s starts at element s * NUM_SAMPLES
+    */
+    const float* getWorldSamples() const { return mWorld.data(); }
+    size_t getByteSize() const { return mWorld.size() * sizeof(float); }
+
+    /** Changes whenever the world space samples change, 0 before the first update()
+    */
+    uint64_t getGeneration() const { return mGeneration; }
+
+private:
+    std::vector<float> mModel;
+    std::vector<float> mWorld;
+    uint64_t mGeneration = 0;
+
+    // state the cached samples were created with, mModel depends on the polygon and seed only
+    bool mModelValid = false;
+    bool mWorldValid = false;
+    std::vector<float> mSampledVertices;
+    uint32_t mSampledSeed = 0;
+    float mSampledTransform[16] = {};
+};
+
+/** Destination of the sample upload, a GPU buffer in the app
+*/
+class SampleUploadSink
+{
+public:
+    virtual ~SampleUploadSink() {}
+    virtual void upload(const void* pData, size_t offset, size_t size) = 0;
+};
+
+/** Counts the bytes uploaded per frame instead of uploading them, for headless runs
+*/
+class CountingUploadSink : public SampleUploadSink
+{
+public:
+    void beginFrame() { mFrameBytes = 0; }
+    void upload(const void* pData, size_t offset, size_t size) override;
+
+    size_t getFrameBytes() const { return mFrameBytes; }
+    uint64_t getTotalBytes() const { return mTotalBytes; }
+    uint32_t getUploadCount() const { return mUploadCount; }
+
+private:
+    size_t mFrameBytes = 0;
+    uint64_t mTotalBytes = 0;
+    uint32_t mUploadCount = 0;
+};
+
+/** Keeps a sample buffer in sync with AreaLightSamples, uploading all sets when the generation differs from the one
+    in the buffer
+*/
+class SampleBufferUploader
+{
+public:
+    /** \return True if the samples were uploaded
+    */
+    bool update(const AreaLightSamples& samples, SampleUploadSink& sink);
+
+    /** The buffer lost its contents, e.g. because it was recreated. The next update() uploads.
+    */
+    void invalidate() { mValid = false; }
+
+private:
+    bool mValid = false;
+    uint64_t mGeneration = 0;
+};
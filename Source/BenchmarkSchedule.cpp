@@ -0,0 +1,141 @@
+#include "BenchmarkSchedule.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace
+{
+    bool equalsIgnoreCase(const std::string& a, const char* b)
+    {
+        size_t i = 0;
+        for (; i < a.size() && b[i]; i++)
+        {
+            if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i])) return false;
+        }
+        return i == a.size() && !b[i];
+    }
+
+    std::vector<std::string> splitList(const std::string& value)
+    {
+        std::vector<std::string> items;
+        size_t start = 0;
+        while (start <= value.size())
+        {
+            size_t end = value.find(',', start);
+            if (end == std::string::npos) end = value.size();
+            if (end > start) items.push_back(value.substr(start, end - start));
+            start = end + 1;
+        }
+        return items;
+    }
+
+    uint32_t parseCount(const std::string& arg, const std::string& value)
+    {
+        char* end;
+        unsigned long count = std::strtoul(value.c_str(), &end, 10);
+        if (value.empty() || *end || value[0] == '-')
+        {
+            throw std::invalid_argument(arg + " expects a number, got " + value);
+        }
+        return uint32_t(count);
+    }
+}
+
+BenchmarkSettings parseBenchmarkArgs(int argc, const char* const* argv, const char* const* modeNames, uint32_t numModes,
+                                     const std::vector<uint32_t>& defaultModes)
+{
+    BenchmarkSettings settings;
+    settings.modes = defaultModes;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--benchmark")
+        {
+            settings.enabled = true;
+            continue;
+        }
+        if (arg.compare(0, 8, "--bench-") != 0) continue;
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument(arg + " expects a value");
+        }
+        std::string value = argv[++i];
+        if (arg == "--bench-modes")
+        {
+            settings.modes.clear();
+            for (const std::string& name : splitList(value))
+            {
+                uint32_t mode = 0;
+                while (mode < numModes && !equalsIgnoreCase(name, modeNames[mode])) mode++;
+                if (mode == numModes)
+                {
+                    throw std::invalid_argument("unknown render mode " + name);
+                }
+                settings.modes.push_back(mode);
+            }
+        }
+        else if (arg == "--bench-frames") settings.timedFrames = parseCount(arg, value);
+        else if (arg == "--bench-warmup") settings.warmupFrames = parseCount(arg, value);
+        else if (arg == "--bench-capture")
+        {
+            settings.captureFrames.clear();
+            for (const std::string& frame : splitList(value))
+            {
+                settings.captureFrames.push_back(parseCount(arg, frame));
+            }
+        }
+        else if (arg == "--bench-out") settings.outputFile = value;
+        else
+        {
+            throw std::invalid_argument("unknown argument " + arg);
+        }
+    }
+    if (settings.enabled && (settings.modes.empty() || settings.timedFrames == 0))
+    {
+        throw std::invalid_argument("the benchmark needs at least one mode and one frame");
+    }
+    return settings;
+}
+
+BenchmarkSchedule::BenchmarkSchedule(const BenchmarkSettings& settings)
+    : mSettings(settings)
+{
+}
+
+std::vector<uint32_t> BenchmarkSchedule::getModeStartFrames() const
+{
+    std::vector<uint32_t> frames;
+    for (uint32_t i = 0; i < mSettings.modes.size(); i++)
+    {
+        frames.push_back(i * getFramesPerMode());
+    }
+    return frames;
+}
+
+BenchmarkSchedule::Frame BenchmarkSchedule::getFrame(uint64_t benchmarkFrame) const
+{
+    Frame frame;
+    if (!isEnabled() || benchmarkFrame >= getTotalFrames()) return frame;
+
+    frame.modeIndex = uint32_t(benchmarkFrame / getFramesPerMode());
+    frame.mode = mSettings.modes[frame.modeIndex];
+    uint32_t local = uint32_t(benchmarkFrame % getFramesPerMode());
+    if (local < mSettings.warmupFrames)
+    {
+        // the warm-up shows the first view, the caches are then warm for the timed frames
+        frame.phase = Phase::Warmup;
+        frame.reelFrame = 0;
+    }
+    else if (local < mSettings.warmupFrames + mSettings.timedFrames)
+    {
+        frame.phase = Phase::Timed;
+        frame.reelFrame = local - mSettings.warmupFrames;
+    }
+    else
+    {
+        frame.phase = Phase::Capture;
+        frame.reelFrame = mSettings.captureFrames[local - mSettings.warmupFrames - mSettings.timedFrames];
+    }
+    return frame;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// Frame schedule of the scripted benchmark of SimpleDeferred (--benchmark). Every render mode runs the same segment of
+// frames: warm-up frames that are rendered but not recorded, timed frames along the camera reel and one untimed frame
+// per capture keyframe, so the screenshots don't distort the frame times. The camera reel restarts with every mode,
+// so all modes are timed on the same views and the results can be compared between runs.
+// Does not depend on Falcor.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BenchmarkSettings
+{
+    bool enabled = false;
+    std::vector<uint32_t> modes;            ///< Render modes in the order they run, indices into the mode names
+    uint32_t warmupFrames = 60;
+    uint32_t timedFrames = 600;             ///< Frames per mode, frame i shows the camera reel at i
+    std::vector<uint32_t> captureFrames;    ///< Reel frames that are captured for every mode
+    std::string outputFile = "benchmark.jsonl";
+};
+
+/** Parse the --bench* arguments, other arguments are left to Falcor.
+    --benchmark [--bench-modes LTC,LTSH_N4,LTSH_N2] [--bench-frames 600] [--bench-warmup 60] [--bench-capture 0,150,300]
+    [--bench-out benchmark.jsonl]
+    Throws std::invalid_argument for unknown modes and malformed values.
+    \param[in] modeNames Names of the render modes, matched case-insensitively
+    \param[in] defaultModes Modes that run if --bench-modes is not given
+*/
+BenchmarkSettings parseBenchmarkArgs(int argc, const char* const* argv, const char* const* modeNames, uint32_t numModes,
+                                     const std::vector<uint32_t>& defaultModes);
+
+class BenchmarkSchedule
+{
+public:
+    enum class Phase
+    {
+        Warmup,
+        Timed,
+        Capture,
+        Done,
+    };
+
+    struct Frame
+    {
+        Phase phase = Phase::Done;
+        uint32_t modeIndex = 0;     ///< Index into BenchmarkSettings::modes
+        uint32_t mode = 0;          ///< Render mode
+        uint32_t reelFrame = 0;     ///< Frame of the camera reel to show
+    };
+
+    BenchmarkSchedule() = default;
+    explicit BenchmarkSchedule(const BenchmarkSettings& settings);
+
+    bool isEnabled() const { return mSettings.enabled && !mSettings.modes.empty(); }
+    const BenchmarkSettings& getSettings() const { return mSettings; }
+
+    uint32_t getFramesPerMode() const { return mSettings.warmupFrames + mSettings.timedFrames + uint32_t(mSettings.captureFrames.size()); }
+    uint64_t getTotalFrames() const { return uint64_t(getFramesPerMode()) * mSettings.modes.size(); }
+
+    /** Benchmark frames at which the next render mode starts, one per mode
+    */
+    std::vector<uint32_t> getModeStartFrames() const;
+
+    /** What to render in the given frame, counted from the start of the benchmark
+    */
+    Frame getFrame(uint64_t benchmarkFrame) const;
+
+private:
+    BenchmarkSettings mSettings;
+};
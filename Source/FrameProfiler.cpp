@@ -0,0 +1,271 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    const uint32_t kNumStages = uint32_t(FrameStage::Count);
+
+    const char* kStageNames[kNumStages] = { "gbuffer", "light_upload", "sample_upload", "lighting", "capture" };
+
+    bool matchesMode(const char* mode, const char* renderMode)
+    {
+        return !renderMode || std::strcmp(mode, renderMode) == 0;
+    }
+
+    /** Nearest rank percentile of sorted values
+    */
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        size_t rank = size_t(std::ceil(p * sorted.size()));
+        return sorted[std::min(std::max(rank, size_t(1)), sorted.size()) - 1];
+    }
+
+    void appendStages(std::string& json, const char* key, const double* ms, uint32_t stageMask)
+    {
+        char buffer[64];
+        json += ",\"";
+        json += key;
+        json += "\":{";
+        bool first = true;
+        for (uint32_t s = 0; s < kNumStages; s++)
+        {
+            if (!(stageMask & (1u << s))) continue;
+            std::snprintf(buffer, sizeof(buffer), "%s\"%s\":%.4f", first ? "" : ",", kStageNames[s], ms[s]);
+            json += buffer;
+            first = false;
+        }
+        json += "}";
+    }
+
+    void appendPercentiles(std::string& json, const char* key, const FrameProfiler::Percentiles& p)
+    {
+        char buffer[192];
+        std::snprintf(buffer, sizeof(buffer), "\"%s\":{\"count\":%u,\"mean\":%.4f,\"p50\":%.4f,\"p90\":%.4f,\"p99\":%.4f,\"max\":%.4f}",
+                      key, p.count, p.mean, p.p50, p.p90, p.p99, p.max);
+        json += buffer;
+    }
+}
+
+const char* getFrameStageName(FrameStage stage)
+{
+    return uint32_t(stage) < kNumStages ? kStageNames[uint32_t(stage)] : "unknown";
+}
+
+double CpuTimerBackend::getCpuTimeMs()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+MockTimerBackend::MockTimerBackend(uint32_t latency)
+    : mLatency(latency), mSlots(size_t(latency + 1) * kNumStages, -1.0)
+{
+}
+
+void MockTimerBackend::beginGpu(uint64_t frameIndex, FrameStage stage)
+{
+    mSlots[size_t(frameIndex % (mLatency + 1)) * kNumStages + uint32_t(stage)] = mGpuCost[uint32_t(stage)];
+}
+
+void MockTimerBackend::endGpu(uint64_t, FrameStage)
+{
+}
+
+double MockTimerBackend::readGpu(uint64_t frameIndex, FrameStage stage)
+{
+    return mSlots[size_t(frameIndex % (mLatency + 1)) * kNumStages + uint32_t(stage)];
+}
+
+FrameProfiler::FrameProfiler(FrameTimerBackend& backend, uint32_t historySize)
+    : mBackend(backend), mHistory(std::max(historySize, backend.getGpuLatency() + 1))
+{
+}
+
+void FrameProfiler::beginFrame(uint64_t frameId, const char* renderMode, const char* debugMode)
+{
+    if (mInFrame)
+    {
+        throw std::logic_error("FrameProfiler::beginFrame() called twice without endFrame()");
+    }
+    Record& record = mHistory[size_t(mFrameIndex % mHistory.size())];
+    record = Record();
+    record.frameIndex = mFrameIndex;
+    record.frameId = frameId;
+    record.renderMode = renderMode ? renderMode : "";
+    record.debugMode = debugMode ? debugMode : "";
+    mInFrame = true;
+    mFrameStartMs = mBackend.getCpuTimeMs();
+}
+
+void FrameProfiler::beginStage(FrameStage stage)
+{
+    if (!mInFrame) return;
+    mStageStartMs[uint32_t(stage)] = mBackend.getCpuTimeMs();
+    mBackend.beginGpu(mFrameIndex, stage);
+}
+
+void FrameProfiler::endStage(FrameStage stage)
+{
+    if (!mInFrame) return;
+    mBackend.endGpu(mFrameIndex, stage);
+    Record& record = mHistory[size_t(mFrameIndex % mHistory.size())];
+    record.cpuMs[uint32_t(stage)] += mBackend.getCpuTimeMs() - mStageStartMs[uint32_t(stage)];
+    record.stageMask |= 1u << uint32_t(stage);
+}
+
+void FrameProfiler::endFrame()
+{
+    if (!mInFrame) return;
+    Record& current = mHistory[size_t(mFrameIndex % mHistory.size())];
+    current.frameCpuMs = mBackend.getCpuTimeMs() - mFrameStartMs;
+    mInFrame = false;
+
+    // the frames whose device results just became available, oldest first so the JSON stays in frame order
+    uint64_t latency = mBackend.hasGpuTimers() ? mBackend.getGpuLatency() : 0;
+    uint64_t first = mFrameIndex >= latency ? mFrameIndex - latency : 0;
+    for (uint64_t index = first; index <= mFrameIndex; index++)
+    {
+        Record& record = mHistory[size_t(index % mHistory.size())];
+        if (!record.complete && record.frameIndex + latency <= mFrameIndex)
+        {
+            complete(record);
+        }
+    }
+    mFrameIndex++;
+}
+
+void FrameProfiler::flush()
+{
+    uint64_t latency = mBackend.getGpuLatency();
+    uint64_t first = mFrameIndex >= latency ? mFrameIndex - latency : 0;
+    for (uint64_t index = first; index < mFrameIndex; index++)
+    {
+        Record& record = mHistory[size_t(index % mHistory.size())];
+        if (!record.complete && record.frameIndex == index)
+        {
+            complete(record);
+        }
+    }
+}
+
+void FrameProfiler::clearHistory()
+{
+    // pending frames are dropped, their timers are reused by the next frames anyway
+    for (Record& record : mHistory)
+    {
+        record = Record();
+        record.complete = true;
+        record.frameIndex = ~0ull;
+    }
+}
+
+void FrameProfiler::complete(Record& record)
+{
+    if (mBackend.hasGpuTimers())
+    {
+        for (uint32_t s = 0; s < kNumStages; s++)
+        {
+            if (record.stageMask & (1u << s))
+            {
+                record.gpuMs[s] = mBackend.readGpu(record.frameIndex, FrameStage(s));
+            }
+        }
+    }
+    record.complete = true;
+    writeRecord(record);
+}
+
+void FrameProfiler::writeRecord(const Record& record) const
+{
+    if (!mpJsonStream) return;
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "{\"frame\":%llu,\"mode\":\"%s\",\"debug\":\"%s\",\"frame_cpu_ms\":%.4f",
+                  (unsigned long long)record.frameId, record.renderMode, record.debugMode, record.frameCpuMs);
+    std::string json = buffer;
+    appendStages(json, "cpu_ms", record.cpuMs, record.stageMask);
+    if (mBackend.hasGpuTimers())
+    {
+        appendStages(json, "gpu_ms", record.gpuMs, record.stageMask);
+    }
+    json += "}\n";
+    *mpJsonStream << json;
+}
+
+template<typename Getter>
+FrameProfiler::Percentiles FrameProfiler::computePercentiles(const char* renderMode, const Getter& get) const
+{
+    std::vector<double> values;
+    values.reserve(mHistory.size());
+    for (const Record& record : mHistory)
+    {
+        double value;
+        if (record.complete && record.frameIndex < mFrameIndex && matchesMode(record.renderMode, renderMode) && get(record, value))
+        {
+            values.push_back(value);
+        }
+    }
+
+    Percentiles p;
+    if (values.empty()) return p;
+    std::sort(values.begin(), values.end());
+    p.count = uint32_t(values.size());
+    double sum = 0;
+    for (double v : values) sum += v;
+    p.mean = sum / values.size();
+    p.p50 = percentile(values, 0.5);
+    p.p90 = percentile(values, 0.9);
+    p.p99 = percentile(values, 0.99);
+    p.max = values.back();
+    return p;
+}
+
+FrameProfiler::Percentiles FrameProfiler::getPercentiles(FrameStage stage, bool gpu, const char* renderMode) const
+{
+    uint32_t s = uint32_t(stage);
+    return computePercentiles(renderMode, [&](const Record& record, double& value)
+    {
+        if (!(record.stageMask & (1u << s))) return false;
+        value = gpu ? record.gpuMs[s] : record.cpuMs[s];
+        return true;
+    });
+}
+
+FrameProfiler::Percentiles FrameProfiler::getFramePercentiles(const char* renderMode) const
+{
+    return computePercentiles(renderMode, [](const Record& record, double& value)
+    {
+        value = record.frameCpuMs;
+        return true;
+    });
+}
+
+void FrameProfiler::writeSummary(std::ostream& stream, const char* renderMode) const
+{
+    std::string json = "{\"summary\":\"";
+    json += renderMode ? renderMode : "all";
+    json += "\",";
+    appendPercentiles(json, "frame_cpu_ms", getFramePercentiles(renderMode));
+    for (uint32_t s = 0; s < kNumStages; s++)
+    {
+        Percentiles cpu = getPercentiles(FrameStage(s), false, renderMode);
+        if (cpu.count == 0) continue;
+        json += ",\"";
+        json += kStageNames[s];
+        json += "\":{";
+        appendPercentiles(json, "cpu_ms", cpu);
+        if (mBackend.hasGpuTimers())
+        {
+            json += ",";
+            appendPercentiles(json, "gpu_ms", getPercentiles(FrameStage(s), true, renderMode));
+        }
+        json += "}";
+    }
+    json += "}\n";
+    stream << json;
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+// Per-frame timings of the stages of SimpleDeferred::onFrameRender() (G-buffer, light upload, sample upload,
+// lighting, capture) in a ring buffer, with percentiles per stage and render mode and export as JSON lines.
+// The clock and the device timers come from a FrameTimerBackend: the app uses GpuTimerBackend on top of Falcor's
+// GPU timers, CPU-only tools use CpuTimerBackend, and MockTimerBackend simulates a device with a fixed latency and
+// scripted stage costs so that the profiler produces deterministic output without a GPU.
+// Does not depend on Falcor.
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+enum class FrameStage : uint32_t
+{
+    GBuffer = 0,
+    LightUpload,
+    SampleUpload,
+    Lighting,
+    Capture,
+    Count
+};
+
+/** Name of the stage in the JSON output, e.g. "light_upload"
+*/
+const char* getFrameStageName(FrameStage stage);
+
+class FrameTimerBackend
+{
+public:
+    virtual ~FrameTimerBackend() {}
+
+    /** Milliseconds on a monotonic CPU clock
+    */
+    virtual double getCpuTimeMs() = 0;
+
+    /** False if the backend has no device timers, the profiler then only records CPU times
+    */
+    virtual bool hasGpuTimers() const = 0;
+
+    /** Frames after which the device time of a frame can be read without stalling. Results of a frame must stay
+        readable until that many frames have been begun after it.
+    */
+    virtual uint32_t getGpuLatency() const = 0;
+
+    /** Bracket the device work of a stage, frameIndex counts the frames of the profiler from 0
+    */
+    virtual void beginGpu(uint64_t frameIndex, FrameStage stage) = 0;
+    virtual void endGpu(uint64_t frameIndex, FrameStage stage) = 0;
+
+    /** Device milliseconds of a stage that was bracketed in frameIndex
+    */
+    virtual double readGpu(uint64_t frameIndex, FrameStage stage) = 0;
+};
+
+/** std::chrono::steady_clock, no device timers
+*/
+class CpuTimerBackend : public FrameTimerBackend
+{
+public:
+    double getCpuTimeMs() override;
+    bool hasGpuTimers() const override { return false; }
+    uint32_t getGpuLatency() const override { return 0; }
+    void beginGpu(uint64_t, FrameStage) override {}
+    void endGpu(uint64_t, FrameStage) override {}
+    double readGpu(uint64_t, FrameStage) override { return 0; }
+};
+
+/** Simulated device for headless runs. The CPU clock only moves with advance(), every bracketed stage costs the
+    device the time set with setGpuCost() and the results of a frame are released after the given latency.
+*/
+class MockTimerBackend : public FrameTimerBackend
+{
+public:
+    explicit MockTimerBackend(uint32_t latency = 2);
+
+    void advance(double ms) { mCpuTimeMs += ms; }
+    void setGpuCost(FrameStage stage, double ms) { mGpuCost[uint32_t(stage)] = ms; }
+
+    double getCpuTimeMs() override { return mCpuTimeMs; }
+    bool hasGpuTimers() const override { return true; }
+    uint32_t getGpuLatency() const override { return mLatency; }
+    void beginGpu(uint64_t frameIndex, FrameStage stage) override;
+    void endGpu(uint64_t frameIndex, FrameStage stage) override;
+    double readGpu(uint64_t frameIndex, FrameStage stage) override;
+
+private:
+    uint32_t mLatency;
+    double mCpuTimeMs = 0;
+    double mGpuCost[uint32_t(FrameStage::Count)] = {};
+    // one slot per stage and frame in flight, reused like a pool of timestamp queries
+    std::vector<double> mSlots;
+};
+
+class FrameProfiler
+{
+public:
+    struct Percentiles
+    {
+        uint32_t count = 0;     ///< Frames that ran the stage
+        double mean = 0;
+        double p50 = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double max = 0;
+    };
+
+    /** Times the stages between begin and end of the scope
+    */
+    class Scope
+    {
+    public:
+        Scope(FrameProfiler& profiler, FrameStage stage) : mProfiler(profiler), mStage(stage) { mProfiler.beginStage(stage); }
+        ~Scope() { mProfiler.endStage(mStage); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameProfiler& mProfiler;
+        FrameStage mStage;
+    };
+
+    /** \param[in] backend Clock and device timers, must outlive the profiler
+        \param[in] historySize Frames kept for the percentiles, at least the GPU latency + 1
+    */
+    explicit FrameProfiler(FrameTimerBackend& backend, uint32_t historySize = 512);
+
+    /** Start a frame. renderMode and debugMode are written to the JSON and select the frames of getPercentiles(),
+        they must point to strings that outlive the profiler, e.g. literals.
+    */
+    void beginFrame(uint64_t frameId, const char* renderMode, const char* debugMode);
+
+    /** A stage may be timed at most once per frame, stages that don't run in a frame are left out
+    */
+    void beginStage(FrameStage stage);
+    void endStage(FrameStage stage);
+
+    /** Finish the frame, collect the device times that became available and write the frames that are complete
+        to the JSON stream
+    */
+    void endFrame();
+
+    /** Read the device times of all pending frames, which may stall the device, and write them out
+    */
+    void flush();
+
+    /** Write one JSON object per completed frame to the stream, nullptr to stop
+    */
+    void setJsonStream(std::ostream* pStream) { mpJsonStream = pStream; }
+
+    /** Percentiles of the completed frames in the history
+        \param[in] renderMode Only frames of this render mode, nullptr for all
+        \param[in] gpu Device instead of CPU time
+    */
+    Percentiles getPercentiles(FrameStage stage, bool gpu, const char* renderMode = nullptr) const;
+
+    /** Percentiles of the CPU time from beginFrame() to endFrame()
+    */
+    Percentiles getFramePercentiles(const char* renderMode = nullptr) const;
+
+    /** One JSON object with the percentiles of every stage, for the frames of renderMode or all frames
+    */
+    void writeSummary(std::ostream& stream, const char* renderMode = nullptr) const;
+
+    uint64_t getFrameCount() const { return mFrameIndex; }
+
+    /** Forget the recorded frames, e.g. after a mode switch. Frames still waiting for their device times are
+        dropped. Call between frames.
+    */
+    void clearHistory();
+
+private:
+    struct Record
+    {
+        uint64_t frameIndex = 0;
+        uint64_t frameId = 0;
+        const char* renderMode = "";
+        const char* debugMode = "";
+        uint32_t stageMask = 0;
+        bool complete = false;
+        double frameCpuMs = 0;
+        double cpuMs[uint32_t(FrameStage::Count)] = {};
+        double gpuMs[uint32_t(FrameStage::Count)] = {};
+    };
+
+    template<typename Getter>
+    Percentiles computePercentiles(const char* renderMode, const Getter& get) const;
+    void complete(Record& record);
+    void writeRecord(const Record& record) const;
+
+    FrameTimerBackend& mBackend;
+    std::vector<Record> mHistory;
+    uint64_t mFrameIndex = 0;
+    bool mInFrame = false;
+    double mFrameStartMs = 0;
+    double mStageStartMs[uint32_t(FrameStage::Count)] = {};
+    std::ostream* mpJsonStream = nullptr;
+};
@@ -0,0 +1,29 @@
+#include "GpuTimerBackend.h"
+
+GpuTimerBackend::GpuTimerBackend()
+{
+    for (GpuTimer::SharedPtr& pTimer : mTimers)
+    {
+        pTimer = GpuTimer::create();
+    }
+}
+
+GpuTimer::SharedPtr& GpuTimerBackend::getTimer(uint64_t frameIndex, FrameStage stage)
+{
+    return mTimers[size_t(frameIndex % (kLatency + 1)) * uint32_t(FrameStage::Count) + uint32_t(stage)];
+}
+
+void GpuTimerBackend::beginGpu(uint64_t frameIndex, FrameStage stage)
+{
+    getTimer(frameIndex, stage)->begin();
+}
+
+void GpuTimerBackend::endGpu(uint64_t frameIndex, FrameStage stage)
+{
+    getTimer(frameIndex, stage)->end();
+}
+
+double GpuTimerBackend::readGpu(uint64_t frameIndex, FrameStage stage)
+{
+    return getTimer(frameIndex, stage)->getElapsedTime();
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <Falcor.h>
+#include "FrameProfiler.h"
+#include <array>
+
+using namespace Falcor;
+
+/** FrameTimerBackend on Falcor's GPU timers. Every stage has one timer per frame in flight, a frame's timers are read
+    kLatency frames later, when the queries have long been resolved, and reused in the frame after that.
+*/
+class GpuTimerBackend : public FrameTimerBackend
+{
+public:
+    static const uint32_t kLatency = 3;
+
+    GpuTimerBackend();
+
+    double getCpuTimeMs() override { return mCpuTimer.getCpuTimeMs(); }
+    bool hasGpuTimers() const override { return true; }
+    uint32_t getGpuLatency() const override { return kLatency; }
+    void beginGpu(uint64_t frameIndex, FrameStage stage) override;
+    void endGpu(uint64_t frameIndex, FrameStage stage) override;
+    double readGpu(uint64_t frameIndex, FrameStage stage) override;
+
+private:
+    GpuTimer::SharedPtr& getTimer(uint64_t frameIndex, FrameStage stage);
+
+    CpuTimerBackend mCpuTimer;
+    std::array<GpuTimer::SharedPtr, (kLatency + 1) * uint32_t(FrameStage::Count)> mTimers;
+};
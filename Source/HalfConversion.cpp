@@ -0,0 +1,117 @@
+#include "HalfConversion.h"
+#include "Reference/Half.h"
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define HALF_CONVERSION_F16C 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HALF_CONVERSION_SSE2 1
+#endif
+
+namespace
+{
+#if defined(HALF_CONVERSION_F16C)
+
+    inline void storeHalf8(__m256 v, uint16_t* out)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+
+#elif defined(HALF_CONVERSION_SSE2)
+
+    // branchless version of ltsh::floatToHalf for 4 lanes, denormals are rounded by adding a magic number
+    // see https://gist.github.com/rygorous/2156668
+    inline __m128i floatToHalf4(__m128 f)
+    {
+        const __m128i signMask = _mm_set1_epi32(int(0x80000000u));
+        const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);
+        const __m128i f32Infinity = _mm_set1_epi32(255 << 23);
+        const __m128i minNormal = _mm_set1_epi32(113 << 23);
+        const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i rebias = _mm_set1_epi32(int((uint32_t(15 - 127) << 23) + 0xfff));
+        const __m128i one = _mm_set1_epi32(1);
+
+        __m128i x = _mm_castps_si128(f);
+        __m128i sign = _mm_and_si128(x, signMask);
+        x = _mm_xor_si128(x, sign);
+
+        // NaN -> quiet NaN, overflow -> infinity
+        __m128i special = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(_mm_cmpgt_epi32(x, f32Infinity), _mm_set1_epi32(0x200)));
+        // denormals and zero
+        __m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x), _mm_castsi128_ps(denormMagic))), denormMagic);
+        // normalized numbers, round to nearest even
+        __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(x, 13), one);
+        __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x, rebias), mantissaOdd), 13);
+
+        __m128i isSpecial = _mm_cmpgt_epi32(f16Max, x);  // inverted, all bits set where not special
+        __m128i isDenorm = _mm_cmpgt_epi32(minNormal, x);
+        __m128i finite = _mm_or_si128(_mm_and_si128(isDenorm, denorm), _mm_andnot_si128(isDenorm, normal));
+        __m128i result = _mm_or_si128(_mm_and_si128(isSpecial, finite), _mm_andnot_si128(isSpecial, special));
+        return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+    }
+
+    inline void storeHalf8(__m128 lo, __m128 hi, uint16_t* out)
+    {
+        // sign extend the low 16 bits so the saturating pack keeps them unchanged
+        __m128i a = _mm_srai_epi32(_mm_slli_epi32(floatToHalf4(lo), 16), 16);
+        __m128i b = _mm_srai_epi32(_mm_slli_epi32(floatToHalf4(hi), 16), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(a, b));
+    }
+
+#endif
+}
+
+void convertDoubleToHalf(const double* in, size_t count, uint16_t* out)
+{
+    size_t i = 0;
+#if defined(HALF_CONVERSION_F16C)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 v = _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(in + i + 4)), _mm256_cvtpd_ps(_mm256_loadu_pd(in + i)));
+        storeHalf8(v, out + i);
+    }
+#elif defined(HALF_CONVERSION_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 lo = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(in + i)), _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2)));
+        __m128 hi = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(in + i + 4)), _mm_cvtpd_ps(_mm_loadu_pd(in + i + 6)));
+        storeHalf8(lo, hi, out + i);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        out[i] = ltsh::floatToHalf(float(in[i]));
+    }
+}
+
+void convertFloatToHalf(const float* in, size_t count, uint16_t* out)
+{
+    size_t i = 0;
+#if defined(HALF_CONVERSION_F16C)
+    for (; i + 8 <= count; i += 8)
+    {
+        storeHalf8(_mm256_loadu_ps(in + i), out + i);
+    }
+#elif defined(HALF_CONVERSION_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+        storeHalf8(_mm_loadu_ps(in + i), _mm_loadu_ps(in + i + 4), out + i);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        out[i] = ltsh::floatToHalf(in[i]);
+    }
+}
+
+const char* getHalfConversionBackend()
+{
+#if defined(HALF_CONVERSION_F16C)
+    return "F16C";
+#elif defined(HALF_CONVERSION_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
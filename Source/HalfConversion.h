@@ -0,0 +1,59 @@
+#pragma once
+
+// Bulk float/double to half conversion and the reorder + pad kernel that turns per-cell coefficient vectors into
+// RGBA16F texture rows. The converters use F16C when the translation unit is compiled with it (-mf16c, or
+// /arch:AVX2 on MSVC), a branchless SSE2 emulation on other x86-64 targets and ltsh::floatToHalf elsewhere.
+// All backends round to nearest even and produce the same bits as glm::detail::toFloat16 for every non-NaN input.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/** Convert count doubles to half floats, rounding through float like float(in[i]) does
+*/
+void convertDoubleToHalf(const double* in, size_t count, uint16_t* out);
+
+/** Convert count floats to half floats
+*/
+void convertFloatToHalf(const float* in, size_t count, uint16_t* out);
+
+/** Name of the conversion backend compiled in, "F16C", "SSE2" or "scalar"
+*/
+const char* getHalfConversionBackend();
+
+/** Reorder and pad coefficients into RGBA16F texture rows.
+    Input is indexed [theta][alpha][k] with res x res cells of NumCoeffs coefficients. The coefficients of a cell are
+    padded with zeros to Groups = ceil(NumCoeffs / 4) texels and texel g of cell (theta, alpha) is written to column
+    g * res + theta of row alpha, so the output is a (res * Groups) x res RGBA texture.
+    \param[out] out res * res * Groups * 4 halfs
+*/
+template<uint32_t NumCoeffs>
+void packCoeffTiles(const double* in, uint32_t res, uint16_t* out)
+{
+    static const uint32_t kGroups = (NumCoeffs + 3) / 4;
+    const size_t rowSize = size_t(res) * kGroups * 4;
+    // halfs of the last texel that come from the cell, the rest is padding
+    static const uint32_t kLastCount = NumCoeffs - (kGroups - 1) * 4;
+    static const uint64_t kLastMask = kLastCount == 4 ? ~uint64_t(0) : (uint64_t(1) << (16 * kLastCount)) - 1;
+
+    // one converted input row (all alpha cells of one theta), plus room for the over-read of the last texel
+    std::vector<uint16_t> row(size_t(res) * NumCoeffs + 4, 0);
+    for (uint32_t theta = 0; theta < res; theta++)
+    {
+        convertDoubleToHalf(in + size_t(theta) * res * NumCoeffs, size_t(res) * NumCoeffs, row.data());
+        for (uint32_t alpha = 0; alpha < res; alpha++)
+        {
+            const uint16_t* cell = row.data() + alpha * NumCoeffs;
+            uint16_t* dst = out + alpha * rowSize + theta * 4;
+            for (uint32_t g = 0; g < kGroups; g++)
+            {
+                // one texel is 4 halfs, move it as a single 64 bit word
+                uint64_t texel;
+                std::memcpy(&texel, cell + g * 4, sizeof(texel));
+                if (g == kGroups - 1) texel &= kLastMask;
+                std::memcpy(dst + size_t(g) * res * 4, &texel, sizeof(texel));
+            }
+        }
+    }
+}
@@ -0,0 +1,249 @@
+#include "LutBundle.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace
+{
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    std::string withSlash(const std::string& dir)
+    {
+        return dir.empty() || dir.back() == '/' || dir.back() == '\\' ? dir : dir + "/";
+    }
+}
+
+bool readLutSourceStamp(const std::string& filename, LutSourceStamp& stamp)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) return false;
+
+    // magic, version and header length, see MappedNumpyArray; only the header is read, not the payload
+    std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+    uint8_t prefix[12] = {};
+    if (!stream.read(reinterpret_cast<char*>(prefix), sizeof(prefix)) || std::memcmp(prefix, "\x93NUMPY", 6) != 0) return false;
+    size_t headerEnd = prefix[6] == 1 ? 10 + (size_t(prefix[8]) | size_t(prefix[9]) << 8)
+                                      : 12 + (size_t(prefix[8]) | size_t(prefix[9]) << 8 | size_t(prefix[10]) << 16 | size_t(prefix[11]) << 24);
+    if (headerEnd > uint64_t(st.st_size)) return false;
+    std::vector<char> header(headerEnd);
+    stream.seekg(0);
+    if (!stream.read(header.data(), header.size())) return false;
+
+    stamp.size = uint64_t(st.st_size);
+    stamp.mtime = uint64_t(st.st_mtime);
+    stamp.headerChecksum = computeLutChecksum(header.data(), header.size());
+    return true;
+}
+
+uint64_t computeLutChecksum(const void* pData, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(pData);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void writeLutBundle(const std::string& filename, const std::vector<PackedLut>& tables)
+{
+    std::vector<LutBundleTableDesc> descs(tables.size());
+    uint64_t offset = alignUp(sizeof(LutBundleHeader) + sizeof(LutBundleTableDesc) * tables.size(), kLutBundleAlignment);
+    for (size_t i = 0; i < tables.size(); i++)
+    {
+        const PackedLut& table = tables[i];
+        if (table.name.size() >= sizeof(descs[i].name))
+        {
+            throw std::runtime_error("table name too long: " + table.name);
+        }
+        if (table.data.size() != size_t(table.width) * table.height * uint32_t(table.format))
+        {
+            throw std::runtime_error("table size does not match its dimensions: " + table.name);
+        }
+        LutBundleTableDesc& desc = descs[i];
+        std::memset(&desc, 0, sizeof(desc));
+        std::memcpy(desc.name, table.name.c_str(), table.name.size());
+        desc.format = uint32_t(table.format);
+        desc.width = table.width;
+        desc.height = table.height;
+        desc.offset = offset;
+        desc.size = table.data.size() * sizeof(uint16_t);
+        desc.checksum = computeLutChecksum(table.data.data(), (size_t)desc.size);
+        if (!table.sourceFile.empty())
+        {
+            LutSourceStamp stamp;
+            if (!readLutSourceStamp(table.sourceFile, stamp))
+            {
+                throw std::runtime_error("io error: failed to read the .npy header of " + table.sourceFile);
+            }
+            MappedFile source(table.sourceFile);
+            desc.sourceSize = stamp.size;
+            desc.sourceChecksum = computeLutChecksum(source.data(), source.size());
+            desc.sourceMTime = stamp.mtime;
+            desc.sourceHeaderChecksum = stamp.headerChecksum;
+        }
+        offset = alignUp(offset + desc.size, kLutBundleAlignment);
+    }
+
+    LutBundleHeader header;
+    std::memcpy(header.magic, kLutBundleMagic, sizeof(header.magic));
+    header.version = kLutBundleVersion;
+    header.tableCount = (uint32_t)tables.size();
+    header.descChecksum = computeLutChecksum(descs.data(), descs.size() * sizeof(LutBundleTableDesc));
+
+    std::vector<char> out(sizeof(header) + descs.size() * sizeof(LutBundleTableDesc));
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), descs.data(), descs.size() * sizeof(LutBundleTableDesc));
+    for (size_t i = 0; i < tables.size(); i++)
+    {
+        out.resize((size_t)descs[i].offset, 0);
+        const char* pData = reinterpret_cast<const char*>(tables[i].data.data());
+        out.insert(out.end(), pData, pData + descs[i].size);
+    }
+
+    std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        throw std::runtime_error("io error: failed to open " + filename);
+    }
+    stream.write(out.data(), out.size());
+    if (!stream)
+    {
+        throw std::runtime_error("io error: failed to write " + filename);
+    }
+}
+
+LutBundle::LutBundle(const std::string& filename)
+    : mFile(filename)
+{
+    const uint8_t* pData = mFile.data();
+    const size_t size = mFile.size();
+
+    LutBundleHeader header;
+    if (size < sizeof(header))
+    {
+        throw std::runtime_error("formatting error: " + filename + " is not a LUT bundle");
+    }
+    std::memcpy(&header, pData, sizeof(header));
+    if (std::memcmp(header.magic, kLutBundleMagic, sizeof(header.magic)) != 0)
+    {
+        throw std::runtime_error("formatting error: " + filename + " is not a LUT bundle");
+    }
+    if (header.version != kLutBundleVersion)
+    {
+        throw std::runtime_error("formatting error: " + filename + " has version " + std::to_string(header.version) + ", expected " + std::to_string(kLutBundleVersion));
+    }
+
+    const size_t descSize = size_t(header.tableCount) * sizeof(LutBundleTableDesc);
+    if (sizeof(header) + descSize > size)
+    {
+        throw std::runtime_error("formatting error: truncated table descriptors in " + filename);
+    }
+    const uint8_t* pDescs = pData + sizeof(header);
+    if (computeLutChecksum(pDescs, descSize) != header.descChecksum)
+    {
+        throw std::runtime_error("formatting error: descriptor checksum mismatch in " + filename);
+    }
+
+    for (uint32_t i = 0; i < header.tableCount; i++)
+    {
+        LutBundleTableDesc desc;
+        std::memcpy(&desc, pDescs + i * sizeof(desc), sizeof(desc));
+        desc.name[sizeof(desc.name) - 1] = 0;
+
+        const uint64_t expectedSize = uint64_t(desc.width) * desc.height * desc.format * sizeof(uint16_t);
+        if ((desc.format != uint32_t(LutFormat::R16Float) && desc.format != uint32_t(LutFormat::RGBA16Float)) || desc.size != expectedSize)
+        {
+            throw std::runtime_error(std::string("formatting error: invalid descriptor for ") + desc.name + " in " + filename);
+        }
+        if (desc.offset % kLutBundleAlignment != 0 || desc.offset > size || desc.size > size - desc.offset)
+        {
+            throw std::runtime_error(std::string("formatting error: payload of ") + desc.name + " out of bounds in " + filename);
+        }
+
+        Table table;
+        table.name = desc.name;
+        table.format = LutFormat(desc.format);
+        table.width = desc.width;
+        table.height = desc.height;
+        table.data = ArraySpan<uint16_t>(reinterpret_cast<const uint16_t*>(pData + desc.offset), size_t(desc.size / sizeof(uint16_t)));
+        table.checksum = desc.checksum;
+        table.sourceChecksum = desc.sourceChecksum;
+        table.sourceStamp.size = desc.sourceSize;
+        table.sourceStamp.mtime = desc.sourceMTime;
+        table.sourceStamp.headerChecksum = desc.sourceHeaderChecksum;
+        mTables.push_back(table);
+    }
+}
+
+const LutBundle::Table* LutBundle::findTable(const std::string& name) const
+{
+    for (const Table& table : mTables)
+    {
+        if (table.name == name) return &table;
+    }
+    return nullptr;
+}
+
+bool LutBundle::isUpToDate(const std::string& paramDir) const
+{
+    std::string dir = withSlash(paramDir);
+    for (int i = 0; i < LutTableCount; i++)
+    {
+        const LutTableInfo& info = getLutTableInfo(LutTable(i));
+        const Table* pTable = findTable(info.name);
+        if (!pTable) return false;
+
+        LutSourceStamp stamp;
+        std::string sourceFile = dir + info.filename;
+        if (!readLutSourceStamp(sourceFile, stamp))
+        {
+            // a missing source is fine, one that is no .npy file is not
+            struct stat st;
+            if (stat(sourceFile.c_str(), &st) != 0) continue;
+            return false;
+        }
+        if (stamp.size != pTable->sourceStamp.size || stamp.mtime != pTable->sourceStamp.mtime || stamp.headerChecksum != pTable->sourceStamp.headerChecksum)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LutBundle::verify(const std::string& paramDir) const
+{
+    std::string dir = withSlash(paramDir);
+    for (const Table& table : mTables)
+    {
+        if (computeLutChecksum(table.data.data(), table.data.size() * sizeof(uint16_t)) != table.checksum)
+        {
+            throw std::runtime_error("checksum mismatch for the payload of " + table.name);
+        }
+    }
+    for (int i = 0; i < LutTableCount; i++)
+    {
+        const LutTableInfo& info = getLutTableInfo(LutTable(i));
+        const Table* pTable = findTable(info.name);
+        if (!pTable)
+        {
+            throw std::runtime_error(std::string("missing table ") + info.name);
+        }
+        std::string sourceFile = dir + info.filename;
+        struct stat st;
+        if (stat(sourceFile.c_str(), &st) != 0) continue;
+        MappedFile source(sourceFile);
+        if (source.size() != pTable->sourceStamp.size || computeLutChecksum(source.data(), source.size()) != pTable->sourceChecksum)
+        {
+            throw std::runtime_error(std::string("table ") + info.name + " was packed from another version of " + sourceFile);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// Versioned binary bundle holding all lookup tables in their final texture layout (half floats, reordered and
+// padded), so startup is a single file mapping followed by the texture uploads.
+//
+// Layout (little endian):
+//   LutBundleHeader
+//   LutBundleTableDesc[tableCount]
+//   payloads, each starting at a multiple of kLutBundleAlignment
+// The header checksum covers the descriptors, every descriptor carries the checksum of its payload, the checksum of
+// the .npy file it was packed from and a stamp of that file: size, mtime and a checksum of the .npy header. Startup
+// only compares the stamps, which reads the headers but not the float64 payloads. The mtime is only compared for
+// equality, never for order (checkouts, copies and unpacked archives don't preserve the order of the mtimes), so a
+// touched source costs one rebuild of the bundle. verify() checks the full checksums, lut_pack --check runs it.
+
+#include "LutPacking.h"
+#include "MappedNumpy.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+static const char kLutBundleMagic[8] = { 'L', 'T', 'S', 'H', 'L', 'U', 'T', 0 };
+static const uint32_t kLutBundleVersion = 3;
+static const uint64_t kLutBundleAlignment = 64;
+
+struct LutBundleHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t tableCount;
+    uint64_t descChecksum;      // checksum of the table descriptors
+};
+
+struct LutBundleTableDesc
+{
+    char name[32];
+    uint32_t format;            // LutFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t offset;            // payload offset from the start of the file
+    uint64_t size;              // payload size in bytes
+    uint64_t checksum;          // checksum of the payload
+    uint64_t sourceSize;        // size of the source .npy file in bytes, 0 if the table has none
+    uint64_t sourceChecksum;    // checksum of the whole source .npy file
+    uint64_t sourceMTime;       // last modification of the source file, seconds since the epoch
+    uint64_t sourceHeaderChecksum; // checksum of the .npy header of the source file, dtype and shape
+};
+
+/** Cheap identification of a source .npy file, compared at startup instead of hashing the whole file
+*/
+struct LutSourceStamp
+{
+    uint64_t size = 0;
+    uint64_t mtime = 0;
+    uint64_t headerChecksum = 0;
+};
+
+/** Stat the file and hash its .npy header. Returns false if the file does not exist or is not a .npy file.
+*/
+bool readLutSourceStamp(const std::string& filename, LutSourceStamp& stamp);
+
+/** 64 bit FNV-1a hash used for the bundle checksums
+*/
+uint64_t computeLutChecksum(const void* pData, size_t size);
+
+/** Write the tables to a bundle file, the source files of the tables are hashed into the descriptors.
+    Throws std::runtime_error on IO errors.
+*/
+void writeLutBundle(const std::string& filename, const std::vector<PackedLut>& tables);
+
+/** Memory mapped bundle. The descriptors are validated on open, the table data points into the mapping. The payload
+    checksums are only checked by verify().
+*/
+class LutBundle
+{
+public:
+    struct Table
+    {
+        std::string name;
+        LutFormat format;
+        uint32_t width;
+        uint32_t height;
+        ArraySpan<uint16_t> data;
+        uint64_t checksum;
+        uint64_t sourceChecksum;
+        LutSourceStamp sourceStamp;
+    };
+
+    /** Map and validate the bundle. Throws std::runtime_error if the file is missing, of a different version or its
+        descriptors are corrupt.
+    */
+    explicit LutBundle(const std::string& filename);
+
+    const std::vector<Table>& getTables() const { return mTables; }
+
+    /** Find a table by name, returns nullptr if the bundle does not contain it
+    */
+    const Table* findTable(const std::string& name) const;
+
+    /** Returns true if the bundle holds every table of LutTable and the stamp of each source file in paramDir equals
+        the one recorded when packing. Tables whose source file is missing are accepted, so a bundle can ship without
+        the .npy files.
+    */
+    bool isUpToDate(const std::string& paramDir) const;
+
+    /** Full check that reads everything: the payload checksums, and the checksums of the source files in paramDir
+        that exist. Throws std::runtime_error naming the first table that does not match.
+    */
+    void verify(const std::string& paramDir) const;
+
+private:
+    MappedFile mFile;
+    std::vector<Table> mTables;
+};
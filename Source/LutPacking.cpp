@@ -0,0 +1,114 @@
+#include "LutPacking.h"
+#include "HalfConversion.h"
+#include "Reference/Half.h"
+
+#include <stdexcept>
+
+namespace
+{
+    const LutTableInfo kLutTables[LutTableCount] =
+    {
+        { "ltcMInv",     "inv_cos_mat_t128.npy",    LutFormat::RGBA16Float, 4 },
+        { "ltcCoeff",    "cos_coeff_t128.npy",      LutFormat::R16Float,    1 },
+        { "ltshMInv",    "inv_sh_mat_n4_t128.npy",  LutFormat::RGBA16Float, 4 },
+        { "ltshCoeff",   "sh_coeff_n4_t128.npy",    LutFormat::RGBA16Float, 25 },
+        { "ltshMInvN2",  "inv_sh_mat_n2_t128.npy",  LutFormat::RGBA16Float, 4 },
+        { "ltshCoeffN2", "sh_coeff_n2_t128.npy",    LutFormat::RGBA16Float, 9 },
+    };
+}
+
+const LutTableInfo& getLutTableInfo(LutTable table)
+{
+    return kLutTables[table];
+}
+
+uint32_t getLutTextureWidth(LutTable table, uint32_t resolution)
+{
+    const LutTableInfo& info = kLutTables[table];
+    uint32_t channels = uint32_t(info.format);
+    return resolution * ((info.valuesPerCell + channels - 1) / channels);
+}
+
+void convertToHalf(ArraySpan<double> in, std::vector<uint16_t>& out)
+{
+    out.resize(in.size());
+    convertDoubleToHalf(in.data(), in.size(), out.data());
+}
+
+void convertToHalf(ArraySpan<float> in, std::vector<uint16_t>& out)
+{
+    out.resize(in.size());
+    convertFloatToHalf(in.data(), in.size(), out.data());
+}
+
+void packLtshCoeffs(ArraySpan<double> in, uint32_t resolution, uint32_t numCoeffs, std::vector<uint16_t>& out)
+{
+    // we only need numCoeffs coefficients but to fit the RGBA texture we pad to a multiple of 4
+    const uint32_t res = resolution;
+    const uint32_t groups = (numCoeffs + 3) / 4;
+    const size_t rowSize = size_t(res) * groups * 4;
+    if (in.size() != size_t(res) * res * numCoeffs)
+    {
+        throw std::runtime_error("packLtshCoeffs: input size does not match the resolution and coefficient count");
+    }
+
+    // the coefficient counts of the fitted tables have specialized kernels
+    switch (numCoeffs)
+    {
+    case 25:
+        out.resize(res * rowSize);
+        packCoeffTiles<25>(in.data(), res, out.data());
+        return;
+    case 9:
+        out.resize(res * rowSize);
+        packCoeffTiles<9>(in.data(), res, out.data());
+        return;
+    }
+
+    out.assign(res * rowSize, ltsh::floatToHalf(0.f));
+    for (uint32_t alpha = 0; alpha < res; alpha++)
+    {
+        for (uint32_t theta = 0; theta < res; theta++)
+        {
+            const double* cell = in.data() + (size_t(theta) * res + alpha) * numCoeffs;
+            for (uint32_t k = 0; k < numCoeffs; k++)
+            {
+                // order has to be rewritten to match texture format
+                out[alpha * rowSize + (k / 4) * res * 4 + theta * 4 + (k % 4)] = ltsh::floatToHalf(float(cell[k]));
+            }
+        }
+    }
+}
+
+PackedLut packLookupTable(LutTable table, const std::string& paramDir)
+{
+    const LutTableInfo& info = kLutTables[table];
+    std::string dir = paramDir.empty() || paramDir.back() == '/' || paramDir.back() == '\\' ? paramDir : paramDir + "/";
+    MappedNumpyArray file(dir + info.filename);
+
+    // the resolution comes from the header, every table may be refitted at another resolution
+    uint32_t res = getLutResolution(file.getShape(), info.valuesPerCell);
+    if (res == 0)
+    {
+        throw std::runtime_error("formatting error: " + file.getFilename() + " is not a square table of " + std::to_string(info.valuesPerCell) + " values per cell");
+    }
+
+    PackedLut lut;
+    lut.name = info.name;
+    lut.format = info.format;
+    lut.width = getLutTextureWidth(table, res);
+    lut.height = res;
+    lut.sourceFile = file.getFilename();
+
+    switch (table)
+    {
+    case LtshCoeff:
+    case LtshCoeffN2:
+        packLtshCoeffs(file.getData<double>({ res, res, info.valuesPerCell }), res, info.valuesPerCell, lut.data);
+        break;
+    default:
+        convertToHalf(file.getData<double>(), lut.data);
+        break;
+    }
+    return lut;
+}
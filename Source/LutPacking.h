@@ -0,0 +1,93 @@
+#pragma once
+
+// Conversion of the fitted LTC/LTSH tables in Data/Params into the half float texture layouts the lighting pass
+// samples. Shared by SimpleDeferred (when no up-to-date bundle exists) and the offline packer in Source/Tools.
+
+#include "MappedNumpy.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Texel format of a packed table, the value is the channel count
+*/
+enum class LutFormat : uint32_t
+{
+    R16Float = 1,
+    RGBA16Float = 4,
+};
+
+/** Texture-ready table: half floats, reordered and padded to whole RGBA texels
+*/
+struct PackedLut
+{
+    std::string name;
+    LutFormat format = LutFormat::RGBA16Float;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint16_t> data;
+    std::string sourceFile;     // .npy file the table was packed from, empty if it has none
+};
+
+/** The six tables in the order SimpleDeferred binds them
+*/
+enum LutTable
+{
+    LtcMInv = 0,
+    LtcCoeff,
+    LtshMInv,
+    LtshCoeff,
+    LtshMInvN2,
+    LtshCoeffN2,
+    LutTableCount
+};
+
+/** Description of a table: bundle name, source file, texel format and the number of values per (theta, alpha) cell.
+    The resolution is not fixed, it comes from the shape of the source file.
+*/
+struct LutTableInfo
+{
+    const char* name;
+    const char* filename;
+    LutFormat format;
+    uint32_t valuesPerCell;
+};
+
+const LutTableInfo& getLutTableInfo(LutTable table);
+
+/** Width of the texture of a table with resolution x resolution cells, the height is the resolution
+*/
+uint32_t getLutTextureWidth(LutTable table, uint32_t resolution);
+
+/** Resolution of a square (theta, alpha) table from its .npy shape, either flat (res * res * valuesPerCell values) like
+    the matrix tables or (res, res, valuesPerCell) like the coefficient tables. Returns 0 if the shape is not square.
+*/
+inline uint32_t getLutResolution(const std::vector<size_t>& shape, uint32_t valuesPerCell)
+{
+    size_t count = 1;
+    for (size_t dim : shape) count *= dim;
+    if (shape.empty() || valuesPerCell == 0 || count % valuesPerCell != 0) return 0;
+    size_t cells = count / valuesPerCell;
+    size_t res = 1;
+    while (res * res < cells) res++;
+    if (res * res != cells || res < 2) return 0;
+    if (shape.size() > 1 && (shape[0] != res || shape[1] != res)) return 0;
+    return uint32_t(res);
+}
+
+/** Convert to half floats, out is resized to the input size
+*/
+void convertToHalf(ArraySpan<double> in, std::vector<uint16_t>& out);
+void convertToHalf(ArraySpan<float> in, std::vector<uint16_t>& out);
+
+/** Reorder LTSH coefficients from the [theta][alpha][k] fitting layout into RGBA texels. The coefficients are padded
+    to a multiple of 4 and texel group g of cell (theta, alpha) goes to (g * res + theta, alpha) of a res*groups x res texture.
+    \param[in] in Coefficients, shape (res, res, numCoeffs)
+    \param[in] resolution Cells along theta and alpha
+    \param[in] numCoeffs Coefficients per cell, 25 for N=4 and 9 for N=2
+*/
+void packLtshCoeffs(ArraySpan<double> in, uint32_t resolution, uint32_t numCoeffs, std::vector<uint16_t>& out);
+
+/** Load one table from its .npy file and convert it to the texture layout. Throws std::runtime_error on malformed input.
+    \param[in] paramDir Directory containing the .npy files, e.g. Data/Params
+*/
+PackedLut packLookupTable(LutTable table, const std::string& paramDir);
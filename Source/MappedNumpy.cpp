@@ -0,0 +1,234 @@
+#include "MappedNumpy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("io error: failed to open " + filename);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        throw std::runtime_error("io error: failed to map " + filename);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* pData = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!pData)
+    {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("io error: failed to map " + filename);
+    }
+    mFileHandle = file;
+    mMappingHandle = mapping;
+    mpData = pData;
+    mSize = (size_t)size.QuadPart;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("io error: failed to open " + filename);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("io error: failed to map " + filename);
+    }
+    void* pData = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+    if (pData == MAP_FAILED)
+    {
+        throw std::runtime_error("io error: failed to map " + filename);
+    }
+    mpData = pData;
+    mSize = (size_t)st.st_size;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(mpData, other.mpData);
+        std::swap(mSize, other.mSize);
+#ifdef _WIN32
+        std::swap(mFileHandle, other.mFileHandle);
+        std::swap(mMappingHandle, other.mMappingHandle);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::close()
+{
+    if (!mpData) return;
+#ifdef _WIN32
+    UnmapViewOfFile(mpData);
+    CloseHandle(mMappingHandle);
+    CloseHandle(mFileHandle);
+    mFileHandle = nullptr;
+    mMappingHandle = nullptr;
+#else
+    munmap(mpData, mSize);
+#endif
+    mpData = nullptr;
+    mSize = 0;
+}
+
+namespace
+{
+    // value of a python literal following key in the header dict, e.g. "'<f8'" for 'descr'
+    std::string findValue(const std::string& header, const std::string& key, const std::string& filename)
+    {
+        size_t loc = header.find("'" + key + "'");
+        if (loc == std::string::npos) throw std::runtime_error("formatting error: " + key + " missing in " + filename);
+        loc = header.find(':', loc);
+        if (loc == std::string::npos) throw std::runtime_error("formatting error: " + key + " missing in " + filename);
+        loc = header.find_first_not_of(' ', loc + 1);
+        if (loc == std::string::npos) throw std::runtime_error("formatting error: " + key + " missing in " + filename);
+
+        size_t end;
+        if (header[loc] == '(') end = header.find(')', loc) + 1;
+        else if (header[loc] == '\'') end = header.find('\'', loc + 1) + 1;
+        else end = header.find_first_of(",}", loc);
+        if (end == std::string::npos || end == 0) throw std::runtime_error("formatting error: malformed header in " + filename);
+        return header.substr(loc, end - loc);
+    }
+}
+
+MappedNumpyArray::MappedNumpyArray(const std::string& filename)
+    : mFile(filename), mFilename(filename)
+{
+    const uint8_t* pData = mFile.data();
+    const size_t size = mFile.size();
+
+    // magic string, version and header length
+    if (size < 10 || std::memcmp(pData, "\x93NUMPY", 6) != 0)
+    {
+        throw std::runtime_error("io error: " + filename + " does not have a valid npy format.");
+    }
+    const uint8_t major = pData[6];
+    size_t headerLength;
+    size_t headerOffset;
+    if (major == 1)
+    {
+        headerLength = size_t(pData[8]) | size_t(pData[9]) << 8;
+        headerOffset = 10;
+    }
+    else if ((major == 2 || major == 3) && size >= 12)
+    {
+        headerLength = size_t(pData[8]) | size_t(pData[9]) << 8 | size_t(pData[10]) << 16 | size_t(pData[11]) << 24;
+        headerOffset = 12;
+    }
+    else
+    {
+        throw std::runtime_error("formatting error: unsupported npy version in " + filename);
+    }
+    if (headerOffset + headerLength > size)
+    {
+        throw std::runtime_error("formatting error: truncated header in " + filename);
+    }
+    const std::string header(reinterpret_cast<const char*>(pData) + headerOffset, headerLength);
+    mDataOffset = headerOffset + headerLength;
+
+    // dtype, only native byte order is supported since the data is used in place
+    const std::string descr = findValue(header, "descr", filename);
+    if (descr.size() < 5)
+    {
+        throw std::runtime_error("formatting error: malformed descr in " + filename);
+    }
+    const char byteOrder = descr[1];
+    if (byteOrder != '<' && byteOrder != '|')
+    {
+        throw std::runtime_error("formatting error: difference endian is not supported.");
+    }
+    mTypeChar = descr[2];
+    mWordSize = (size_t)std::stoul(descr.substr(3, descr.size() - 4));
+
+    mFortranOrder = findValue(header, "fortran_order", filename) == "True";
+
+    // shape tuple, e.g. "(64, 64, 25)" or "(4096,)"
+    const std::string shape = findValue(header, "shape", filename);
+    mShape.clear();
+    mElementCount = 1;
+    size_t pos = 1;
+    while (pos < shape.size())
+    {
+        size_t next = shape.find_first_of(",)", pos);
+        std::string dim = shape.substr(pos, next - pos);
+        if (dim.find_first_not_of(' ') != std::string::npos)
+        {
+            mShape.push_back((size_t)std::stoull(dim));
+            mElementCount *= mShape.back();
+        }
+        pos = next + 1;
+    }
+    if (mDataOffset + mElementCount * mWordSize > size)
+    {
+        throw std::runtime_error("formatting error: truncated payload in " + filename);
+    }
+    if (mDataOffset % mWordSize != 0)
+    {
+        throw std::runtime_error("formatting error: misaligned payload in " + filename);
+    }
+}
+
+void MappedNumpyArray::checkType(char typeChar, size_t wordSize) const
+{
+    if (typeChar != mTypeChar || wordSize != mWordSize)
+    {
+        throw std::runtime_error("formatting error: the type of " + mFilename + " is not equal to the requested type");
+    }
+}
+
+void MappedNumpyArray::checkOrder() const
+{
+    // column-major and row-major only agree if at most one dimension is larger than 1
+    if (mFortranOrder && std::count_if(mShape.begin(), mShape.end(), [](size_t dim) { return dim > 1; }) > 1)
+    {
+        throw std::runtime_error("formatting error: " + mFilename + " is stored in Fortran order, which is not supported");
+    }
+}
+
+void MappedNumpyArray::checkShape(const size_t* expectedShape, size_t dims) const
+{
+    if (dims != mShape.size() || !std::equal(mShape.begin(), mShape.end(), expectedShape))
+    {
+        std::string expected;
+        for (size_t i = 0; i < dims; i++)
+        {
+            expected += (i ? ", " : "") + std::to_string(expectedShape[i]);
+        }
+        throw std::runtime_error("formatting error: " + mFilename + " does not have the expected shape (" + expected + ")");
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+// Zero-copy access to .npy files. The file is memory mapped, the header is validated once on open and the payload
+// is exposed as a typed, shape-checked span that points straight into the mapping, so loading a table does not
+// allocate or copy. Use Numpy.hpp to write files or when the data has to outlive the file.
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** Read-only view of a contiguous array, valid as long as the object it was taken from
+*/
+template<typename T>
+class ArraySpan
+{
+public:
+    ArraySpan() {}
+    ArraySpan(const T* pData, size_t size) : mpData(pData), mSize(size) {}
+
+    const T* data() const { return mpData; }
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+
+    const T* begin() const { return mpData; }
+    const T* end() const { return mpData + mSize; }
+    const T& operator[](size_t i) const { return mpData[i]; }
+
+private:
+    const T* mpData = nullptr;
+    size_t mSize = 0;
+};
+
+/** Read-only memory mapping of a whole file
+*/
+class MappedFile
+{
+public:
+    MappedFile() {}
+
+    /** Map the file. Throws std::runtime_error if it can't be opened or mapped.
+    */
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(mpData); }
+    size_t size() const { return mSize; }
+    bool isOpen() const { return mpData != nullptr; }
+
+    /** Unmap the file
+    */
+    void close();
+
+private:
+    void* mpData = nullptr;
+    size_t mSize = 0;
+#ifdef _WIN32
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#endif
+};
+
+/** Memory mapped .npy file (format version 1.0 to 3.0, native byte order)
+*/
+class MappedNumpyArray
+{
+public:
+    MappedNumpyArray() {}
+
+    /** Map the file and parse its header. Throws std::runtime_error if the file is not a valid .npy file.
+    */
+    explicit MappedNumpyArray(const std::string& filename);
+
+    /** Shape of the array as written in the header. The payload of a Fortran order file is column-major, see getData().
+    */
+    const std::vector<size_t>& getShape() const { return mShape; }
+    bool isFortranOrder() const { return mFortranOrder; }
+    size_t getElementCount() const { return mElementCount; }
+    const std::string& getFilename() const { return mFilename; }
+
+    /** Typed view of the payload in C order. Throws std::runtime_error if Scalar does not match the stored type, or if
+        the file is stored in Fortran order and has more than one dimension larger than 1, since the data is used in
+        place and not transposed.
+    */
+    template<typename Scalar>
+    ArraySpan<Scalar> getData() const
+    {
+        checkType(TypeChar<Scalar>::value, sizeof(Scalar));
+        checkOrder();
+        return ArraySpan<Scalar>(reinterpret_cast<const Scalar*>(mFile.data() + mDataOffset), mElementCount);
+    }
+
+    /** Typed view of the payload that additionally checks the shape of the array
+        \param[in] expectedShape Required shape, in C order
+    */
+    template<typename Scalar>
+    ArraySpan<Scalar> getData(std::initializer_list<size_t> expectedShape) const
+    {
+        checkShape(expectedShape.begin(), expectedShape.size());
+        return getData<Scalar>();
+    }
+
+private:
+    template<typename Scalar> struct TypeChar {};
+
+    void checkType(char typeChar, size_t wordSize) const;
+    void checkOrder() const;
+    void checkShape(const size_t* expectedShape, size_t dims) const;
+
+    MappedFile mFile;
+    std::string mFilename;
+    std::vector<size_t> mShape;
+    size_t mElementCount = 0;
+    size_t mDataOffset = 0;
+    char mTypeChar = 0;
+    size_t mWordSize = 0;
+    bool mFortranOrder = false;
+};
+
+template<> struct MappedNumpyArray::TypeChar<double> { static const char value = 'f'; };
+template<> struct MappedNumpyArray::TypeChar<float> { static const char value = 'f'; };
+template<> struct MappedNumpyArray::TypeChar<uint16_t> { static const char value = 'u'; };
+template<> struct MappedNumpyArray::TypeChar<int32_t> { static const char value = 'i'; };
@@ -0,0 +1,264 @@
+#include "PolygonSampler.h"
+#include "PolygonShape.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POLYGON_SAMPLER_SSE2 1
+#endif
+
+namespace
+{
+    inline uint32_t reverseBits(uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+        x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+
+    // integer hash, see https://nullprogram.com/blog/2018/07/31/
+    inline uint32_t hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // second dimension of the Sobol sequence, the generator matrix is the Pascal matrix mod 2
+    uint32_t sobolDim1Reference(uint32_t index)
+    {
+        uint32_t result = 0;
+        for (uint32_t v = 1u << 31; index; index >>= 1, v ^= v >> 1)
+        {
+            if (index & 1) result ^= v;
+        }
+        return result;
+    }
+
+    // the sequence is linear in the bits of the index, so it can be assembled from one table per index byte
+    struct SobolTable
+    {
+        SobolTable()
+        {
+            for (uint32_t b = 0; b < 4; b++)
+            {
+                for (uint32_t x = 0; x < 256; x++) bytes[b][x] = sobolDim1Reference(x << (8 * b));
+            }
+        }
+        uint32_t bytes[4][256];
+    };
+
+    const SobolTable& getSobolTable()
+    {
+        static const SobolTable table;
+        return table;
+    }
+
+    inline uint32_t sobolDim1(const SobolTable& table, uint32_t index)
+    {
+        return table.bytes[0][index & 0xff] ^ table.bytes[1][(index >> 8) & 0xff] ^ table.bytes[2][(index >> 16) & 0xff] ^ table.bytes[3][index >> 24];
+    }
+
+    // hash based Owen scrambling, see Burley, "Practical Hash-based Owen Scrambling", JCGT 2020
+    inline uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed)
+    {
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return x;
+    }
+
+    inline uint32_t nestedUniformScramble(uint32_t x, uint32_t seed)
+    {
+        return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+    }
+
+    // 24 bits, so the result is exactly representable and strictly below 1
+    inline float toUnitFloat(uint32_t x)
+    {
+        return float(x >> 8) * (1.f / 16777216.f);
+    }
+}
+
+PolygonSampler::PolygonSampler(const float* vertices, uint32_t numVertices, uint32_t dimension)
+    : mDimension(dimension), mVertices(vertices, vertices + size_t(numVertices) * dimension)
+{
+    if (numVertices < 3 || (dimension != 2 && dimension != 3))
+    {
+        throw std::runtime_error("PolygonSampler: expected at least 3 vertices with 2 or 3 components");
+    }
+    auto vertex = [&](uint32_t i) { return &mVertices[size_t(i) * dimension]; };
+
+    // triangulate in 2D, 3D polygons are projected along the largest component of their Newell normal
+    double normal[3] = {};
+    if (dimension == 3)
+    {
+        for (uint32_t i = 0; i < numVertices; i++)
+        {
+            const float* a = vertex(i);
+            const float* b = vertex((i + 1) % numVertices);
+            normal[0] += (double(a[1]) - b[1]) * (double(a[2]) + b[2]);
+            normal[1] += (double(a[2]) - b[2]) * (double(a[0]) + b[0]);
+            normal[2] += (double(a[0]) - b[0]) * (double(a[1]) + b[1]);
+        }
+    }
+    int axis = 2;
+    if (std::abs(normal[0]) > std::abs(normal[axis])) axis = 0;
+    if (std::abs(normal[1]) > std::abs(normal[axis])) axis = 1;
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    std::vector<double> points(size_t(numVertices) * 2);
+    double signedArea = 0;
+    for (uint32_t i = 0; i < numVertices; i++)
+    {
+        points[i * 2 + 0] = dimension == 3 ? vertex(i)[u] : vertex(i)[0];
+        points[i * 2 + 1] = dimension == 3 ? vertex(i)[v] : vertex(i)[1];
+    }
+    for (uint32_t i = 0; i < numVertices; i++)
+    {
+        uint32_t j = (i + 1) % numVertices;
+        signedArea += points[i * 2] * points[j * 2 + 1] - points[j * 2] * points[i * 2 + 1];
+    }
+    // the triangulation expects counter-clockwise points, mirror clockwise ones
+    if (signedArea < 0)
+    {
+        for (uint32_t i = 0; i < numVertices; i++) points[i * 2 + 1] = -points[i * 2 + 1];
+    }
+    triangulatePolygon(points.data(), numVertices, mTriangles);
+
+    // triangle areas from the cross product of the edges at their first vertex
+    size_t numTriangles = mTriangles.size() / 3;
+    mTriangleCdf.resize(numTriangles);
+    double total = 0;
+    for (size_t t = 0; t < numTriangles; t++)
+    {
+        const float* p0 = vertex(mTriangles[t * 3 + 0]);
+        const float* p1 = vertex(mTriangles[t * 3 + 1]);
+        const float* p2 = vertex(mTriangles[t * 3 + 2]);
+        float e1[3] = {}, e2[3] = {};
+        for (uint32_t c = 0; c < dimension; c++)
+        {
+            e1[c] = p1[c] - p0[c];
+            e2[c] = p2[c] - p0[c];
+        }
+        double cx = double(e1[1]) * e2[2] - double(e1[2]) * e2[1];
+        double cy = double(e1[2]) * e2[0] - double(e1[0]) * e2[2];
+        double cz = double(e1[0]) * e2[1] - double(e1[1]) * e2[0];
+        total += 0.5 * std::sqrt(cx * cx + cy * cy + cz * cz);
+        mTriangleCdf[t] = float(total);
+    }
+    mArea = float(total);
+    for (float& c : mTriangleCdf)
+    {
+        c = total > 0 ? float(c / total) : 1.f;
+    }
+    mTriangleCdf.back() = 1.f;
+}
+
+namespace
+{
+    struct SequenceSeeds
+    {
+        explicit SequenceSeeds(uint32_t seed) : dim0(hash(seed * 2 + 0x9e3779b9u)), dim1(hash(seed * 2 + 1 + 0x9e3779b9u)), sobol(getSobolTable()) {}
+        uint32_t dim0, dim1;
+        const SobolTable& sobol;
+    };
+
+    inline void sampleUnitSquare(SampleSequence sequence, const SequenceSeeds& seeds, uint32_t index, float& u, float& v)
+    {
+        if (sequence == SampleSequence::Sobol)
+        {
+            // the first dimension is the van der Corput sequence, reversing its bits gives back the index
+            u = toUnitFloat(reverseBits(laineKarrasPermutation(index, seeds.dim0)));
+            v = toUnitFloat(nestedUniformScramble(sobolDim1(seeds.sobol, index), seeds.dim1));
+        }
+        else
+        {
+            u = toUnitFloat(hash(hash(index ^ seeds.dim0) ^ seeds.dim1));
+            v = toUnitFloat(hash(hash(index ^ seeds.dim1) + seeds.dim0));
+        }
+    }
+}
+
+void PolygonSampler::sampleUnitSquare(SampleSequence sequence, uint32_t seed, uint32_t index, float& u, float& v)
+{
+    ::sampleUnitSquare(sequence, SequenceSeeds(seed), index, u, v);
+}
+
+void PolygonSampler::mapToPolygon(float u, float v, float* out) const
+{
+    // v picks the triangle and is rescaled to the position within it
+    size_t t = std::min(size_t(std::upper_bound(mTriangleCdf.begin(), mTriangleCdf.end(), v) - mTriangleCdf.begin()), mTriangleCdf.size() - 1);
+    float begin = t > 0 ? mTriangleCdf[t - 1] : 0.f;
+    float width = mTriangleCdf[t] - begin;
+    float w = width > 0 ? std::min((v - begin) / width, 1.f) : 0.f;
+
+    // uniform on the triangle (v0, v1, v2): sqrt(u) is the distance from v0, w the position along v1 -> v2
+    float s = std::sqrt(u);
+    float b1 = s * (1.f - w);
+    float b2 = s * w;
+    const float* p0 = &mVertices[mTriangles[t * 3 + 0] * mDimension];
+    const float* p1 = &mVertices[mTriangles[t * 3 + 1] * mDimension];
+    const float* p2 = &mVertices[mTriangles[t * 3 + 2] * mDimension];
+    for (uint32_t c = 0; c < mDimension; c++)
+    {
+        out[c] = p0[c] + (p1[c] - p0[c]) * b1 + (p2[c] - p0[c]) * b2;
+    }
+}
+
+void PolygonSampler::generate(SampleSequence sequence, uint32_t seed, uint32_t first, uint32_t count, float* out, uint32_t stride) const
+{
+    if (mTriangleCdf.empty())
+    {
+        throw std::runtime_error("PolygonSampler::generate() called without a polygon");
+    }
+    SequenceSeeds seeds(seed);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float u, v;
+        ::sampleUnitSquare(sequence, seeds, first + i, u, v);
+        mapToPolygon(u, v, out + size_t(i) * stride);
+    }
+}
+
+void transformPoints(const float* matrix, const float* in, uint32_t count, float* out)
+{
+#if defined(POLYGON_SAMPLER_SSE2)
+    // one point per register, the columns stay in registers for the whole batch
+    const __m128 c0 = _mm_loadu_ps(matrix + 0);
+    const __m128 c1 = _mm_loadu_ps(matrix + 4);
+    const __m128 c2 = _mm_loadu_ps(matrix + 8);
+    const __m128 c3 = _mm_loadu_ps(matrix + 12);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        __m128 p = _mm_loadu_ps(in + size_t(i) * 4);
+        __m128 x = _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 y = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 z = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 w = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, x), _mm_mul_ps(c1, y)), _mm_add_ps(_mm_mul_ps(c2, z), _mm_mul_ps(c3, w)));
+        _mm_storeu_ps(out + size_t(i) * 4, r);
+    }
+#else
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const float* p = in + size_t(i) * 4;
+        float r[4];
+        for (int row = 0; row < 4; row++)
+        {
+            r[row] = matrix[row] * p[0] + matrix[4 + row] * p[1] + matrix[8 + row] * p[2] + matrix[12 + row] * p[3];
+        }
+        for (int row = 0; row < 4; row++) out[size_t(i) * 4 + row] = r[row];
+    }
+#endif
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// Rejection-free sample generation on planar polygons. A convex polygon is split into the triangle fan around
+// vertex 0; the second sample dimension picks a triangle proportional to its area and is then rescaled to the
+// angle inside the triangle, the first dimension becomes the distance from the triangle's first vertex through a
+// square root, so the whole polygon is covered by one continuous, area preserving map from the unit square.
+// Stratification of the 2D sequence therefore carries over to the polygon. Concave polygons are ear clipped
+// instead, the map stays area preserving but is only continuous within each triangle.
+// Sample i only depends on the seed and i, so any range of samples can be generated independently on any thread
+// and the result does not depend on how the work was split.
+
+#include <cstdint>
+#include <vector>
+
+enum class SampleSequence
+{
+    Uniform,    ///< Independent uniform samples from a hash of seed and index
+    Sobol,      ///< Owen scrambled 2D Sobol points, every power of two prefix is stratified
+};
+
+class PolygonSampler
+{
+public:
+    PolygonSampler() {}
+
+    /** Prepare sampling of a simple polygon, convex or concave
+        \param[in] vertices numVertices points of dimension floats each (2 or 3), in order around the polygon, 3D points must be coplanar
+        \param[in] numVertices At least 3
+        \param[in] dimension Floats per vertex
+    */
+    PolygonSampler(const float* vertices, uint32_t numVertices, uint32_t dimension);
+
+    /** Area of the polygon
+    */
+    float getArea() const { return mArea; }
+
+    uint32_t getDimension() const { return mDimension; }
+
+    /** Generate samples first .. first + count - 1 of the sequence
+        \param[in] seed Seed of the randomization, different seeds give independent sample sets
+        \param[out] out count points with stride floats between them, only the first getDimension() floats are written
+    */
+    void generate(SampleSequence sequence, uint32_t seed, uint32_t first, uint32_t count, float* out, uint32_t stride) const;
+
+    /** Point in the unit square for sample index of the sequence, before it is mapped to the polygon
+    */
+    static void sampleUnitSquare(SampleSequence sequence, uint32_t seed, uint32_t index, float& u, float& v);
+
+private:
+    void mapToPolygon(float u, float v, float* out) const;
+
+    uint32_t mDimension = 0;
+    std::vector<float> mVertices;
+    std::vector<uint32_t> mTriangles;   // three vertex indices per triangle
+    std::vector<float> mTriangleCdf;    // cumulative, normalized triangle areas, mTriangleCdf.back() == 1
+    float mArea = 0;
+};
+
+/** Multiply count homogeneous points by a 4x4 matrix, uses SSE2 where available
+    \param[in] matrix Column major, like glm::mat4
+    \param[in] in count points of 4 floats
+    \param[out] out count points of 4 floats, may be equal to in
+*/
+void transformPoints(const float* matrix, const float* in, uint32_t count, float* out);
@@ -0,0 +1,405 @@
+#include "PolygonShape.h"
+#include "Reference/Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // twice the signed area of the 2D triangle (a, b, c), positive if counter-clockwise
+    inline double orient2d(const double* a, const double* b, const double* c)
+    {
+        return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+    }
+
+    inline float orient2d(const float* a, const float* b, float x, float y)
+    {
+        return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+    }
+
+    bool insideTriangle(const double* a, const double* b, const double* c, const double* p)
+    {
+        return orient2d(a, b, p) >= 0 && orient2d(b, c, p) >= 0 && orient2d(c, a, p) >= 0;
+    }
+
+    // s + e == a + b exactly, see Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast Robust
+    // Geometric Predicates", 1997
+    inline void twoSum(double a, double b, double& s, double& e)
+    {
+        s = a + b;
+        double bVirtual = s - a;
+        double aVirtual = s - bVirtual;
+        e = (a - aVirtual) + (b - bVirtual);
+    }
+
+    // relative error bound of the float orientation (b - a) x (p - a) computed as in classifyPoints(), Shewchuk's
+    // ccwerrboundA = (3 + 16 eps) eps for eps = 2^-24, rounded up
+    const float kOrientErrorBound = 1.8e-7f;
+
+    // plane of the edge a -> b, positive on its left side
+    EdgePlane edgePlane(const float* a, const float* b)
+    {
+        EdgePlane plane;
+        plane.a = a[1] - b[1];
+        plane.b = b[0] - a[0];
+        plane.c = -(plane.a * a[0] + plane.b * a[1]);
+        plane.dy = b[1] - a[1];
+        return plane;
+    }
+}
+
+void triangulatePolygon(const double* points, uint32_t numVertices, std::vector<uint32_t>& triangles)
+{
+    uint32_t n = numVertices;
+    auto p = [&](uint32_t i) { return &points[size_t(i) * 2]; };
+
+    bool convex = true;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        convex = convex && orient2d(p(i), p((i + 1) % n), p((i + 2) % n)) >= 0;
+    }
+
+    triangles.clear();
+    if (convex)
+    {
+        for (uint32_t t = 0; t + 2 < n; t++)
+        {
+            triangles.insert(triangles.end(), { 0, t + 1, t + 2 });
+        }
+        return;
+    }
+
+    std::vector<uint32_t> remaining(n);
+    for (uint32_t i = 0; i < n; i++) remaining[i] = i;
+    while (remaining.size() > 3)
+    {
+        size_t m = remaining.size();
+        size_t ear = m;
+        for (size_t i = 0; i < m && ear == m; i++)
+        {
+            const double* a = p(remaining[(i + m - 1) % m]);
+            const double* b = p(remaining[i]);
+            const double* c = p(remaining[(i + 1) % m]);
+            if (orient2d(a, b, c) <= 0) continue;
+
+            // an ear contains no other vertex of the remaining polygon
+            bool isEar = true;
+            for (size_t j = 0; j < m && isEar; j++)
+            {
+                if (j == i || j == (i + 1) % m || j == (i + m - 1) % m) continue;
+                isEar = !insideTriangle(a, b, c, p(remaining[j]));
+            }
+            if (isEar) ear = i;
+        }
+        // only degenerate (e.g. self-intersecting) input has no ear, cut the first corner to terminate anyway
+        if (ear == m) ear = 0;
+
+        triangles.insert(triangles.end(), { remaining[(ear + m - 1) % m], remaining[ear], remaining[(ear + 1) % m] });
+        remaining.erase(remaining.begin() + ear);
+    }
+    triangles.insert(triangles.end(), { remaining[0], remaining[1], remaining[2] });
+}
+
+int orient2dExact(const float* a, const float* b, float px, float py)
+{
+    // (bx - ax) (py - ay) - (by - ay) (px - ax) expanded into products of two floats, which are exact in double
+    const double terms[6] =
+    {
+        double(b[0]) * py, -double(b[0]) * a[1], -double(a[0]) * py,
+        -double(b[1]) * px, double(b[1]) * a[0], double(a[1]) * px,
+    };
+    // sum them into a nonoverlapping expansion of increasing magnitude, its largest component has the sign of the sum
+    double expansion[6];
+    int length = 0;
+    for (double term : terms)
+    {
+        double q = term;
+        int out = 0;
+        for (int i = 0; i < length; i++)
+        {
+            double sum, error;
+            twoSum(q, expansion[i], sum, error);
+            if (error != 0) expansion[out++] = error;
+            q = sum;
+        }
+        if (q != 0) expansion[out++] = q;
+        length = out;
+    }
+    return length == 0 ? 0 : (expansion[length - 1] > 0 ? 1 : -1);
+}
+
+PolygonShape::PolygonShape(const float* vertices, uint32_t numVertices)
+    : mVertices(vertices, vertices + size_t(numVertices) * 2)
+{
+    if (numVertices < 3)
+    {
+        throw std::runtime_error("PolygonShape: expected at least 3 vertices");
+    }
+    uint32_t n = numVertices;
+    auto vertex = [&](uint32_t i) { return &mVertices[size_t(i) * 2]; };
+
+    double signedArea = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const float* a = vertex(i);
+        const float* b = vertex((i + 1) % n);
+        signedArea += double(a[0]) * b[1] - double(b[0]) * a[1];
+    }
+    mArea = float(std::abs(signedArea) * 0.5);
+    bool clockwise = signedArea < 0;
+
+    mCcwOrder.resize(n);
+    for (uint32_t i = 0; i < n; i++) mCcwOrder[i] = clockwise ? n - 1 - i : i;
+
+    mBounds[0] = mBounds[2] = vertex(0)[0];
+    mBounds[1] = mBounds[3] = vertex(0)[1];
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const float* v = vertex(i);
+        mBounds[0] = std::min(mBounds[0], v[0]);
+        mBounds[1] = std::min(mBounds[1], v[1]);
+        mBounds[2] = std::max(mBounds[2], v[0]);
+        mBounds[3] = std::max(mBounds[3], v[1]);
+    }
+
+    // edge planes in the given order, flipped for clockwise polygons so the inside is always positive
+    mEdgePlanes.resize(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        EdgePlane& plane = mEdgePlanes[i];
+        plane = edgePlane(vertex(i), vertex((i + 1) % n));
+        if (clockwise)
+        {
+            plane.a = -plane.a;
+            plane.b = -plane.b;
+            plane.c = -plane.c;
+            plane.dy = -plane.dy;
+        }
+    }
+
+    // triangulate counter-clockwise in double precision, then map back to the given indices
+    std::vector<double> points(size_t(n) * 2);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        points[i * 2 + 0] = vertex(mCcwOrder[i])[0];
+        points[i * 2 + 1] = vertex(mCcwOrder[i])[1];
+    }
+    mConvex = true;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        mConvex = mConvex && orient2d(&points[i * 2], &points[((i + 1) % n) * 2], &points[((i + 2) % n) * 2]) >= 0;
+    }
+    triangulatePolygon(points.data(), n, mTriangles);
+    for (uint32_t& index : mTriangles) index = mCcwOrder[index];
+
+    // Hertel-Mehlhorn: remove every diagonal of the triangulation whose removal keeps both of its end points convex
+    std::vector<std::vector<uint32_t>> pieces;
+    if (mConvex)
+    {
+        pieces.push_back(mCcwOrder);
+    }
+    else
+    {
+        for (size_t t = 0; t < mTriangles.size(); t += 3)
+        {
+            pieces.push_back({ mTriangles[t], mTriangles[t + 1], mTriangles[t + 2] });
+        }
+    }
+    auto orient = [&](uint32_t a, uint32_t b, uint32_t c) { return orient2d(&points[size_t(a) * 2], &points[size_t(b) * 2], &points[size_t(c) * 2]); };
+    // orient() works on the counter-clockwise copy, so translate given indices to positions in it
+    std::vector<uint32_t> ccwPosition(n);
+    for (uint32_t i = 0; i < n; i++) ccwPosition[mCcwOrder[i]] = i;
+    auto convexCorner = [&](uint32_t prev, uint32_t corner, uint32_t next) { return orient(ccwPosition[prev], ccwPosition[corner], ccwPosition[next]) >= 0; };
+    auto isBoundary = [&](uint32_t u, uint32_t v) { uint32_t d = (u + n - v) % n; return d == 1 || d == n - 1; };
+
+    for (size_t pi = 0; pi < pieces.size(); pi++)
+    {
+        bool merged = true;
+        while (merged && !pieces[pi].empty())
+        {
+            merged = false;
+            std::vector<uint32_t>& P = pieces[pi];
+            size_t m = P.size();
+            for (size_t k = 0; k < m && !merged; k++)
+            {
+                uint32_t u = P[k];
+                uint32_t v = P[(k + 1) % m];
+                if (isBoundary(u, v)) continue;
+
+                // the piece on the other side of the diagonal has the edge v -> u
+                for (size_t qi = 0; qi < pieces.size() && !merged; qi++)
+                {
+                    std::vector<uint32_t>& Q = pieces[qi];
+                    size_t mq = Q.size();
+                    if (qi == pi || mq == 0) continue;
+                    size_t j = 0;
+                    while (j < mq && !(Q[j] == v && Q[(j + 1) % mq] == u)) j++;
+                    if (j == mq) continue;
+
+                    if (!convexCorner(P[(k + m - 1) % m], u, Q[(j + 2) % mq]) || !convexCorner(Q[(j + mq - 1) % mq], v, P[(k + 2) % m])) break;
+
+                    // v .. u along P, then the vertices of Q strictly between u and v
+                    std::vector<uint32_t> joined;
+                    joined.reserve(m + mq - 2);
+                    for (size_t t = 0; t < m; t++) joined.push_back(P[(k + 1 + t) % m]);
+                    for (size_t t = 2; t < mq; t++) joined.push_back(Q[(j + t) % mq]);
+                    P.swap(joined);
+                    Q.clear();
+                    merged = true;
+                }
+            }
+        }
+    }
+
+    for (const std::vector<uint32_t>& piece : pieces)
+    {
+        if (piece.empty()) continue;
+        float bounds[4] = { vertex(piece[0])[0], vertex(piece[0])[1], vertex(piece[0])[0], vertex(piece[0])[1] };
+        for (size_t k = 0; k < piece.size(); k++)
+        {
+            const float* a = vertex(piece[k]);
+            mPieceIndices.push_back(piece[k]);
+            bounds[0] = std::min(bounds[0], a[0]);
+            bounds[1] = std::min(bounds[1], a[1]);
+            bounds[2] = std::max(bounds[2], a[0]);
+            bounds[3] = std::max(bounds[3], a[1]);
+        }
+        mPieceOffsets.push_back(uint32_t(mPieceIndices.size()));
+        mPieceBounds.insert(mPieceBounds.end(), bounds, bounds + 4);
+    }
+}
+
+const uint32_t* PolygonShape::getPiece(uint32_t piece, uint32_t& count) const
+{
+    count = mPieceOffsets[piece + 1] - mPieceOffsets[piece];
+    return &mPieceIndices[mPieceOffsets[piece]];
+}
+
+bool PolygonShape::containsConvex(float x, float y) const
+{
+    // binary search for the wedge q0, q[lo], q[lo + 1] of the fan around q0 that contains the point
+    uint32_t n = getVertexCount();
+    auto q = [&](uint32_t i) { return &mVertices[size_t(mCcwOrder[i]) * 2]; };
+    if (orient2d(q(0), q(1), x, y) < 0 || orient2d(q(0), q(n - 1), x, y) > 0) return false;
+
+    uint32_t lo = 1, hi = n - 1;
+    while (hi - lo > 1)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if (orient2d(q(0), q(mid), x, y) >= 0) lo = mid;
+        else hi = mid;
+    }
+    return orient2d(q(lo), q(lo + 1), x, y) >= 0;
+}
+
+bool PolygonShape::containsPiece(uint32_t piece, float x, float y) const
+{
+    // relative to the vertices like containsConvex(), so the test is exactly 0 on the vertices of the piece; a plane
+    // equation with a rounded constant term misses vertices of concave polygons
+    uint32_t first = mPieceOffsets[piece], end = mPieceOffsets[piece + 1];
+    bool inside = true;
+    for (uint32_t k = first; k < end; k++)
+    {
+        const float* a = &mVertices[size_t(mPieceIndices[k]) * 2];
+        const float* b = &mVertices[size_t(mPieceIndices[k + 1 < end ? k + 1 : first]) * 2];
+        inside &= orient2d(a, b, x, y) >= 0;
+    }
+    return inside;
+}
+
+bool PolygonShape::contains(float x, float y) const
+{
+    if (mVertices.empty() || x < mBounds[0] || y < mBounds[1] || x > mBounds[2] || y > mBounds[3]) return false;
+    if (mConvex) return containsConvex(x, y);
+
+    for (uint32_t piece = 0; piece < getPieceCount(); piece++)
+    {
+        const float* b = &mPieceBounds[size_t(piece) * 4];
+        if (x < b[0] || y < b[1] || x > b[2] || y > b[3]) continue;
+        if (containsPiece(piece, x, y)) return true;
+    }
+    return false;
+}
+
+bool PolygonShape::containsExact(float x, float y) const
+{
+    uint32_t n = getVertexCount();
+    int winding = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const float* a = &mVertices[size_t(i) * 2];
+        const float* b = &mVertices[size_t((i + 1) % n) * 2];
+        bool upward = a[1] <= y && b[1] > y;
+        bool downward = a[1] > y && b[1] <= y;
+        bool inBox = x >= std::min(a[0], b[0]) && x <= std::max(a[0], b[0]) && y >= std::min(a[1], b[1]) && y <= std::max(a[1], b[1]);
+        if (!upward && !downward && !inBox) continue;
+
+        int orientation = orient2dExact(a, b, x, y);
+        if (orientation == 0 && inBox) return true;
+        if (upward && orientation > 0) winding++;
+        if (downward && orientation < 0) winding--;
+    }
+    return winding != 0;
+}
+
+size_t PolygonShape::classifyPoints(const float* points, size_t count, uint8_t* insideMask) const
+{
+    using namespace ltsh::simd;
+
+    uint32_t n = getVertexCount();
+    size_t fallbacks = 0;
+    for (size_t first = 0; first < count; first += kWidth)
+    {
+        // deinterleave, the last batch is padded with copies of the first point
+        size_t batch = std::min(count - first, size_t(kWidth));
+        float xs[kWidth], ys[kWidth];
+        for (size_t i = 0; i < size_t(kWidth); i++)
+        {
+            size_t index = first + (i < batch ? i : 0);
+            xs[i] = points[index * 2];
+            ys[i] = points[index * 2 + 1];
+        }
+        float8 px = float8::load(xs);
+        float8 py = float8::load(ys);
+
+        // same tests as containsExact(), a lane is uncertain if an orientation that matters is within the error bound
+        float8 winding(0.f);
+        float8 uncertain(0.f);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            const float* a = &mVertices[size_t(i) * 2];
+            const float* b = &mVertices[size_t((i + 1) % n) * 2];
+            float8 ax(a[0]), ay(a[1]), bx(b[0]), by(b[1]);
+            float8 upward = (ay <= py) & (by > py);
+            float8 downward = (ay > py) & (by <= py);
+            float8 inBox = (px >= float8(std::min(a[0], b[0]))) & (px <= float8(std::max(a[0], b[0])))
+                & (py >= float8(std::min(a[1], b[1]))) & (py <= float8(std::max(a[1], b[1])));
+
+            float8 t0 = (bx - ax) * (py - ay);
+            float8 t1 = (by - ay) * (px - ax);
+            float8 orientation = t0 - t1;
+            float8 bound = float8(kOrientErrorBound) * (abs(t0) + abs(t1));
+
+            winding += (upward & (orientation > float8(0.f)) & float8(1.f)) - (downward & (orientation < float8(0.f)) & float8(1.f));
+            uncertain = uncertain | ((upward | downward | inBox) & (abs(orientation) <= bound));
+        }
+
+        int inside = ~moveMask(winding == float8(0.f)) & 0xff;
+        int exact = moveMask(uncertain);
+        for (size_t i = 0; i < batch; i++)
+        {
+            if (!(exact & (1 << i))) continue;
+            bool isInside = containsExact(xs[i], ys[i]);
+            inside = isInside ? inside | (1 << i) : inside & ~(1 << i);
+            fallbacks++;
+        }
+        for (size_t i = 0; i < batch; i++)
+        {
+            size_t index = first + i;
+            uint8_t bit = uint8_t(1u << (index % 8));
+            insideMask[index / 8] = (inside & (1 << i)) ? uint8_t(insideMask[index / 8] | bit) : uint8_t(insideMask[index / 8] & ~bit);
+        }
+    }
+    return fallbacks;
+}
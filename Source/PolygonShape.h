@@ -0,0 +1,110 @@
+#pragma once
+
+// Preprocessed planar polygon. Everything that only depends on the vertices is computed once when they change:
+// a triangulation (the fan around vertex 0 for convex polygons, ear clipping otherwise), a convex decomposition
+// that merges the triangles back into as few convex pieces as the Hertel-Mehlhorn heuristic finds (at most four
+// times the optimum), and the edge plane of every edge. Point-in-polygon queries then need no per-edge intersection
+// tests: a convex polygon is searched in O(log n) by the wedge around vertex 0 that contains the point, a concave
+// one tests the pieces whose bounding box contains the point against their edge planes without branching per edge.
+// classifyPoints() is the robust variant for batches: 8 points at a time against all edges by their winding number,
+// with exact arithmetic for the few points whose float orientation tests cannot be trusted.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Edge a * x + b * y + c = 0 of a polygon, positive on the inner side. dy is the y extent of the edge when the
+    polygon is walked counter-clockwise, which is all a crossing number test needs besides the plane: a ray from p
+    in +x direction crosses the edge iff p.y lies between its end points and (a * p.x + b * p.y + c) * dy > 0.
+*/
+struct EdgePlane
+{
+    float a = 0;
+    float b = 0;
+    float c = 0;
+    float dy = 0;
+
+    float eval(float x, float y) const { return a * x + b * y + c; }
+};
+
+/** Triangulate a simple 2D polygon given counter-clockwise, the fan around vertex 0 if it is convex, otherwise
+    ear clipping
+    \param[in] points numVertices x, y pairs
+    \param[out] triangles numVertices - 2 triangles of three vertex indices, counter-clockwise
+*/
+void triangulatePolygon(const double* points, uint32_t numVertices, std::vector<uint32_t>& triangles);
+
+/** Exact sign of the orientation of the triangle (a, b, p), 1 if counter-clockwise, -1 if clockwise and 0 if the
+    points are collinear. Evaluated with floating point expansions, so no rounding can flip the result.
+*/
+int orient2dExact(const float* a, const float* b, float px, float py);
+
+class PolygonShape
+{
+public:
+    PolygonShape() {}
+
+    /** Preprocess a simple polygon, convex or concave
+        \param[in] vertices numVertices x, y pairs in order around the polygon, clockwise or counter-clockwise
+        \param[in] numVertices At least 3
+    */
+    PolygonShape(const float* vertices, uint32_t numVertices);
+
+    uint32_t getVertexCount() const { return uint32_t(mVertices.size() / 2); }
+
+    bool isConvex() const { return mConvex; }
+
+    /** Area of the polygon, positive for either orientation
+    */
+    float getArea() const { return mArea; }
+
+    /** Triangulation, three indices into the vertices per triangle, counter-clockwise
+    */
+    const std::vector<uint32_t>& getTriangles() const { return mTriangles; }
+
+    /** Edge planes in vertex order, plane i belongs to the edge from vertex i to vertex i + 1
+    */
+    const std::vector<EdgePlane>& getEdgePlanes() const { return mEdgePlanes; }
+
+    /** Number of convex pieces, 1 for a convex polygon
+    */
+    uint32_t getPieceCount() const { return uint32_t(mPieceOffsets.size() - 1); }
+
+    /** Vertex indices of a convex piece, counter-clockwise
+        \param[out] count Number of vertices of the piece
+    */
+    const uint32_t* getPiece(uint32_t piece, uint32_t& count) const;
+
+    /** True if the point lies inside the polygon or on its boundary
+    */
+    bool contains(float x, float y) const;
+
+    /** Like contains(), but exact for every input: points on an edge or a vertex are always inside, regardless of
+        how the edge is oriented. Sunday's winding number test with exact orientation predicates.
+    */
+    bool containsExact(float x, float y) const;
+
+    /** Classify a batch of points, 8 per SIMD instruction, with the same result as containsExact(). Each edge is
+        tested with float arithmetic and a forward error bound; points for which any test is within the bound are
+        repeated with containsExact().
+        \param[in] points count x, y pairs
+        \param[out] insideMask (count + 7) / 8 bytes, bit i % 8 of byte i / 8 is set if point i is inside
+        \return Number of points that needed the exact fallback
+    */
+    size_t classifyPoints(const float* points, size_t count, uint8_t* insideMask) const;
+
+private:
+    bool containsConvex(float x, float y) const;
+    bool containsPiece(uint32_t piece, float x, float y) const;
+
+    std::vector<float> mVertices;           // as given
+    std::vector<uint32_t> mCcwOrder;        // vertex indices counter-clockwise
+    std::vector<uint32_t> mTriangles;
+    std::vector<EdgePlane> mEdgePlanes;
+    std::vector<uint32_t> mPieceIndices;    // vertices of all pieces, piece i is mPieceIndices[mPieceOffsets[i] .. mPieceOffsets[i + 1])
+    std::vector<uint32_t> mPieceOffsets = { 0 };
+    std::vector<float> mPieceBounds;        // min x, min y, max x, max y per piece
+    float mBounds[4] = {};
+    float mArea = 0;
+    bool mConvex = false;
+};
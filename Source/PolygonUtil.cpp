@@ -1,4 +1,5 @@
 #include "PolygonUtil.h"
+#include "PolygonShape.h"
 
 // Code taken from: https://www.geeksforgeeks.org/how-to-check-if-a-given-point-lies-inside-a-polygon/
 
@@ -12,10 +13,11 @@ bool PolygonUtil::onSegment(const glm::vec2& p, const glm::vec2& q, const glm::v
 
 int PolygonUtil::orientation(const glm::vec2& p, const glm::vec2& q, const glm::vec2& r)
 {
-    float val = (q.y - p.y) * (r.x - q.x) - (q.x - p.x) * (r.y - q.y);
-
-    if (std::abs(val) < std::numeric_limits<float>::epsilon()) return 0;  // colinear 
-    return (val > 0) ? 1 : 2; // clock or counterclock wise 
+    // exact sign instead of an epsilon test, which misses collinear points far from the origin and reports
+    // nearly collinear ones close to it
+    int sign = orient2dExact(&p.x, &q.x, r.x, r.y);
+    if (sign == 0) return 0;  // colinear 
+    return (sign < 0) ? 1 : 2; // clock or counterclock wise 
 }
 
 
@@ -80,4 +82,10 @@ bool PolygonUtil::isInside(const std::vector<glm::vec2>& polygon, int n, const g
 
     // Return true if count is odd, false otherwise 
     return count & 1;  // Same as (count%2 == 1) 
-}
\ No newline at end of file
+}
+
+void PolygonUtil::classifyPoints(const std::vector<glm::vec2>& polygon, const glm::vec2* points, size_t count, uint8_t* insideMask)
+{
+    PolygonShape shape(&polygon[0].x, (uint32_t)polygon.size());
+    shape.classifyPoints(&points[0].x, count, insideMask);
+}
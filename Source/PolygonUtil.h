@@ -11,7 +11,7 @@ public:
 	*/
 	static bool onSegment(const glm::vec2 &p, const glm::vec2 &q, const glm::vec2 &r);
 
-	/** To find orientation of ordered triplet(p, q, r).
+	/** To find orientation of ordered triplet(p, q, r), exact (see orient2dExact()).
 		The function returns following values 
 		0 --> p, q and r are colinear 
 		1 --> Clockwise 
@@ -26,5 +26,12 @@ public:
 	/** Returns true if the point p lies inside the polygon[] with n vertices
 	*/
 	static bool isInside(const std::vector<glm::vec2>& polygon, int n, const glm::vec2& p);
+
+	/** Classify count points against the polygon with the batched winding number test of PolygonShape::classifyPoints(),
+		exact also for points on edges and vertices. Preprocesses the polygon on every call, keep a PolygonShape around
+		when classifying many batches against the same polygon.
+		\param[out] insideMask (count + 7) / 8 bytes, bit i % 8 of byte i / 8 is set if points[i] is inside or on the boundary
+	*/
+	static void classifyPoints(const std::vector<glm::vec2>& polygon, const glm::vec2* points, size_t count, uint8_t* insideMask);
 };
 
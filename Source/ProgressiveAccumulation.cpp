@@ -0,0 +1,57 @@
+#include "ProgressiveAccumulation.h"
+
+#include <algorithm>
+#include <cstring>
+
+ProgressiveAccumulation::ProgressiveAccumulation(uint32_t samplesPerSet, uint32_t numSets, uint32_t samplesPerFrame)
+    : mSamplesPerSet(samplesPerSet), mNumSets(numSets)
+{
+    setSamplesPerFrame(samplesPerFrame);
+}
+
+void ProgressiveAccumulation::setSamplesPerFrame(uint32_t count)
+{
+    count = std::min(std::max(count, 1u), mSamplesPerSet);
+    uint32_t powerOfTwo = 1;
+    while (powerOfTwo * 2 <= count) powerOfTwo *= 2;
+    if (powerOfTwo != mSamplesPerFrame)
+    {
+        mSamplesPerFrame = powerOfTwo;
+        reset();
+    }
+}
+
+bool ProgressiveAccumulation::setState(const void* pState, size_t size)
+{
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pState);
+    if (mState.size() == size && std::memcmp(mState.data(), pBytes, size) == 0) return false;
+    mState.assign(pBytes, pBytes + size);
+    reset();
+    return true;
+}
+
+bool ProgressiveAccumulation::nextFrame(SampleWindow& window, uint32_t& framesBefore)
+{
+    if (isConverged()) return false;
+    uint32_t sample = getSamplesPerPixel();
+    window.first = sample % mSamplesPerSet;
+    window.count = mSamplesPerFrame;
+    window.setShift = sample / mSamplesPerSet;
+    framesBefore = mFrames++;
+    return true;
+}
+
+void accumulateFrame(float* history, const float* frame, size_t count, uint32_t framesBefore)
+{
+    // the first frame replaces whatever the history held
+    if (framesBefore == 0)
+    {
+        std::copy(frame, frame + count, history);
+        return;
+    }
+    float weight = 1.f / float(framesBefore + 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        history[i] += (frame[i] - history[i]) * weight;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Progressive ground truth: instead of NumSamples / SampleReductionFactor samples per pixel every frame, the ground
+// truth modes evaluate a small window of samples per frame and the frames are averaged in a float32 history while
+// camera and light stay where they are. The windows walk through the whole sample set the pixel picks and then
+// through the other sets, so after numSets * samplesPerSet samples every sample has been used once and the image is
+// converged. Any change of the state the image depends on starts over.
+// Does not depend on Falcor, the app accumulates in LightingPass.ps.hlsl and ltsh_render on the CPU.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Samples of the ground truth estimate of one frame. A pixel uses set (its random set + setShift) % numSets and the
+    samples first .. first + count - 1 of that set.
+*/
+struct SampleWindow
+{
+    uint32_t first = 0;
+    uint32_t count = 0;
+    uint32_t setShift = 0;
+};
+
+class ProgressiveAccumulation
+{
+public:
+    /** \param[in] samplesPerSet Power of two
+        \param[in] samplesPerFrame Budget per frame, see setSamplesPerFrame()
+    */
+    ProgressiveAccumulation(uint32_t samplesPerSet, uint32_t numSets, uint32_t samplesPerFrame);
+
+    /** Rounded down to a power of two in [1, samplesPerSet] so the windows tile the sets, starts over if it changed
+    */
+    void setSamplesPerFrame(uint32_t count);
+    uint32_t getSamplesPerFrame() const { return mSamplesPerFrame; }
+
+    /** Start over if the state differs from the one of the last call
+        \param[in] pState Everything the image depends on, e.g. camera, light, render mode, compared bytewise
+        \return True if the accumulation was reset
+    */
+    bool setState(const void* pState, size_t size);
+
+    /** Start over with the next frame
+    */
+    void reset() { mFrames = 0; }
+
+    /** Window of the next frame
+        \param[out] framesBefore Frames already averaged into the history, 0 means the frame replaces the history
+        \return False if all samples have been used, the history is then final and nothing has to be rendered
+    */
+    bool nextFrame(SampleWindow& window, uint32_t& framesBefore);
+
+    /** Samples per pixel in the history
+    */
+    uint32_t getSamplesPerPixel() const { return mFrames * mSamplesPerFrame; }
+    uint32_t getMaxSamplesPerPixel() const { return mSamplesPerSet * mNumSets; }
+    bool isConverged() const { return getSamplesPerPixel() >= getMaxSamplesPerPixel(); }
+
+private:
+    uint32_t mSamplesPerSet;
+    uint32_t mNumSets;
+    uint32_t mSamplesPerFrame = 1;
+    uint32_t mFrames = 0;
+    std::vector<uint8_t> mState;
+};
+
+/** Running mean of count floats, history = history + (frame - history) / (framesBefore + 1)
+*/
+void accumulateFrame(float* history, const float* frame, size_t count, uint32_t framesBefore);
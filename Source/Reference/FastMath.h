@@ -0,0 +1,159 @@
+#pragma once
+
+// Polynomial approximations of the transcendental functions in the edge integrals of LTC (acos) and LTSH (acos,
+// sincos of the edge arc, atan2 of the solid angle), mirrored by Data/FastMath.slang. Every function takes a
+// TrigPrecision; Exact calls the standard library (simd::acos/simd::sincos for float8), Medium and Fast evaluate
+// minimax polynomials that were fitted offline. Max. absolute error of the polynomials on their domain, measured in
+// long double (float rounding adds ~1e-7):
+//
+//   function                    Medium     Fast
+//   acos(x), x in [-1, 1]       6.4e-7     3.3e-4     radians, degree 5 / 2 in |x| times sqrt(1 - |x|)
+//   sin(x), x in [0, pi]        4.7e-8     6.0e-4     degree 8 / 4 even polynomial in x - pi/2
+//   cos(x), x in [0, pi]        5.9e-7     6.8e-5     degree 7 / 5 odd polynomial in x - pi/2
+//   atan2(y, x)                 1.7e-6     8.1e-5     radians, degree 11 / 7 odd polynomial of min/max
+//
+// thetaOverSinTheta() for the LTC edge integral uses the Medium acos for Medium and the rational fit from Heitz's
+// LTC code for Fast. ltsh_trig_bench measures the error these kernels add to the rendered LTC and LTSH result.
+// The functions are templates over float, double and simd::float8, all lanes of a float8 use the same precision.
+
+#include "Simd.h"
+#include "VecMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace ltsh
+{
+    // same values as the Trig* constants in Data/FastMath.slang
+    enum class TrigPrecision : uint32_t
+    {
+        Exact = 0,
+        Medium,
+        Fast,
+    };
+
+    namespace fastmath
+    {
+        // scalar counterparts of the float8 helpers, found next to them by overload resolution
+        using std::abs;
+        using std::sqrt;
+        using std::min;
+        using std::max;
+        using simd::abs;
+        using simd::sqrt;
+        using simd::min;
+        using simd::max;
+        using simd::select;
+        inline float select(bool mask, float a, float b) { return mask ? a : b; }
+        inline double select(bool mask, double a, double b) { return mask ? a : b; }
+
+        inline float exactAcos(float x) { return std::acos(x); }
+        inline double exactAcos(double x) { return std::acos(x); }
+        inline simd::float8 exactAcos(simd::float8 x) { return simd::acos(x); }
+
+        template<typename T> void exactSinCos(T x, T& s, T& c) { s = std::sin(x); c = std::cos(x); }
+        inline void exactSinCos(simd::float8 x, simd::float8& s, simd::float8& c) { simd::sincos(x, s, c); }
+
+        template<typename T> T exactAtan2(T y, T x) { return std::atan2(y, x); }
+        inline simd::float8 exactAtan2(simd::float8 y, simd::float8 x) { return simd::atan2(y, x); }
+
+        template<typename T, int N>
+        T horner(T x, const float (&c)[N])
+        {
+            T p = T(c[N - 1]);
+            for (int i = N - 2; i >= 0; i--)
+            {
+                p = p * x + T(c[i]);
+            }
+            return p;
+        }
+
+        // acos(x) ~ sqrt(1 - x) * P(x) on [0, 1]
+        static const float kAcosMedium[] = { 1.570795690e+00f, -2.145428167e-01f, 8.817105299e-02f, -4.592722685e-02f, 2.062005919e-02f, -4.911173334e-03f };
+        static const float kAcosFast[] = { 1.570470261e+00f, -2.054975365e-01f, 5.138952759e-02f };
+        // sin(t) ~ t * P(t^2) and cos(t) ~ P(t^2) on [-pi/2, pi/2]
+        static const float kSinMedium[] = { 9.999966159e-01f, -1.666482838e-01f, 8.306325236e-03f, -1.836365417e-04f };
+        static const float kSinFast[] = { 9.996967734e-01f, -1.656730797e-01f, 7.514377299e-03f };
+        static const float kCosMedium[] = { 9.999999535e-01f, -4.999990536e-01f, 4.166358490e-02f, -1.385370544e-03f, 2.315395207e-05f };
+        static const float kCosFast[] = { 9.994035415e-01f, -4.955813576e-01f, 3.679184800e-02f };
+        // atan(r) ~ r * P(r^2) on [0, 1]
+        static const float kAtanMedium[] = { 9.999772191e-01f, -3.326228280e-01f, 1.935403761e-01f, -1.164264813e-01f, 5.264735033e-02f, -1.171913520e-02f };
+        static const float kAtanFast[] = { 9.992138127e-01f, -3.211749694e-01f, 1.462644626e-01f, -3.898651319e-02f };
+    }
+
+    /** Arc cosine, x is clamped to [-1, 1]
+    */
+    template<typename T>
+    T acosApprox(T x, TrigPrecision precision)
+    {
+        using namespace fastmath;
+        x = max(min(x, T(1.f)), T(-1.f));
+        if (precision == TrigPrecision::Exact) return exactAcos(x);
+
+        T a = abs(x);
+        T p = precision == TrigPrecision::Medium ? horner(a, kAcosMedium) : horner(a, kAcosFast);
+        T r = sqrt(T(1.f) - a) * p;
+        return select(x < T(0.f), T(float(kPi)) - r, r);
+    }
+
+    /** Sine and cosine of an angle in [0, pi], the range of the edge arcs
+    */
+    template<typename T>
+    void sinCosApprox(T x, T& s, T& c, TrigPrecision precision)
+    {
+        using namespace fastmath;
+        if (precision == TrigPrecision::Exact)
+        {
+            exactSinCos(x, s, c);
+            return;
+        }
+
+        // sin(x) = cos(t) and cos(x) = -sin(t) with t = x - pi/2 in [-pi/2, pi/2]
+        T t = x - T(float(0.5 * kPi));
+        T t2 = t * t;
+        bool medium = precision == TrigPrecision::Medium;
+        s = medium ? horner(t2, kCosMedium) : horner(t2, kCosFast);
+        c = -t * (medium ? horner(t2, kSinMedium) : horner(t2, kSinFast));
+    }
+
+    /** Two argument arc tangent. The polynomials return 0 for y = x = 0.
+    */
+    template<typename T>
+    T atan2Approx(T y, T x, TrigPrecision precision)
+    {
+        using namespace fastmath;
+        if (precision == TrigPrecision::Exact) return exactAtan2(y, x);
+
+        T ax = abs(x);
+        T ay = abs(y);
+        T hi = max(ax, ay);
+        // a tiny denominator keeps 0 / 0 finite
+        T r = min(ax, ay) / max(hi, T(1e-30f));
+        T r2 = r * r;
+        T a = r * (precision == TrigPrecision::Medium ? horner(r2, kAtanMedium) : horner(r2, kAtanFast));
+        a = select(ay > ax, T(float(0.5 * kPi)) - a, a);
+        a = select(x < T(0.f), T(float(kPi)) - a, a);
+        return select(y < T(0.f), -a, a);
+    }
+
+    /** theta / sin(theta) for cosTheta = cos(theta), the factor of the LTC edge integral. Exact and Medium clamp
+        cosTheta to +-0.9999 like the original code.
+    */
+    template<typename Real>
+    Real thetaOverSinTheta(Real cosTheta, TrigPrecision precision)
+    {
+        if (precision == TrigPrecision::Fast)
+        {
+            // rational fit from Heitz's LTC reference code, which folds in the 1 / (2 pi) of the form factor
+            Real y = std::abs(cosTheta);
+            Real a = Real(0.8543985) + (Real(0.4965155) + Real(0.0145206) * y) * y;
+            Real b = Real(3.4175940) + (Real(4.1616724) + y) * y;
+            Real v = Real(2.0 * kPi) * a / b;
+            // theta / sin(theta) = pi / sin(theta) - (pi - theta) / sin(theta) past 90 degrees
+            return cosTheta > Real(0.0) ? v : Real(kPi) / std::sqrt(std::max(Real(1.0) - cosTheta * cosTheta, Real(1e-7))) - v;
+        }
+        cosTheta = std::min(std::max(cosTheta, Real(-0.9999)), Real(0.9999));
+        Real theta = acosApprox(cosTheta, precision);
+        return precision == TrigPrecision::Exact ? theta / std::sin(theta) : theta / std::sqrt(Real(1.0) - cosTheta * cosTheta);
+    }
+}
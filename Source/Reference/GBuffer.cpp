@@ -0,0 +1,92 @@
+#include "GBuffer.h"
+#include "../MappedNumpy.h"
+#include "../Numpy.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace ltsh
+{
+    namespace
+    {
+        const char* kBufferSuffix[4] = { "_gbuf0.npy", "_gbuf1.npy", "_gbuf2.npy", "_gbuf3.npy" };
+
+        std::ostream& operator<<(std::ostream& s, const float3& v)
+        {
+            return s << v.x << " " << v.y << " " << v.z;
+        }
+
+        std::istream& operator>>(std::istream& s, float3& v)
+        {
+            return s >> v.x >> v.y >> v.z;
+        }
+    }
+
+    void GBufferFrame::save(const std::string& prefix) const
+    {
+        const std::vector<float4>* buffers[4] = { &posLightFlag, &normalLinearRoughness, &albedo, &specularRoughness };
+        for (int i = 0; i < 4; i++)
+        {
+            aoba::SaveArrayAsNumpy(prefix + kBufferSuffix[i], (int)height, (int)width, 4, reinterpret_cast<const float*>(buffers[i]->data()));
+        }
+
+        std::ofstream stream(prefix + "_frame.txt");
+        if (!stream)
+        {
+            throw std::runtime_error("io error: failed to open a file.");
+        }
+        stream.precision(9);
+        stream << "width " << width << "\n";
+        stream << "height " << height << "\n";
+        stream << "camPosW " << camPosW << "\n";
+        stream << "lightPosW " << areaLight.posW << "\n";
+        stream << "lightDirW " << areaLight.dirW << "\n";
+        stream << "lightIntensity " << areaLight.intensity << "\n";
+        stream << "lightSurfaceArea " << areaLight.surfaceArea << "\n";
+        for (const float3& v : areaLightPosW)
+        {
+            stream << "lightVertex " << v << "\n";
+        }
+    }
+
+    void GBufferFrame::load(const std::string& prefix)
+    {
+        std::ifstream stream(prefix + "_frame.txt");
+        if (!stream)
+        {
+            throw std::runtime_error("io error: failed to open " + prefix + "_frame.txt");
+        }
+        areaLightPosW.clear();
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            std::istringstream ls(line);
+            std::string key;
+            ls >> key;
+            if (key == "width") ls >> width;
+            else if (key == "height") ls >> height;
+            else if (key == "camPosW") ls >> camPosW;
+            else if (key == "lightPosW") ls >> areaLight.posW;
+            else if (key == "lightDirW") ls >> areaLight.dirW;
+            else if (key == "lightIntensity") ls >> areaLight.intensity;
+            else if (key == "lightSurfaceArea") ls >> areaLight.surfaceArea;
+            else if (key == "lightVertex")
+            {
+                float3 v;
+                ls >> v;
+                areaLightPosW.push_back(v);
+            }
+        }
+
+        std::vector<float4>* buffers[4] = { &posLightFlag, &normalLinearRoughness, &albedo, &specularRoughness };
+        for (int i = 0; i < 4; i++)
+        {
+            MappedNumpyArray file(prefix + kBufferSuffix[i]);
+            ArraySpan<float> data = file.getData<float>({ height, width, 4 });
+            buffers[i]->resize(getPixelCount());
+            std::memcpy(static_cast<void*>(buffers[i]->data()), data.data(), data.size() * sizeof(float));
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Serialized G-buffer of one frame plus everything the lighting pass reads from its constant buffer.
+// The four targets are stored as float32 .npy files of shape (height, width, 4), the scalar state in a small
+// key/value text file. SimpleDeferred writes these files when G is pressed.
+
+#include "Shading.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ltsh
+{
+    struct GBufferFrame
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        // gGBuf0..3 of the deferred pass
+        std::vector<float4> posLightFlag;           // world position, light flag
+        std::vector<float4> normalLinearRoughness;  // world normal, linear roughness
+        std::vector<float4> albedo;                 // diffuse albedo, opacity
+        std::vector<float4> specularRoughness;      // specular color, roughness
+
+        float3 camPosW;
+        AreaLightData areaLight;
+        // world space vertices of the area light polygon
+        std::vector<float3> areaLightPosW;
+
+        /** Write the frame to <prefix>_gbuf0.npy .. <prefix>_gbuf3.npy and <prefix>_frame.txt
+        */
+        void save(const std::string& prefix) const;
+
+        /** Read a frame written by save(). Throws std::runtime_error on malformed input.
+        */
+        void load(const std::string& prefix);
+
+        size_t getPixelCount() const { return size_t(width) * height; }
+    };
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// IEEE 754 half precision conversion, bit-compatible with glm::detail::toFloat16/toFloat32 which the Falcor build
+// uses to fill the RGBA16F textures. Round to nearest even, overflow saturates to infinity.
+
+#include <cstdint>
+#include <cstring>
+
+namespace ltsh
+{
+    typedef uint16_t half;
+
+    inline half floatToHalf(float f)
+    {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+        uint32_t sign = (x >> 16) & 0x8000u;
+        uint32_t absX = x & 0x7fffffffu;
+
+        // NaN and infinity
+        if (absX >= 0x7f800000u)
+        {
+            return (half)(sign | 0x7c00u | (absX > 0x7f800000u ? 0x200u : 0u));
+        }
+        // overflow
+        if (absX >= 0x477ff000u)
+        {
+            return (half)(sign | 0x7c00u);
+        }
+        // denormals and zero
+        if (absX < 0x38800000u)
+        {
+            if (absX < 0x33000000u)
+            {
+                return (half)sign;
+            }
+            uint32_t mantissa = (absX & 0x7fffffu) | 0x800000u;
+            int shift = 113 - int(absX >> 23) + 13;
+            uint32_t rounded = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (rounded & 1u)))
+            {
+                rounded++;
+            }
+            return (half)(sign | rounded);
+        }
+        // normalized numbers, round to nearest even
+        uint32_t rounded = absX - 0x38000000u;
+        rounded += 0xfffu + ((rounded >> 13) & 1u);
+        return (half)(sign | (rounded >> 13));
+    }
+
+    inline float halfToFloat(half h)
+    {
+        uint32_t sign = uint32_t(h & 0x8000u) << 16;
+        uint32_t exponent = (h >> 10) & 0x1fu;
+        uint32_t mantissa = h & 0x3ffu;
+        uint32_t x;
+        if (exponent == 0)
+        {
+            if (mantissa == 0)
+            {
+                x = sign;
+            }
+            else
+            {
+                // renormalize the denormal
+                exponent = 113;
+                while ((mantissa & 0x400u) == 0)
+                {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                x = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+            }
+        }
+        else if (exponent == 31)
+        {
+            x = sign | 0x7f800000u | (mantissa << 13);
+        }
+        else
+        {
+            x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+
+    /** Round a float to the closest half precision value, used to mimic the precision of the RGBA16F textures
+    */
+    inline float quantizeToHalf(float f)
+    {
+        return halfToFloat(floatToHalf(f));
+    }
+}
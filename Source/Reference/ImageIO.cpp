@@ -0,0 +1,146 @@
+#include "ImageIO.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace ltsh
+{
+    namespace
+    {
+        // all multi-byte values in EXR and our PFM files are little endian, which matches every platform we build on
+        template<typename T>
+        void put(std::vector<char>& out, const T& value)
+        {
+            const char* p = reinterpret_cast<const char*>(&value);
+            out.insert(out.end(), p, p + sizeof(T));
+        }
+
+        void putString(std::vector<char>& out, const char* s)
+        {
+            out.insert(out.end(), s, s + std::strlen(s) + 1);
+        }
+
+        void putAttribute(std::vector<char>& out, const char* name, const char* type, int32_t size)
+        {
+            putString(out, name);
+            putString(out, type);
+            put(out, size);
+        }
+
+        void writeFile(const std::string& filename, const std::vector<char>& data)
+        {
+            std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream)
+            {
+                throw std::runtime_error("io error: failed to open " + filename);
+            }
+            stream.write(data.data(), data.size());
+        }
+    }
+
+    void writeExr(const std::string& filename, const Image& image)
+    {
+        std::vector<char> out;
+        const int32_t w = (int32_t)image.width;
+        const int32_t h = (int32_t)image.height;
+
+        // magic number and version 2, single part scanline file
+        put(out, int32_t(20000630));
+        put(out, int32_t(2));
+
+        // channels are stored in alphabetical order
+        const char* channels[3] = { "B", "G", "R" };
+        putAttribute(out, "channels", "chlist", 3 * (2 + 16) + 1);
+        for (const char* c : channels)
+        {
+            putString(out, c);
+            put(out, int32_t(2));   // FLOAT
+            put(out, int32_t(0));   // pLinear + reserved
+            put(out, int32_t(1));   // xSampling
+            put(out, int32_t(1));   // ySampling
+        }
+        out.push_back(0);
+
+        putAttribute(out, "compression", "compression", 1);
+        out.push_back(0);           // NO_COMPRESSION
+
+        const int32_t window[4] = { 0, 0, w - 1, h - 1 };
+        putAttribute(out, "dataWindow", "box2i", 16);
+        for (int32_t v : window) put(out, v);
+        putAttribute(out, "displayWindow", "box2i", 16);
+        for (int32_t v : window) put(out, v);
+
+        putAttribute(out, "lineOrder", "lineOrder", 1);
+        out.push_back(0);           // INCREASING_Y
+
+        putAttribute(out, "pixelAspectRatio", "float", 4);
+        put(out, 1.f);
+        putAttribute(out, "screenWindowCenter", "v2f", 8);
+        put(out, 0.f);
+        put(out, 0.f);
+        putAttribute(out, "screenWindowWidth", "float", 4);
+        put(out, 1.f);
+        out.push_back(0);           // end of header
+
+        // offset table, one entry per scanline
+        const int32_t lineBytes = w * 3 * (int32_t)sizeof(float);
+        const uint64_t firstLine = out.size() + sizeof(uint64_t) * h;
+        for (int32_t y = 0; y < h; y++)
+        {
+            put(out, uint64_t(firstLine + uint64_t(y) * (8 + lineBytes)));
+        }
+
+        for (int32_t y = 0; y < h; y++)
+        {
+            put(out, y);
+            put(out, lineBytes);
+            for (int c = 2; c >= 0; c--)
+            {
+                for (int32_t x = 0; x < w; x++)
+                {
+                    put(out, image.at(x, y)[c]);
+                }
+            }
+        }
+
+        writeFile(filename, out);
+    }
+
+    void writePfm(const std::string& filename, const Image& image)
+    {
+        std::string header = "PF\n" + std::to_string(image.width) + " " + std::to_string(image.height) + "\n-1.0\n";
+        std::vector<char> out(header.begin(), header.end());
+        // PFM stores the bottom row first
+        for (uint32_t row = 0; row < image.height; row++)
+        {
+            uint32_t y = image.height - 1 - row;
+            for (uint32_t x = 0; x < image.width; x++)
+            {
+                const float3& p = image.at(x, y);
+                put(out, p.x);
+                put(out, p.y);
+                put(out, p.z);
+            }
+        }
+        writeFile(filename, out);
+    }
+
+    void writeImage(const std::string& filename, const Image& image)
+    {
+        size_t dot = filename.find_last_of('.');
+        std::string ext = dot == std::string::npos ? "" : filename.substr(dot + 1);
+        if (ext == "pfm" || ext == "PFM")
+        {
+            writePfm(filename, image);
+        }
+        else if (ext == "exr" || ext == "EXR")
+        {
+            writeExr(filename, image);
+        }
+        else
+        {
+            throw std::runtime_error("io error: unsupported image format " + filename);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// HDR image output for the CPU renderer without external dependencies: uncompressed scanline OpenEXR
+// (float32 RGB) and PFM.
+
+#include "VecMath.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ltsh
+{
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // row major, first row is the top of the image
+        std::vector<float3> pixels;
+
+        Image() {}
+        Image(uint32_t w, uint32_t h) : width(w), height(h), pixels(size_t(w) * h) {}
+
+        float3& at(uint32_t x, uint32_t y) { return pixels[size_t(y) * width + x]; }
+        const float3& at(uint32_t x, uint32_t y) const { return pixels[size_t(y) * width + x]; }
+    };
+
+    /** Write an uncompressed float32 OpenEXR file. Throws std::runtime_error on IO errors.
+    */
+    void writeExr(const std::string& filename, const Image& image);
+
+    /** Write a little endian PFM file. Throws std::runtime_error on IO errors.
+    */
+    void writePfm(const std::string& filename, const Image& image);
+
+    /** Write EXR or PFM depending on the file extension (.exr or .pfm)
+    */
+    void writeImage(const std::string& filename, const Image& image);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// CPU port of Data/LTC.slang: edge integration of linearly transformed cosines over clipped polygons.
+// code taken from https://eheitzresearch.wordpress.com/415-2/, some refactoring was done to meet our requirements
+
+#include "FastMath.h"
+#include "Polygon.h"
+
+namespace ltsh
+{
+    template<typename Real>
+    Real integrateEdge(const Vec3<Real>& v1, const Vec3<Real>& v2, TrigPrecision precision = TrigPrecision::Exact)
+    {
+        Real res = cross(v1, v2).z * thetaOverSinTheta(dot(v1, v2), precision);
+
+        return res;
+    }
+
+    /** Integrate the clamped cosine transformed by Minv over a polygonal light, in the tangent frame around N
+        \param[in] points The world space vertices of the light, convex or concave
+        \param[in] numPoints Number of vertices, 3 to kMaxPolygonVertices
+        \param[in] precision Approximation of theta / sin(theta) in the edge integral, see FastMath.h
+    */
+    template<typename Real>
+    Vec3<Real> ltcEvaluate(const Vec3<Real>& N, const Vec3<Real>& V, const Vec3<Real>& P, Mat3<Real> Minv, const Vec3<Real>* points, int numPoints, bool twoSided, const Vec3<Real>& lightIntensity,
+                           TrigPrecision precision = TrigPrecision::Exact)
+    {
+        // construct orthonormal basis around N
+        Vec3<Real> T1, T2;
+        T1 = normalize(V - N * dot(V, N));
+        T2 = cross(N, T1);
+
+        // rotate area light in (T1, T2, R) basis
+        Mat3<Real> baseMat = Mat3<Real>(T1, T2, N);
+        Minv = mul(Minv, baseMat);
+
+        Vec3<Real> polygon[kMaxPolygonVertices];
+        for (int i = 0; i < numPoints; i++)
+        {
+            polygon[i] = mul(Minv, points[i] - P);
+        }
+
+        Vec3<Real> L[kMaxClippedVertices];
+        int n = clipPolygonToHorizon(polygon, numPoints, L);
+
+        if (n == 0)
+            return Vec3<Real>(0);
+
+        // project onto sphere
+        for (int i = 0; i < n; i++)
+        {
+            L[i] = normalize(L[i]);
+        }
+
+        // integrate
+        Real sum = 0;
+        for (int i = 0; i < n; i++)
+        {
+            sum += integrateEdge(L[i], L[(i + 1) % n], precision);
+        }
+
+        // note: negated due to winding order
+        sum = twoSided ? std::abs(sum) : std::fmax(Real(0), -sum);
+
+        // scale by filtered light color
+        return lightIntensity * sum;
+    }
+
+    /** Transformed clamped cosine evaluated in direction L (without the normalization coefficient)
+    */
+    template<typename Real>
+    Real evalLtcBrdf(const Vec3<Real>& L, const Mat3<Real>& MInv)
+    {
+        Vec3<Real> LInv = mul(MInv, L);
+        Real D = std::abs(determinant(MInv));
+        Real L_ = length(LInv);
+        Real jacob = D / (L_ * L_ * L_);
+
+        LInv = normalize(LInv);
+        return saturate(LInv.z) * jacob / Real(3.14159f);
+    }
+}
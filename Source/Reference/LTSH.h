@@ -0,0 +1,298 @@
+#pragma once
+
+// CPU port of the closed-form SH projection of polygonal lights in Data/LTSH.slang. The scalar functions are
+// templated on the floating point type so the same code serves as a float oracle for the shader and as a
+// double precision reference. The batched 8-wide variant lives in LTSHSimd.h.
+
+#include "FastMath.h"
+#include "Polygon.h"
+
+namespace ltsh
+{
+    // Number of SH coefficients of the N=4 expansion
+    static const int kNumCoeffsN4 = 25;
+
+    // ------ BEGIN: The following code is taken from https://cseweb.ucsd.edu/~viscomp/projects/ash/, ported from Data/LTSH.slang ---------
+
+    /** Solid angle of a spherical polygon. The sign is flipped for clockwise polygons to enable double sided lighting.
+        Sums the signed solid angles of the triangle fan around vertex 0 (Van Oosterom and Strackee), which unlike the
+        interior angle sum of the original code also holds for concave polygons.
+        \param[in] verts Normalized polygon vertices
+        \param[in] numVerts Number of valid vertices (3 to kMaxClippedVertices)
+        \param[in] precision atan2 approximation, see FastMath.h
+    */
+    template<typename Real>
+    Real solidAngle(const Vec3<Real>* verts, int numVerts, TrigPrecision precision = TrigPrecision::Exact)
+    {
+        Real sa = 0;
+        for (int i = 1; i + 1 < numVerts; i++)
+        {
+            const Vec3<Real>& a = verts[0];
+            const Vec3<Real>& b = verts[i];
+            const Vec3<Real>& c = verts[i + 1];
+            Real numerator = dot(a, cross(b, c));
+            Real denominator = Real(1.0) + dot(a, b) + dot(b, c) + dot(c, a);
+            sa += Real(2.0) * atan2Approx(numerator, denominator, precision);
+        }
+        return sa;
+    }
+
+    template<typename Real>
+    void legendre(Real x, Real P[3])
+    {
+        P[0] = 0;
+        P[1] = x;
+        P[2] = Real(0.5) * (Real(3.0) * x * x - Real(1.0));
+    }
+
+    /** Boundary integrals B_n of one edge for n < maxN (maxN <= 5)
+    */
+    template<typename Real>
+    void boundary(Real a, Real b, Real x, int maxN, Real B_n[5], TrigPrecision precision = TrigPrecision::Exact)
+    {
+        Real sinX, cosX;
+        sinCosApprox(x, sinX, cosX, precision);
+        Real z = a * cosX + b * sinX;
+        Real tmp1 = a * sinX - b * cosX;
+        Real tmp2 = a * a + b * b - Real(1.0);
+
+        Real P[3];
+        legendre(z, P);
+        Real Pa[3];
+        legendre(a, Pa);
+
+        B_n[0] = x;
+        B_n[1] = tmp1 + b;
+
+        Real D_next = Real(3.0) * B_n[1];
+        Real D_prev = x;
+
+        for (int i = 2; i < maxN; i++)
+        {
+            Real j = Real(i);
+            Real sf = Real(1.0) / Real(i);
+
+            Real C_n = (tmp1 * P[i - 1]) + (tmp2 * D_prev) + ((j - Real(1.0)) * B_n[i - 2]) + (b * Pa[i - 1]);
+            C_n *= sf;
+
+            B_n[i] = (Real(2.0) * j - Real(1.0)) * C_n - (j - Real(1.0)) * B_n[i - 2];
+            B_n[i] *= sf;
+
+            Real temp = D_next;
+            D_next = (Real(2.0) * j + Real(1.0)) * B_n[i] + D_prev;
+            D_prev = temp;
+        }
+    }
+
+    /** Zonal harmonic integrals of the polygon around the lobe direction dir, surf[1..4] hold bands 1 to 4
+    */
+    template<typename Real>
+    void evalLight(const Vec3<Real>& dir, const Vec3<Real>* verts, const Vec3<Real>* gam, const Vec3<Real>* gamP, int maxN, int numVerts, Real surf[5],
+                   TrigPrecision precision = TrigPrecision::Exact)
+    {
+        Real total[5] = {};
+        Real bound[5];
+        for (int i = 0; i < numVerts; i++)
+        {
+            int next = (i + 1) % numVerts;
+            boundary(dot(dir, verts[i]), dot(dir, gamP[i]), acosApprox(dot(verts[i], verts[next]), precision), maxN, bound, precision);
+            Real w = dot(dir, gam[i]);
+            for (int n = 0; n < maxN; n++)
+            {
+                total[n] += bound[n] * w;
+            }
+        }
+
+        surf[1] = Real(0.5) * total[0];
+        surf[2] = Real(0.5) * total[1];
+        surf[3] = Real(0.416667) * total[2] + Real(0.166667) * surf[1];
+        surf[4] = Real(0.35) * total[3] + Real(0.3) * surf[2];
+
+        for (int i = 1; i < 5; i++)
+        {
+            surf[i] *= std::sqrt((Real(2.0) * Real(i) + Real(1.0)) / (Real(4.0) * Real(kPi)));
+        }
+    }
+
+    /** Lobe directions used to recover the SH coefficients from rotated zonal harmonics
+    */
+    template<typename Real>
+    const Vec3<Real>* polygonSHLobes()
+    {
+        static const Vec3<Real> kLobes[9] =
+        {
+            Vec3<Real>(Real(0.866025), Real(-0.500001), Real(-0.000004)),
+            Vec3<Real>(Real(-0.759553), Real(0.438522), Real(-0.480394)),
+            Vec3<Real>(Real(-0.000002), Real(0.638694), Real(0.769461)),
+            Vec3<Real>(Real(-0.000004), Real(-1.000000), Real(-0.000004)),
+            Vec3<Real>(Real(-0.000007), Real(0.000003), Real(-1.000000)),
+            Vec3<Real>(Real(-0.000002), Real(-0.638694), Real(0.769461)),
+            Vec3<Real>(Real(-0.974097), Real(0.000007), Real(-0.226131)),
+            Vec3<Real>(Real(-0.000003), Real(0.907079), Real(-0.420960)),
+            Vec3<Real>(Real(-0.960778), Real(0.000007), Real(-0.277320)),
+        };
+        return kLobes;
+    }
+
+    /** Combine the zonal integrals w[lobe][band] of the 9 lobes to the 24 non-constant SH coefficients Lcoeff[1..24]
+    */
+    template<typename Real>
+    void projectZonalToSH(const Real w[9][5], Real Lcoeff[25])
+    {
+        Lcoeff[1] = Real(2.1995339) * w[0][1] + Real(2.50785367) * w[1][1] + Real(1.56572711) * w[2][1];
+        Lcoeff[2] = Real(-1.82572523) * w[0][1] + Real(-2.08165037) * w[1][1];
+        Lcoeff[3] = Real(2.42459869) * w[0][1] + Real(1.44790525) * w[1][1] + Real(0.90397552) * w[2][1];
+
+        Lcoeff[4] = Real(-1.33331385) * w[0][2] + Real(-0.66666684) * w[3][2] + Real(-0.99999606) * w[4][2];
+        Lcoeff[5] = Real(1.1747938) * w[2][2] + Real(-0.47923799) * w[3][2] + Real(-0.69556433) * w[4][2];
+        Lcoeff[6] = w[4][2];
+        Lcoeff[7] = Real(-1.21710396) * w[0][2] + Real(1.58226094) * w[1][2] + Real(0.67825711) * w[2][2];
+        Lcoeff[7] += Real(-0.27666329) * w[3][2] + Real(-0.76671491) * w[4][2];
+        Lcoeff[8] = Real(-1.15470843) * w[3][2] + Real(-0.57735948) * w[4][2];
+
+        Lcoeff[9] = Real(-0.418128476395) * w[2][3] + Real(1.04704832111) * w[3][3] + Real(0.418135743058) * w[5][3];
+        Lcoeff[10] = Real(-0.217803921828) * w[0][3] + Real(1.61365275071) * w[1][3] + Real(-0.0430709310435) * w[2][3];
+        Lcoeff[10] += Real(-1.08141635635) * w[3][3] + Real(0.730013109257) * w[4][3] + Real(-0.906789272616) * w[5][3];
+        Lcoeff[11] = Real(0.539792926181) * w[2][3] + Real(0.281276817357) * w[3][3] + Real(-0.53979650602) * w[5][3];
+        Lcoeff[12] = Real(-1.0) * w[4][3];
+        Lcoeff[13] = Real(-1.88563738164) * w[0][3] + Real(0.934959388519) * w[2][3] + Real(-1.39846078802) * w[3][3] + Real(-0.934977410564) * w[5][3];
+        Lcoeff[14] = Real(-0.822588107798) * w[2][3] + Real(0.0250955547337) * w[4][3] + Real(-0.822583092847) * w[5][3];
+        Lcoeff[15] = Real(-1.14577301943) * w[0][3] + Real(1.03584677217) * w[2][3] + Real(-0.849735800355) * w[3][3];
+        Lcoeff[15] += Real(-0.438905584229) * w[4][3] + Real(-0.100364975081) * w[5][3] + Real(-1.36852983602) * w[6][3];
+        Lcoeff[16] = Real(-0.694140591095) * w[0][4] + Real(-1.46594132085) * w[1][4] + Real(-3.76291455607) * w[2][4];
+        Lcoeff[16] += Real(-4.19771773174) * w[3][4] + Real(-4.41452625915) * w[4][4] + Real(-5.21937739623) * w[5][4];
+        Lcoeff[16] += Real(30.1096083902) * w[6][4] + Real(-0.582891410482) * w[7][4] + Real(-25.58700736) * w[8][4];
+        Lcoeff[17] = Real(-0.776237001754) * w[2][4] + Real(-0.497694700099) * w[3][4] + Real(0.155804529921) * w[4][4] + Real(0.255292423057) * w[5][4];
+        Lcoeff[17] += Real(-0.00123151211175) * w[6][4] + Real(0.86352262597) * w[7][4] + Real(0.00106337156796) * w[8][4];
+        Lcoeff[18] = Real(1.14732747049) * w[0][4] + Real(-1.93927453351) * w[1][4] + Real(-4.97819284362) * w[2][4];
+        Lcoeff[18] += Real(-4.52057526927) * w[3][4] + Real(-7.00211058681) * w[4][4] + Real(-6.90497275343) * w[5][4];
+        Lcoeff[18] += Real(39.8336896922) * w[6][4] + Real(-0.771083185249) * w[7][4] + Real(-33.8504871326) * w[8][4];
+        Lcoeff[19] = Real(0.392392485498) * w[2][4] + Real(-0.469375435363) * w[3][4] + Real(0.146862690526) * w[4][4];
+        Lcoeff[19] += Real(-0.883760925422) * w[5][4] + Real(0.81431736181) * w[7][4];
+        Lcoeff[20] = Real(1.00015572278) * w[4][4] + Real(-0.00110374505123) * w[6][4] + Real(0.000937958411459) * w[8][4];
+        Lcoeff[21] = Real(7.51111593422) * w[2][4] + Real(6.56318513992) * w[3][4] + Real(7.31626822687) * w[4][4];
+        Lcoeff[21] += Real(7.51109857163) * w[5][4] + Real(-51.4260730066) * w[6][4] + Real(43.7016908482) * w[8][4];
+        Lcoeff[22] = Real(-0.61727564343) * w[2][4] + Real(0.205352092062) * w[3][4] + Real(-0.461764665742) * w[4][4] + Real(-0.617286413191) * w[5][4];
+        Lcoeff[23] = Real(6.71336600734) * w[2][4] + Real(5.24419547627) * w[3][4] + Real(7.13550000457) * w[4][4];
+        Lcoeff[23] += Real(6.71337558899) * w[5][4] + Real(-51.8339912003) * w[6][4] + Real(45.9921960339) * w[8][4];
+        Lcoeff[24] = Real(0.466450172383) * w[2][4] + Real(1.19684418958) * w[3][4] + Real(-0.158210638771) * w[4][4];
+        Lcoeff[24] += Real(0.466416144347) * w[5][4] + Real(0.000906975300098) * w[6][4];
+    }
+
+    /** Project a spherical polygon onto the first 25 SH coefficients (N=4)
+        \param[in] L Normalized polygon vertices, at most kMaxClippedVertices
+        \param[in] numVerts Number of valid vertices
+        \param[out] Lcoeff SH coefficients of the polygon's indicator function
+        \param[in] precision Approximation of the transcendental functions, see FastMath.h
+    */
+    template<typename Real>
+    void polygonSH(const Vec3<Real>* L, int numVerts, Real Lcoeff[25], TrigPrecision precision = TrigPrecision::Exact)
+    {
+        Vec3<Real> G[kMaxClippedVertices];
+        Vec3<Real> Gp[kMaxClippedVertices];
+        for (int i = 0; i < numVerts; i++)
+        {
+            G[i] = normalize(cross(L[i], L[(i + 1) % numVerts]));
+            Gp[i] = cross(G[i], L[i]);
+        }
+
+        Real SA = solidAngle(L, numVerts, precision);
+
+        Lcoeff[0] = Real(0.282095) * SA;
+
+        const Vec3<Real>* lobes = polygonSHLobes<Real>();
+        Real w[9][5];
+        for (int i = 0; i < 9; i++)
+        {
+            evalLight(lobes[i], L, G, Gp, 4, numVerts, w[i], precision);
+        }
+
+        projectZonalToSH(w, Lcoeff);
+    }
+
+    // ------ END: The following code is taken from https://cseweb.ucsd.edu/~viscomp/projects/ash/, ported from Data/LTSH.slang ---------
+
+    // ---------------- BEGIN: this code was provided by Christoph Peters and is used with permission -------------------
+
+    /** Evaluate the real SH basis up to band 4 in direction (x, y, z) and return the dot product with the coefficients
+    */
+    template<typename Real>
+    Real evaluateSH(Real x, Real y, Real z, const Real coefficients[25])
+    {
+        Real legendre0_0 = Real(1.0);
+        Real legendre1_0 = Real(1.00000000000000000e+00) * z * legendre0_0;
+        Real legendre1_1 = Real(-1.00000000000000000e+00) * legendre0_0;
+        Real legendre2_0 = Real(1.50000000000000000e+00) * z * legendre1_0 - Real(5.00000000000000000e-01) * legendre0_0;
+        Real legendre2_1 = Real(3.00000000000000000e+00) * z * legendre1_1;
+        Real legendre2_2 = Real(-3.00000000000000000e+00) * legendre1_1;
+        Real legendre3_0 = Real(1.66666666666666674e+00) * z * legendre2_0 - Real(6.66666666666666630e-01) * legendre1_0;
+        Real legendre3_1 = Real(2.50000000000000000e+00) * z * legendre2_1 - Real(1.50000000000000000e+00) * legendre1_1;
+        Real legendre3_2 = Real(5.00000000000000000e+00) * z * legendre2_2;
+        Real legendre3_3 = Real(-5.00000000000000000e+00) * legendre2_2;
+        Real legendre4_0 = Real(1.75000000000000000e+00) * z * legendre3_0 - Real(7.50000000000000000e-01) * legendre2_0;
+        Real legendre4_1 = Real(2.33333333333333348e+00) * z * legendre3_1 - Real(1.33333333333333326e+00) * legendre2_1;
+        Real legendre4_2 = Real(3.50000000000000000e+00) * z * legendre3_2 - Real(2.50000000000000000e+00) * legendre2_2;
+        Real legendre4_3 = Real(7.00000000000000000e+00) * z * legendre3_3;
+        Real legendre4_4 = Real(-7.00000000000000000e+00) * legendre3_3;
+        Real cosine0 = Real(1.0);
+        Real sine0 = Real(0.0);
+        Real cosine1 = x * cosine0 - y * sine0;
+        Real sine1 = x * sine0 + y * cosine0;
+        Real cosine2 = x * cosine1 - y * sine1;
+        Real sine2 = x * sine1 + y * cosine1;
+        Real cosine3 = x * cosine2 - y * sine2;
+        Real sine3 = x * sine2 + y * cosine2;
+        Real cosine4 = x * cosine3 - y * sine3;
+        Real sine4 = x * sine3 + y * cosine3;
+
+        Real pSH[25];
+        pSH[0] = Real(2.82094791773878140e-01) * cosine0 * legendre0_0;
+        pSH[1] = Real(-4.88602511902919923e-01) * sine1 * legendre1_1;
+        pSH[2] = Real(4.88602511902919923e-01) * cosine0 * legendre1_0;
+        pSH[3] = Real(-4.88602511902919923e-01) * cosine1 * legendre1_1;
+        pSH[4] = Real(1.82091405098679854e-01) * sine2 * legendre2_2;
+        pSH[5] = Real(-3.64182810197359708e-01) * sine1 * legendre2_1;
+        pSH[6] = Real(6.30783130505040091e-01) * cosine0 * legendre2_0;
+        pSH[7] = Real(-3.64182810197359708e-01) * cosine1 * legendre2_1;
+        pSH[8] = Real(1.82091405098679854e-01) * cosine2 * legendre2_2;
+        pSH[9] = Real(-3.93362393284428999e-02) * sine3 * legendre3_3;
+        pSH[10] = Real(9.63537147546851408e-02) * sine2 * legendre3_2;
+        pSH[11] = Real(-3.04697199642977146e-01) * sine1 * legendre3_1;
+        pSH[12] = Real(7.46352665180230801e-01) * cosine0 * legendre3_0;
+        pSH[13] = Real(-3.04697199642977146e-01) * cosine1 * legendre3_1;
+        pSH[14] = Real(9.63537147546851408e-02) * cosine2 * legendre3_2;
+        pSH[15] = Real(-3.93362393284428999e-02) * cosine3 * legendre3_3;
+        pSH[16] = Real(5.96034033761120175e-03) * sine4 * legendre4_4;
+        pSH[17] = Real(-1.68583882836183876e-02) * sine3 * legendre4_3;
+        pSH[18] = Real(6.30783130505040007e-02) * sine2 * legendre4_2;
+        pSH[19] = Real(-2.67618617422915650e-01) * sine1 * legendre4_1;
+        pSH[20] = Real(8.46284375321634474e-01) * cosine0 * legendre4_0;
+        pSH[21] = Real(-2.67618617422915650e-01) * cosine1 * legendre4_1;
+        pSH[22] = Real(6.30783130505040007e-02) * cosine2 * legendre4_2;
+        pSH[23] = Real(-1.68583882836183876e-02) * cosine3 * legendre4_3;
+        pSH[24] = Real(5.96034033761120175e-03) * cosine4 * legendre4_4;
+
+        Real sum = 0;
+        for (int i = 0; i < 25; i++)
+        {
+            sum += pSH[i] * coefficients[i];
+        }
+        return sum;
+    }
+
+    // ---------------- END: this code was provided by Christoph Peters and is used with permission -------------------
+
+    /** Transformed SH lobe evaluated in direction L, the CPU counterpart of evalLtshBrdf() in Data/LTSH.slang
+    */
+    template<typename Real>
+    Real evalLtshBrdf(const Vec3<Real>& L, const Mat3<Real>& MInv, const Real coefficients[25])
+    {
+        Vec3<Real> LInv = mul(MInv, L);
+        Real D = std::abs(determinant(MInv));
+        Real L_ = length(LInv);
+        Real jacob = D / (L_ * L_ * L_);
+
+        LInv = normalize(LInv);
+        return evaluateSH(LInv.x, LInv.y, LInv.z, coefficients) * jacob;
+    }
+}
@@ -0,0 +1,323 @@
+#include "LTSHSimd.h"
+#include <algorithm>
+
+using namespace ltsh::simd;
+
+namespace ltsh
+{
+    namespace
+    {
+        struct Vec3x8
+        {
+            float8 x, y, z;
+
+            Vec3x8() {}
+            Vec3x8(float8 x_, float8 y_, float8 z_) : x(x_), y(y_), z(z_) {}
+        };
+
+        inline float8 dot(const Vec3x8& a, const Vec3x8& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        inline float8 dot(const float3& a, const Vec3x8& b) { return float8(a.x) * b.x + float8(a.y) * b.y + float8(a.z) * b.z; }
+        inline Vec3x8 cross(const Vec3x8& a, const Vec3x8& b)
+        {
+            return Vec3x8(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+        }
+        inline float8 length(const Vec3x8& v) { return simd::sqrt(dot(v, v)); }
+        inline Vec3x8 normalize(const Vec3x8& v)
+        {
+            float8 l = length(v);
+            return Vec3x8(v.x / l, v.y / l, v.z / l);
+        }
+        inline Vec3x8 select(float8 mask, const Vec3x8& a, const Vec3x8& b)
+        {
+            return Vec3x8(simd::select(mask, a.x, b.x), simd::select(mask, a.y, b.y), simd::select(mask, a.z, b.z));
+        }
+
+        // edge data shared by all lobes
+        struct Edges
+        {
+            Vec3x8 L[kMaxBatchVertices];
+            Vec3x8 next[kMaxBatchVertices];
+            Vec3x8 G[kMaxBatchVertices];
+            Vec3x8 Gp[kMaxBatchVertices];
+            float8 arc[kMaxBatchVertices];      // acos(dot(L, next)), the same for every lobe
+            float8 sinArc[kMaxBatchVertices];
+            float8 cosArc[kMaxBatchVertices];
+            float8 active[kMaxBatchVertices];
+        };
+
+        // solidAngle() from LTSH.h
+        float8 solidAngle(const Edges& e, float8 n, TrigPrecision precision)
+        {
+            float8 sa(0.f);
+            for (int i = 1; i + 1 < kMaxBatchVertices; i++)
+            {
+                const Vec3x8& a = e.L[0];
+                const Vec3x8& b = e.L[i];
+                const Vec3x8& c = e.L[i + 1];
+                float8 num = dot(a, cross(b, c));
+                float8 den = float8(1.f) + dot(a, b) + dot(b, c) + dot(c, a);
+                // triangles past the last vertex are masked, like the inactive edges
+                sa += (float8(float(i + 1)) < n) & (float8(2.f) * atan2Approx(num, den, precision));
+            }
+            return sa;
+        }
+
+        // boundary() from LTSH.h with maxN = 4, the edge arc x and its sine and cosine come precomputed
+        void boundary(float8 a, float8 b, float8 x, float8 s, float8 c, float8 B_n[4])
+        {
+            float8 z = a * c + b * s;
+            float8 tmp1 = a * s - b * c;
+            float8 tmp2 = a * a + b * b - float8(1.f);
+
+            float8 P[3] = { float8(0.f), z, float8(0.5f) * (float8(3.f) * z * z - float8(1.f)) };
+            float8 Pa[3] = { float8(0.f), a, float8(0.5f) * (float8(3.f) * a * a - float8(1.f)) };
+
+            B_n[0] = x;
+            B_n[1] = tmp1 + b;
+
+            float8 D_next = float8(3.f) * B_n[1];
+            float8 D_prev = x;
+
+            for (int i = 2; i < 4; i++)
+            {
+                float8 j = float8(float(i));
+                float8 sf = float8(1.f / float(i));
+
+                float8 C_n = (tmp1 * P[i - 1]) + (tmp2 * D_prev) + ((j - float8(1.f)) * B_n[i - 2]) + (b * Pa[i - 1]);
+                C_n *= sf;
+
+                B_n[i] = (float8(2.f) * j - float8(1.f)) * C_n - (j - float8(1.f)) * B_n[i - 2];
+                B_n[i] *= sf;
+
+                float8 temp = D_next;
+                D_next = (float8(2.f) * j + float8(1.f)) * B_n[i] + D_prev;
+                D_prev = temp;
+            }
+        }
+
+        void evalLight(const float3& dir, const Edges& e, float8 surf[5])
+        {
+            float8 total[4];
+            for (int i = 0; i < kMaxBatchVertices; i++)
+            {
+                float8 bound[4];
+                boundary(dot(dir, e.L[i]), dot(dir, e.Gp[i]), e.arc[i], e.sinArc[i], e.cosArc[i], bound);
+                float8 w = dot(dir, e.G[i]);
+                for (int n = 0; n < 4; n++)
+                {
+                    // inactive edges may be degenerate, mask the product rather than the weight to drop NaNs
+                    total[n] += e.active[i] & (bound[n] * w);
+                }
+            }
+
+            surf[1] = float8(0.5f) * total[0];
+            surf[2] = float8(0.5f) * total[1];
+            surf[3] = float8(0.416667f) * total[2] + float8(0.166667f) * surf[1];
+            surf[4] = float8(0.35f) * total[3] + float8(0.3f) * surf[2];
+
+            for (int i = 1; i < 5; i++)
+            {
+                surf[i] *= float8(std::sqrt((2.f * float(i) + 1.f) / (4.f * float(kPi))));
+            }
+        }
+    }
+
+    void PolygonBatch::setLane(int lane, const float3* L, int n)
+    {
+        for (int i = 0; i < kMaxBatchVertices; i++)
+        {
+            // repeat the first vertex in unused slots to keep the inactive edges finite
+            const float3& v = i < n ? L[i] : L[0];
+            x[i][lane] = v.x;
+            y[i][lane] = v.y;
+            z[i][lane] = v.z;
+        }
+        numVerts[lane] = n;
+    }
+
+    void SHBatch::getLane(int lane, float out[kNumCoeffsN4]) const
+    {
+        for (int k = 0; k < kNumCoeffsN4; k++)
+        {
+            out[k] = coeffs[k][lane];
+        }
+    }
+
+    void polygonSHBatch(const PolygonBatch& L, SHBatch& Lcoeff, TrigPrecision precision)
+    {
+        float nf[kWidth];
+        for (int lane = 0; lane < kWidth; lane++)
+        {
+            nf[lane] = (float)L.numVerts[lane];
+        }
+        float8 n = float8::load(nf);
+        float8 valid = n >= float8(3.f);
+        // degenerate lanes are evaluated as triangles and masked at the end
+        n = simd::select(valid, n, float8(3.f));
+
+        Edges e;
+        for (int i = 0; i < kMaxBatchVertices; i++)
+        {
+            e.L[i] = Vec3x8(float8::load(L.x[i]), float8::load(L.y[i]), float8::load(L.z[i]));
+        }
+        for (int i = 0; i < kMaxBatchVertices; i++)
+        {
+            e.active[i] = float8(float(i)) < n;
+            e.next[i] = i + 1 < kMaxBatchVertices ? select(float8(float(i + 1)) < n, e.L[i + 1], e.L[0]) : e.L[0];
+            e.G[i] = normalize(cross(e.L[i], e.next[i]));
+            e.Gp[i] = cross(e.G[i], e.L[i]);
+            e.arc[i] = acosApprox(dot(e.L[i], e.next[i]), precision);
+            sinCosApprox(e.arc[i], e.sinArc[i], e.cosArc[i], precision);
+        }
+
+        float8 c[kNumCoeffsN4];
+        c[0] = float8(0.282095f) * solidAngle(e, n, precision);
+
+        const float3* lobes = polygonSHLobes<float>();
+        float8 w[9][5];
+        for (int i = 0; i < 9; i++)
+        {
+            evalLight(lobes[i], e, w[i]);
+        }
+        projectZonalToSH(w, c);
+
+        for (int k = 0; k < kNumCoeffsN4; k++)
+        {
+            (valid & c[k]).store(Lcoeff.coeffs[k]);
+        }
+    }
+
+    void polygonSHArray(const float3* polygons, const int* numVerts, size_t count, float* Lcoeff, TrigPrecision precision)
+    {
+        PolygonBatch batch;
+        SHBatch result;
+        for (size_t first = 0; first < count; first += kWidth)
+        {
+            size_t lanes = std::min<size_t>(kWidth, count - first);
+            for (int lane = 0; lane < kWidth; lane++)
+            {
+                // pad the last batch by repeating its first polygon
+                size_t p = first + (lane < (int)lanes ? lane : 0);
+                batch.setLane(lane, polygons + p * kMaxBatchVertices, numVerts[p]);
+            }
+            polygonSHBatch(batch, result, precision);
+            for (size_t lane = 0; lane < lanes; lane++)
+            {
+                result.getLane((int)lane, Lcoeff + (first + lane) * kNumCoeffsN4);
+            }
+        }
+    }
+
+    size_t polygonSHTile(const float3* polygonW, int numVertices, const TilePoint* points, size_t count, float* Lcoeff, TrigPrecision precision)
+    {
+        PolygonBatch batch;
+        SHBatch result;
+        size_t numScalar = 0;
+        for (size_t first = 0; first < count; first += kWidth)
+        {
+            size_t lanes = std::min<size_t>(kWidth, count - first);
+
+            // transpose position, frame and MInv of the packet, the last packet is padded with its first point
+            alignas(32) float pos[3][kWidth];
+            alignas(32) float frame[9][kWidth];
+            alignas(32) float MInv[9][kWidth];
+            for (int lane = 0; lane < kWidth; lane++)
+            {
+                const TilePoint& p = points[first + (lane < (int)lanes ? lane : 0)];
+                for (int r = 0; r < 3; r++)
+                {
+                    pos[r][lane] = p.posW[r];
+                    for (int c = 0; c < 3; c++)
+                    {
+                        frame[r * 3 + c][lane] = p.frame[r][c];
+                        MInv[r * 3 + c][lane] = p.MInv[r][c];
+                    }
+                }
+            }
+            Vec3x8 P(float8::load(pos[0]), float8::load(pos[1]), float8::load(pos[2]));
+            Vec3x8 T1(float8::load(frame[0]), float8::load(frame[1]), float8::load(frame[2]));
+            Vec3x8 T2(float8::load(frame[3]), float8::load(frame[4]), float8::load(frame[5]));
+            Vec3x8 N(float8::load(frame[6]), float8::load(frame[7]), float8::load(frame[8]));
+
+            // light in the shading frame of every lane
+            alignas(32) float local[3][kMaxPolygonVertices][kWidth];
+            float8 below(0.f);
+            for (int i = 0; i < numVertices; i++)
+            {
+                const float3& v = polygonW[i];
+                Vec3x8 rel(float8(v.x) - P.x, float8(v.y) - P.y, float8(v.z) - P.z);
+                float8 z = dot(N, rel);
+                dot(T1, rel).store(local[0][i]);
+                dot(T2, rel).store(local[1][i]);
+                z.store(local[2][i]);
+                below = below | (z <= float8(0.f));
+            }
+
+            bool scalarLane[kWidth] = {};
+            int belowMask = simd::moveMask(below);
+            for (int lane = 0; lane < kWidth; lane++)
+            {
+                float3 L[kMaxPolygonVertices];
+                for (int i = 0; i < numVertices; i++)
+                {
+                    L[i] = float3(local[0][i][lane], local[1][i][lane], local[2][i][lane]);
+                }
+
+                float3 clipped[kMaxClippedVertices];
+                const float3* V = L;
+                int n = numVertices;
+                if (belowMask & (1 << lane))
+                {
+                    n = clipPolygonToHorizon(L, numVertices, clipped);
+                    V = clipped;
+                }
+                if (n <= kMaxBatchVertices)
+                {
+                    // lanes below the horizon get a finite dummy vertex and produce zero coefficients
+                    const float3 up(0.f, 0.f, 1.f);
+                    batch.setLane(lane, n > 0 ? V : &up, n);
+                    continue;
+                }
+
+                // too many vertices for the batch, finish this point on its own and leave the lane empty
+                if (lane < (int)lanes)
+                {
+                    const TilePoint& p = points[first + lane];
+                    float3 W[kMaxClippedVertices];
+                    for (int i = 0; i < n; i++)
+                    {
+                        W[i] = normalize(mul(p.MInv, V[i]));
+                    }
+                    polygonSH(W, n, Lcoeff + (first + lane) * kNumCoeffsN4, precision);
+                    numScalar++;
+                }
+                scalarLane[lane] = true;
+                const float3 up(0.f, 0.f, 1.f);
+                batch.setLane(lane, &up, 0);
+            }
+
+            // MInv and normalization for all lanes at once, empty lanes hold a finite dummy vertex
+            Vec3x8 M0(float8::load(MInv[0]), float8::load(MInv[1]), float8::load(MInv[2]));
+            Vec3x8 M1(float8::load(MInv[3]), float8::load(MInv[4]), float8::load(MInv[5]));
+            Vec3x8 M2(float8::load(MInv[6]), float8::load(MInv[7]), float8::load(MInv[8]));
+            for (int i = 0; i < kMaxBatchVertices; i++)
+            {
+                Vec3x8 v(float8::load(batch.x[i]), float8::load(batch.y[i]), float8::load(batch.z[i]));
+                v = normalize(Vec3x8(dot(M0, v), dot(M1, v), dot(M2, v)));
+                v.x.store(batch.x[i]);
+                v.y.store(batch.y[i]);
+                v.z.store(batch.z[i]);
+            }
+
+            polygonSHBatch(batch, result, precision);
+            for (size_t lane = 0; lane < lanes; lane++)
+            {
+                if (!scalarLane[lane])
+                {
+                    result.getLane((int)lane, Lcoeff + (first + lane) * kNumCoeffsN4);
+                }
+            }
+        }
+        return numScalar;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+// Batched version of polygonSH() from LTSH.h. Evaluates the N=4 projection for simd::kWidth (8) shading points
+// per call, one polygon per lane, in structure-of-arrays layout. Lanes may have different vertex counts.
+//
+// polygonSHTile() goes one step further for a tile of shading points lit by the same light: it does the work of
+// CpuLightingPass::evalAreaLightLTSH() up to the projection (frame change, horizon clip, MInv, normalize) eight
+// points at a time, so a renderer can hand it whole tiles instead of calling polygonSH() once per pixel.
+
+#include "LTSH.h"
+#include "Polygon.h"
+#include "Simd.h"
+
+namespace ltsh
+{
+    // The batch is laid out for clipped quads, wider polygons go through the scalar polygonSH()
+    static const int kMaxBatchVertices = 5;
+
+    // Max. absolute difference of polygonSHBatch() and polygonSHTile() to the scalar float path with exact trig,
+    // ltsh_bench fails above it. Both float paths are about 5e-6 off the double precision result.
+    static const float kMaxBatchDeviation = 2e-5f;
+
+    /** Polygons of 8 shading points in SoA layout, x[i][lane] is the x coordinate of vertex i in the given lane.
+        Vertices must be normalized, numVerts may differ per lane. Lanes with less than 3 vertices produce zero coefficients.
+    */
+    struct alignas(32) PolygonBatch
+    {
+        float x[kMaxBatchVertices][simd::kWidth];
+        float y[kMaxBatchVertices][simd::kWidth];
+        float z[kMaxBatchVertices][simd::kWidth];
+        int numVerts[simd::kWidth];
+
+        /** Write a polygon into a lane
+            \param[in] lane Lane index in [0, simd::kWidth)
+            \param[in] L Normalized polygon vertices
+            \param[in] n Number of vertices
+        */
+        void setLane(int lane, const float3* L, int n);
+    };
+
+    /** SH coefficients of 8 polygons, coeffs[k][lane]
+    */
+    struct alignas(32) SHBatch
+    {
+        float coeffs[kNumCoeffsN4][simd::kWidth];
+
+        void getLane(int lane, float out[kNumCoeffsN4]) const;
+    };
+
+    /** Project 8 spherical polygons onto the first 25 SH coefficients. Vectorized counterpart of polygonSH<float>().
+        With exact trig the coefficients stay within kMaxBatchDeviation of polygonSH<float>() (absolute). The remaining
+        difference comes from the Cephes polynomials of simd::acos, simd::sincos and simd::atan2 (1 to 2 ulp against
+        libm) and from the edge arc being computed once per edge, where the scalar path recomputes it per lobe.
+        The solid angle used to take the atan2 as acos(x / sqrt(x^2 + y^2)), which loses half the float digits for
+        small angles and put the batch up to 1.8e-4 off; simd::atan2 brought it down to the rounding error.
+        \param[in] precision Approximation of acos, sincos and atan2, see FastMath.h
+    */
+    void polygonSHBatch(const PolygonBatch& L, SHBatch& Lcoeff, TrigPrecision precision = TrigPrecision::Exact);
+
+    /** Project count polygons, scalar tail included. Convenience wrapper around polygonSHBatch() for AoS input.
+        \param[in] polygons count * kMaxBatchVertices normalized vertices
+        \param[in] numVerts Vertex count per polygon
+        \param[in] count Number of polygons
+        \param[out] Lcoeff count * kNumCoeffsN4 coefficients
+    */
+    void polygonSHArray(const float3* polygons, const int* numVerts, size_t count, float* Lcoeff, TrigPrecision precision = TrigPrecision::Exact);
+
+    /** A shading point of a tile, see polygonSHTile()
+    */
+    struct TilePoint
+    {
+        float3 posW;
+        float3x3 frame;     ///< Rows T1, T2, N of the shading frame
+        float3x3 MInv;      ///< LTSH matrix of the point
+    };
+
+    /** Project one light polygon for count shading points. Per point this matches clipping the polygon in the shading
+        frame, transforming the clipped vertices by MInv, normalizing them and calling polygonSH<float>(). The frame
+        change and the MInv transform run on eight points at once, and the scalar clip only runs for points that see
+        part of the light. Points whose clipped polygon has more than kMaxBatchVertices vertices take the scalar path.
+        \param[in] polygonW numVertices world space vertices of the light, at most kMaxPolygonVertices
+        \param[in] points count shading points
+        \param[out] Lcoeff count * kNumCoeffsN4 coefficients, zero for points that don't see the light
+        \return Number of points that went through the scalar path
+    */
+    size_t polygonSHTile(const float3* polygonW, int numVertices, const TilePoint* points, size_t count, float* Lcoeff,
+                         TrigPrecision precision = TrigPrecision::Exact);
+}
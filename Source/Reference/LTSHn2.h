@@ -0,0 +1,98 @@
+#pragma once
+
+// CPU port of the N=2 (9 coefficient) SH projection in Data/LTSHn2.slang
+
+#include "LTSH.h"
+
+namespace ltsh
+{
+    // Number of SH coefficients of the N=2 expansion
+    static const int kNumCoeffsN2 = 9;
+
+    // ------- BEGIN: The following code is taken from https://cseweb.ucsd.edu/~viscomp/projects/ash/, ported from Data/LTSHn2.slang ---------
+
+    template<typename Real>
+    void boundaryN2(Real a, Real b, Real x, Real B_n[3], TrigPrecision precision = TrigPrecision::Exact)
+    {
+        Real sinX, cosX;
+        sinCosApprox(x, sinX, cosX, precision);
+        Real z = a * cosX + b * sinX;
+        Real tmp1 = a * sinX - b * cosX;
+        Real tmp2 = a * a + b * b - Real(1.0);
+
+        B_n[0] = x;
+        B_n[1] = tmp1 + b;
+
+        Real D_prev = x;
+
+        Real C_n = (tmp1 * z) + (tmp2 * D_prev) + (B_n[0]) + (b * a);
+        C_n *= Real(.5f);
+
+        B_n[2] = (Real(3.0) * C_n - B_n[0]) * Real(.5f);
+    }
+
+    template<typename Real>
+    void evalLightN2(const Vec3<Real>& dir, const Vec3<Real>* verts, const Vec3<Real>* gam, const Vec3<Real>* gamP, int numVerts, Real surf[3],
+                     TrigPrecision precision = TrigPrecision::Exact)
+    {
+        Real total[2] = {};
+        Real bound[3];
+        for (int i = 0; i < numVerts; i++)
+        {
+            int next = (i + 1) % numVerts;
+            boundaryN2(dot(dir, verts[i]), dot(dir, gamP[i]), acosApprox(dot(verts[i], verts[next]), precision), bound, precision);
+            Real w = dot(dir, gam[i]);
+            for (int n = 0; n < 2; n++)
+            {
+                total[n] += bound[n] * w;
+            }
+        }
+
+        surf[1] = Real(0.5) * total[0];
+        surf[2] = Real(0.5) * total[1];
+
+        for (int i = 1; i < 3; i++)
+        {
+            surf[i] *= std::sqrt((Real(2.0) * Real(i) + Real(1.0)) / (Real(4.0) * Real(kPi)));
+        }
+    }
+
+    /** Project a spherical polygon onto the first 9 SH coefficients (N=2)
+        \param[in] precision Approximation of the transcendental functions, see FastMath.h
+    */
+    template<typename Real>
+    void polygonSHN2(const Vec3<Real>* L, int numVerts, Real Lcoeff[9], TrigPrecision precision = TrigPrecision::Exact)
+    {
+        Vec3<Real> G[kMaxClippedVertices];
+        Vec3<Real> Gp[kMaxClippedVertices];
+        for (int i = 0; i < numVerts; i++)
+        {
+            G[i] = normalize(cross(L[i], L[(i + 1) % numVerts]));
+            Gp[i] = cross(G[i], L[i]);
+        }
+
+        Real SA = solidAngle(L, numVerts, precision);
+
+        Lcoeff[0] = Real(0.282095) * SA;
+
+        const Vec3<Real>* lobes = polygonSHLobes<Real>();
+        Real w[5][3];
+        for (int i = 0; i < 5; i++)
+        {
+            evalLightN2(lobes[i], L, G, Gp, numVerts, w[i], precision);
+        }
+
+        Lcoeff[1] = Real(2.1995339) * w[0][1] + Real(2.50785367) * w[1][1] + Real(1.56572711) * w[2][1];
+        Lcoeff[2] = Real(-1.82572523) * w[0][1] + Real(-2.08165037) * w[1][1];
+        Lcoeff[3] = Real(2.42459869) * w[0][1] + Real(1.44790525) * w[1][1] + Real(0.90397552) * w[2][1];
+
+        Lcoeff[4] = Real(-1.33331385) * w[0][2] + Real(-0.66666684) * w[3][2] + Real(-0.99999606) * w[4][2];
+        Lcoeff[5] = Real(1.1747938) * w[2][2] + Real(-0.47923799) * w[3][2] + Real(-0.69556433) * w[4][2];
+        Lcoeff[6] = w[4][2];
+        Lcoeff[7] = Real(-1.21710396) * w[0][2] + Real(1.58226094) * w[1][2] + Real(0.67825711) * w[2][2];
+        Lcoeff[7] += Real(-0.27666329) * w[3][2] + Real(-0.76671491) * w[4][2];
+        Lcoeff[8] = Real(-1.15470843) * w[3][2] + Real(-0.57735948) * w[4][2];
+    }
+
+    // ------- END: The following code is taken from https://cseweb.ucsd.edu/~viscomp/projects/ash/, ported from Data/LTSHn2.slang ---------
+}
@@ -0,0 +1,178 @@
+#include "LightCulling.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ltsh
+{
+    namespace
+    {
+        // margin of the angle test, keeps the culling conservative despite rounding
+        const float kAngleEpsilon = 1e-3f;
+
+        float luminance(const float3& rgb)
+        {
+            return dot(rgb, float3(0.2126f, 0.7152f, 0.0722f));
+        }
+
+        float safeAcos(float x)
+        {
+            return std::acos(clamp(x, -1.f, 1.f));
+        }
+    }
+
+    LightBounds computeLightBounds(const float3* polygon, int numVertices, const float3& dirW, const float3& intensity, float surfaceArea, const CullingSettings& settings)
+    {
+        LightBounds bounds;
+        for (int i = 0; i < numVertices; i++)
+        {
+            bounds.center += polygon[i];
+        }
+        bounds.center = bounds.center / float(numVertices);
+        for (int i = 0; i < numVertices; i++)
+        {
+            bounds.radius = std::max(bounds.radius, length(polygon[i] - bounds.center));
+        }
+        bounds.normal = normalize(dirW);
+        bounds.oneSided = settings.oneSidedLights;
+
+        // a light of radiance I and area A at distance d creates an irradiance of at most about I * A / d^2
+        bounds.influenceRadius = -1.f;
+        if (settings.irradianceThreshold > 0)
+        {
+            bounds.influenceRadius = std::sqrt(std::max(0.f, luminance(intensity) * surfaceArea / settings.irradianceThreshold));
+        }
+        return bounds;
+    }
+
+    TileBounds computeTileBounds(const GBufferFrame& frame, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+    {
+        TileBounds tile;
+        float3 lo(INFINITY), hi(-INFINITY);
+        float3 normalSum;
+        for (uint32_t y = y0; y < y1; y++)
+        {
+            for (uint32_t x = x0; x < x1; x++)
+            {
+                size_t index = size_t(y) * frame.width + x;
+                const float4& buf0Val = frame.posLightFlag[index];
+                // same conditions as CpuLightingPass::shadePixel()
+                if (buf0Val.w > .5f || frame.albedo[index].w <= 0) continue;
+
+                float3 posW = buf0Val.xyz();
+                lo = min(lo, posW);
+                hi = max(hi, posW);
+                normalSum += frame.normalLinearRoughness[index].xyz();
+                tile.empty = false;
+            }
+        }
+        if (tile.empty) return tile;
+
+        tile.center = (lo + hi) * 0.5f;
+        tile.radius = length(hi - lo) * 0.5f;
+
+        // normal cone around the mean normal, a full sphere if the normals cancel out
+        float sumLength = length(normalSum);
+        if (sumLength < 1e-6f)
+        {
+            tile.normalAxis = float3(0, 0, 1);
+            tile.normalSpread = float(kPi);
+            return tile;
+        }
+        tile.normalAxis = normalSum / sumLength;
+        for (uint32_t y = y0; y < y1; y++)
+        {
+            for (uint32_t x = x0; x < x1; x++)
+            {
+                size_t index = size_t(y) * frame.width + x;
+                if (frame.posLightFlag[index].w > .5f || frame.albedo[index].w <= 0) continue;
+                float3 n = normalize(frame.normalLinearRoughness[index].xyz());
+                tile.normalSpread = std::max(tile.normalSpread, safeAcos(dot(n, tile.normalAxis)));
+            }
+        }
+        return tile;
+    }
+
+    CullResult cullLight(const LightBounds& light, const TileBounds& tile)
+    {
+        float3 d = light.center - tile.center;
+        float distance = length(d);
+        float gap = distance - light.radius - tile.radius;
+
+        if (light.influenceRadius >= 0 && gap > light.influenceRadius)
+        {
+            return CullResult::Distance;
+        }
+
+        // all points of the tile behind the plane of a one-sided light
+        if (light.oneSided && dot(-d, light.normal) < -tile.radius)
+        {
+            return CullResult::Side;
+        }
+
+        // Every vector from a shaded point to a point on the light lies in the sphere around d with the radius
+        // R = light.radius + tile.radius, which is seen under the half angle asin(R / |d|). If the angle between d
+        // and the normal cone exceeds 90 degrees by more than that, every such vector is below every horizon.
+        if (gap > 0)
+        {
+            float alpha = safeAcos(dot(d, tile.normalAxis) / distance);
+            float beta = std::asin(std::min(1.f, (light.radius + tile.radius) / distance));
+            if (alpha - beta - tile.normalSpread > float(kPi) * 0.5f + kAngleEpsilon)
+            {
+                return CullResult::Horizon;
+            }
+        }
+        return CullResult::Visible;
+    }
+
+    void TiledLightCuller::build(ThreadPool& pool, const GBufferFrame& frame, const std::vector<LightBounds>& lights, uint32_t tileSize)
+    {
+        mTileSize = std::max(tileSize, 1u);
+        mTilesX = (frame.width + mTileSize - 1) / mTileSize;
+        mTilesY = (frame.height + mTileSize - 1) / mTileSize;
+        size_t numTiles = size_t(mTilesX) * mTilesY;
+        mTileLights.resize(numTiles);
+
+        std::vector<Stats> tileStats(numTiles);
+        pool.parallelFor(numTiles, [&](size_t t, uint32_t)
+        {
+            uint32_t x0 = uint32_t(t % mTilesX) * mTileSize;
+            uint32_t y0 = uint32_t(t / mTilesX) * mTileSize;
+            uint32_t x1 = std::min(x0 + mTileSize, frame.width);
+            uint32_t y1 = std::min(y0 + mTileSize, frame.height);
+            TileBounds tile = computeTileBounds(frame, x0, y0, x1, y1);
+
+            std::vector<uint32_t>& list = mTileLights[t];
+            list.clear();
+            Stats& stats = tileStats[t];
+            if (tile.empty)
+            {
+                stats.emptyTiles = 1;
+                return;
+            }
+            stats.tests = lights.size();
+            for (uint32_t i = 0; i < uint32_t(lights.size()); i++)
+            {
+                switch (cullLight(lights[i], tile))
+                {
+                case CullResult::Visible: list.push_back(i); stats.visible++; break;
+                case CullResult::Distance: stats.culledByDistance++; break;
+                case CullResult::Side: stats.culledBySide++; break;
+                case CullResult::Horizon: stats.culledByHorizon++; break;
+                }
+            }
+        });
+
+        mStats = Stats();
+        mStats.tiles = uint32_t(numTiles);
+        for (const Stats& s : tileStats)
+        {
+            mStats.emptyTiles += s.emptyTiles;
+            mStats.tests += s.tests;
+            mStats.visible += s.visible;
+            mStats.culledByDistance += s.culledByDistance;
+            mStats.culledBySide += s.culledBySide;
+            mStats.culledByHorizon += s.culledByHorizon;
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// Tiled light culling for polygonal area lights. The shaded points of every screen tile are bounded by a sphere
+// around their positions and a cone around their normals, every light by the bounding sphere of its polygon.
+// A light is dropped for a tile if
+//   - it is further away than the distance at which its irradiance falls below a threshold (optional),
+//   - it is one-sided and the tile lies completely behind it, or
+//   - it lies below the horizon of every point in the tile, where the shading clips it away completely.
+// The last two tests are exact in the sense that culled lights contribute exactly zero, only the distance
+// threshold changes the image.
+
+#include "GBuffer.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+namespace ltsh
+{
+    struct CullingSettings
+    {
+        /** Lights are ignored where the irradiance estimate luminance(intensity) * area / d^2 drops below this
+            value, with d the distance to the bounding sphere of the light. 0 keeps lights at any distance.
+        */
+        float irradianceThreshold = 0;
+
+        /** Treat lights as emitting only to the side dirW points to. The shaders light both sides, so this is
+            only meant for measuring how much one-sided lights would save.
+        */
+        bool oneSidedLights = false;
+    };
+
+    struct LightBounds
+    {
+        float3 center;
+        float radius = 0;
+        float3 normal;
+        float influenceRadius = 0;  // distance from the bounding sphere beyond which the light is ignored, < 0 for unlimited
+        bool oneSided = false;
+    };
+
+    struct TileBounds
+    {
+        float3 center;
+        float radius = 0;
+        float3 normalAxis;
+        float normalSpread = 0;     // half angle of the normal cone in radians
+        bool empty = true;
+    };
+
+    enum class CullResult
+    {
+        Visible,
+        Distance,
+        Side,
+        Horizon,
+    };
+
+    /** Bounds of a light
+        \param[in] polygon numVertices world space vertices
+        \param[in] dirW Normal of the polygon, the side it emits to if the light is one-sided
+    */
+    LightBounds computeLightBounds(const float3* polygon, int numVertices, const float3& dirW, const float3& intensity, float surfaceArea, const CullingSettings& settings);
+
+    /** Bounds of the pixels x0 .. x1 - 1, y0 .. y1 - 1 of a frame that the lighting pass shades, i.e. without
+        empty pixels and pixels showing the light
+    */
+    TileBounds computeTileBounds(const GBufferFrame& frame, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
+    CullResult cullLight(const LightBounds& light, const TileBounds& tile);
+
+    class TiledLightCuller
+    {
+    public:
+        struct Stats
+        {
+            uint32_t tiles = 0;
+            uint32_t emptyTiles = 0;
+            uint64_t tests = 0;         // non-empty tiles times lights
+            uint64_t visible = 0;
+            uint64_t culledByDistance = 0;
+            uint64_t culledBySide = 0;
+            uint64_t culledByHorizon = 0;
+        };
+
+        /** Bin the lights into square tiles of the frame, in the same tile order as CpuLightingPass::render()
+        */
+        void build(ThreadPool& pool, const GBufferFrame& frame, const std::vector<LightBounds>& lights, uint32_t tileSize);
+
+        uint32_t getTileSize() const { return mTileSize; }
+        uint32_t getTileCountX() const { return mTilesX; }
+        uint32_t getTileCountY() const { return mTilesY; }
+
+        /** Indices of the lights that may affect the tile, in increasing order
+        */
+        const std::vector<uint32_t>& getTileLights(size_t tile) const { return mTileLights[tile]; }
+
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        uint32_t mTileSize = 0;
+        uint32_t mTilesX = 0;
+        uint32_t mTilesY = 0;
+        std::vector<std::vector<uint32_t>> mTileLights;
+        Stats mStats;
+    };
+}
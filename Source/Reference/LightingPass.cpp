@@ -0,0 +1,547 @@
+#include "LightingPass.h"
+#include "LTC.h"
+#include "LTSH.h"
+#include "LTSHn2.h"
+#include "../PolygonSampler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace ltsh
+{
+    namespace
+    {
+        // clear color of SimpleDeferred, the lighting pass discards empty pixels
+        const float3 kClearColor = float3(0.38f, 0.52f, 0.10f);
+
+        // maps [0,1] to the texel centers of the first and last cell for unbiased texture access
+        float2 unbiasedUv(const float2& uv, int resolution)
+        {
+            float m = float(resolution - 1) / resolution;
+            float b = .5f / resolution;
+            return float2(m * uv.x + b, m * uv.y + b);
+        }
+
+        float maxComponent(const float3& v)
+        {
+            return std::max(std::max(v.x, v.y), v.z);
+        }
+
+        // seed offset of the LTC lobe samples, keeps them independent of the light samples of the same set
+        const uint32_t kLobeSeedOffset = 0x10000;
+
+        /** Where the ray from origin along dir hits the plane of the polygon, lit from both sides
+            \return False if the ray misses the plane or the hit is outside of the polygon
+        */
+        bool intersectPolygon(const float3& origin, const float3& dir, const float3* polygon, int numVertices, const float3& normal, float3& hit)
+        {
+            float denom = dot(dir, normal);
+            if (denom == 0) return false;
+            float t = dot(polygon[0] - origin, normal) / denom;
+            if (t <= 0) return false;
+            hit = origin + dir * t;
+
+            // crossing test in the coordinate plane the polygon covers the most
+            float3 a = float3(std::abs(normal.x), std::abs(normal.y), std::abs(normal.z));
+            int dropped = (a.x > a.y && a.x > a.z) ? 0 : (a.y > a.z ? 1 : 2);
+            auto project = [dropped](const float3& p)
+            {
+                return dropped == 0 ? float2(p.y, p.z) : (dropped == 1 ? float2(p.z, p.x) : float2(p.x, p.y));
+            };
+            float2 q = project(hit);
+            bool inside = false;
+            for (int i = 0, j = numVertices - 1; i < numVertices; j = i++)
+            {
+                float2 pi = project(polygon[i]), pj = project(polygon[j]);
+                if ((pi.y > q.y) != (pj.y > q.y) && q.x < pj.x + (pi.x - pj.x) * (q.y - pj.y) / (pi.y - pj.y))
+                {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        }
+    }
+
+    CpuLightingPass::CpuLightingPass(const LutTables& tables, uint32_t seed)
+        : mTables(tables), mSeed(seed)
+    {
+        mSampleWindow.count = kNumSamples / kSampleReductionFactor;
+
+        // cosine distributed directions, the same for every light
+        for (int set = 0; set < kNumSampleSets; set++)
+        {
+            mLobeSamples[set].resize(kNumSamples);
+            for (uint32_t i = 0; i < uint32_t(kNumSamples); i++)
+            {
+                float u, v;
+                PolygonSampler::sampleUnitSquare(SampleSequence::Sobol, (mSeed + kLobeSeedOffset) * kNumSampleSets + set, i, u, v);
+                float r = std::sqrt(u);
+                float phi = 2.f * float(kPi) * v;
+                mLobeSamples[set][i] = float3(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::max(1.f - u, 0.f)));
+            }
+        }
+    }
+
+    void CpuLightingPass::setSampleWindow(const SampleWindow& window)
+    {
+        if (window.count == 0 || window.first + window.count > uint32_t(kNumSamples))
+        {
+            throw std::runtime_error("CpuLightingPass::setSampleWindow(): the window must lie inside the " + std::to_string(kNumSamples) + " samples of a set");
+        }
+        mSampleWindow = window;
+    }
+
+    void CpuLightingPass::setFrame(const GBufferFrame& frame)
+    {
+        if (frame.areaLightPosW.size() < 3 || frame.areaLightPosW.size() > size_t(kMaxPolygonVertices))
+        {
+            throw std::runtime_error("formatting error: the area light must have 3 to " + std::to_string(kMaxPolygonVertices) + " vertices");
+        }
+        mpFrame = &frame;
+        mLights.clear();
+        mLightBounds.clear();
+        addLight(frame.areaLight, &frame.areaLightPosW[0], int(frame.areaLightPosW.size()));
+    }
+
+    void CpuLightingPass::setLights(const AreaLightCollection& lights)
+    {
+        mLights.clear();
+        mLightBounds.clear();
+        mLights.reserve(lights.getCount());
+        for (uint32_t i = 0; i < lights.getCount(); i++)
+        {
+            const PackedAreaLight& packed = lights.get(i);
+            AreaLightData data;
+            data.dirW = float3(packed.dirW[0], packed.dirW[1], packed.dirW[2]);
+            data.intensity = float3(packed.intensity[0], packed.intensity[1], packed.intensity[2]);
+            data.surfaceArea = packed.surfaceArea;
+            if (packed.numVertices < 3 || packed.numVertices > uint32_t(kMaxPolygonVertices))
+            {
+                throw std::runtime_error("CpuLightingPass::setLights(): light " + std::to_string(i) + " has " + std::to_string(packed.numVertices) + " vertices");
+            }
+            float3 polygon[kMaxPolygonVertices];
+            for (uint32_t v = 0; v < packed.numVertices; v++)
+            {
+                polygon[v] = float3(packed.posW[v][0], packed.posW[v][1], packed.posW[v][2]);
+            }
+            addLight(data, polygon, int(packed.numVertices));
+        }
+    }
+
+    void CpuLightingPass::setCulling(bool enabled, const CullingSettings& settings)
+    {
+        mCullingEnabled = enabled;
+        mCullingSettings = settings;
+    }
+
+    void CpuLightingPass::addLight(const AreaLightData& data, const float3* polygon, int numVertices)
+    {
+        mLights.emplace_back();
+        Light& light = mLights.back();
+        light.data = data;
+        light.numVertices = numVertices;
+        for (int i = 0; i < numVertices; i++)
+        {
+            light.polygon[i] = polygon[i];
+        }
+        mLightBounds.push_back(computeLightBounds(polygon, numVertices, data.dirW, data.intensity, data.surfaceArea, mCullingSettings));
+        for (int i = 0; i < numVertices; i++)
+        {
+            light.normal += cross(polygon[i], polygon[(i + 1) % numVertices]);
+        }
+
+        // same samples as SimpleAreaLight::createSamples() for the same seed, generated on the world space polygon
+        // instead of being transformed to it
+        uint32_t seed = mSeed + uint32_t(mLights.size() - 1);
+        PolygonSampler sampler(&light.polygon[0].x, uint32_t(numVertices), 3);
+        for (int set = 0; set < kNumSampleSets; set++)
+        {
+            light.samples[set].resize(kNumSamples);
+            sampler.generate(SampleSequence::Sobol, seed * kNumSampleSets + set, 0, kNumSamples, &light.samples[set][0].x, 3);
+        }
+    }
+
+    void CpuLightingPass::render(ThreadPool& pool, AreaLightRenderMode mode, DebugMode debugMode, uint32_t tileSize, Image& image)
+    {
+        if (!mpFrame)
+        {
+            throw std::runtime_error("CpuLightingPass::render() called without a frame");
+        }
+        tileSize = std::max(tileSize, 1u);
+        image = Image(mpFrame->width, mpFrame->height);
+        if (mCullingEnabled)
+        {
+            mCuller.build(pool, *mpFrame, mLightBounds, tileSize);
+        }
+
+        uint32_t tilesX = (mpFrame->width + tileSize - 1) / tileSize;
+        uint32_t tilesY = (mpFrame->height + tileSize - 1) / tileSize;
+        pool.parallelFor(size_t(tilesX) * tilesY, [&](size_t tile, uint32_t)
+        {
+            uint32_t x0 = uint32_t(tile % tilesX) * tileSize;
+            uint32_t y0 = uint32_t(tile / tilesX) * tileSize;
+            uint32_t x1 = std::min(x0 + tileSize, mpFrame->width);
+            uint32_t y1 = std::min(y0 + tileSize, mpFrame->height);
+            for (uint32_t y = y0; y < y1; y++)
+            {
+                for (uint32_t x = x0; x < x1; x++)
+                {
+                    image.at(x, y) = shadePixel(x, y, mode, debugMode, mCullingEnabled ? &mCuller.getTileLights(tile) : nullptr);
+                }
+            }
+        });
+    }
+
+    float3 CpuLightingPass::evalDiffuseAreaLight(const ShadingData& sd, const Light& light, TrigPrecision precision) const
+    {
+        // diffuse lighting
+        float3x3 identity;
+        return ltcEvaluate(sd.N, sd.V, sd.posW, identity, light.polygon, light.numVertices, true, light.data.intensity, precision) * sd.diffuse / 2.0f / 3.14159f;
+    }
+
+    void CpuLightingPass::getLtsh(const float2& uv, const float2& texC, float3x3& MInv, float coeffs[25]) const
+    {
+        if (mLtshLookup == LtshLookup::Bilinear)
+        {
+            float2 tableUv = unbiasedUv(uv, mTables.getResolution());
+            MInv = mTables.getLtshMatrix(tableUv);
+            mTables.getLtshCoeffs(tableUv, coeffs);
+        }
+        else
+        {
+            // translate from [0,1] to [0,resolution-1]
+            int2 viewAlpha = dither(uv * float(mTables.getResolution() - 1), texC);
+            MInv = mTables.getLtshMatrix(viewAlpha);
+            mTables.getLtshCoeffs(viewAlpha, coeffs);
+        }
+    }
+
+    void CpuLightingPass::getLtshN2(const float2& uv, const float2& texC, float3x3& MInv, float coeffs[9]) const
+    {
+        if (mLtshLookup == LtshLookup::Bilinear)
+        {
+            float2 tableUv = unbiasedUv(uv, mTables.getResolution());
+            MInv = mTables.getLtshMatrixN2(tableUv);
+            mTables.getLtshCoeffsN2(tableUv, coeffs);
+        }
+        else
+        {
+            int2 viewAlpha = dither(uv * float(mTables.getResolution() - 1), texC);
+            MInv = mTables.getLtshMatrixN2(viewAlpha);
+            mTables.getLtshCoeffsN2(viewAlpha, coeffs);
+        }
+    }
+
+    int CpuLightingPass::clipPolygon(const ShadingData& sd, const Light& light, float3 L[kMaxClippedVertices]) const
+    {
+        // construct orthonormal basis around N
+        float3 T1 = normalize(sd.V - sd.N * sd.NdotV);
+        float3 T2 = cross(sd.N, T1);
+
+        // rotate area light in (T1, T2, R) basis
+        float3x3 baseMat = float3x3(T1, T2, sd.N);
+        float3 polygon[kMaxPolygonVertices];
+        for (int i = 0; i < light.numVertices; i++)
+        {
+            polygon[i] = mul(baseMat, light.polygon[i] - sd.posW);
+        }
+        return clipPolygonToHorizon(polygon, light.numVertices, L);
+    }
+
+    ShadingResult CpuLightingPass::evalAreaLight(const ShadingData& sd, const Light& light, AreaLightRenderMode mode, const float3& specularColor, const float2& texC) const
+    {
+        switch (mode)
+        {
+        case AreaLightRenderMode::GroundTruth:
+        case AreaLightRenderMode::LtcBrdf:
+        case AreaLightRenderMode::LtshBrdf:
+            return evalAreaLightGroundTruth(sd, light, mode, specularColor, texC);
+        case AreaLightRenderMode::GroundTruthMis:
+            return evalAreaLightGroundTruthMis(sd, light, specularColor, texC);
+        case AreaLightRenderMode::LTC:
+            return evalAreaLightLTC(sd, light, specularColor);
+        case AreaLightRenderMode::LTSH:
+            return evalAreaLightLTSH(sd, light, specularColor, texC);
+        case AreaLightRenderMode::LTSH_N2:
+            return evalAreaLightLTSH_N2(sd, light, specularColor, texC);
+        case AreaLightRenderMode::None:
+            break;
+        }
+        return ShadingResult();
+    }
+
+    ShadingResult CpuLightingPass::evalAreaLightLTC(const ShadingData& sd, const Light& light, const float3& specularColor) const
+    {
+        TrigPrecision precision = getTrigPrecision(AreaLightRenderMode::LTC);
+        ShadingResult sr;
+        sr.diffuse = evalDiffuseAreaLight(sd, light, precision);
+
+        float2 uv = unbiasedUv(cosThetaRoughnessToUv(sd.NdotV, sd.roughness), mTables.getResolution());
+        float3x3 MInv = mTables.getLtcMatrix(uv);
+        float coeff = mTables.getLtcCoeff(uv);
+
+        sr.specular = ltcEvaluate(sd.N, sd.V, sd.posW, MInv, light.polygon, light.numVertices, true, light.data.intensity, precision) * specularColor * coeff;
+        // Normalization
+        sr.specular = sr.specular / (2 * 3.14159f);
+
+        sr.color = sr.diffuse + sr.specular;
+        return sr;
+    }
+
+    ShadingResult CpuLightingPass::evalAreaLightLTSH(const ShadingData& sd, const Light& light, const float3& specularColor, const float2& texC) const
+    {
+        TrigPrecision precision = getTrigPrecision(AreaLightRenderMode::LTSH);
+        ShadingResult sr;
+        sr.diffuse = evalDiffuseAreaLight(sd, light, precision);
+
+        float2 uv = cosThetaRoughnessToUv(sd.NdotV, sd.roughness);
+        float3x3 MInv;
+        float coeffs[25];
+        getLtsh(uv, texC, MInv, coeffs);
+
+        float3 L[kMaxClippedVertices];
+        int n = clipPolygon(sd, light, L);
+
+        float result = 0;
+        if (n != 0)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                L[i] = normalize(mul(MInv, L[i]));
+            }
+
+            float Lc[25];
+            polygonSH(L, n, Lc, precision);
+
+            for (int i = 0; i < 25; i++)
+            {
+                result += Lc[i] * coeffs[i];
+            }
+        }
+
+        sr.specular = light.data.intensity * specularColor * std::abs(result);
+        sr.color = sr.diffuse + sr.specular;
+        return sr;
+    }
+
+    ShadingResult CpuLightingPass::evalAreaLightLTSH_N2(const ShadingData& sd, const Light& light, const float3& specularColor, const float2& texC) const
+    {
+        TrigPrecision precision = getTrigPrecision(AreaLightRenderMode::LTSH_N2);
+        ShadingResult sr;
+        sr.diffuse = evalDiffuseAreaLight(sd, light, precision);
+
+        float2 uv = cosThetaRoughnessToUv(sd.NdotV, sd.roughness);
+        float3x3 MInv;
+        float coeffs[9];
+        getLtshN2(uv, texC, MInv, coeffs);
+
+        float3 L[kMaxClippedVertices];
+        int n = clipPolygon(sd, light, L);
+
+        float result = 0;
+        if (n != 0)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                L[i] = normalize(mul(MInv, L[i]));
+            }
+
+            float Lc[9];
+            polygonSHN2(L, n, Lc, precision);
+
+            for (int i = 0; i < 9; i++)
+            {
+                result += Lc[i] * coeffs[i];
+            }
+        }
+
+        sr.specular = light.data.intensity * specularColor * std::abs(result);
+        sr.color = sr.diffuse + sr.specular;
+        return sr;
+    }
+
+    ShadingResult CpuLightingPass::evalAreaLightGroundTruth(ShadingData sd, const Light& areaLight, AreaLightRenderMode mode, const float3& specularColor, const float2& texC) const
+    {
+        ShadingResult sr;
+        const AreaLightData& light = areaLight.data;
+
+        float2 uv = cosThetaRoughnessToUv(sd.NdotV, sd.roughness);
+        float2 cosUv = unbiasedUv(uv, mTables.getResolution());
+
+        float3x3 MInvCos = mTables.getLtcMatrix(cosUv);
+        float3x3 MInvSh;
+        float ltshCoeffs[25];
+        getLtsh(uv, texC, MInvSh, ltshCoeffs);
+        float cosCoeff = mTables.getLtcCoeff(cosUv);
+
+        float3 T1 = normalize(sd.V - sd.N * sd.NdotV);
+        float3 T2 = cross(sd.N, T1);
+
+        // rotate area light in (T1, T2, R) basis
+        float3x3 baseMat = float3x3(T1, T2, sd.N);
+        MInvCos = mul(MInvCos, baseMat);
+        MInvSh = mul(MInvSh, baseMat);
+
+        // decide, which set of point lights to sample; like the shader, a rounded 4 falls through to the last set
+        int sampleSet = std::min(int(std::round(hashRand(texC) * 4)), kNumSampleSets - 1);
+        const std::vector<float3>& samples = areaLight.samples[(sampleSet + mSampleWindow.setShift) % kNumSampleSets];
+
+        for (uint32_t i = mSampleWindow.first; i < mSampleWindow.first + mSampleWindow.count; i++)
+        {
+            LightSample ls = calculateAreaLightSample(sd, light, samples[i]);
+
+            // If the light doesn't hit the surface or we are viewing the surface from the back, skip the sample
+            if (ls.NdotL <= 0) continue;
+            sd.NdotV = saturate(sd.NdotV);
+
+            // Calculate the diffuse term
+            sr.diffuseBrdf = evalDiffuseLambertBrdf(sd, ls);
+            sr.diffuse += sr.diffuseBrdf * (ls.diffuse * ls.NdotL);
+
+            // Calculate the specular term
+            if (mode == AreaLightRenderMode::LtcBrdf)           sr.specularBrdf = float3(evalLtcBrdf(ls.L, MInvCos) * cosCoeff);
+            else if (mode == AreaLightRenderMode::LtshBrdf)     sr.specularBrdf = float3(evalLtshBrdf(ls.L, MInvSh, ltshCoeffs));
+            else if (mode == AreaLightRenderMode::GroundTruth)  sr.specularBrdf = evalSpecularBrdf(sd, ls) * ls.NdotL;
+            sr.specular += sr.specularBrdf * ls.specular;
+        }
+        float scale = light.surfaceArea / float(mSampleWindow.count);
+        sr.diffuse = sr.diffuse * light.intensity * scale;
+        sr.specular = sr.specular * light.intensity * specularColor * scale;
+        sr.color = sr.diffuse + sr.specular;
+        return sr;
+    }
+
+    ShadingResult CpuLightingPass::evalAreaLightGroundTruthMis(ShadingData sd, const Light& areaLight, const float3& specularColor, const float2& texC) const
+    {
+        ShadingResult sr;
+        const AreaLightData& light = areaLight.data;
+        sd.NdotV = saturate(sd.NdotV);
+
+        // the LTC of the pixel approximates the GGX lobe, so its directions mostly land where the BRDF is large
+        float2 cosUv = unbiasedUv(cosThetaRoughnessToUv(sd.NdotV, sd.roughness), mTables.getResolution());
+        float3 T1 = normalize(sd.V - sd.N * sd.NdotV);
+        float3 T2 = cross(sd.N, T1);
+        float3x3 MInv = mul(mTables.getLtcMatrix(cosUv), float3x3(T1, T2, sd.N));
+        float3x3 M = inverse(MInv);
+
+        int sampleSet = (std::min(int(std::round(hashRand(texC) * 4)), kNumSampleSets - 1) + int(mSampleWindow.setShift)) % kNumSampleSets;
+        const std::vector<float3>& samples = areaLight.samples[sampleSet];
+        const std::vector<float3>& lobeSamples = mLobeSamples[sampleSet];
+
+        // Balance heuristic over both strategies with the same number of samples each. With the solid angle densities
+        // pdfLight = 1 / (falloff * area) and pdfLobe = evalLtcBrdf(), every sample of either strategy contributes
+        // f / (pdfLight + pdfLobe) = f * falloff * area / (1 + pdfLobe * falloff * area).
+        auto misSpecular = [&](const LightSample& ls)
+        {
+            float lightWeight = ls.specular * light.surfaceArea;
+            float pdfLobe = evalLtcBrdf(ls.L, MInv);
+            return evalSpecularBrdf(sd, ls) * (ls.NdotL * lightWeight / (1.f + pdfLobe * lightWeight));
+        };
+
+        for (uint32_t i = mSampleWindow.first; i < mSampleWindow.first + mSampleWindow.count; i++)
+        {
+            // light sample, the diffuse term uses these alone like GroundTruth
+            LightSample ls = calculateAreaLightSample(sd, light, samples[i]);
+            if (ls.NdotL > 0)
+            {
+                sr.diffuse += evalDiffuseLambertBrdf(sd, ls) * (ls.diffuse * ls.NdotL * light.surfaceArea);
+                sr.specular += misSpecular(ls);
+            }
+
+            // lobe sample, a cosine distributed direction transformed by the LTC matrix
+            float3 L = normalize(mul(M, lobeSamples[i]));
+            float3 hit;
+            if (dot(L, sd.N) <= 0 || !intersectPolygon(sd.posW, L, areaLight.polygon, areaLight.numVertices, areaLight.normal, hit)) continue;
+            ls = calculateAreaLightSample(sd, light, hit);
+            if (ls.NdotL > 0)
+            {
+                sr.specular += misSpecular(ls);
+            }
+        }
+        float scale = 1.f / float(mSampleWindow.count);
+        sr.diffuse = sr.diffuse * light.intensity * scale;
+        sr.specular = sr.specular * light.intensity * specularColor * scale;
+        sr.color = sr.diffuse + sr.specular;
+        return sr;
+    }
+
+    float3 CpuLightingPass::shadePixel(uint32_t x, uint32_t y, AreaLightRenderMode mode, DebugMode debugMode) const
+    {
+        return shadePixel(x, y, mode, debugMode, nullptr);
+    }
+
+    float3 CpuLightingPass::shadePixel(uint32_t x, uint32_t y, AreaLightRenderMode mode, DebugMode debugMode, const std::vector<uint32_t>* pLights) const
+    {
+        size_t index = size_t(y) * mpFrame->width + x;
+        const float4& buf0Val = mpFrame->posLightFlag[index];
+        const float4& buf1Val = mpFrame->normalLinearRoughness[index];
+        const float4& albedo = mpFrame->albedo[index];
+        const float4& buf3Val = mpFrame->specularRoughness[index];
+
+        float3 posW = float3(buf0Val.x, buf0Val.y, buf0Val.z);
+        float3 normalW = float3(buf1Val.x, buf1Val.y, buf1Val.z);
+        float3 diffuse = float3(albedo.x, albedo.y, albedo.z);
+        float3 specular = float3(buf3Val.x, buf3Val.y, buf3Val.z);
+        float2 texC = float2((x + 0.5f) / mpFrame->width, (y + 0.5f) / mpFrame->height);
+
+        if (buf0Val.w > .5f)
+        {
+            const float3& intensity = mpFrame->areaLight.intensity;
+            return intensity / maxComponent(intensity);
+        }
+
+        // Discard empty pixels
+        if (albedo.w <= 0)
+        {
+            return kClearColor;
+        }
+
+        /* Reconstruct the hit-point */
+        ShadingData sd;
+        sd.posW = posW;
+        sd.V = normalize(mpFrame->camPosW - posW);
+        sd.N = normalW;
+        sd.NdotV = std::abs(dot(sd.V, sd.N));
+        sd.linearRoughness = buf1Val.w;
+        sd.diffuse = diffuse;
+
+        // sd.specular is used as F0 in the BRDF and needs to be fixed for our technique
+        sd.specular = float3(.4f);
+        // the ground truth can't handle very specular surfaces so the roughness is clamped to 0.1
+        sd.roughness = std::max(buf3Val.w, .1f);
+
+        /* Do lighting, the contributions of all lights add up */
+        ShadingResult areaResult;
+        uint32_t numLights = pLights ? uint32_t(pLights->size()) : uint32_t(mLights.size());
+        for (uint32_t i = 0; i < numLights; i++)
+        {
+            const Light& light = mLights[pLights ? (*pLights)[i] : i];
+            ShadingResult lightResult = evalAreaLight(sd, light, mode, specular, texC);
+            areaResult.diffuse += lightResult.diffuse;
+            areaResult.specular += lightResult.specular;
+            areaResult.color += lightResult.color;
+            // the Lambert BRDF does not depend on the light, the last one that hit the surface is as good as any
+            if (dot(lightResult.diffuseBrdf, lightResult.diffuseBrdf) > 0) areaResult.diffuseBrdf = lightResult.diffuseBrdf;
+        }
+
+        // Debug vis
+        switch (debugMode)
+        {
+        case DebugMode::ShowPos:
+            return posW;
+        case DebugMode::ShowNormals:
+            return normalW * 0.5f + float3(0.5f);
+        case DebugMode::ShowAlbedo:
+            return diffuse;
+        case DebugMode::ShowLighting:
+            return float3(areaResult.diffuseBrdf.x / sd.diffuse.x, areaResult.diffuseBrdf.y / sd.diffuse.y, areaResult.diffuseBrdf.z / sd.diffuse.z);
+        case DebugMode::ShowDiffuse:
+            return areaResult.diffuse;
+        case DebugMode::ShowSpecular:
+            return areaResult.specular;
+        default:
+            return areaResult.color;
+        }
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+// CPU port of Data/LightingPass.ps.hlsl. Shades a serialized G-buffer frame with the same area light render
+// modes as SimpleDeferred so the techniques can be compared and profiled without a GPU. Only area lights are
+// evaluated, the directional and point lights of the app have zero intensity. By default the single light of the
+// frame is shaded, setLights() replaces it with any number of lights whose contributions are summed.
+
+#include "FastMath.h"
+#include "GBuffer.h"
+#include "ImageIO.h"
+#include "LightCulling.h"
+#include "LutTables.h"
+#include "Polygon.h"
+#include "ThreadPool.h"
+#include "../AreaLightCollection.h"
+#include "../ProgressiveAccumulation.h"
+#include <array>
+#include <cstdint>
+
+namespace ltsh
+{
+    class CpuLightingPass
+    {
+    public:
+        // same values as SimpleDeferred::AreaLightRenderMode and the defines in LightingPass.ps.hlsl
+        enum class AreaLightRenderMode
+        {
+            GroundTruth = 0,
+            LTC,
+            LTSH,
+            None,
+            LtcBrdf,
+            LtshBrdf,
+            LTSH_N2,
+            // CPU only for now: GroundTruth with multiple importance sampling of the light and the LTC lobe
+            GroundTruthMis,
+        };
+
+        enum class DebugMode
+        {
+            Disabled = 0,
+            ShowPos,
+            ShowNormals,
+            ShowAlbedo,
+            ShowLighting,
+            ShowDiffuse,
+            ShowSpecular,
+        };
+
+        // same values as SimpleDeferred::LtshLookup and the defines in LightingPass.ps.hlsl
+        enum class LtshLookup
+        {
+            Dithered = 0,
+            Bilinear,
+        };
+
+        static const int kNumSampleSets = 4;
+        static const int kNumSamples = 4096;
+        static const int kSampleReductionFactor = 4;
+
+        /** \param[in] tables Lookup tables, must outlive the pass
+            \param[in] seed Seed for the ground truth light samples
+        */
+        CpuLightingPass(const LutTables& tables, uint32_t seed = 0);
+
+        /** Set the frame to shade and create the ground truth light samples for its area light, a polygon with 3
+            to kMaxPolygonVertices vertices
+        */
+        void setFrame(const GBufferFrame& frame);
+
+        /** Shade the frame with these lights instead of the light stored in the frame. Light i gets the ground
+            truth samples of seed + i, so light 0 matches the app for the same seed. Call after setFrame().
+        */
+        void setLights(const AreaLightCollection& lights);
+
+        uint32_t getLightCount() const { return uint32_t(mLights.size()); }
+
+        /** Cull the lights per tile before render() shades the tile, see LightCulling.h. Off by default.
+            Call before setFrame() / setLights(), the light bounds are computed when the lights are set.
+        */
+        void setCulling(bool enabled, const CullingSettings& settings = CullingSettings());
+
+        /** Light lists of the last render() with culling enabled
+        */
+        const TiledLightCuller& getCuller() const { return mCuller; }
+
+        /** How the LTSH modes fetch matrix and coefficients, dithered by default like the app
+        */
+        void setLtshLookup(LtshLookup lookup) { mLtshLookup = lookup; }
+        LtshLookup getLtshLookup() const { return mLtshLookup; }
+
+        /** Approximation of the transcendental functions in the edge integrals of a render mode, see FastMath.h.
+            Exact for every mode by default, only LTC, LTSH and LTSH_N2 evaluate edge integrals.
+        */
+        void setTrigPrecision(AreaLightRenderMode mode, TrigPrecision precision) { mTrigPrecision[size_t(mode)] = precision; }
+        TrigPrecision getTrigPrecision(AreaLightRenderMode mode) const { return mTrigPrecision[size_t(mode)]; }
+
+        /** Samples the ground truth modes (GroundTruth, LtcBrdf, LtshBrdf, GroundTruthMis) evaluate, for progressive
+            rendering with ProgressiveAccumulation. By default the first kNumSamples / kSampleReductionFactor of every
+            set like the app. GroundTruthMis takes the window from the light samples and from the LTC samples each.
+        */
+        void setSampleWindow(const SampleWindow& window);
+        const SampleWindow& getSampleWindow() const { return mSampleWindow; }
+
+        /** Shade every pixel of the frame, tiles are distributed over the pool
+            \param[out] image Resized to the frame resolution
+        */
+        void render(ThreadPool& pool, AreaLightRenderMode mode, DebugMode debugMode, uint32_t tileSize, Image& image);
+
+        /** Shade a single pixel, returns the clear color for empty pixels
+        */
+        float3 shadePixel(uint32_t x, uint32_t y, AreaLightRenderMode mode, DebugMode debugMode) const;
+
+    private:
+        struct Light
+        {
+            AreaLightData data;
+            float3 polygon[kMaxPolygonVertices];
+            int numVertices = 0;
+            // kNumSamples per set, the sample window selects the ones the ground truth estimate uses
+            std::array<std::vector<float3>, kNumSampleSets> samples;
+            // unnormalized plane normal for the ray intersections of GroundTruthMis
+            float3 normal;
+        };
+
+        void addLight(const AreaLightData& data, const float3* polygon, int numVertices);
+
+        /** \param[in] pLights Indices of the lights to shade, nullptr for all
+        */
+        float3 shadePixel(uint32_t x, uint32_t y, AreaLightRenderMode mode, DebugMode debugMode, const std::vector<uint32_t>* pLights) const;
+
+        ShadingResult evalAreaLight(const ShadingData& sd, const Light& light, AreaLightRenderMode mode, const float3& specularColor, const float2& texC) const;
+        ShadingResult evalAreaLightLTC(const ShadingData& sd, const Light& light, const float3& specularColor) const;
+        ShadingResult evalAreaLightLTSH(const ShadingData& sd, const Light& light, const float3& specularColor, const float2& texC) const;
+        ShadingResult evalAreaLightLTSH_N2(const ShadingData& sd, const Light& light, const float3& specularColor, const float2& texC) const;
+        ShadingResult evalAreaLightGroundTruth(ShadingData sd, const Light& light, AreaLightRenderMode mode, const float3& specularColor, const float2& texC) const;
+        ShadingResult evalAreaLightGroundTruthMis(ShadingData sd, const Light& light, const float3& specularColor, const float2& texC) const;
+        float3 evalDiffuseAreaLight(const ShadingData& sd, const Light& light, TrigPrecision precision) const;
+        /** LTSH matrix and coefficients for a [0,1] uv with the current lookup, equivalent to getLtsh()/getLtshN2()
+        */
+        void getLtsh(const float2& uv, const float2& texC, float3x3& MInv, float coeffs[25]) const;
+        void getLtshN2(const float2& uv, const float2& texC, float3x3& MInv, float coeffs[9]) const;
+        /** Light polygon in the (T1, T2, N) frame of the shading point, clipped to the horizon
+            \return Number of vertices of L, 0 if the light is below the horizon
+        */
+        int clipPolygon(const ShadingData& sd, const Light& light, float3 L[kMaxClippedVertices]) const;
+
+        const LutTables& mTables;
+        uint32_t mSeed;
+        LtshLookup mLtshLookup = LtshLookup::Dithered;
+        SampleWindow mSampleWindow;
+        std::array<TrigPrecision, size_t(AreaLightRenderMode::GroundTruthMis) + 1> mTrigPrecision = {};
+        // cosine distributed directions around +z per set, GroundTruthMis maps them to the LTC lobe of the pixel
+        std::array<std::vector<float3>, kNumSampleSets> mLobeSamples;
+        const GBufferFrame* mpFrame = nullptr;
+        std::vector<Light> mLights;
+        std::vector<LightBounds> mLightBounds;
+
+        bool mCullingEnabled = false;
+        CullingSettings mCullingSettings;
+        TiledLightCuller mCuller;
+    };
+}
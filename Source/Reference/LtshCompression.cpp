@@ -0,0 +1,353 @@
+#include "LtshCompression.h"
+#include "../LutPacking.h"
+#include "../MappedNumpy.h"
+#include "../Numpy.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace ltsh
+{
+    namespace
+    {
+        // largest finite half float
+        const double kHalfMax = 65504.0;
+
+        double cellNorm(const double* c, uint32_t numCoeffs)
+        {
+            double sum = 0;
+            for (uint32_t k = 0; k < numCoeffs; k++) sum += c[k] * c[k];
+            return std::sqrt(sum);
+        }
+
+        /** Smallest half float that is not below v, v >= 0
+        */
+        half halfCeil(float v)
+        {
+            half h = floatToHalf(v);
+            if (halfToFloat(h) < v) h++;
+            return h;
+        }
+
+        /** Eigen decomposition of a symmetric n x n matrix with cyclic Jacobi rotations
+            \param[in,out] a The matrix, destroyed
+            \param[out] values Eigenvalues in descending order
+            \param[out] vectors Matching eigenvectors, row i belongs to values[i]
+        */
+        void symmetricEigen(std::vector<double>& a, int n, std::vector<double>& values, std::vector<double>& vectors)
+        {
+            std::vector<double> v(n * n, 0.0);
+            for (int i = 0; i < n; i++) v[i * n + i] = 1.0;
+
+            for (int sweep = 0; sweep < 100; sweep++)
+            {
+                double off = 0, diag = 0;
+                for (int i = 0; i < n; i++)
+                {
+                    diag += a[i * n + i] * a[i * n + i];
+                    for (int j = i + 1; j < n; j++) off += a[i * n + j] * a[i * n + j];
+                }
+                if (off <= 1e-30 * diag) break;
+
+                for (int p = 0; p < n; p++)
+                {
+                    for (int q = p + 1; q < n; q++)
+                    {
+                        double apq = a[p * n + q];
+                        if (apq == 0) continue;
+                        double theta = 0.5 * (a[q * n + q] - a[p * n + p]) / apq;
+                        double t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                        double c = 1.0 / std::sqrt(t * t + 1.0);
+                        double s = t * c;
+                        for (int k = 0; k < n; k++)
+                        {
+                            double akp = a[k * n + p], akq = a[k * n + q];
+                            a[k * n + p] = c * akp - s * akq;
+                            a[k * n + q] = s * akp + c * akq;
+                        }
+                        for (int k = 0; k < n; k++)
+                        {
+                            double apk = a[p * n + k], aqk = a[q * n + k];
+                            a[p * n + k] = c * apk - s * aqk;
+                            a[q * n + k] = s * apk + c * aqk;
+                        }
+                        for (int k = 0; k < n; k++)
+                        {
+                            double vkp = v[k * n + p], vkq = v[k * n + q];
+                            v[k * n + p] = c * vkp - s * vkq;
+                            v[k * n + q] = s * vkp + c * vkq;
+                        }
+                    }
+                }
+            }
+
+            std::vector<int> order(n);
+            for (int i = 0; i < n; i++) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](int x, int y) { return a[x * n + x] > a[y * n + y]; });
+            values.resize(n);
+            vectors.resize(n * n);
+            for (int i = 0; i < n; i++)
+            {
+                values[i] = a[order[i] * n + order[i]];
+                for (int k = 0; k < n; k++) vectors[i * n + k] = v[k * n + order[i]];
+            }
+        }
+    }
+
+    CoeffTable loadCoeffTable(const std::string& filename, uint32_t numCoeffs)
+    {
+        MappedNumpyArray file(filename);
+        CoeffTable table;
+        table.resolution = getLutResolution(file.getShape(), numCoeffs);
+        if (table.resolution == 0)
+        {
+            throw std::runtime_error("formatting error: " + filename + " is not a square table of " + std::to_string(numCoeffs) + " values per cell");
+        }
+        table.numCoeffs = numCoeffs;
+        ArraySpan<double> data = file.getData<double>();
+        table.values.assign(data.begin(), data.end());
+        return table;
+    }
+
+    void QuantizedCoeffTable::decode(size_t cell, float* coeffs) const
+    {
+        const uint32_t* texel = &texels[cell * getTexelsPerCell() * 4];
+        auto byteAt = [&](uint32_t i) { return (texel[i / 4] >> (8 * (i % 4))) & 0xffu; };
+        float scale = halfToFloat(half(byteAt(numCoeffs) | (byteAt(numCoeffs + 1) << 8))) / 127.f;
+        for (uint32_t k = 0; k < numCoeffs; k++)
+        {
+            coeffs[k] = float(int8_t(uint8_t(byteAt(k)))) * scale;
+        }
+    }
+
+    QuantizedCoeffTable quantizeCoeffs(const CoeffTable& table)
+    {
+        QuantizedCoeffTable res;
+        res.resolution = table.resolution;
+        res.numCoeffs = table.numCoeffs;
+        const uint32_t K = table.numCoeffs;
+        const uint32_t wordsPerCell = res.getTexelsPerCell() * 4;
+        res.texels.assign(table.getCellCount() * wordsPerCell, 0u);
+
+        for (size_t cell = 0; cell < table.getCellCount(); cell++)
+        {
+            const double* c = table.getCell(cell);
+            double maxAbs = 0;
+            for (uint32_t k = 0; k < K; k++) maxAbs = std::max(maxAbs, std::abs(c[k]));
+
+            // round the scale up so every coefficient stays within [-127, 127]
+            half scaleBits = halfCeil(float(maxAbs));
+            double scale = halfToFloat(scaleBits);
+
+            uint32_t* words = &res.texels[cell * wordsPerCell];
+            auto setByte = [&](uint32_t i, uint32_t value) { words[i / 4] |= (value & 0xffu) << (8 * (i % 4)); };
+            for (uint32_t k = 0; k < K; k++)
+            {
+                double q = scale > 0 && std::isfinite(scale) ? std::round(c[k] / scale * 127.0) : 0.0;
+                setByte(k, uint32_t(int32_t(std::max(-127.0, std::min(127.0, q)))));
+            }
+            setByte(K, scaleBits & 0xffu);
+            setByte(K + 1, scaleBits >> 8);
+        }
+        return res;
+    }
+
+    size_t PcaCoeffTable::getByteSize() const
+    {
+        return size_t(resolution) * resolution * getTexelsPerCell() * 8 + (mean.size() + basis.size()) * sizeof(float);
+    }
+
+    void PcaCoeffTable::decode(size_t cell, float* coeffs) const
+    {
+        const half* w = &weights[cell * (numComponents + 1)];
+        float norm = halfToFloat(w[numComponents]);
+        float len2 = 0;
+        for (uint32_t k = 0; k < numCoeffs; k++)
+        {
+            float v = mean[k];
+            for (uint32_t i = 0; i < numComponents; i++)
+            {
+                v += halfToFloat(w[i]) * basis[i * numCoeffs + k];
+            }
+            coeffs[k] = v;
+            len2 += v * v;
+        }
+        // the truncated expansion is shorter than the unit vector it approximates, renormalize it
+        float s = len2 > 0 ? norm / std::sqrt(len2) : 0.f;
+        for (uint32_t k = 0; k < numCoeffs; k++) coeffs[k] *= s;
+    }
+
+    PcaCoeffTable encodePca(const CoeffTable& table, uint32_t numComponents)
+    {
+        const uint32_t K = table.numCoeffs;
+        if (numComponents < 1 || numComponents > K)
+        {
+            throw std::invalid_argument("encodePca: numComponents must be 1 to " + std::to_string(K));
+        }
+
+        // directions of the cells, the norm is stored separately so the cells with huge coefficients don't dominate
+        const size_t cells = table.getCellCount();
+        std::vector<double> dirs(cells * K, 0.0);
+        std::vector<double> norms(cells);
+        std::vector<double> mean(K, 0.0);
+        size_t count = 0;
+        for (size_t cell = 0; cell < cells; cell++)
+        {
+            const double* c = table.getCell(cell);
+            norms[cell] = cellNorm(c, K);
+            if (!(norms[cell] > 0 && norms[cell] <= kHalfMax)) continue;
+            for (uint32_t k = 0; k < K; k++)
+            {
+                dirs[cell * K + k] = c[k] / norms[cell];
+                mean[k] += dirs[cell * K + k];
+            }
+            count++;
+        }
+        for (uint32_t k = 0; k < K; k++) mean[k] /= std::max<size_t>(count, 1);
+
+        std::vector<double> cov(K * K, 0.0);
+        for (size_t cell = 0; cell < cells; cell++)
+        {
+            if (!(norms[cell] > 0 && norms[cell] <= kHalfMax)) continue;
+            const double* u = &dirs[cell * K];
+            for (uint32_t k = 0; k < K; k++)
+            {
+                for (uint32_t l = k; l < K; l++) cov[k * K + l] += (u[k] - mean[k]) * (u[l] - mean[l]);
+            }
+        }
+        for (uint32_t k = 0; k < K; k++)
+        {
+            for (uint32_t l = 0; l < k; l++) cov[k * K + l] = cov[l * K + k];
+        }
+
+        std::vector<double> values, vectors;
+        symmetricEigen(cov, int(K), values, vectors);
+
+        PcaCoeffTable res;
+        res.resolution = table.resolution;
+        res.numCoeffs = K;
+        res.numComponents = numComponents;
+        res.mean.assign(mean.begin(), mean.end());
+        res.basis.assign(vectors.begin(), vectors.begin() + numComponents * K);
+        res.weights.assign(cells * (numComponents + 1), half(0));
+        for (size_t cell = 0; cell < cells; cell++)
+        {
+            half* w = &res.weights[cell * (numComponents + 1)];
+            w[numComponents] = floatToHalf(float(norms[cell]));
+            if (!(norms[cell] > 0 && norms[cell] <= kHalfMax)) continue;
+            const double* u = &dirs[cell * K];
+            for (uint32_t i = 0; i < numComponents; i++)
+            {
+                double dot = 0;
+                for (uint32_t k = 0; k < K; k++) dot += (u[k] - mean[k]) * vectors[i * K + k];
+                w[i] = floatToHalf(float(dot));
+            }
+        }
+        return res;
+    }
+
+    CoeffError measureError(const CoeffTable& table, const std::function<void(size_t, float*)>& decode)
+    {
+        const uint32_t K = table.numCoeffs;
+        std::vector<float> decoded(K);
+        std::vector<double> cellErrors;
+        double sumSq = 0, sumRaw = 0;
+        CoeffError err;
+        for (size_t cell = 0; cell < table.getCellCount(); cell++)
+        {
+            const double* c = table.getCell(cell);
+            double norm = cellNorm(c, K);
+            if (!(norm <= kHalfMax))
+            {
+                err.numSkipped++;
+                continue;
+            }
+            decode(cell, decoded.data());
+            double diff2 = 0;
+            for (uint32_t k = 0; k < K; k++)
+            {
+                double d = decoded[k] - c[k];
+                diff2 += d * d;
+                sumRaw += c[k] * c[k];
+            }
+            sumSq += diff2;
+            cellErrors.push_back(norm > 0 ? std::sqrt(diff2) / norm : std::sqrt(diff2));
+        }
+
+        err.numCells = cellErrors.size();
+        if (cellErrors.empty()) return err;
+        size_t n = err.numCells * K;
+        err.rmse = std::sqrt(sumSq / n);
+        err.relativeRmse = sumRaw > 0 ? std::sqrt(sumSq / sumRaw) : 0;
+        std::sort(cellErrors.begin(), cellErrors.end());
+        err.medianCellError = cellErrors[cellErrors.size() / 2];
+        err.p95CellError = cellErrors[std::min(cellErrors.size() - 1, cellErrors.size() * 95 / 100)];
+        err.maxCellError = cellErrors.back();
+        return err;
+    }
+
+    void saveQuantized(const std::string& prefix, const QuantizedCoeffTable& table)
+    {
+        const int shape[3] = { int(table.resolution), int(table.resolution), int(table.getTexelsPerCell() * 4) };
+        std::vector<int> words(table.texels.begin(), table.texels.end());
+        aoba::SaveArrayAsNumpy(prefix + "_q8.npy", 3, shape, words.data());
+    }
+
+    QuantizedCoeffTable loadQuantized(const std::string& prefix, uint32_t numCoeffs)
+    {
+        QuantizedCoeffTable table;
+        table.numCoeffs = numCoeffs;
+        MappedNumpyArray file(prefix + "_q8.npy");
+        const std::vector<size_t>& shape = file.getShape();
+        if (shape.size() != 3 || shape[0] != shape[1] || shape[2] != table.getTexelsPerCell() * 4)
+        {
+            throw std::runtime_error("formatting error: unexpected shape of " + file.getFilename());
+        }
+        table.resolution = uint32_t(shape[0]);
+        ArraySpan<int32_t> words = file.getData<int32_t>();
+        table.texels.assign(words.begin(), words.end());
+        return table;
+    }
+
+    void savePca(const std::string& prefix, const PcaCoeffTable& table)
+    {
+        const uint32_t K = table.numCoeffs;
+        const uint32_t k = table.numComponents;
+        std::string name = prefix + "_pca" + std::to_string(k);
+
+        std::vector<double> basis(table.mean.begin(), table.mean.end());
+        basis.insert(basis.end(), table.basis.begin(), table.basis.end());
+        const int basisShape[2] = { int(k + 1), int(K) };
+        aoba::SaveArrayAsNumpy(name + "_basis.npy", 2, basisShape, basis.data());
+
+        std::vector<double> weights(table.weights.size());
+        for (size_t i = 0; i < weights.size(); i++) weights[i] = halfToFloat(table.weights[i]);
+        const int weightShape[3] = { int(table.resolution), int(table.resolution), int(k + 1) };
+        aoba::SaveArrayAsNumpy(name + "_weights.npy", 3, weightShape, weights.data());
+    }
+
+    PcaCoeffTable loadPca(const std::string& prefix, uint32_t numCoeffs, uint32_t numComponents)
+    {
+        std::string name = prefix + "_pca" + std::to_string(numComponents);
+        PcaCoeffTable table;
+        table.numCoeffs = numCoeffs;
+        table.numComponents = numComponents;
+
+        MappedNumpyArray basisFile(name + "_basis.npy");
+        ArraySpan<double> basis = basisFile.getData<double>({ numComponents + 1, numCoeffs });
+        table.mean.assign(basis.begin(), basis.begin() + numCoeffs);
+        table.basis.assign(basis.begin() + numCoeffs, basis.end());
+
+        MappedNumpyArray weightFile(name + "_weights.npy");
+        table.resolution = getLutResolution(weightFile.getShape(), numComponents + 1);
+        if (table.resolution == 0)
+        {
+            throw std::runtime_error("formatting error: unexpected shape of " + weightFile.getFilename());
+        }
+        ArraySpan<double> weights = weightFile.getData<double>();
+        table.weights.resize(weights.size());
+        for (size_t i = 0; i < weights.size(); i++) table.weights[i] = floatToHalf(float(weights[i]));
+        return table;
+    }
+}
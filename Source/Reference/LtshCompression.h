@@ -0,0 +1,106 @@
+#pragma once
+
+// Compressed storage of the LTSH coefficient tables. The raw texture holds the K coefficients of a cell as half
+// floats padded to whole RGBA16F texels, 7 fetches per pixel for N=4. Two encodings trade accuracy for fewer fetches:
+//
+// - Quantized: the coefficients of a cell are 8-bit signed integers with one half float scale per cell (its largest
+//   magnitude). For N=4 the 25 bytes and the scale fit in 2 RGBA32_UINT texels, for N=2 in one.
+// - PCA: every cell is its norm times a unit vector, and the unit vectors are approximated by the table mean plus
+//   k principal components. A cell stores k weights and the norm as half floats, ceil((k + 1) / 4) RGBA16F texels;
+//   the mean and the basis, (k + 1) * K floats, belong in a constant buffer.
+//
+// The encoders run offline (ltsh_compress), the decoders reconstruct the coefficients the way a shader would.
+// All tables keep the cell order and the sign convention of the sh_coeff .npy files, [theta][alpha][k].
+
+#include "Half.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ltsh
+{
+    /** An uncompressed coefficient table
+    */
+    struct CoeffTable
+    {
+        uint32_t resolution = 0;
+        uint32_t numCoeffs = 0;
+        std::vector<double> values;
+
+        size_t getCellCount() const { return size_t(resolution) * resolution; }
+        const double* getCell(size_t cell) const { return &values[cell * numCoeffs]; }
+    };
+
+    /** Read sh_coeff_n<order>_t128.npy. Throws std::runtime_error if the file is missing or not a square table.
+    */
+    CoeffTable loadCoeffTable(const std::string& filename, uint32_t numCoeffs);
+
+    struct QuantizedCoeffTable
+    {
+        uint32_t resolution = 0;
+        uint32_t numCoeffs = 0;
+        std::vector<uint32_t> texels;   ///< getTexelsPerCell() RGBA32_UINT texels per cell
+
+        /** 8-bit coefficients followed by the 16-bit scale, little endian, padded to whole 16 byte texels
+        */
+        uint32_t getTexelsPerCell() const { return (numCoeffs + 2 + 15) / 16; }
+        size_t getByteSize() const { return texels.size() * sizeof(uint32_t); }
+
+        void decode(size_t cell, float* coeffs) const;
+    };
+
+    QuantizedCoeffTable quantizeCoeffs(const CoeffTable& table);
+
+    struct PcaCoeffTable
+    {
+        uint32_t resolution = 0;
+        uint32_t numCoeffs = 0;
+        uint32_t numComponents = 0;
+        std::vector<float> mean;        ///< numCoeffs values
+        std::vector<float> basis;       ///< [component][numCoeffs], orthonormal
+        std::vector<half> weights;      ///< [cell][numComponents + 1], the norm of the cell last
+
+        uint32_t getTexelsPerCell() const { return (numComponents + 1 + 3) / 4; }
+        /** Weight texture plus mean and basis as 32-bit floats
+        */
+        size_t getByteSize() const;
+
+        void decode(size_t cell, float* coeffs) const;
+    };
+
+    /** \param[in] numComponents Principal components, 1 to the number of coefficients
+    */
+    PcaCoeffTable encodePca(const CoeffTable& table, uint32_t numComponents);
+
+    /** Texture size of the raw half float layout, K coefficients padded to RGBA16F texels
+    */
+    inline size_t getRawByteSize(const CoeffTable& table) { return table.getCellCount() * ((table.numCoeffs + 3) / 4) * 8; }
+
+    struct CoeffError
+    {
+        double rmse = 0;            ///< over all coefficients of the cells counted
+        double relativeRmse = 0;    ///< rmse divided by the RMS of the raw coefficients
+        double medianCellError = 0; ///< relative L2 error of a cell, |decoded - raw| / |raw|
+        double p95CellError = 0;
+        double maxCellError = 0;
+        size_t numCells = 0;
+        size_t numSkipped = 0;      ///< cells whose norm is out of the half float range, the raw texture can't hold them either
+    };
+
+    /** Compare decoded cells against the raw table
+        \param[in] decode Writes the numCoeffs coefficients of a cell
+    */
+    CoeffError measureError(const CoeffTable& table, const std::function<void(size_t, float*)>& decode);
+
+    /** Write <prefix>_q8.npy, int32 of shape (res, res, 4 * texelsPerCell) holding the RGBA32_UINT texels
+    */
+    void saveQuantized(const std::string& prefix, const QuantizedCoeffTable& table);
+    QuantizedCoeffTable loadQuantized(const std::string& prefix, uint32_t numCoeffs);
+
+    /** Write <prefix>_pca<k>_basis.npy, shape (k + 1, K) with the mean in the first row, and
+        <prefix>_pca<k>_weights.npy, shape (res, res, k + 1) with the half float weights widened to double
+    */
+    void savePca(const std::string& prefix, const PcaCoeffTable& table);
+    PcaCoeffTable loadPca(const std::string& prefix, uint32_t numCoeffs, uint32_t numComponents);
+}
@@ -0,0 +1,639 @@
+#include "LtshFitter.h"
+#include "PolygonSH.h"
+#include "../MappedNumpy.h"
+#include "../Numpy.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace ltsh
+{
+    namespace
+    {
+        const int kNumParams = 4;
+        using Params = std::array<double, kNumParams>;
+
+        // smallest GGX alpha that is fitted, the first rows of the table would otherwise be a delta distribution
+        const double kMinAlpha = 1e-3;
+        // smallest cosine of the view angle, the last column would otherwise look along the horizon
+        const double kMinCosTheta = 1e-3;
+        // Tikhonov regularization of the SH least squares, relative to the mean diagonal of the normal equations
+        const double kRegularization = 1e-7;
+        // objective of matrices that are singular or mirror the hemisphere
+        const double kInvalidError = 1e30;
+        // largest fitted matrix entry, the textures store half floats (max 65504) and the shaders filter them
+        const double kMaxParam = 1e4;
+
+        struct LtcLobe
+        {
+            static const int kNumCoeffs = 1;
+            static const int kOrder = 0;
+            static const bool kLeastSquares = false;
+
+            static void basis(const double3& dir, double b[1])
+            {
+                b[0] = std::fmax(0.0, dir.z) * kInvPi;
+            }
+        };
+
+        template<int Order>
+        struct ShLobe
+        {
+            static const int kNumCoeffs = PolygonSH<Order>::kNumCoeffs;
+            static const int kOrder = Order;
+            static const bool kLeastSquares = true;
+
+            static void basis(const double3& dir, double b[kNumCoeffs])
+            {
+                PolygonSH<Order>::evaluateBasis(dir, b);
+            }
+        };
+
+        /** BRDF samples of one cell, shared by all objective evaluations of the cell
+        */
+        struct CellSamples
+        {
+            std::vector<double3> L;
+            std::vector<double> f;
+            std::vector<double> weight;     // 1 / (count * pdf)
+            double albedo = 0;
+            double fSquared = 0;
+        };
+
+        double radicalInverse(uint32_t bits)
+        {
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+            return double(bits) * 2.3283064365386963e-10;
+        }
+
+        double cosinePdf(const double3& L)
+        {
+            return std::fmax(0.0, L.z) * kInvPi;
+        }
+
+        void generateSamples(const GgxLobe& brdf, uint32_t count, CellSamples& cell)
+        {
+            // half of the Hammersley points sample the BRDF, the other half the cosine, combined with the balance heuristic
+            uint32_t half = std::max(1u, count / 2);
+            cell.L.clear();
+            cell.f.clear();
+            cell.weight.clear();
+            for (uint32_t i = 0; i < half; i++)
+            {
+                double u1 = (i + 0.5) / half;
+                double u2 = radicalInverse(i);
+                double3 L;
+                brdf.sample(u1, u2, L);
+                cell.L.push_back(L);
+
+                double phi = 2.0 * kPi * u2;
+                double r = std::sqrt(u1);
+                cell.L.push_back(double3(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::fmax(0.0, 1.0 - u1))));
+            }
+
+            cell.albedo = 0;
+            cell.fSquared = 0;
+            double n = double(cell.L.size());
+            for (const double3& L : cell.L)
+            {
+                double f = brdf.eval(L);
+                double pdf = 0.5 * (brdf.pdf(L) + cosinePdf(L));
+                double w = pdf > 0 ? 1.0 / (n * pdf) : 0.0;
+                cell.f.push_back(f);
+                cell.weight.push_back(w);
+                cell.albedo += f * w;
+                cell.fSquared += f * f * w;
+            }
+        }
+
+        double3x3 matrixFromParams(const Params& p)
+        {
+            return double3x3(
+                1, 0, p[2],
+                0, p[1], 0,
+                p[0], 0, p[3]
+            );
+        }
+
+        /** Solve A x = b for a symmetric positive definite A (row-major n x n) with a Cholesky factorization
+        */
+        bool solveCholesky(int n, std::vector<double>& A, std::vector<double>& x, const double* b)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                double d = A[j * n + j];
+                for (int k = 0; k < j; k++) d -= A[j * n + k] * A[j * n + k];
+                if (d <= 0) return false;
+                d = std::sqrt(d);
+                A[j * n + j] = d;
+                for (int i = j + 1; i < n; i++)
+                {
+                    double s = A[i * n + j];
+                    for (int k = 0; k < j; k++) s -= A[i * n + k] * A[j * n + k];
+                    A[i * n + j] = s / d;
+                }
+            }
+            x.assign(b, b + n);
+            for (int i = 0; i < n; i++)
+            {
+                for (int k = 0; k < i; k++) x[i] -= A[i * n + k] * x[k];
+                x[i] /= A[i * n + i];
+            }
+            for (int i = n - 1; i >= 0; i--)
+            {
+                for (int k = i + 1; k < n; k++) x[i] -= A[k * n + i] * x[k];
+                x[i] /= A[i * n + i];
+            }
+            return true;
+        }
+
+        /** Squared relative L2 error of the lobe with inverse matrix p against the BRDF samples
+            \param[in] solve Solve for the coefficients by least squares, otherwise they are read
+            \param[in,out] coeffs The lobe coefficients
+            \param[in] allowMirror Accept matrices with a negative determinant. The fit rejects them, but the shaders
+                take the absolute value of the integral, so existing tables may contain them.
+        */
+        template<typename Lobe>
+        double lobeError(const CellSamples& cell, const Params& p, bool solve, std::vector<double>& coeffs, bool allowMirror = false)
+        {
+            const int K = Lobe::kNumCoeffs;
+            double3x3 MInv = matrixFromParams(p);
+            double det = determinant(MInv);
+            if (allowMirror) det = std::abs(det);
+            else if (!(std::fabs(p[0]) <= kMaxParam && std::fabs(p[1]) <= kMaxParam && std::fabs(p[2]) <= kMaxParam && std::fabs(p[3]) <= kMaxParam)) return kInvalidError;
+            if (!(det > 1e-12)) return kInvalidError;
+
+            // normal equations of the weighted least squares problem sum w (f - J * basis . c)^2
+            std::vector<double> A(K * K, 0.0);
+            double r[K] = {};
+            double b[K];
+            for (size_t i = 0; i < cell.L.size(); i++)
+            {
+                double w = cell.weight[i];
+                if (w == 0) continue;
+                double3 u = mul(MInv, cell.L[i]);
+                double len2 = dot(u, u);
+                double len = std::sqrt(len2);
+                double jacobian = det / (len2 * len);
+                Lobe::basis(u / len, b);
+                for (int k = 0; k < K; k++)
+                {
+                    b[k] *= jacobian;
+                    r[k] += w * cell.f[i] * b[k];
+                }
+                for (int k = 0; k < K; k++)
+                {
+                    double wb = w * b[k];
+                    for (int l = k; l < K; l++) A[k * K + l] += wb * b[l];
+                }
+            }
+            for (int k = 0; k < K; k++)
+            {
+                for (int l = 0; l < k; l++) A[k * K + l] = A[l * K + k];
+            }
+
+            if (solve)
+            {
+                std::vector<double> regularized = A;
+                double trace = 0;
+                for (int k = 0; k < K; k++) trace += A[k * K + k];
+                for (int k = 0; k < K; k++) regularized[k * K + k] += kRegularization * trace / K;
+                if (!solveCholesky(K, regularized, coeffs, r)) return kInvalidError;
+            }
+
+            // |f - g|^2 = f.f - 2 c.r + c.A.c
+            double err = cell.fSquared;
+            for (int k = 0; k < K; k++)
+            {
+                double Ac = 0;
+                for (int l = 0; l < K; l++) Ac += A[k * K + l] * coeffs[l];
+                err += coeffs[k] * (Ac - 2.0 * r[k]);
+            }
+            return std::fmax(0.0, err) / cell.fSquared;
+        }
+
+        /** Nelder-Mead minimization of func starting at p, stops after maxEvals evaluations or when the simplex
+            has collapsed. Returns the best value, p is set to its parameters.
+        */
+        template<typename Func>
+        double nelderMead(Func&& func, Params& p, uint32_t maxEvals)
+        {
+            const int n = kNumParams;
+            std::array<Params, n + 1> x;
+            std::array<double, n + 1> fx;
+            x[0] = p;
+            for (int i = 0; i < n; i++)
+            {
+                x[i + 1] = p;
+                x[i + 1][i] += 0.05 * std::fmax(1.0, std::abs(p[i]));
+            }
+            for (int i = 0; i <= n; i++) fx[i] = func(x[i]);
+            uint32_t evals = n + 1;
+
+            auto blend = [](const Params& a, const Params& b, double t)
+            {
+                Params res;
+                for (int i = 0; i < n; i++) res[i] = a[i] + t * (b[i] - a[i]);
+                return res;
+            };
+
+            while (evals < maxEvals)
+            {
+                // order the simplex from best to worst
+                std::array<int, n + 1> order;
+                for (int i = 0; i <= n; i++) order[i] = i;
+                std::sort(order.begin(), order.end(), [&](int a, int b) { return fx[a] < fx[b]; });
+                std::array<Params, n + 1> xs;
+                std::array<double, n + 1> fs;
+                for (int i = 0; i <= n; i++)
+                {
+                    xs[i] = x[order[i]];
+                    fs[i] = fx[order[i]];
+                }
+                x = xs;
+                fx = fs;
+
+                if (fx[n] - fx[0] <= 1e-10 * fx[0] + 1e-14) break;
+
+                Params centroid = {};
+                for (int i = 0; i < n; i++)
+                {
+                    for (int j = 0; j < n; j++) centroid[j] += x[i][j] / n;
+                }
+
+                Params reflected = blend(centroid, x[n], -1.0);
+                double fr = func(reflected);
+                evals++;
+                if (fr < fx[0])
+                {
+                    Params expanded = blend(centroid, x[n], -2.0);
+                    double fe = func(expanded);
+                    evals++;
+                    if (fe < fr) { x[n] = expanded; fx[n] = fe; }
+                    else { x[n] = reflected; fx[n] = fr; }
+                }
+                else if (fr < fx[n - 1])
+                {
+                    x[n] = reflected;
+                    fx[n] = fr;
+                }
+                else
+                {
+                    // contract towards the better of the worst and the reflected point
+                    bool outside = fr < fx[n];
+                    Params contracted = blend(centroid, outside ? reflected : x[n], 0.5);
+                    double fc = func(contracted);
+                    evals++;
+                    if (fc < (outside ? fr : fx[n]))
+                    {
+                        x[n] = contracted;
+                        fx[n] = fc;
+                    }
+                    else
+                    {
+                        for (int i = 1; i <= n; i++)
+                        {
+                            x[i] = blend(x[0], x[i], 0.5);
+                            fx[i] = func(x[i]);
+                        }
+                        evals += n;
+                    }
+                }
+            }
+
+            int best = int(std::min_element(fx.begin(), fx.end()) - fx.begin());
+            p = x[best];
+            return fx[best];
+        }
+
+        GgxLobe cellBrdf(const FitSettings& settings, uint32_t alphaIndex, uint32_t thetaIndex)
+        {
+            GgxLobe brdf;
+            brdf.alpha = cellAlpha(alphaIndex, settings.resolution);
+            brdf.f0 = settings.f0;
+            brdf.schlickFresnel = settings.schlickFresnel;
+            double theta = cellTheta(thetaIndex, settings.resolution);
+            double cosTheta = std::fmax(kMinCosTheta, std::cos(theta));
+            brdf.V = double3(std::sqrt(1.0 - cosTheta * cosTheta), 0.0, cosTheta);
+            return brdf;
+        }
+
+        /** Fit one cell, p holds the warm start on input
+        */
+        template<typename Lobe>
+        double fitCell(const FitSettings& settings, uint32_t alphaIndex, uint32_t thetaIndex, Params& p, std::vector<double>& coeffs)
+        {
+            CellSamples cell;
+            generateSamples(cellBrdf(settings, alphaIndex, thetaIndex), settings.numSamples, cell);
+            coeffs.assign(Lobe::kNumCoeffs, 0.0);
+            if (!(cell.fSquared > 0)) return 0;
+
+            // LTC keeps the normalization at the albedo so the lobe conserves the energy of the BRDF
+            if (!Lobe::kLeastSquares) coeffs[0] = cell.albedo;
+
+            std::vector<double> scratch = coeffs;
+            auto objective = [&](const Params& q) { return lobeError<Lobe>(cell, q, Lobe::kLeastSquares, scratch); };
+
+            // restart once from the optimum, the simplex of the first run may have collapsed prematurely
+            uint32_t budget = std::max(2u * (kNumParams + 1), settings.maxIterations);
+            nelderMead(objective, p, budget * 3 / 4);
+            nelderMead(objective, p, budget / 4);
+
+            double err = lobeError<Lobe>(cell, p, Lobe::kLeastSquares, coeffs);
+            return std::sqrt(err);
+        }
+
+        Params initialParams(const FitSettings& settings, uint32_t alphaIndex)
+        {
+            // at normal incidence the lobe is isotropic, the LTC is about diag(1, 1, alpha) after normalization
+            return Params{ 0.0, 1.0, 0.0, std::fmax(cellAlpha(alphaIndex, settings.resolution), 0.05) };
+        }
+
+        std::string withSlash(const std::string& dir)
+        {
+            return dir.empty() || dir.back() == '/' || dir.back() == '\\' ? dir : dir + "/";
+        }
+
+        std::string ltshSuffix(int order)
+        {
+            return "_n" + std::to_string(order) + "_t128.npy";
+        }
+    }
+
+    double GgxLobe::eval(const double3& L) const
+    {
+        if (L.z <= 0 || V.z <= 0) return 0;
+        double3 H = normalize(V + L);
+        double NdotH = std::fmax(0.0, H.z);
+        double LdotH = std::fmax(0.0, dot(L, H));
+        double NdotL = L.z;
+        double NdotV = V.z;
+
+        // evalGGX() and evalSmithGGX() of Shading.h
+        double a2 = alpha * alpha;
+        double d = (NdotH * a2 - NdotH) * NdotH + 1;
+        double D = a2 / (kPi * d * d);
+        double ggxv = NdotL * std::sqrt((-NdotV * a2 + NdotV) * NdotV + a2);
+        double ggxl = NdotV * std::sqrt((-NdotL * a2 + NdotL) * NdotL + a2);
+        double G = 0.5 / (ggxv + ggxl);
+        double F = schlickFresnel ? f0 + (1 - f0) * std::pow(1 - LdotH, 5.0) : f0;
+        return F * D * G * NdotL;
+    }
+
+    double GgxLobe::sample(double u1, double u2, double3& L) const
+    {
+        // Heitz 2018, "Sampling the GGX Distribution of Visible Normals"
+        double3 Vh = normalize(double3(alpha * V.x, alpha * V.y, V.z));
+        double lensq = Vh.x * Vh.x + Vh.y * Vh.y;
+        double3 T1 = lensq > 0 ? double3(-Vh.y, Vh.x, 0) / std::sqrt(lensq) : double3(1, 0, 0);
+        double3 T2 = cross(Vh, T1);
+        double r = std::sqrt(u1);
+        double phi = 2.0 * kPi * u2;
+        double t1 = r * std::cos(phi);
+        double t2 = r * std::sin(phi);
+        double s = 0.5 * (1.0 + Vh.z);
+        t2 = (1.0 - s) * std::sqrt(std::fmax(0.0, 1.0 - t1 * t1)) + s * t2;
+        double3 Nh = T1 * t1 + T2 * t2 + Vh * std::sqrt(std::fmax(0.0, 1.0 - t1 * t1 - t2 * t2));
+        double3 H = normalize(double3(alpha * Nh.x, alpha * Nh.y, std::fmax(0.0, Nh.z)));
+        L = H * (2.0 * dot(V, H)) - V;
+        return pdf(L);
+    }
+
+    double GgxLobe::pdf(const double3& L) const
+    {
+        if (L.z <= 0 || V.z <= 0) return 0;
+        // D(H) * G1(V) * dot(V, H) / V.z, times the Jacobian 1 / (4 dot(V, H)) of the reflection
+        double3 H = normalize(V + L);
+        double a2 = alpha * alpha;
+        double d = (H.z * a2 - H.z) * H.z + 1;
+        double D = a2 / (kPi * d * d);
+        double G1 = 2.0 * V.z / (V.z + std::sqrt(a2 + (1.0 - a2) * V.z * V.z));
+        return D * G1 / (4.0 * V.z);
+    }
+
+    double FitTable::maxError() const
+    {
+        return errors.empty() ? 0.0 : *std::max_element(errors.begin(), errors.end());
+    }
+
+    double FitTable::meanError() const
+    {
+        double sum = 0;
+        for (double e : errors) sum += e;
+        return errors.empty() ? 0.0 : sum / errors.size();
+    }
+
+    double cellTheta(uint32_t thetaIndex, uint32_t resolution)
+    {
+        // cosThetaRoughnessToUv() divides by 1.57079 and the shader scales by resolution - 1
+        return double(thetaIndex) / double(resolution - 1) * 1.57079;
+    }
+
+    double cellAlpha(uint32_t alphaIndex, uint32_t resolution)
+    {
+        double sqrtAlpha = double(alphaIndex) / double(resolution - 1);
+        return std::fmax(kMinAlpha, sqrtAlpha * sqrtAlpha);
+    }
+
+    LtshFitter::LtshFitter(const FitSettings& settings)
+        : mSettings(settings)
+        , mPool(settings.numThreads)
+    {
+        if (mSettings.resolution < 2)
+        {
+            throw std::invalid_argument("LtshFitter: the resolution has to be at least 2");
+        }
+    }
+
+    template<typename Lobe>
+    FitTable LtshFitter::fit()
+    {
+        const uint32_t res = mSettings.resolution;
+        const int K = Lobe::kNumCoeffs;
+
+        FitTable table;
+        table.resolution = res;
+        table.numCoeffs = K;
+        table.matrices.resize(size_t(res) * res * kNumParams);
+        table.coeffs.resize(size_t(res) * res * K);
+        table.errors.resize(size_t(res) * res);
+
+        auto store = [&](uint32_t alpha, uint32_t theta, const Params& p, const std::vector<double>& coeffs, double err)
+        {
+            size_t cell = size_t(alpha) * res + theta;
+            std::copy(p.begin(), p.end(), table.matrices.begin() + cell * kNumParams);
+            std::copy(coeffs.begin(), coeffs.end(), table.coeffs.begin() + cell * K);
+            table.errors[cell] = err;
+        };
+
+        // normal incidence from rough to smooth, the isotropic lobes change slowly with alpha
+        std::vector<Params> start(res);
+        Params p = initialParams(mSettings, res - 1);
+        std::vector<double> coeffs;
+        for (uint32_t alpha = res; alpha-- > 0;)
+        {
+            double err = fitCell<Lobe>(mSettings, alpha, 0, p, coeffs);
+            store(alpha, 0, p, coeffs, err);
+            start[alpha] = p;
+        }
+
+        // the rows are independent, within a row each cell starts at the optimum of its predecessor
+        mPool.parallelFor(res, [&](size_t alpha, uint32_t)
+        {
+            Params q = start[alpha];
+            std::vector<double> c;
+            for (uint32_t theta = 1; theta < res; theta++)
+            {
+                double err = fitCell<Lobe>(mSettings, uint32_t(alpha), theta, q, c);
+                store(uint32_t(alpha), theta, q, c, err);
+            }
+        });
+        return table;
+    }
+
+    template<typename Lobe>
+    void LtshFitter::evaluate(FitTable& table)
+    {
+        const uint32_t res = mSettings.resolution;
+        const int K = Lobe::kNumCoeffs;
+        if (table.resolution != res || table.numCoeffs != uint32_t(K))
+        {
+            throw std::invalid_argument("LtshFitter::evaluateTable: the table does not match the fitter settings");
+        }
+        table.errors.assign(size_t(res) * res, 0.0);
+        mPool.parallelFor(size_t(res) * res, [&](size_t cellIndex, uint32_t)
+        {
+            CellSamples cell;
+            generateSamples(cellBrdf(mSettings, uint32_t(cellIndex / res), uint32_t(cellIndex % res)), mSettings.numSamples, cell);
+            if (!(cell.fSquared > 0)) return;
+            Params p;
+            std::copy_n(table.matrices.begin() + cellIndex * kNumParams, kNumParams, p.begin());
+            std::vector<double> coeffs(table.coeffs.begin() + cellIndex * K, table.coeffs.begin() + (cellIndex + 1) * K);
+            // compare against the same samples the fit uses, singular matrices count as a total miss
+            double err = lobeError<Lobe>(cell, p, false, coeffs, true);
+            table.errors[cellIndex] = err >= kInvalidError ? 1.0 : std::sqrt(err);
+        });
+    }
+
+    FitTable LtshFitter::fitLtc()
+    {
+        return fit<LtcLobe>();
+    }
+
+    FitTable LtshFitter::fitLtsh(int order)
+    {
+        switch (order)
+        {
+        case 2: return fit<ShLobe<2>>();
+        case 3: return fit<ShLobe<3>>();
+        case 4: return fit<ShLobe<4>>();
+        case 5: return fit<ShLobe<5>>();
+        case 6: return fit<ShLobe<6>>();
+        case 7: return fit<ShLobe<7>>();
+        case 8: return fit<ShLobe<8>>();
+        }
+        throw std::invalid_argument("LtshFitter::fitLtsh: unsupported order " + std::to_string(order));
+    }
+
+    void LtshFitter::evaluateTable(int order, FitTable& table)
+    {
+        switch (order)
+        {
+        case 0: evaluate<LtcLobe>(table); return;
+        case 2: evaluate<ShLobe<2>>(table); return;
+        case 3: evaluate<ShLobe<3>>(table); return;
+        case 4: evaluate<ShLobe<4>>(table); return;
+        case 5: evaluate<ShLobe<5>>(table); return;
+        case 6: evaluate<ShLobe<6>>(table); return;
+        case 7: evaluate<ShLobe<7>>(table); return;
+        case 8: evaluate<ShLobe<8>>(table); return;
+        }
+        throw std::invalid_argument("LtshFitter::evaluateTable: unsupported order " + std::to_string(order));
+    }
+
+    void saveLtcTables(const std::string& paramDir, const FitTable& table)
+    {
+        std::string dir = withSlash(paramDir);
+        aoba::SaveArrayAsNumpy(dir + "inv_cos_mat_t128.npy", int(table.matrices.size()), table.matrices.data());
+        aoba::SaveArrayAsNumpy(dir + "cos_coeff_t128.npy", int(table.coeffs.size()), table.coeffs.data());
+    }
+
+    void saveLtshTables(const std::string& paramDir, int order, const FitTable& table)
+    {
+        std::string dir = withSlash(paramDir);
+        const uint32_t res = table.resolution;
+        const uint32_t K = table.numCoeffs;
+        aoba::SaveArrayAsNumpy(dir + "inv_sh_mat" + ltshSuffix(order), int(table.matrices.size()), table.matrices.data());
+
+        std::vector<double> coeffs(table.coeffs.size());
+        for (uint32_t alpha = 0; alpha < res; alpha++)
+        {
+            for (uint32_t theta = 0; theta < res; theta++)
+            {
+                const double* src = &table.coeffs[(size_t(alpha) * res + theta) * K];
+                double* dst = &coeffs[(size_t(theta) * res + alpha) * K];
+                for (uint32_t k = 0; k < K; k++)
+                {
+                    // the odd coefficients are stored negated, see LutTables::loadCoeffs()
+                    dst[k] = (k & 1) ? -src[k] : src[k];
+                }
+            }
+        }
+        const int shape[3] = { int(res), int(res), int(K) };
+        aoba::SaveArrayAsNumpy(dir + "sh_coeff" + ltshSuffix(order), 3, shape, coeffs.data());
+    }
+
+    FitTable loadLtcTables(const std::string& paramDir, uint32_t resolution)
+    {
+        std::string dir = withSlash(paramDir);
+        size_t cells = size_t(resolution) * resolution;
+        FitTable table;
+        table.resolution = resolution;
+        table.numCoeffs = 1;
+
+        MappedNumpyArray matrices(dir + "inv_cos_mat_t128.npy");
+        ArraySpan<double> m = matrices.getData<double>({ cells * kNumParams });
+        table.matrices.assign(m.begin(), m.end());
+        MappedNumpyArray coeffs(dir + "cos_coeff_t128.npy");
+        ArraySpan<double> c = coeffs.getData<double>({ cells });
+        table.coeffs.assign(c.begin(), c.end());
+        return table;
+    }
+
+    FitTable loadLtshTables(const std::string& paramDir, int order, uint32_t resolution)
+    {
+        std::string dir = withSlash(paramDir);
+        const uint32_t K = uint32_t((order + 1) * (order + 1));
+        size_t cells = size_t(resolution) * resolution;
+        FitTable table;
+        table.resolution = resolution;
+        table.numCoeffs = K;
+
+        MappedNumpyArray matrices(dir + "inv_sh_mat" + ltshSuffix(order));
+        ArraySpan<double> m = matrices.getData<double>({ cells * kNumParams });
+        table.matrices.assign(m.begin(), m.end());
+
+        MappedNumpyArray coeffs(dir + "sh_coeff" + ltshSuffix(order));
+        ArraySpan<double> c = coeffs.getData<double>({ resolution, resolution, K });
+        table.coeffs.resize(c.size());
+        for (uint32_t theta = 0; theta < resolution; theta++)
+        {
+            for (uint32_t alpha = 0; alpha < resolution; alpha++)
+            {
+                const double* src = &c[(size_t(theta) * resolution + alpha) * K];
+                double* dst = &table.coeffs[(size_t(alpha) * resolution + theta) * K];
+                for (uint32_t k = 0; k < K; k++)
+                {
+                    dst[k] = (k & 1) ? -src[k] : src[k];
+                }
+            }
+        }
+        return table;
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// Offline fit of the LTC and LTSH lookup tables in Data/Params. Every cell of the (theta, alpha) grid approximates
+// the GGX BRDF times the cosine, as the ground truth mode of the lighting pass evaluates it, by a lobe in a linearly
+// transformed space: the clamped cosine for LTC, an SH expansion of the given order for LTSH. The inverse matrix
+// has the 4 free entries that getLtcMatrix()/getLtshMatrix() read,
+//      1 0 m.z
+//      0 m.y 0
+//      m.x 0 m.w
+// and is found with Nelder-Mead. For a fixed matrix the SH coefficients are the weighted least squares solution,
+// so the optimizer only searches the matrix. The integrals over the BRDF use a fixed set of samples per cell, drawn
+// half from the GGX distribution of visible normals and half from the cosine, which keeps the objective smooth.
+//
+// The cells at normal incidence are fitted first, from rough to smooth, each starting from its rougher neighbor.
+// Then every alpha row is fitted in parallel along theta, each cell starting from the previous one.
+
+#include "ThreadPool.h"
+#include "VecMath.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ltsh
+{
+    /** GGX times the cosine with Falcor's height correlated Smith term, Schlick's Fresnel (F90 = 1) or a
+        constant F0 instead. The view direction is (sin(theta), 0, cos(theta)).
+    */
+    struct GgxLobe
+    {
+        double alpha = 0.5;
+        double f0 = 0.4;
+        bool schlickFresnel = true;
+        double3 V = double3(0, 0, 1);
+
+        double eval(const double3& L) const;
+
+        /** Sample a direction from the distribution of visible normals, returns the pdf of the direction
+        */
+        double sample(double u1, double u2, double3& L) const;
+        double pdf(const double3& L) const;
+    };
+
+    struct FitSettings
+    {
+        uint32_t resolution = 64;       ///< Cells along theta and alpha
+        uint32_t numSamples = 2048;     ///< BRDF samples per cell
+        uint32_t maxIterations = 400;   ///< Objective evaluations of Nelder-Mead per cell
+        double f0 = 0.4;                ///< sd.specular of LightingPass.ps.hlsl
+        bool schlickFresnel = true;
+        uint32_t numThreads = 0;
+    };
+
+    /** One fitted table in the cell order of the matrix textures, [alpha][theta]
+    */
+    struct FitTable
+    {
+        uint32_t resolution = 0;
+        uint32_t numCoeffs = 0;
+        std::vector<double> matrices;   ///< (m.x, m.y, m.z, m.w) per cell
+        std::vector<double> coeffs;     ///< numCoeffs per cell; the normalization for LTC, SH in evaluateSH() convention for LTSH
+        std::vector<double> errors;     ///< relative L2 error of the fitted lobe per cell
+
+        double maxError() const;
+        double meanError() const;
+    };
+
+    /** Angle of view and GGX alpha of a cell, with the same mapping as cosThetaRoughnessToUv()
+    */
+    double cellTheta(uint32_t thetaIndex, uint32_t resolution);
+    double cellAlpha(uint32_t alphaIndex, uint32_t resolution);
+
+    class LtshFitter
+    {
+    public:
+        explicit LtshFitter(const FitSettings& settings);
+
+        /** Fit the inverse LTC matrices and normalizations
+        */
+        FitTable fitLtc();
+
+        /** Fit the inverse LTSH matrices and SH coefficients of the given order (2 to kPolygonSHMaxOrder)
+        */
+        FitTable fitLtsh(int order);
+
+        /** Relative L2 error of an existing table under this fitter's BRDF and samples
+            \param[in] order SH order, 0 for an LTC table
+        */
+        void evaluateTable(int order, FitTable& table);
+
+        const FitSettings& getSettings() const { return mSettings; }
+
+    private:
+        template<typename Lobe>
+        FitTable fit();
+        template<typename Lobe>
+        void evaluate(FitTable& table);
+
+        FitSettings mSettings;
+        ThreadPool mPool;
+    };
+
+    /** Write inv_cos_mat_t128.npy and cos_coeff_t128.npy to paramDir
+    */
+    void saveLtcTables(const std::string& paramDir, const FitTable& table);
+
+    /** Write inv_sh_mat_n<order>_t128.npy and sh_coeff_n<order>_t128.npy to paramDir. The coefficient file is
+        indexed [theta][alpha][k] and its odd coefficients are negated, like the tables LutTables reads.
+    */
+    void saveLtshTables(const std::string& paramDir, int order, const FitTable& table);
+
+    /** Read tables in the format written above. Throws std::runtime_error if a file is missing or malformed.
+    */
+    FitTable loadLtcTables(const std::string& paramDir, uint32_t resolution);
+    FitTable loadLtshTables(const std::string& paramDir, int order, uint32_t resolution);
+}
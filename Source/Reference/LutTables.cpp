@@ -0,0 +1,161 @@
+#include "LutTables.h"
+#include "Half.h"
+#include "../LutPacking.h"
+#include "../MappedNumpy.h"
+
+#include <stdexcept>
+
+namespace ltsh
+{
+    namespace
+    {
+        // returns the resolution of the table, all tables of a directory must agree on it
+        int loadTable(const std::string& filename, uint32_t valuesPerCell, bool quantize, std::vector<float>& out)
+        {
+            MappedNumpyArray file(filename);
+            int res = (int)getLutResolution(file.getShape(), valuesPerCell);
+            if (res == 0)
+            {
+                throw std::runtime_error("formatting error: " + filename + " is not a square table of " + std::to_string(valuesPerCell) + " values per cell");
+            }
+            ArraySpan<double> data = file.getData<double>();
+            out.resize(data.size());
+            for (size_t i = 0; i < data.size(); i++)
+            {
+                out[i] = quantize ? quantizeToHalf(float(data[i])) : float(data[i]);
+            }
+            return res;
+        }
+
+        // the coefficient files are indexed [theta][alpha][k], transpose them to the [alpha][theta][k] texture order
+        void transposeCoeffs(int resolution, int numCoeffs, std::vector<float>& table)
+        {
+            std::vector<float> res(table.size());
+            for (int theta = 0; theta < resolution; theta++)
+            {
+                for (int alpha = 0; alpha < resolution; alpha++)
+                {
+                    for (int k = 0; k < numCoeffs; k++)
+                    {
+                        res[(alpha * resolution + theta) * numCoeffs + k] = table[(theta * resolution + alpha) * numCoeffs + k];
+                    }
+                }
+            }
+            table.swap(res);
+        }
+    }
+
+    void LutTables::load(const std::string& paramDir, bool quantize)
+    {
+        std::string dir = paramDir.empty() || paramDir.back() == '/' || paramDir.back() == '\\' ? paramDir : paramDir + "/";
+        int res[6];
+        res[0] = loadTable(dir + "inv_cos_mat_t128.npy", 4, quantize, mLtcMInv);
+        res[1] = loadTable(dir + "cos_coeff_t128.npy", 1, quantize, mLtcCoeff);
+        res[2] = loadTable(dir + "inv_sh_mat_n4_t128.npy", 4, quantize, mLtshMInv);
+        res[3] = loadTable(dir + "sh_coeff_n4_t128.npy", 25, quantize, mLtshCoeff);
+        res[4] = loadTable(dir + "inv_sh_mat_n2_t128.npy", 4, quantize, mLtshMInvN2);
+        res[5] = loadTable(dir + "sh_coeff_n2_t128.npy", 9, quantize, mLtshCoeffN2);
+        for (int i = 1; i < 6; i++)
+        {
+            if (res[i] != res[0])
+            {
+                throw std::runtime_error("formatting error: the tables in " + paramDir + " have different resolutions");
+            }
+        }
+        mResolution = res[0];
+        transposeCoeffs(mResolution, 25, mLtshCoeff);
+        transposeCoeffs(mResolution, 9, mLtshCoeffN2);
+    }
+
+    float3x3 LutTables::matrixFromVec(const float4& matVec)
+    {
+        return float3x3(
+            1, 0, matVec.z,
+            0, matVec.y, 0,
+            matVec.x, 0, matVec.w
+        );
+    }
+
+    float4 LutTables::load4(const std::vector<float>& table, const int2& uv) const
+    {
+        const int kRes = mResolution;
+        // out of bounds loads return zero like Texture2D.Load
+        if (uv.x < 0 || uv.y < 0 || uv.x >= kRes || uv.y >= kRes)
+        {
+            return float4();
+        }
+        const float* p = &table[(uv.y * kRes + uv.x) * 4];
+        return float4(p[0], p[1], p[2], p[3]);
+    }
+
+    void LutTables::loadCoeffs(const std::vector<float>& table, int numCoeffs, const int2& uv, float* coeffs) const
+    {
+        const int kRes = mResolution;
+        if (uv.x < 0 || uv.y < 0 || uv.x >= kRes || uv.y >= kRes)
+        {
+            for (int k = 0; k < numCoeffs; k++) coeffs[k] = 0.f;
+            return;
+        }
+        const float* p = &table[(uv.y * kRes + uv.x) * numCoeffs];
+        // all the odd coefficients need to be negated due to a different convention in the Wang/Ramamoorthi code
+        for (int k = 0; k < numCoeffs; k++)
+        {
+            coeffs[k] = (k & 1) ? -p[k] : p[k];
+        }
+    }
+
+    float4 LutTables::sample4(const std::vector<float>& table, int channels, const float2& uv) const
+    {
+        float res[4] = {};
+        sample(table, channels, uv, res);
+        return float4(res[0], res[1], res[2], res[3]);
+    }
+
+    void LutTables::sample(const std::vector<float>& table, int channels, const float2& uv, float* values) const
+    {
+        const int kRes = mResolution;
+        float tx = uv.x * kRes - 0.5f;
+        float ty = uv.y * kRes - 0.5f;
+        int x0 = (int)std::floor(tx);
+        int y0 = (int)std::floor(ty);
+        float fx = tx - x0;
+        float fy = ty - y0;
+
+        for (int c = 0; c < channels; c++) values[c] = 0.f;
+        for (int j = 0; j < 2; j++)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                int x = x0 + i, y = y0 + j;
+                // border addressing, the border color is black
+                if (x < 0 || y < 0 || x >= kRes || y >= kRes) continue;
+                float w = (i ? fx : 1.f - fx) * (j ? fy : 1.f - fy);
+                const float* p = &table[(y * kRes + x) * channels];
+                for (int c = 0; c < channels; c++)
+                {
+                    values[c] += w * p[c];
+                }
+            }
+        }
+    }
+
+    void LutTables::sampleCoeffs(const std::vector<float>& table, int numCoeffs, const float2& uv, float* coeffs) const
+    {
+        // the shader filters every texel group of a tile separately, which is the same as filtering per coefficient
+        sample(table, numCoeffs, uv, coeffs);
+        for (int k = 1; k < numCoeffs; k += 2)
+        {
+            coeffs[k] = -coeffs[k];
+        }
+    }
+
+    float3x3 LutTables::getLtcMatrix(const float2& uv) const
+    {
+        return matrixFromVec(sample4(mLtcMInv, 4, uv));
+    }
+
+    float LutTables::getLtcCoeff(const float2& uv) const
+    {
+        return sample4(mLtcCoeff, 1, uv).x;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// CPU side copies of the LTC/LTSH lookup tables in Data/Params with the same addressing as the textures that
+// SimpleDeferred::onLoad creates, so the CPU lighting pass fetches exactly what the shader fetches.
+
+#include "Shading.h"
+#include <string>
+#include <vector>
+
+namespace ltsh
+{
+    class LutTables
+    {
+    public:
+        /** Load the six fitted tables. Throws std::runtime_error if a file is missing or malformed or if the tables
+            do not share one resolution.
+            \param[in] paramDir Directory containing the .npy files, usually Data/Params
+            \param[in] quantize Round all values to half precision like the RGBA16F/R16F textures do
+        */
+        void load(const std::string& paramDir, bool quantize = true);
+
+        /** Cells along theta and alpha, read from the table files
+        */
+        int getResolution() const { return mResolution; }
+
+        /** Bilinear fetch of the LTC matrix, equivalent to getLtcMatrix() with the border sampler
+        */
+        float3x3 getLtcMatrix(const float2& uv) const;
+
+        /** Bilinear fetch of the LTC normalization, equivalent to getCoeff()
+        */
+        float getLtcCoeff(const float2& uv) const;
+
+        /** Point fetch of the LTSH matrix (N=4), equivalent to getLtshMatrix()
+        */
+        float3x3 getLtshMatrix(const int2& uv) const { return matrixFromVec(load4(mLtshMInv, uv)); }
+
+        /** Point fetch of the LTSH matrix (N=2), equivalent to getLtshMatrixN2()
+        */
+        float3x3 getLtshMatrixN2(const int2& uv) const { return matrixFromVec(load4(mLtshMInvN2, uv)); }
+
+        /** Point fetch of the 25 LTSH coefficients with the odd coefficients negated, equivalent to getLtshCoeffs()
+        */
+        void getLtshCoeffs(const int2& uv, float coeffs[25]) const { loadCoeffs(mLtshCoeff, 25, uv, coeffs); }
+
+        /** Point fetch of the 9 LTSH coefficients with the odd coefficients negated, equivalent to getLtshCoeffsN2()
+        */
+        void getLtshCoeffsN2(const int2& uv, float coeffs[9]) const { loadCoeffs(mLtshCoeffN2, 9, uv, coeffs); }
+
+        /** Bilinear fetch of the LTSH matrix (N=4), equivalent to getLtshMatrixFiltered(). uv is the unbiased
+            [0,1] table coordinate like for getLtcMatrix().
+        */
+        float3x3 getLtshMatrix(const float2& uv) const { return matrixFromVec(sample4(mLtshMInv, 4, uv)); }
+
+        /** Bilinear fetch of the LTSH matrix (N=2), equivalent to getLtshMatrixN2Filtered()
+        */
+        float3x3 getLtshMatrixN2(const float2& uv) const { return matrixFromVec(sample4(mLtshMInvN2, 4, uv)); }
+
+        /** Bilinear fetch of the 25 LTSH coefficients, equivalent to getLtshCoeffsFiltered()
+        */
+        void getLtshCoeffs(const float2& uv, float coeffs[25]) const { sampleCoeffs(mLtshCoeff, 25, uv, coeffs); }
+
+        /** Bilinear fetch of the 9 LTSH coefficients, equivalent to getLtshCoeffsN2Filtered()
+        */
+        void getLtshCoeffsN2(const float2& uv, float coeffs[9]) const { sampleCoeffs(mLtshCoeffN2, 9, uv, coeffs); }
+
+    private:
+        static float3x3 matrixFromVec(const float4& matVec);
+        float4 load4(const std::vector<float>& table, const int2& uv) const;
+        void loadCoeffs(const std::vector<float>& table, int numCoeffs, const int2& uv, float* coeffs) const;
+        float4 sample4(const std::vector<float>& table, int channels, const float2& uv) const;
+        void sample(const std::vector<float>& table, int channels, const float2& uv, float* values) const;
+        void sampleCoeffs(const std::vector<float>& table, int numCoeffs, const float2& uv, float* coeffs) const;
+
+        int mResolution = 0;
+
+        // matrices are stored row by row like the textures, [alpha][theta][4]
+        std::vector<float> mLtcMInv;
+        std::vector<float> mLtcCoeff;
+        std::vector<float> mLtshMInv;
+        std::vector<float> mLtshMInvN2;
+        // coefficients are stored per cell, [alpha][theta][numCoeffs]
+        std::vector<float> mLtshCoeff;
+        std::vector<float> mLtshCoeffN2;
+    };
+}
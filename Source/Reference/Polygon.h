@@ -0,0 +1,44 @@
+#pragma once
+
+// CPU port of the polygon limits and the horizon clipping in Data/Polygon.slang. Area lights are arbitrary simple
+// polygons, convex or concave, with up to kMaxPolygonVertices vertices.
+
+#include "VecMath.h"
+
+namespace ltsh
+{
+    // Maximum number of vertices of an area light, AREA_LIGHT_MAX_VERTICES on the host and MaxPolygonVertices in the shaders
+    static const int kMaxPolygonVertices = 8;
+    // Clipping adds at most one vertex to a convex polygon, but up to n / 2 to a concave one that crosses the horizon repeatedly
+    static const int kMaxClippedVertices = kMaxPolygonVertices + kMaxPolygonVertices / 2;
+
+    /** Clip a polygon to the upper hemisphere (z > 0). Walks the edges once and keeps the vertices above the horizon
+        plus the intersection of every edge that crosses it (Sutherland-Hodgman with a single plane).
+        \param[in] L numVerts vertices
+        \param[in] numVerts Number of input vertices, at most kMaxPolygonVertices
+        \param[out] clipped Up to numVerts + numVerts / 2 vertices, must not alias L
+        \return Number of vertices after clipping, 0 if the polygon is below the horizon
+    */
+    template<typename Real>
+    int clipPolygonToHorizon(const Vec3<Real>* L, int numVerts, Vec3<Real>* clipped)
+    {
+        int n = 0;
+        for (int i = 0; i < numVerts; i++)
+        {
+            const Vec3<Real>& a = L[i];
+            const Vec3<Real>& b = L[(i + 1) % numVerts];
+            bool aAbove = a.z > Real(0.0);
+            bool bAbove = b.z > Real(0.0);
+            if (aAbove)
+            {
+                clipped[n++] = a;
+            }
+            if (aAbove != bAbove)
+            {
+                // intersection with z = 0 up to a positive scale, the vertices are normalized afterwards
+                clipped[n++] = aAbove ? -b.z * a + a.z * b : -a.z * b + b.z * a;
+            }
+        }
+        return n >= 3 ? n : 0;
+    }
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+// Double precision integration of a function of direction over the solid angle of a polygonal light, the golden
+// reference for the analytic and sampled render modes. The polygon is clipped to the upper hemisphere at the exact
+// intersection with z = 0 and split into a signed triangle fan, so concave polygons need no decomposition. Every
+// triangle of the fan is integrated in the plane of the light, where the solid angle measure is
+// |dot(n, p)| / |p|^3 dA, with a degree 5 rule (Radon's 7 points) and refined adaptively: a triangle is split into
+// its 4 midpoint children until their sum differs from the parent rule by less than the triangle's share of the
+// tolerance. The first minDepth levels are always refined so that narrow lobes inside a large light are not missed.
+
+#include "VecMath.h"
+#include <cmath>
+#include <cstdint>
+
+namespace ltsh
+{
+    struct QuadratureSettings
+    {
+        double relTolerance = 1e-7;     ///< Target error relative to a coarse estimate of the integral
+        double absTolerance = 1e-14;    ///< Lower bound of the target error for integrals close to zero
+        int minDepth = 3;               ///< Levels of uniform refinement before the error test
+        int maxDepth = 16;              ///< Triangles at this level are accepted regardless of their error
+    };
+
+    struct QuadratureStats
+    {
+        uint64_t evaluations = 0;       ///< Calls of the integrand
+        double errorEstimate = 0;       ///< Sum of |children - parent| over the accepted triangles
+        bool converged = true;          ///< False if a triangle reached maxDepth above its tolerance
+    };
+
+    namespace quadrature
+    {
+        // Radon's degree 5 rule, barycentric coordinates (a, a, 1 - 2a) and weights relative to the area
+        const double kSqrt15 = 3.872983346207417;
+        const double kA1 = (6.0 - kSqrt15) / 21.0;
+        const double kA2 = (6.0 + kSqrt15) / 21.0;
+        const double kW0 = 9.0 / 40.0;
+        const double kW1 = (155.0 - kSqrt15) / 1200.0;
+        const double kW2 = (155.0 + kSqrt15) / 1200.0;
+
+        template<typename Func>
+        struct PlaneIntegrand
+        {
+            const Func& f;
+            double3 normal;
+            QuadratureStats& stats;
+
+            double operator()(const double3& p) const
+            {
+                stats.evaluations++;
+                double r2 = dot(p, p);
+                double r = std::sqrt(r2);
+                return f(p / r) * std::abs(dot(normal, p)) / (r2 * r);
+            }
+        };
+
+        template<typename Integrand>
+        double rule(const Integrand& g, const double3& a, const double3& b, const double3& c)
+        {
+            double area = 0.5 * length(cross(b - a, c - a));
+            double3 centroid = (a + b + c) / 3.0;
+            double sum = kW0 * g(centroid);
+            sum += kW1 * (g(a * (1.0 - 2.0 * kA1) + (b + c) * kA1) + g(b * (1.0 - 2.0 * kA1) + (a + c) * kA1) + g(c * (1.0 - 2.0 * kA1) + (a + b) * kA1));
+            sum += kW2 * (g(a * (1.0 - 2.0 * kA2) + (b + c) * kA2) + g(b * (1.0 - 2.0 * kA2) + (a + c) * kA2) + g(c * (1.0 - 2.0 * kA2) + (a + b) * kA2));
+            return area * sum;
+        }
+
+        template<typename Integrand>
+        double adapt(const Integrand& g, const double3& a, const double3& b, const double3& c, double whole, double tolerance,
+                     int depth, const QuadratureSettings& settings, QuadratureStats& stats)
+        {
+            double3 ab = (a + b) * 0.5;
+            double3 bc = (b + c) * 0.5;
+            double3 ca = (c + a) * 0.5;
+            double children[4] = { rule(g, a, ab, ca), rule(g, ab, b, bc), rule(g, ca, bc, c), rule(g, ab, bc, ca) };
+            double sum = children[0] + children[1] + children[2] + children[3];
+            double error = std::abs(sum - whole);
+
+            if (depth >= settings.minDepth && (error <= tolerance || depth >= settings.maxDepth))
+            {
+                stats.errorEstimate += error;
+                if (error > tolerance) stats.converged = false;
+                return sum;
+            }
+            double childTolerance = tolerance * 0.25;
+            return adapt(g, a, ab, ca, children[0], childTolerance, depth + 1, settings, stats) +
+                   adapt(g, ab, b, bc, children[1], childTolerance, depth + 1, settings, stats) +
+                   adapt(g, ca, bc, c, children[2], childTolerance, depth + 1, settings, stats) +
+                   adapt(g, ab, bc, ca, children[3], childTolerance, depth + 1, settings, stats);
+        }
+
+        /** Sum over the fan of the clipped polygon, each triangle weighted with the sign of its orientation
+        */
+        template<typename Integrand>
+        double integrateFan(const Integrand& g, const double3* clipped, int n, double tolerance, const QuadratureSettings& settings,
+                            QuadratureStats& stats)
+        {
+            double total = 0;
+            for (int i = 1; i + 1 < n; i++)
+            {
+                const double3& a = clipped[0];
+                const double3& b = clipped[i];
+                const double3& c = clipped[i + 1];
+                double orientation = dot(cross(b - a, c - a), g.normal);
+                if (orientation == 0) continue;
+                double value = adapt(g, a, b, c, rule(g, a, b, c), tolerance, 1, settings, stats);
+                total += orientation > 0 ? value : -value;
+            }
+            return total;
+        }
+    }
+
+    /** Integrate f(w) over the directions w of a planar polygon seen from the origin, restricted to w.z >= 0
+        \param[in] polygon numVertices vertices of a simple planar polygon, relative to the shading point
+        \param[in] f Callable double(const double3& w) with a unit direction w
+        \param[out] pStats Optional statistics, accumulated over calls
+    */
+    template<typename Func>
+    double integratePolygon(const double3* polygon, int numVertices, const Func& f, const QuadratureSettings& settings = QuadratureSettings(),
+                            QuadratureStats* pStats = nullptr)
+    {
+        // Newell's normal, robust for concave polygons
+        double3 normal(0.0);
+        for (int i = 0; i < numVertices; i++)
+        {
+            const double3& a = polygon[i];
+            const double3& b = polygon[(i + 1) % numVertices];
+            normal += cross(a, b);
+        }
+        if (dot(normal, normal) == 0) return 0;
+        normal = normalize(normal);
+
+        // clip at the exact intersection so the vertices stay in the plane of the light
+        const int kMaxVertices = 64;
+        double3 clipped[kMaxVertices];
+        int n = 0;
+        for (int i = 0; i < numVertices && n + 2 <= kMaxVertices; i++)
+        {
+            const double3& a = polygon[i];
+            const double3& b = polygon[(i + 1) % numVertices];
+            if (a.z >= 0) clipped[n++] = a;
+            if ((a.z >= 0) != (b.z >= 0))
+            {
+                double t = a.z / (a.z - b.z);
+                double3 p = a + (b - a) * t;
+                p.z = 0;
+                clipped[n++] = p;
+            }
+        }
+        if (n < 3) return 0;
+
+        QuadratureStats localStats;
+        QuadratureStats& stats = pStats ? *pStats : localStats;
+        quadrature::PlaneIntegrand<Func> g = { f, normal, stats };
+
+        // the fixed first levels give the scale of the integral for the relative tolerance
+        QuadratureSettings coarse = settings;
+        coarse.maxDepth = settings.minDepth;
+        QuadratureStats coarseStats;
+        quadrature::PlaneIntegrand<Func> gCoarse = { f, normal, coarseStats };
+        double estimate = quadrature::integrateFan(gCoarse, clipped, n, 0.0, coarse, coarseStats);
+        stats.evaluations += coarseStats.evaluations;
+
+        double tolerance = std::fmax(settings.relTolerance * std::abs(estimate), settings.absTolerance) / double(n - 2);
+        return quadrature::integrateFan(g, clipped, n, tolerance, settings, stats);
+    }
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+// Closed-form SH projection of polygonal lights for any order from 2 to kPolygonSHMaxOrder. This generalizes the
+// hand-written N=2 and N=4 code in LTSHn2.h and LTSH.h: the boundary and zonal recurrences are unrolled at compile
+// time with their coefficients folded to constants, and the projection matrices come from PolygonSHTables.h, which
+// polygon_sh_gen writes together with the matching shader code in Data/PolygonSH.slang. Up to order 4 the same lobes
+// as the hand-written code are used, so PolygonSH<4> and polygonSH() agree to the precision of its constants.
+
+#include "LTSH.h"
+#include "PolygonSHTables.h"
+
+#include <type_traits>
+#include <utility>
+
+namespace ltsh
+{
+    namespace detail
+    {
+        template<typename Func, int... I>
+        inline void staticFor(Func&& func, std::integer_sequence<int, I...>)
+        {
+            int expand[] = { 0, (func(std::integral_constant<int, I>()), 0)... };
+            (void)expand;
+        }
+
+        /** Call func(std::integral_constant<int, I>()) for I = Begin .. End - 1 so every iteration sees a constant index
+        */
+        template<int Begin, int End, typename Func>
+        inline void staticFor(Func&& func)
+        {
+            staticFor([&](auto i) { func(std::integral_constant<int, Begin + decltype(i)::value>()); },
+                      std::make_integer_sequence<int, (End > Begin ? End - Begin : 0)>());
+        }
+
+        // Legendre recurrence P_k = legendreA(k) * x * P_{k-1} - legendreB(k) * P_{k-2}
+        constexpr double legendreA(int k) { return double(2 * k - 1) / double(k); }
+        constexpr double legendreB(int k) { return double(k - 1) / double(k); }
+
+        // Zonal recurrence S_l = zonalA(l) * total_{l-1} + zonalB(l) * S_{l-2}
+        constexpr double zonalA(int l) { return double(2 * l - 1) / double(l * (l + 1)); }
+        constexpr double zonalB(int l) { return double((l - 2) * (l - 1)) / double(l * (l + 1)); }
+    }
+
+    template<int Order>
+    struct PolygonSH
+    {
+        static_assert(Order >= 2 && Order <= kPolygonSHMaxOrder, "PolygonSH supports orders 2 to kPolygonSHMaxOrder");
+
+        static const int kNumBands = Order + 1;
+        static const int kNumCoeffs = kNumBands * kNumBands;
+        static const int kNumLobes = 2 * Order + 1;
+
+        /** Polygon edge from vertex v to the next one, shared by all lobes
+        */
+        template<typename Real>
+        struct Edge
+        {
+            Vec3<Real> v;
+            Vec3<Real> gam;     ///< Normal of the great circle through the edge
+            Vec3<Real> gamP;    ///< cross(gam, v)
+            Real arc;           ///< Arc length of the edge
+            Real cosArc;
+            Real sinArc;
+        };
+
+        /** Boundary integrals B_0 .. B_{Order-1} of one edge
+            \param[in] a dot(dir, v)
+            \param[in] b dot(dir, gamP)
+        */
+        template<typename Real>
+        static void boundary(Real a, Real b, const Edge<Real>& e, Real B_n[Order])
+        {
+            Real z = a * e.cosArc + b * e.sinArc;
+            Real tmp1 = a * e.sinArc - b * e.cosArc;
+            Real tmp2 = a * a + b * b - Real(1.0);
+
+            B_n[0] = e.arc;
+            B_n[1] = tmp1 + b;
+
+            Real D_next = Real(3.0) * B_n[1];
+            Real D_prev = e.arc;
+            // P_{i-1} of z and a, advanced along with i
+            Real P_prev = Real(1.0), P = z;
+            Real Pa_prev = Real(1.0), Pa = a;
+
+            detail::staticFor<2, Order>([&](auto index)
+            {
+                constexpr int i = decltype(index)::value;
+                if (i > 2)
+                {
+                    Real t = Real(detail::legendreA(i - 1)) * z * P - Real(detail::legendreB(i - 1)) * P_prev;
+                    P_prev = P;
+                    P = t;
+                    t = Real(detail::legendreA(i - 1)) * a * Pa - Real(detail::legendreB(i - 1)) * Pa_prev;
+                    Pa_prev = Pa;
+                    Pa = t;
+                }
+
+                Real C_n = ((tmp1 * P) + (tmp2 * D_prev) + (Real(i - 1) * B_n[i - 2]) + (b * Pa)) * Real(1.0 / i);
+                B_n[i] = (Real(2 * i - 1) * C_n - Real(i - 1) * B_n[i - 2]) * Real(1.0 / i);
+
+                Real temp = D_next;
+                D_next = Real(2 * i + 1) * B_n[i] + D_prev;
+                D_prev = temp;
+            });
+        }
+
+        /** Unnormalized zonal integrals int P_l(dot(dir, s)) ds of the polygon, surf[l] for bands 1 to Order
+        */
+        template<typename Real>
+        static void evalLight(const Vec3<Real>& dir, const Edge<Real>* edges, int numVerts, Real surf[kNumBands])
+        {
+            Real total[Order] = {};
+            Real bound[Order];
+            for (int i = 0; i < numVerts; i++)
+            {
+                boundary(dot(dir, edges[i].v), dot(dir, edges[i].gamP), edges[i], bound);
+                Real w = dot(dir, edges[i].gam);
+                for (int n = 0; n < Order; n++)
+                {
+                    total[n] += bound[n] * w;
+                }
+            }
+
+            surf[0] = 0;
+            detail::staticFor<1, kNumBands>([&](auto index)
+            {
+                constexpr int l = decltype(index)::value;
+                surf[l] = Real(detail::zonalA(l)) * total[l - 1];
+                if (l > 2) surf[l] += Real(detail::zonalB(l)) * surf[l < 2 ? 0 : l - 2];
+            });
+        }
+
+        /** Project a spherical polygon onto the first kNumCoeffs SH coefficients
+            \param[in] L Normalized polygon vertices, at most kMaxClippedVertices
+            \param[in] numVerts Number of valid vertices
+            \param[out] Lcoeff SH coefficients of the polygon's indicator function
+        */
+        template<typename Real>
+        static void project(const Vec3<Real>* L, int numVerts, Real Lcoeff[kNumCoeffs])
+        {
+            Edge<Real> edges[kMaxClippedVertices];
+            for (int i = 0; i < numVerts; i++)
+            {
+                const Vec3<Real>& next = L[(i + 1) % numVerts];
+                edges[i].v = L[i];
+                edges[i].gam = normalize(cross(L[i], next));
+                edges[i].gamP = cross(edges[i].gam, L[i]);
+                edges[i].arc = std::acos(dot(L[i], next));
+                edges[i].cosArc = std::cos(edges[i].arc);
+                edges[i].sinArc = std::sin(edges[i].arc);
+            }
+
+            Lcoeff[0] = Real(0.28209479177387814) * solidAngle(L, numVerts);
+
+            Real w[kNumLobes][kNumBands];
+            for (int j = 0; j < kNumLobes; j++)
+            {
+                Vec3<Real> dir(Real(kPolygonSHLobes[j][0]), Real(kPolygonSHLobes[j][1]), Real(kPolygonSHLobes[j][2]));
+                evalLight(dir, edges, numVerts, w[j]);
+            }
+
+            // band l only uses the first 2l + 1 lobes
+            detail::staticFor<1, kNumBands>([&](auto band)
+            {
+                constexpr int l = decltype(band)::value;
+                constexpr int n = 2 * l + 1;
+                constexpr int offset = polygonSHProjectionOffset(l);
+                for (int m = 0; m < n; m++)
+                {
+                    Real sum = 0;
+                    for (int j = 0; j < n; j++)
+                    {
+                        sum += Real(kPolygonSHProjection[offset + m * n + j]) * w[j][l];
+                    }
+                    Lcoeff[l * l + m] = sum;
+                }
+            });
+        }
+
+        /** Evaluate all kNumCoeffs real SH basis functions in direction dir, in the convention of evaluateSH()
+        */
+        template<typename Real>
+        static void evaluateBasis(const Vec3<Real>& dir, Real basis[kNumCoeffs])
+        {
+            Real cosine[kNumBands], sine[kNumBands];
+            cosine[0] = Real(1.0);
+            sine[0] = Real(0.0);
+            for (int m = 1; m < kNumBands; m++)
+            {
+                cosine[m] = dir.x * cosine[m - 1] - dir.y * sine[m - 1];
+                sine[m] = dir.x * sine[m - 1] + dir.y * cosine[m - 1];
+            }
+
+            Real pmm = Real(1.0);
+            for (int m = 0; m < kNumBands; m++)
+            {
+                if (m > 0) pmm *= Real(2 * m - 1);
+                Real prev = 0;
+                Real p = pmm;
+                for (int l = m; l < kNumBands; l++)
+                {
+                    if (l > m)
+                    {
+                        Real next = (Real(2 * l - 1) * dir.z * p - Real(l + m - 1) * prev) / Real(l - m);
+                        prev = p;
+                        p = next;
+                    }
+                    Real k = Real(kPolygonSHNormalization[l * l + l + m]) * p;
+                    basis[l * l + l + m] = k * cosine[m];
+                    if (m > 0) basis[l * l + l - m] = k * sine[m];
+                }
+            }
+        }
+
+        /** Evaluate the real SH expansion in direction dir, the order-N counterpart of evaluateSH()
+        */
+        template<typename Real>
+        static Real evaluate(const Vec3<Real>& dir, const Real coefficients[kNumCoeffs])
+        {
+            Real basis[kNumCoeffs];
+            evaluateBasis(dir, basis);
+            Real sum = 0;
+            for (int i = 0; i < kNumCoeffs; i++)
+            {
+                sum += basis[i] * coefficients[i];
+            }
+            return sum;
+        }
+    };
+}
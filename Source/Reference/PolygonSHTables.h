@@ -0,0 +1,150 @@
+#pragma once
+
+// Generated by polygon_sh_gen (Source/Tools/PolygonSHGen.cpp), do not edit.
+// Lobe directions and per band zonal to SH projection matrices for PolygonSH<Order> in PolygonSH.h.
+
+namespace ltsh
+{
+    // Highest order the tables cover
+    static const int kPolygonSHMaxOrder = 8;
+
+    /** Lobe directions, order N uses the first 2N + 1
+    */
+    constexpr double kPolygonSHLobes[17][3] =
+    {
+        { 0.866025, -0.500001, -0.000004 },
+        { -0.759553, 0.438522, -0.480394 },
+        { -0.000002, 0.638694, 0.769461 },
+        { -0.000004, -1.000000, -0.000004 },
+        { -0.000007, 0.000003, -1.000000 },
+        { -0.000002, -0.638694, 0.769461 },
+        { -0.974097, 0.000007, -0.226131 },
+        { -0.000003, 0.907079, -0.420960 },
+        { -0.960778, 0.000007, -0.277320 },
+        { 0.594048, 0.761505, -0.259264 },
+        { -0.449995, -0.876844, -0.169261 },
+        { -0.333209, -0.909825, 0.247364 },
+        { -0.463616, 0.831185, -0.306906 },
+        { 0.869531, -0.446600, 0.210865 },
+        { 0.610701, 0.676039, 0.412330 },
+        { -0.337917, -0.481873, -0.808462 },
+        { -0.658309, 0.545563, 0.518644 },
+    };
+
+    /** Offset of band l in kPolygonSHProjection, bands 1 to kPolygonSHMaxOrder are stored back to back
+    */
+    constexpr int polygonSHProjectionOffset(int l)
+    {
+        return l <= 1 ? 0 : polygonSHProjectionOffset(l - 1) + (2 * l - 1) * (2 * l - 1);
+    }
+
+    /** Row-major (2l + 1) x (2l + 1) matrix per band l mapping the unnormalized zonal integrals of the first
+        2l + 1 lobes to the SH coefficients l * l .. l * l + 2l
+    */
+    constexpr double kPolygonSHProjection[968] =
+    {
+        // band 1
+        1.0746964080656181, 1.2253425532962376, 0.76501782265785789,
+        -0.89205272044438666, -1.0170983608489417, -1.1482547650654151e-05,
+        1.1846636019381289, 0.70744889997081928, 0.44168433509520105,
+        // band 2
+        -0.84105018800656273, 4.1165107788899278e-06, 4.7594492931783755e-06, -0.42052389659489303, -0.63078825623820056,
+        -1.3857142510572563e-05, 1.154241916412281e-05, 0.74104209208428029, -0.30229573132718007, -0.43875524746634142,
+        9.3082757456967785e-06, -1.210102768135104e-05, -1.3366604001031959e-06, 5.4512514283830313e-07, 0.63078671449195745,
+        -0.76774210579326807, 0.9980808880429618, 0.42783535971587155, -0.17451565792851642, -0.48363654754534507,
+        -1.210267243651693e-05, 6.9866887993271005e-06, 6.7001097449096475e-06, -0.72837171772043696, -0.36419343577667745,
+        // band 3
+        1.2620888428901255e-05, -3.8341434766691645e-06, -0.31207164006991572, 0.78146781270119225, 6.0562933337647702e-06, 0.31207692004766524, 1.0145810610843122e-05,
+        -0.16259444816051674, 1.2043533716032617, -0.032132847333027313, -0.8071466318591205, 0.54484588584094995, -0.67679813256357191, -2.7753207049524989e-05,
+        2.5832494009879574e-06, 4.9495080095270793e-06, 0.40287575276445292, 0.20993219009358591, 4.3321030011323546e-06, -0.40287785412301619, 2.7254676203576121e-06,
+        2.4131069977603749e-05, -2.738825633449369e-10, -9.0043943987288049e-06, 1.9439141207505993e-05, -0.74635266512134824, 9.0046293486425942e-06, 1.6873968079187737e-10,
+        -1.4073522448226436, 2.3807122827679157e-05, 0.697810603637399, -1.04374662793393, -6.6515419944521651e-06, -0.69782302254511519, -8.6731501822261757e-06,
+        2.2311649626587766e-06, -9.7812306683961368e-12, -0.61394064916415314, 1.6160392421838109e-06, 0.018729560691078086, -0.61393828794692074, -3.2515021517550634e-06,
+        -0.85513009271691565, 2.4308187256625982e-05, 0.77310037070828819, -0.6341864150497265, -0.32757963142205176, -0.074898874885941935, -1.0214075019810891,
+        // band 4
+        -0.58743284041050381, -1.240586653278789, -3.1832686346605508, -3.5513208599374191, -3.7347278801812038, -4.4157488958670594, 25.472911576745446, -0.49334847969541878, -21.646805269157881,
+        -1.5955029651216804e-07, 2.2649367235107866e-05, -0.65696709670868425, -0.42123685681637346, 0.13180449758796442, 0.21599604019064511, -0.00068656316031247603, 0.73078772723825791, 0.00059607978727953649,
+        0.97097491220986343, -1.6411585522506631, -4.211043886742095, -3.8239077579437728, -5.9238735321752181, -5.8414953843758166, 33.69745621701788, -0.65264572790480868, -28.635999092139787,
+        1.1692111418456044e-05, 9.0845178617365471e-06, 0.33203403766520789, -0.39726243055350113, 0.12424781532638833, -0.74795515060940942, -0.00039541991279938473, 0.68914488769823479, 0.00034794690089699049,
+        -3.8842773478211882e-09, 1.6975284640345842e-09, -0.00013751397125901378, -0.00012667797122151305, 0.84614853976723259, -0.00014775597319003085, 0.00096307722293665797, 6.535363349346528e-06, -0.00081842100740431376,
+        0.00018666391864658705, -8.3237395976020625e-05, 6.3545246570704403, 5.5524466887431725, 6.1896496632178666, 6.3543482559683433, -43.507349108657166, 0.00010603395750460592, 36.972459278427152,
+        -5.334886855907574e-07, -4.5239385211027725e-06, -0.5222696234097215, 0.17389799271456463, -0.39066455568497255, -0.52226999277889508, -0.00049025168342565258, -2.216816999947353e-06, 0.00042461443778010532,
+        0.00016420101655828049, -8.6922118113499889e-05, 5.6794536269059925, 4.436256455771904, 6.0367212927903617, 5.6793063129714234, -43.85293948292432, 9.7678641110408884e-05, 38.911196722850583,
+        -3.1216236638409799e-06, -2.6354892443992684e-05, 0.39478888784913219, 1.0129052489979398, -0.13385347089726773, 0.39476080274719871, 0.00049355477008338833, 3.6299578307919615e-06, -0.00042546788821398263,
+        // band 5
+        1.0149105617726697, -0.066559793932639, -0.1575486570495972, -1.0051755145984758, 1.1947028276302269, -1.6729229446069482, 2.8246704736288377, 0.59689025565833864, -4.2965175265753119, -0.19521519029795975, 0.2457582925749322,
+        -2.3322003258306863, 1.3243455256616561, 0.74427784846938749, 0.74461775073074143, -2.8315479286159828, 2.5063218386786339, -3.7595696341462341, -0.51927527779255733, 6.9217723268856721, 0.52476669318715619, 0.2630939741732945,
+        0.069532795256130542, -0.0045491376208802378, -0.77273508231676935, -0.13944611040605784, 0.081848944802012213, 0.64733084616149539, 0.19354597493389281, 0.040895588790672455, -0.29438065989529244, -0.013384720336283323, 0.016842771966761289,
+        1.0034586345302356, -0.76011719753266804, -1.2110331794952085, -0.91578659475961444, 1.2694759177538071, -1.7852706550438795, 1.3010639903495202, 1.1104418441717701, -3.3252524437308484, 1.3754094863642279, 0.26876665953604917,
+        -1.5458909615441776, 0.10136377955147768, 1.0629924283270755, -0.32529193101450643, -1.8197610340705426, 1.7251857028559487, -4.3025356113028632, -0.90916587296543927, 6.5444480843845456, 0.29733865755364608, -0.37431454271497611,
+        -5.9194053890702342e-05, -2.7185074130808501e-06, 8.1208569538753167e-07, 1.927473354869393e-05, -0.93564194866134709, 6.150632143438611e-05, -2.5472180338923431e-05, -2.6801949001759598e-05, 8.1864396461139255e-05, -7.9698407027125351e-06, 1.0031231753101369e-05,
+        1.520884737035394, 0.14370951193690645, 0.42560983916254552, -0.85037616683653716, 0.67223674464186933, -1.5293330957730285, -0.90438939109832495, 0.59897258646925811, -0.21485932554289536, 0.42141456159620089, -0.53042693484914394,
+        0.54237945363475082, -0.03556576398257294, -0.72758785128592729, -0.15701328385235014, 1.2471185707905612, -1.4044230810159948, 1.5094529563392036, -0.19944085128834477, -2.2959940434419681, -0.10430550971019792, 0.13130324653209735,
+        1.0827229414018236, 0.23621294420127192, -0.018157571760240465, -0.83085850901665259, 0.70880832109673353, -1.4412207956263909, 5.1988904401643392, 1.0632803060939837, -6.016025530581997, 0.69254613316702773, -0.87171273389534232,
+        1.1915887448074365, -0.078152143206717706, 0.048157211583852444, -0.34494002555183367, 1.3587338630950878, -1.4388443102574007, 3.3163802664658149, -0.43826320662066909, -5.0444475976111089, -0.22920072430787197, 0.2885254949450009,
+        -0.40063798550223989, 0.09332458470216061, -0.70388970389684613, 0.003118238297715971, 0.56956519516114212, -0.21965175944976334, -0.37415864133102861, 0.46611070337700766, -0.52836724113161426, 0.27351254891105753, -0.34428845424207971,
+        // band 6
+        0.64242371879061455, 0.5600784009406663, -2.8300069186449264, -1.6809422467232151, -3.7513810648825254, -2.4618836637539028, -15.626954783513799, -0.89916198266110781, 15.42037521216661, -1.4526596713176074, -0.47003969000410456, 1.1174617262340707, 0.41897436089233375,
+        2.0540432869555851, 1.9331813621018223, -1.7595866124512916, -2.5532925075294495, -3.1820715715042835, -3.1709756454717914, -13.015662332548446, -2.2803162946716489, 13.068527966929453, -0.40050079727842319, -0.24985151060161595, -0.22540329568685238, 0.2006328894280372,
+        1.7925977223693255, 0.98791799467634445, -0.042641978506653619, 0.20522545798892872, 0.27594949062396279, -0.74757295984844452, -0.15498847398423349, -0.17927217175804908, 0.30862044155900598, 1.0873233761352541, 1.7916669676221333, 0.23345263267214367, -0.10623451961268722,
+        -0.095799684269271129, -0.18071364519160923, -0.61545951072120686, 0.51735792293363503, 0.28619777305711142, 1.3162451224265332, 1.3084031410329935, 0.37419730095469805, -1.2946394910855774, 0.19042125642646407, -0.323122867655393, 0.34849795508347264, 0.71322172690152452,
+        3.3088465639831672, 4.7890069321204454, -3.8275253162834857, -3.6851248872562832, -7.014887517971629, -5.9822792803785081, -25.126877073016896, -1.7448895349283124, 25.39656514033501, 0.42315658947475887, 1.4834015740572444, -0.17634045415853222, 0.26860323657077823,
+        1.3445720283113312, 1.4372538116835529, -1.3411421940368649, -2.4270632164706543, -2.3443572196175095, -2.7797048125887298, -9.8506043610581226, -2.0009063515884007, 9.8544161794614151, -0.58802701625435583, 0.47170808082851312, -0.78887293359677413, -1.2397664929613521,
+        -1.3733415162435096e-05, -5.5157440719567422e-06, -7.9526357313527518e-05, -4.340358635629081e-05, 1.0170009869394083, -9.3289811117294418e-05, -0.00046071934876476778, -2.0306957542945815e-05, 0.00041051347553942559, 8.4657641986774386e-06, 1.3016634579363429e-05, -1.2009161621170343e-06, -3.7167269645667596e-05,
+        1.0043898844916681, 0.78794784334718226, 1.9043593087955764, 0.31287669588068379, 2.3074694568908072, 1.7168779108684107, 10.140607381168318, -0.22449438086719142, -8.5738543893596795, -0.51591683815250533, -0.20360423170771891, -0.30065142279756318, 0.62732476568860562,
+        1.3203871974512293, 1.2426719594089071, -1.9292412159124672, -2.0902826797902017, -2.8642080920914115, -2.3926894405811208, -8.3661923522248909, -0.51912096168871247, 8.4002130410759168, -0.25745253068463775, -0.16066505346507789, -0.14483474125371815, 0.12909225123963558,
+        -1.0417380747422029, -1.2157325985140703, 1.111306733725165, 1.2110109081522933, 1.9541217058214628, 1.7237887781983874, 7.2144853484212152, 0.66442532222393047, -7.9809159293252812, -0.27505398588288288, 0.0052398449283939386, -0.17039488780899414, 0.68910372342261894,
+        0.87056172233377638, 0.8193298147223318, -0.23157182446659164, -1.5194748495009816, -1.2418961105733803, -0.53714741385321174, -5.5165120475932206, -0.34229253993570091, 5.5389162170177455, -0.16973628768330906, -0.10591876208863071, -0.095488595483084152, 0.085080941222581932,
+        0.053978993260002106, -0.031655282040444543, -2.3687690782568787, -0.67862195364883238, -3.2660240233795741, -2.3012972382306653, -13.556465716789742, 0.068022686027125023, 13.525713713904606, -0.17784014526979214, -0.049069950005194041, -0.10554020605613304, 0.28217794235801191,
+        -1.5330466278852488, -1.4428225465268658, 1.4716120050160744, 1.0171252805959667, 2.3748940301238779, 2.0097337138328428, 9.7140746407972216, 0.60270774401263394, -9.7535352700531686, 0.29889684776860476, 0.18655773783599339, 0.16818881006808509, -0.14984970166055336,
+        // band 7
+        0.52328802725829238, -0.22853931647244591, -0.098592050407411355, 0.62349772781890656, -0.38668079876863842, 0.46324892405725759, -0.25101713428204436, -0.9361890717621193, -0.25049183026022159, 0.028200986751599176, -0.60799718792686253, -0.10824473009423077, -0.57183016152547483, 0.10285766530418616, -0.018514182824482514,
+        2.4390146057535418, -2.1017887320186093, 0.62368842980839889, -1.0535510411679621, -0.39832321765835355, 1.1242819231477632, -1.1104145166264108, 0.73255596015551283, -0.29631975369722896, 1.4711833029192616, -0.61690430501376881, 0.79015304787094276, -0.69757352695965325, 0.014265515649295124, -0.31051695267333407,
+        -0.4344337369681085, 0.1897174742330974, 0.67709969186180019, 0.93525030669412357, 0.32105093666395751, -0.97989756253647597, 0.20841816885327605, 0.77720937275815682, 0.20796944817325286, -0.023400087517580017, 0.50470091067228617, 0.089820668694397879, 0.4747160026901126, -0.08539372861694719, 0.015349838443723077,
+        -0.51586741263271907, 0.38371506348080597, -0.31218384697558554, 0.22748706538641489, -0.74367534180522177, -0.088183697864323618, -0.34211142060787425, -0.26796314988758313, 0.32718107010279918, -0.26308269475038615, -0.33759409953677921, 0.8216753310292465, 0.10445743057545279, 1.1624063761648711, 0.26215411716364745,
+        -0.93934903724996466, 0.24891726552152235, -0.39552800884661615, 1.4328934284946926, -0.44084624011580198, 0.27400334586133862, -0.65158074065074001, -0.81258650715196079, 0.51355803104167286, -1.0978977716047684, 0.89044021234449178, 0.5270075601584514, -0.52186535452387617, 0.20933783746201495, -0.62407381902379466,
+        1.2018910122752198, -1.2757464878168707, 0.97996493547577235, 1.20583255638312, -0.082130298592096265, 0.19688975159815927, -1.0081378029811991, -0.43439662318753192, -0.25049180191653386, -1.1959764075003856, 1.5658037568697991, 1.3826856739223525, 0.46799486389634321, -1.1369377343078881, 0.25031833468582121,
+        0.655984470587052, -0.11882877943551982, -0.21258634905763987, -0.89710290273352933, 0.69480864197838876, 0.11566983232647088, 0.83080296600185477, 1.417405113319081, -0.38041998292088586, 1.1237562416113973, -0.55337491168704656, -0.48148418292872919, 0.89229871600177901, -0.28048993737876254, 0.65990535388200267,
+        -4.1384572667114096e-05, 7.4015001048562714e-05, -2.8024123820404791e-05, -2.2108890618762678e-05, -1.092532618772295, -4.5984331842476343e-06, -6.1613976470954938e-05, 1.1793785320750846e-05, 0.00011310660232657246, -5.0780416069040466e-06, -1.6981983468751341e-05, -3.3870678679110523e-05, 3.784061079458554e-05, -1.3756754117232934e-05, -1.9920931104005884e-05,
+        1.3984149256111738, -2.0491464978240543, 0.66547155946211622, 0.21242363204853798, -0.12912081770126285, 0.17371103754614756, 2.0194927614310445, 0.28905238145436762, -3.2166296528892993, 0.6186941312364862, 0.22131737279828789, 0.70808383192845714, -0.63918191260328205, 0.25117165471848107, 0.82063621188397484,
+        1.2351404254819058, -1.0847905131822477, 1.0511404215026652, 0.088494840693646881, -0.75399691784346246, 0.94731633857076791, -2.3290469727439009, -0.010532982721112472, -0.14110700686971059, -0.3104771467400842, 0.921094665093944, 0.32551323894862327, 0.032530526365253054, 0.31352239223554224, -0.21768100903987864,
+        2.1134020513676548, -1.8613238675615997, 0.41703062052225215, 1.8230115714093398, -1.1213538744470664, 0.57050608526433555, -3.7838195959512047, -1.2422322810241591, 2.1110439380638626, -0.5501006903315051, 1.4430347743572811, 2.072794741167546, -1.845682515940813, 0.39244065038155446, 0.69083406272636605,
+        0.1725819685362831, -0.075400220637225207, 0.88358335994674297, -0.14809392406916022, -0.34726587776430468, 1.0183102947444052, -0.082964072022831487, 0.088294733595310398, -0.082580401305373807, 0.009247606949793017, -0.20025742525175422, -0.035640322012534573, -0.1884341416898716, 0.033924532594028306, -0.006127681351448022,
+        0.25301413429637876, 0.56201278443913028, 0.2178975340545691, 2.4759098385682248, -0.77230469163687243, 0.57796276765082732, 0.83742097594634546, -2.1974564400156087, -1.6381248081812212, -1.5029432091348336, 2.1847285678998434, 1.7744471517312506, -0.82047504001877647, 0.052653251626014863, -0.17898202252548692,
+        0.77921217909006946, -0.34042428439806366, -0.3282352174452241, -0.66884467907386524, -0.57597112994312216, 0.2802033928955584, -0.37418452410652731, 0.3987888339722655, -0.37290173507308277, 0.041895856848733509, -0.9046468047670474, -0.16099373733404249, -0.85108647545169724, 0.15315560369700151, -0.027554908211712238,
+        -1.5766497212442272, 1.4349926029857605, 0.18954818386529293, 1.0083505301737958, 0.022597536827301819, -0.0018787614788123735, 0.073805771629663133, -0.86290133248397438, 0.2619509774868069, -0.23581715125974909, 0.43808666926146966, 0.24394448021883991, 0.40614513962451376, -0.36249385011957108, 0.061992105603009745,
+        // band 8
+        1.7012553532498167, 2.2735929322083743, 0.035280450741248595, 0.64230141173151667, 0.78532953286516061, -0.067497185056631701, -1.1965073356640994, 1.1474605761099805, 2.1215524113827109, -0.42211936487176921, -0.54137005542811523, 0.16418514786530564, 1.0083776765898265, 1.058629346258146, 0.9023764269458513, 0.19699150832126086, 0.65959302614342941,
+        -1.2255493533866286, -1.5947107428115055, -0.53110415784871257, 2.5691050272116436, -0.47579443239532471, 0.061494153640699989, 0.61728592555243211, 1.0810814612411304, -1.3187001107726817, 1.4782213127521022, 3.2320360813143449, 2.2217716138271602, -0.25011475762649615, -0.6479342330227813, -1.3708182799040729, -0.47670412182569533, -0.56566480950521247,
+        -0.13683225960064282, -1.5316828640421751, -0.20320711926368951, 1.9983550424314389, -1.4544474737124755, -0.56193115000537786, 1.1036805563594099, -0.10892545495581429, -1.6792801735159446, 1.0539689811656081, 2.4906203685348509, 1.970595029477942, -0.75959343122654133, -2.0827100701809864, -2.4259614881807696, -0.90768762936294434, 0.97454696465243562,
+        2.1891782501616412, 1.7267778234110205, 0.46534977936440169, -2.8567325421805534, -0.27473270239179132, 0.71036124241929732, -0.65244168823574911, -0.40639696308594186, 1.2452577852585349, -3.4412873922496878, -4.1477563115060168, -3.6295633633762447, -0.21096018023446342, 1.3121223865880425, 1.455037312364841, -0.68506959760637964, 0.12407438367539098,
+        -3.8073771776610821, -1.8480932404252979, -2.219761991556739, 3.0634228450701091, -0.13015042284603506, -2.4550842206653281, 2.4376708066165436, -1.5480532838049255, -3.4000349715307197, 3.0733849192487122, 5.6515076264050306, 3.5120152662500774, -1.3892780927577979, -1.7041737876650727, -0.97519407758290444, -0.21014008880895418, 0.32531522109415423,
+        1.8125921209883744, 1.8584795702371735, -0.53141395043108197, -1.6842986086202982, -0.93585921240189651, 0.74959437266348794, 2.1222451897667067, -1.1886958220041723, -1.6696687036876279, -2.831192363679782, -2.9401889581818312, -2.1166737716784914, -0.82652400715490915, 0.22477523777319575, 0.71169265802566661, 0.25457405079666462, 0.020094265204938011,
+        -0.96296393089489662, -2.8878295830513645, -0.31649836314203106, -2.2090202651013806, -1.5643403762248103, 0.23994398925948623, 1.9381543938120591, -2.67684464396108, -3.0274382203857249, 0.66811783558895721, 0.69879464544036385, -1.1113862567363895, -3.0789441906031212, -1.9737752853143293, -0.16180318035180197, 0.046383309303612424, -0.00063693193542314896,
+        1.4777443036023254, 1.0200157780684089, -0.38922805767108865, -2.5335276034961454, 0.37192367628804007, 1.6137282559803303, -2.1335669786130618, 0.090078521316687477, 2.6275917206102228, -2.2490271249830354, -3.278094360466957, -3.0352550219513654, 0.33034231761781607, 1.4017322648205437, 1.3926044639357347, -0.80684650786086376, 0.22909640271269677,
+        -2.0618844153935929e-05, -2.5885104370571864e-05, -4.5691205196355066e-05, -4.760760172219752e-05, 1.1630823146665799, 1.8411279381268788e-05, 0.00013903524704062464, -6.2363858667606391e-05, -0.00011940430156817722, -3.8228065671284268e-05, -1.523173644386785e-05, -4.8993512547226778e-05, -4.6064004906517072e-05, 3.2209320040467167e-05, 1.5354349035966988e-05, 1.6486254052472091e-05, 6.6337891246046374e-06,
+        1.1242287285227119, 1.0534215701764538, 0.92105920913811512, 0.04770752536583367, 0.7381705975993299, 0.25322373025913769, -4.2246869109105241, 1.5234324173282263, 3.9689865191949005, -0.053660170699706522, -1.0422095527866164, -0.13430967450028775, 1.2383049992168629, -0.16617811015433862, 0.23124531613942806, -0.73832512004180095, -0.059762283716709635,
+        0.25388336900404329, 0.31925601825671202, 0.88949020468542406, -1.5450518287199153, 0.20820473114129145, 1.1136423440588015, -3.1488732089018812, -0.598554548285678, 3.830530817361347, -0.68384723737406761, -1.5787467856535016, -1.30951262042399, -0.53042742040023072, 0.59960862966087947, 0.28439759733537295, 0.37511587298201254, -0.076275690246355082,
+        0.15732095904555352, 0.071700992450306061, 0.78167896114578539, 0.92239224646870899, 0.15639400883747659, -0.1668471892971031, 1.1279409725475318, 0.72363791321438298, -0.22908698590691054, 0.90352569510446401, 0.15960453721131859, 1.6932854904588195, 0.45329090460546095, 0.33353411759936696, -0.92516836377585987, -0.10692646523239741, -0.68701042753456065,
+        -0.65889873362971074, -0.7744454704529582, 0.09925136345536463, 2.1339747800985585, -0.62976268423225534, -0.16272809405639491, 2.2213244167710124, 0.13683711919885827, -2.8946813206921034, 1.0889439866354294, 2.2055829080344069, 1.7113448335678458, 0.28010642334046132, -0.65457551011747883, -0.67006509400673631, -0.3280210083889844, -0.12121971510844426,
+        0.49198165608371042, 0.7585027094017408, 0.46531357597816198, 0.9661655244474785, 0.30943765527482137, 0.31376977794027605, -0.94717027245450358, 1.4062735684989163, 0.66865549353990317, -0.58146938639647561, -0.8435390293956776, 1.1474480534471521, 0.19323961907549986, 0.88395911003691818, 0.29159215511715086, 0.73432112946773143, 0.24690875611866769,
+        -1.1498777104301134, -1.3276668864367946, -1.023083693514339, 3.0217299386241288, -0.60936454383880778, -1.3392151795384508, 1.2518537251804285, -0.38604885567332115, -1.9436320235305895, 1.5978624579293224, 3.0146947639068724, 2.2423302236927416, 0.0051829108086513254, -0.74467874145932589, -1.1393583447231026, -0.28775161601374682, -0.35232852862897363,
+        -0.36712775997886893, -0.34697497831818536, -0.0545592921723786, 2.2660655412141799, 0.49232683230037444, -0.36093150094797571, -0.87370418629364965, 1.3805664632484724, 1.1740498911017476, 0.85492341833732777, 2.4091644676805855, 2.6297327842764711, 0.78799417450031595, -0.61484146830409014, -0.33383258664243698, -0.20604945312425962, 0.27808283925141491,
+        1.1134361996661466, 1.2781863469201398, 0.12535628039586438, -0.78457936328846944, 0.2205610841108562, 0.38794465199348754, -0.4016736743437217, 0.56670676679902521, 0.92226453376373929, -1.4537672214713764, -2.6613137200417092, -1.9413459617758035, 0.14429798834220164, 0.59823121034908555, 1.0938993536479036, 0.19064070290533003, 0.38463401490169369,
+    };
+
+    /** Normalization of the real SH basis, including the sqrt(2) of the non-zonal functions
+    */
+    constexpr double kPolygonSHNormalization[81] =
+    {
+        0.28209479177387814,
+        0.48860251190291998, 0.48860251190291992, 0.48860251190291998,
+        0.18209140509867988, 0.36418281019735976, 0.63078313050504009, 0.36418281019735976, 0.18209140509867988,
+        0.039336239328442907, 0.096353714754685155, 0.3046971996429772, 0.7463526651802308, 0.3046971996429772, 0.096353714754685155, 0.039336239328442907,
+        0.0059603403376112026, 0.016858388283618388, 0.063078313050504001, 0.26761861742291571, 0.84628437532163447, 0.26761861742291571, 0.063078313050504001, 0.016858388283618388, 0.0059603403376112026,
+        0.00069458418713245519, 0.0021964680580751762, 0.0093188247511476283, 0.045652731285460234, 0.24157154730437169, 0.9356025796273888, 0.24157154730437169, 0.045652731285460234, 0.0093188247511476283, 0.0021964680580751762, 0.00069458418713245519,
+        6.5722376641838803e-05, 0.00022766899107568562, 0.0010678622237644956, 0.0058489222826344353, 0.03509353369580661, 0.22195099524523101, 1.0171072362820548, 0.22195099524523101, 0.03509353369580661, 0.0058489222826344353, 0.0010678622237644956, 0.00022766899107568562, 6.5722376641838803e-05,
+        5.233009453691466e-06, 1.9580128477462541e-05, 9.9839457185235285e-05, 0.00059903674311141165, 0.0039735602250741348, 0.028097313806030647, 0.20647224590289676, 1.0925484305920792, 0.20647224590289676, 0.028097313806030647, 0.0039735602250741348, 0.00059903674311141165, 9.9839457185235285e-05, 1.9580128477462541e-05, 5.233009453691466e-06,
+        3.5960417862376139e-07, 1.4384167144950456e-06, 7.8785328162140466e-06, 5.1058728265780266e-05, 0.00036818972564450655, 0.0028519853513317033, 0.023169638523677944, 0.1938511038200533, 1.1631066229203195, 0.1938511038200533, 0.023169638523677944, 0.0028519853513317033, 0.00036818972564450655, 5.1058728265780266e-05, 7.8785328162140466e-06, 1.4384167144950456e-06, 3.5960417862376139e-07,
+    };
+}
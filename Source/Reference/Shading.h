@@ -0,0 +1,176 @@
+#pragma once
+
+// CPU counterparts of the Falcor shading structs and the GGX BRDF used by Data/LightingPass.ps.hlsl.
+// Only the parts the lighting pass actually touches are ported.
+
+#include "VecMath.h"
+
+namespace ltsh
+{
+    struct ShadingData
+    {
+        float3 posW;
+        float3 V;
+        float3 N;
+        float NdotV = 0;
+        float3 diffuse;
+        float3 specular;
+        float linearRoughness = 0;
+        float roughness = 0;
+    };
+
+    struct ShadingResult
+    {
+        float3 diffuseBrdf;
+        float3 specularBrdf;
+        float3 diffuse;
+        float3 specular;
+        float3 color;
+    };
+
+    /** Subset of Falcor's LightData for area lights
+    */
+    struct AreaLightData
+    {
+        float3 posW;
+        float3 dirW = float3(0, 0, -1);
+        float3 intensity = float3(1);
+        float surfaceArea = 0;
+    };
+
+    struct LightSample
+    {
+        float3 posW;
+        float3 L;
+        float3 H;
+        float distance = 0;
+        float NdotL = 0;
+        float NdotH = 0;
+        float LdotH = 0;
+        float diffuse = 0;
+        float specular = 0;
+    };
+
+    inline float getDistanceFalloff(float distSquared)
+    {
+        return 1.f / (0.01f * 0.01f + distSquared);
+    }
+
+    inline void calcCommonLightProperties(const ShadingData& sd, LightSample& ls)
+    {
+        ls.H = normalize(sd.V + ls.L);
+        ls.NdotH = saturate(dot(sd.N, ls.H));
+        ls.LdotH = saturate(dot(ls.L, ls.H));
+        ls.NdotL = saturate(dot(ls.L, sd.N));
+    }
+
+    /** Light sample of a point on the area light, lit from both sides
+    */
+    inline LightSample calculateAreaLightSample(const ShadingData& sd, const AreaLightData& light, const float3& lightPosW)
+    {
+        LightSample ls;
+
+        ls.posW = lightPosW;
+
+        ls.L = ls.posW - sd.posW;
+        float distSquared = dot(ls.L, ls.L);
+        ls.distance = (distSquared > 1e-5f) ? length(ls.L) : 0;
+        ls.L = (distSquared > 1e-5f) ? normalize(ls.L) : float3(0);
+
+        // Calculate the falloff
+        float cosTheta = -dot(ls.L, light.dirW); // cos of angle of light orientation
+        float falloff = std::fmax(0.f, cosTheta);
+        falloff *= getDistanceFalloff(distSquared);
+        // calculate falloff for other direction to enable lighting in both directions
+        if (falloff < 1e-5f)
+        {
+            cosTheta = dot(ls.L, light.dirW);
+            falloff = std::fmax(0.f, cosTheta);
+            falloff *= getDistanceFalloff(distSquared);
+        }
+
+        ls.diffuse = falloff;
+        ls.specular = falloff;
+        calcCommonLightProperties(sd, ls);
+        return ls;
+    }
+
+    // GGX as implemented in Falcor's BRDF.slang, roughness is the GGX alpha
+    inline float evalGGX(float roughness, float NdotH)
+    {
+        float a2 = roughness * roughness;
+        float d = ((NdotH * a2 - NdotH) * NdotH + 1);
+        return a2 / (d * d);
+    }
+
+    // Height correlated Smith G, already divided by 4 * NdotL * NdotV
+    inline float evalSmithGGX(float NdotL, float NdotV, float roughness)
+    {
+        float a2 = roughness * roughness;
+        float ggxv = NdotL * std::sqrt((-NdotV * a2 + NdotV) * NdotV + a2);
+        float ggxl = NdotV * std::sqrt((-NdotL * a2 + NdotL) * NdotL + a2);
+        return 0.5f / (ggxv + ggxl);
+    }
+
+    inline float3 fresnelSchlick(const float3& f0, const float3& f90, float u)
+    {
+        return f0 + (f90 - f0) * std::pow(1 - u, 5.f);
+    }
+
+    inline float3 evalSpecularBrdf(const ShadingData& sd, const LightSample& ls)
+    {
+        float D = evalGGX(sd.roughness, ls.NdotH);
+        float G = evalSmithGGX(ls.NdotL, sd.NdotV, sd.roughness);
+        float3 F = fresnelSchlick(sd.specular, float3(1), std::fmax(0.f, ls.LdotH));
+        return F * (D * G * float(kInvPi));
+    }
+
+    inline float3 evalDiffuseLambertBrdf(const ShadingData& sd, const LightSample&)
+    {
+        return sd.diffuse * float(kInvPi);
+    }
+
+    inline float frac(float x)
+    {
+        return x - std::floor(x);
+    }
+
+    /** Returns a random float in [0,1] based on a 2d point, same hash as rand() in LightingPass.ps.hlsl
+        taken from Golden Noise: https://stackoverflow.com/questions/4200224/random-noise-functions-for-glsl
+    */
+    inline float hashRand(const float2& uv)
+    {
+        return frac(std::sin(dot(uv, float2(12.9898f, 78.233f) * 2.0f)) * 43758.5453f);
+    }
+
+    /** Converts view direction and roughness to two floats in [0,1] to fetch the correct transformation matrix
+    */
+    inline float2 cosThetaRoughnessToUv(float cosTheta, float roughness)
+    {
+        float l_idx = std::acos(cosTheta) / 1.57079f;
+        float a_idx = std::sqrt(roughness);
+        return float2(l_idx, a_idx);
+    }
+
+    struct int2
+    {
+        int x, y;
+    };
+
+    /** Randomly rounds up or down, the probability corresponds to how close the input is to the closest integers
+    */
+    inline int2 dither(const float2& uv, const float2& texC)
+    {
+        int2 viewAlpha = { int(std::floor(uv.x)), int(std::floor(uv.y)) };
+
+        float viewFrac = frac(uv.x - viewAlpha.x);
+        float alphaFrac = frac(uv.y - viewAlpha.y);
+
+        float viewRand = hashRand(texC);
+        float alphaRand = hashRand(float2(1.f - texC.x, 1.f - texC.y));
+
+        if (viewRand < viewFrac) viewAlpha.x += 1;
+        if (alphaRand < alphaFrac) viewAlpha.y += 1;
+        return viewAlpha;
+    }
+}
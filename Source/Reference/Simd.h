@@ -0,0 +1,274 @@
+#pragma once
+
+// 8-wide float vector used by the batched CPU kernels. Backed by AVX2 when the translation unit is compiled
+// with AVX2 enabled (/arch:AVX2, -mavx2), by two SSE2 registers on any other x86-64 target and by a plain
+// array everywhere else. Comparisons return masks with all bits set in active lanes, like the intrinsics do.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LTSH_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LTSH_SIMD_SSE2 1
+#endif
+
+namespace ltsh
+{
+namespace simd
+{
+    static const int kWidth = 8;
+
+#if defined(LTSH_SIMD_AVX2)
+
+    struct float8
+    {
+        __m256 v;
+
+        float8() : v(_mm256_setzero_ps()) {}
+        float8(float s) : v(_mm256_set1_ps(s)) {}
+        float8(__m256 v_) : v(v_) {}
+
+        static float8 load(const float* p) { return float8(_mm256_loadu_ps(p)); }
+        void store(float* p) const { _mm256_storeu_ps(p, v); }
+    };
+
+    inline float8 operator+(float8 a, float8 b) { return _mm256_add_ps(a.v, b.v); }
+    inline float8 operator-(float8 a, float8 b) { return _mm256_sub_ps(a.v, b.v); }
+    inline float8 operator*(float8 a, float8 b) { return _mm256_mul_ps(a.v, b.v); }
+    inline float8 operator/(float8 a, float8 b) { return _mm256_div_ps(a.v, b.v); }
+    inline float8 operator&(float8 a, float8 b) { return _mm256_and_ps(a.v, b.v); }
+    inline float8 operator|(float8 a, float8 b) { return _mm256_or_ps(a.v, b.v); }
+    inline float8 operator^(float8 a, float8 b) { return _mm256_xor_ps(a.v, b.v); }
+    inline float8 andNot(float8 mask, float8 a) { return _mm256_andnot_ps(mask.v, a.v); }
+    inline float8 operator<(float8 a, float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+    inline float8 operator<=(float8 a, float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+    inline float8 operator>(float8 a, float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+    inline float8 operator>=(float8 a, float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+    inline float8 operator==(float8 a, float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+    inline float8 sqrt(float8 a) { return _mm256_sqrt_ps(a.v); }
+    inline float8 min(float8 a, float8 b) { return _mm256_min_ps(a.v, b.v); }
+    inline float8 max(float8 a, float8 b) { return _mm256_max_ps(a.v, b.v); }
+    inline float8 select(float8 mask, float8 a, float8 b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+    /** Truncate towards zero, only valid for |a| < 2^31 */
+    inline float8 trunc(float8 a) { return _mm256_cvtepi32_ps(_mm256_cvttps_epi32(a.v)); }
+    inline int moveMask(float8 a) { return _mm256_movemask_ps(a.v); }
+
+#elif defined(LTSH_SIMD_SSE2)
+
+    struct float8
+    {
+        __m128 lo, hi;
+
+        float8() : lo(_mm_setzero_ps()), hi(_mm_setzero_ps()) {}
+        float8(float s) : lo(_mm_set1_ps(s)), hi(_mm_set1_ps(s)) {}
+        float8(__m128 lo_, __m128 hi_) : lo(lo_), hi(hi_) {}
+
+        static float8 load(const float* p) { return float8(_mm_loadu_ps(p), _mm_loadu_ps(p + 4)); }
+        void store(float* p) const { _mm_storeu_ps(p, lo); _mm_storeu_ps(p + 4, hi); }
+    };
+
+#define LTSH_SIMD_BINARY(name, intrinsic) \
+    inline float8 name(float8 a, float8 b) { return float8(intrinsic(a.lo, b.lo), intrinsic(a.hi, b.hi)); }
+
+    LTSH_SIMD_BINARY(operator+, _mm_add_ps)
+    LTSH_SIMD_BINARY(operator-, _mm_sub_ps)
+    LTSH_SIMD_BINARY(operator*, _mm_mul_ps)
+    LTSH_SIMD_BINARY(operator/, _mm_div_ps)
+    LTSH_SIMD_BINARY(operator&, _mm_and_ps)
+    LTSH_SIMD_BINARY(operator|, _mm_or_ps)
+    LTSH_SIMD_BINARY(operator^, _mm_xor_ps)
+    LTSH_SIMD_BINARY(andNot, _mm_andnot_ps)
+    LTSH_SIMD_BINARY(operator<, _mm_cmplt_ps)
+    LTSH_SIMD_BINARY(operator<=, _mm_cmple_ps)
+    LTSH_SIMD_BINARY(operator>, _mm_cmpgt_ps)
+    LTSH_SIMD_BINARY(operator>=, _mm_cmpge_ps)
+    LTSH_SIMD_BINARY(operator==, _mm_cmpeq_ps)
+    LTSH_SIMD_BINARY(min, _mm_min_ps)
+    LTSH_SIMD_BINARY(max, _mm_max_ps)
+
+#undef LTSH_SIMD_BINARY
+
+    inline float8 sqrt(float8 a) { return float8(_mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi)); }
+    inline float8 select(float8 mask, float8 a, float8 b)
+    {
+        return float8(_mm_or_ps(_mm_and_ps(mask.lo, a.lo), _mm_andnot_ps(mask.lo, b.lo)),
+                      _mm_or_ps(_mm_and_ps(mask.hi, a.hi), _mm_andnot_ps(mask.hi, b.hi)));
+    }
+    inline float8 trunc(float8 a)
+    {
+        return float8(_mm_cvtepi32_ps(_mm_cvttps_epi32(a.lo)), _mm_cvtepi32_ps(_mm_cvttps_epi32(a.hi)));
+    }
+    inline int moveMask(float8 a) { return _mm_movemask_ps(a.lo) | (_mm_movemask_ps(a.hi) << 4); }
+
+#else
+
+    struct float8
+    {
+        float v[8];
+
+        float8() { for (int i = 0; i < 8; i++) v[i] = 0.f; }
+        float8(float s) { for (int i = 0; i < 8; i++) v[i] = s; }
+
+        static float8 load(const float* p) { float8 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+        void store(float* p) const { std::memcpy(p, v, sizeof(v)); }
+    };
+
+    namespace detail
+    {
+        inline float maskValue(bool b) { uint32_t bits = b ? 0xffffffffu : 0u; float f; std::memcpy(&f, &bits, 4); return f; }
+        inline uint32_t bitsOf(float f) { uint32_t bits; std::memcpy(&bits, &f, 4); return bits; }
+        inline float fromBits(uint32_t bits) { float f; std::memcpy(&f, &bits, 4); return f; }
+    }
+
+#define LTSH_SIMD_BINARY(name, expr) \
+    inline float8 name(float8 a, float8 b) { float8 r; for (int i = 0; i < 8; i++) { float x = a.v[i], y = b.v[i]; r.v[i] = (expr); } return r; }
+
+    LTSH_SIMD_BINARY(operator+, x + y)
+    LTSH_SIMD_BINARY(operator-, x - y)
+    LTSH_SIMD_BINARY(operator*, x * y)
+    LTSH_SIMD_BINARY(operator/, x / y)
+    LTSH_SIMD_BINARY(operator&, detail::fromBits(detail::bitsOf(x) & detail::bitsOf(y)))
+    LTSH_SIMD_BINARY(operator|, detail::fromBits(detail::bitsOf(x) | detail::bitsOf(y)))
+    LTSH_SIMD_BINARY(operator^, detail::fromBits(detail::bitsOf(x) ^ detail::bitsOf(y)))
+    LTSH_SIMD_BINARY(andNot, detail::fromBits(~detail::bitsOf(x) & detail::bitsOf(y)))
+    LTSH_SIMD_BINARY(operator<, detail::maskValue(x < y))
+    LTSH_SIMD_BINARY(operator<=, detail::maskValue(x <= y))
+    LTSH_SIMD_BINARY(operator>, detail::maskValue(x > y))
+    LTSH_SIMD_BINARY(operator>=, detail::maskValue(x >= y))
+    LTSH_SIMD_BINARY(operator==, detail::maskValue(x == y))
+    LTSH_SIMD_BINARY(min, y < x ? y : x)
+    LTSH_SIMD_BINARY(max, x < y ? y : x)
+
+#undef LTSH_SIMD_BINARY
+
+    inline float8 sqrt(float8 a) { float8 r; for (int i = 0; i < 8; i++) r.v[i] = std::sqrt(a.v[i]); return r; }
+    inline float8 select(float8 mask, float8 a, float8 b)
+    {
+        float8 r;
+        for (int i = 0; i < 8; i++) r.v[i] = (detail::bitsOf(mask.v[i]) & 0x80000000u) ? a.v[i] : b.v[i];
+        return r;
+    }
+    inline float8 trunc(float8 a) { float8 r; for (int i = 0; i < 8; i++) r.v[i] = (float)(int32_t)a.v[i]; return r; }
+    inline int moveMask(float8 a)
+    {
+        int m = 0;
+        for (int i = 0; i < 8; i++) m |= ((detail::bitsOf(a.v[i]) >> 31) & 1) << i;
+        return m;
+    }
+
+#endif
+
+    inline float8 signMask() { return float8(-0.f); }
+    inline float8 abs(float8 a) { return andNot(signMask(), a); }
+    inline float8 operator-(float8 a) { return a ^ signMask(); }
+    /** Copy the sign of s onto the magnitude of a */
+    inline float8 copySign(float8 a, float8 s) { return abs(a) | (s & signMask()); }
+    inline float8 madd(float8 a, float8 b, float8 c) { return a * b + c; }
+    inline float8& operator+=(float8& a, float8 b) { a = a + b; return a; }
+    inline float8& operator-=(float8& a, float8 b) { a = a - b; return a; }
+    inline float8& operator*=(float8& a, float8 b) { a = a * b; return a; }
+    inline bool any(float8 mask) { return moveMask(mask) != 0; }
+    inline bool all(float8 mask) { return moveMask(mask) == 0xff; }
+
+    /** Name of the instruction set the float8 type was compiled for
+    */
+    inline const char* backendName()
+    {
+#if defined(LTSH_SIMD_AVX2)
+        return "AVX2";
+#elif defined(LTSH_SIMD_SSE2)
+        return "SSE2";
+#else
+        return "Scalar";
+#endif
+    }
+
+    /** Single precision arc cosine, polynomial from Cephes asinf, max. error ~2 ulp on [-1, 1]
+    */
+    inline float8 acos(float8 x)
+    {
+        float8 a = abs(x);
+        float8 big = a > float8(0.5f);
+        // asin(sqrt(z)) for |x| > 0.5 and asin(a) otherwise
+        float8 z = select(big, float8(0.5f) * (float8(1.f) - a), a * a);
+        float8 s = select(big, sqrt(z), a);
+        float8 p = float8(4.2163199048e-2f);
+        p = madd(p, z, float8(2.4181311049e-2f));
+        p = madd(p, z, float8(4.5470025998e-2f));
+        p = madd(p, z, float8(7.4953002686e-2f));
+        p = madd(p, z, float8(1.6666752422e-1f));
+        float8 asinS = madd(p * z, s, s);
+
+        // |x| > 0.5: acos(|x|) = 2 asin(sqrt((1 - |x|) / 2)), otherwise acos(|x|) = pi/2 - asin(|x|)
+        float8 acosA = select(big, asinS + asinS, float8(1.5707963267948966f) - asinS);
+        // acos(-x) = pi - acos(x)
+        return select(x < float8(0.f), float8(3.14159265358979323846f) - acosA, acosA);
+    }
+
+    /** Single precision two argument arc tangent, polynomial and range reduction from Cephes atanf, max. error ~2 ulp.
+        Returns 0 for y = x = 0.
+    */
+    inline float8 atan2(float8 y, float8 x)
+    {
+        float8 ax = abs(x), ay = abs(y);
+        float8 hi = max(ax, ay);
+        // the angle to the nearer axis, in [0, pi/4]
+        float8 t = select(hi > float8(0.f), min(ax, ay) / hi, float8(0.f));
+
+        // above tan(pi/8) the argument is reduced to (t - 1) / (t + 1) around pi/4
+        float8 reduce = t > float8(0.4142135623730950f);
+        float8 r = select(reduce, (t - float8(1.f)) / (t + float8(1.f)), t);
+        float8 z = r * r;
+        float8 p = float8(8.05374449538e-2f);
+        p = madd(p, z, float8(-1.38776856032e-1f));
+        p = madd(p, z, float8(1.99777106478e-1f));
+        p = madd(p, z, float8(-3.33329491539e-1f));
+        float8 a = madd(p * z, r, r) + (reduce & float8(0.78539816339744831f));
+
+        a = select(ay > ax, float8(1.5707963267948966f) - a, a);
+        a = select(x < float8(0.f), float8(3.14159265358979323846f) - a, a);
+        return copySign(a, y);
+    }
+
+    /** Single precision sine and cosine, polynomials and range reduction from Cephes sinf/cosf, max. error ~1 ulp for |x| < 8192
+    */
+    inline void sincos(float8 x, float8& s, float8& c)
+    {
+        const float8 kFourOverPi(1.27323954473516f);
+        float8 a = abs(x);
+
+        // reduce to octant j in {0, 2, 4, 6}
+        float8 y = trunc(a * kFourOverPi);
+        y = y + (y - float8(2.f) * trunc(y * float8(0.5f)));
+        float8 j = y - float8(8.f) * trunc(y * float8(0.125f));
+
+        float8 r = ((a - y * float8(0.78515625f)) - y * float8(2.4187564849853515625e-4f)) - y * float8(3.77489497744594108e-8f);
+        float8 r2 = r * r;
+
+        float8 sinPoly = float8(-1.9515295891e-4f);
+        sinPoly = madd(sinPoly, r2, float8(8.3321608736e-3f));
+        sinPoly = madd(sinPoly, r2, float8(-1.6666654611e-1f));
+        sinPoly = madd(sinPoly * r2, r, r);
+
+        float8 cosPoly = float8(2.443315711809948e-5f);
+        cosPoly = madd(cosPoly, r2, float8(-1.388731625493765e-3f));
+        cosPoly = madd(cosPoly, r2, float8(4.166664568298827e-2f));
+        cosPoly = madd(cosPoly * r2, r2, float8(1.f) - float8(0.5f) * r2);
+
+        float8 swap = (j == float8(2.f)) | (j == float8(6.f));
+        float8 sinNeg = j >= float8(4.f);
+        float8 cosNeg = (j == float8(2.f)) | (j == float8(4.f));
+
+        float8 sv = select(swap, cosPoly, sinPoly);
+        float8 cv = select(swap, sinPoly, cosPoly);
+        sv = select(sinNeg, -sv, sv);
+        // sin(-x) = -sin(x)
+        s = sv ^ (x & signMask());
+        c = select(cosNeg, -cv, cv);
+    }
+}
+}
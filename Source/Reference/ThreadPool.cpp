@@ -0,0 +1,113 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace ltsh
+{
+    ThreadPool::ThreadPool(uint32_t numThreads)
+        : mRemaining(0)
+    {
+        if (numThreads == 0)
+        {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (uint32_t i = 0; i < numThreads; i++)
+        {
+            mWorkers.emplace_back(new Worker);
+        }
+        for (uint32_t i = 0; i < numThreads; i++)
+        {
+            mThreads.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShutdown = true;
+        }
+        mWake.notify_all();
+        for (auto& thread : mThreads)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, uint32_t)>& func)
+    {
+        if (count == 0) return;
+
+        // publish the job before any task becomes visible, workers of the previous generation may still be looking for work
+        mpFunc = &func;
+        mRemaining = count;
+
+        size_t numWorkers = mWorkers.size();
+        for (size_t w = 0; w < numWorkers; w++)
+        {
+            size_t begin = count * w / numWorkers;
+            size_t end = count * (w + 1) / numWorkers;
+            std::lock_guard<std::mutex> lock(mWorkers[w]->mutex);
+            for (size_t t = begin; t < end; t++)
+            {
+                // the owner pops from the back, push in reverse to process the block front to back
+                mWorkers[w]->tasks.push_front(t);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mGeneration++;
+        mWake.notify_all();
+        mDone.wait(lock, [this]() { return mRemaining == 0; });
+        mpFunc = nullptr;
+    }
+
+    bool ThreadPool::popTask(uint32_t index, size_t& task)
+    {
+        Worker& worker = *mWorkers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) return false;
+        task = worker.tasks.back();
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool ThreadPool::stealTask(uint32_t index, size_t& task)
+    {
+        uint32_t numWorkers = (uint32_t)mWorkers.size();
+        for (uint32_t i = 1; i < numWorkers; i++)
+        {
+            Worker& victim = *mWorkers[(index + i) % numWorkers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.tasks.empty()) continue;
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void ThreadPool::workerLoop(uint32_t index)
+    {
+        uint64_t seenGeneration = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWake.wait(lock, [&]() { return mShutdown || mGeneration != seenGeneration; });
+                if (mShutdown) return;
+                seenGeneration = mGeneration;
+            }
+
+            size_t task;
+            while (popTask(index, task) || stealTask(index, task))
+            {
+                (*mpFunc)(task, index);
+                if (mRemaining.fetch_sub(1) == 1)
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mDone.notify_all();
+                }
+            }
+        }
+    }
+}
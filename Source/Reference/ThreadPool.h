@@ -0,0 +1,61 @@
+#pragma once
+
+// Small work-stealing thread pool for the CPU reference. Every parallelFor() splits the task range into one
+// contiguous block per worker; a worker pops tasks from the back of its own deque and, once that is empty,
+// steals from the front of the other workers' deques, so uneven tiles (e.g. tiles covering the light) balance out.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ltsh
+{
+    class ThreadPool
+    {
+    public:
+        /** Create the pool
+            \param[in] numThreads Number of worker threads, 0 uses std::thread::hardware_concurrency()
+        */
+        explicit ThreadPool(uint32_t numThreads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        uint32_t getThreadCount() const { return (uint32_t)mThreads.size(); }
+
+        /** Run func(taskIndex, workerIndex) for every task in [0, count) and block until all tasks are done.
+            func must not throw and must not call parallelFor() itself.
+        */
+        void parallelFor(size_t count, const std::function<void(size_t, uint32_t)>& func);
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        void workerLoop(uint32_t index);
+        bool popTask(uint32_t index, size_t& task);
+        bool stealTask(uint32_t index, size_t& task);
+
+        std::vector<std::thread> mThreads;
+        std::vector<std::unique_ptr<Worker>> mWorkers;
+
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::condition_variable mDone;
+        uint64_t mGeneration = 0;
+        bool mShutdown = false;
+
+        const std::function<void(size_t, uint32_t)>* mpFunc = nullptr;
+        std::atomic<size_t> mRemaining;
+    };
+}
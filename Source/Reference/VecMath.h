@@ -0,0 +1,177 @@
+#pragma once
+
+// Minimal HLSL-like vector math for the CPU reference code. The Falcor build uses glm, but the reference
+// library has to compile without Falcor, so it ships its own small set of types. Matrices are row-major like
+// HLSL's float3x3, i.e. mul(M, v) dots every row of M with v.
+
+#include <cmath>
+
+namespace ltsh
+{
+    static const double kPi = 3.14159265358979323846;
+    static const double kInvPi = 0.31830988618379067154;
+
+    template<typename T>
+    struct Vec2
+    {
+        T x, y;
+
+        Vec2() : x(0), y(0) {}
+        Vec2(T x_, T y_) : x(x_), y(y_) {}
+        explicit Vec2(T s) : x(s), y(s) {}
+
+        Vec2 operator+(const Vec2& o) const { return Vec2(x + o.x, y + o.y); }
+        Vec2 operator-(const Vec2& o) const { return Vec2(x - o.x, y - o.y); }
+        Vec2 operator*(const Vec2& o) const { return Vec2(x * o.x, y * o.y); }
+        Vec2 operator*(T s) const { return Vec2(x * s, y * s); }
+        Vec2 operator/(T s) const { return Vec2(x / s, y / s); }
+        Vec2& operator+=(const Vec2& o) { x += o.x; y += o.y; return *this; }
+        bool operator==(const Vec2& o) const { return x == o.x && y == o.y; }
+        bool operator!=(const Vec2& o) const { return !(*this == o); }
+    };
+
+    template<typename T>
+    struct Vec3
+    {
+        T x, y, z;
+
+        Vec3() : x(0), y(0), z(0) {}
+        Vec3(T x_, T y_, T z_) : x(x_), y(y_), z(z_) {}
+        explicit Vec3(T s) : x(s), y(s), z(s) {}
+        template<typename U>
+        explicit Vec3(const Vec3<U>& o) : x(T(o.x)), y(T(o.y)), z(T(o.z)) {}
+
+        T& operator[](int i) { return (&x)[i]; }
+        const T& operator[](int i) const { return (&x)[i]; }
+
+        Vec3 operator-() const { return Vec3(-x, -y, -z); }
+        Vec3 operator+(const Vec3& o) const { return Vec3(x + o.x, y + o.y, z + o.z); }
+        Vec3 operator-(const Vec3& o) const { return Vec3(x - o.x, y - o.y, z - o.z); }
+        Vec3 operator*(const Vec3& o) const { return Vec3(x * o.x, y * o.y, z * o.z); }
+        Vec3 operator*(T s) const { return Vec3(x * s, y * s, z * s); }
+        Vec3 operator/(T s) const { return Vec3(x / s, y / s, z / s); }
+        Vec3& operator+=(const Vec3& o) { x += o.x; y += o.y; z += o.z; return *this; }
+        Vec3& operator-=(const Vec3& o) { x -= o.x; y -= o.y; z -= o.z; return *this; }
+        Vec3& operator*=(T s) { x *= s; y *= s; z *= s; return *this; }
+    };
+
+    template<typename T>
+    inline Vec3<T> operator*(T s, const Vec3<T>& v) { return v * s; }
+
+    template<typename T>
+    struct Vec4
+    {
+        T x, y, z, w;
+
+        Vec4() : x(0), y(0), z(0), w(0) {}
+        Vec4(T x_, T y_, T z_, T w_) : x(x_), y(y_), z(z_), w(w_) {}
+        Vec4(const Vec3<T>& v, T w_) : x(v.x), y(v.y), z(v.z), w(w_) {}
+
+        Vec3<T> xyz() const { return Vec3<T>(x, y, z); }
+    };
+
+    /** Row-major 3x3 matrix, constructed from its rows like HLSL's float3x3(r0, r1, r2)
+    */
+    template<typename T>
+    struct Mat3
+    {
+        Vec3<T> r[3];
+
+        Mat3() : r{ Vec3<T>(1, 0, 0), Vec3<T>(0, 1, 0), Vec3<T>(0, 0, 1) } {}
+        Mat3(const Vec3<T>& r0, const Vec3<T>& r1, const Vec3<T>& r2) : r{ r0, r1, r2 } {}
+        Mat3(T m00, T m01, T m02, T m10, T m11, T m12, T m20, T m21, T m22)
+            : r{ Vec3<T>(m00, m01, m02), Vec3<T>(m10, m11, m12), Vec3<T>(m20, m21, m22) } {}
+        template<typename U>
+        explicit Mat3(const Mat3<U>& o) : r{ Vec3<T>(o.r[0]), Vec3<T>(o.r[1]), Vec3<T>(o.r[2]) } {}
+
+        Vec3<T>& operator[](int i) { return r[i]; }
+        const Vec3<T>& operator[](int i) const { return r[i]; }
+    };
+
+    template<typename T>
+    struct Mat4
+    {
+        Vec4<T> r[4];
+    };
+
+    using float2 = Vec2<float>;
+    using float3 = Vec3<float>;
+    using float4 = Vec4<float>;
+    using float3x3 = Mat3<float>;
+    using float4x4 = Mat4<float>;
+    using double2 = Vec2<double>;
+    using double3 = Vec3<double>;
+    using double3x3 = Mat3<double>;
+
+    template<typename T> inline T dot(const Vec2<T>& a, const Vec2<T>& b) { return a.x * b.x + a.y * b.y; }
+    template<typename T> inline T dot(const Vec3<T>& a, const Vec3<T>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    template<typename T> inline T cross(const Vec2<T>& a, const Vec2<T>& b) { return a.x * b.y - a.y * b.x; }
+
+    template<typename T>
+    inline Vec3<T> cross(const Vec3<T>& a, const Vec3<T>& b)
+    {
+        return Vec3<T>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    template<typename T> inline T length(const Vec3<T>& v) { return std::sqrt(dot(v, v)); }
+    template<typename T> inline Vec3<T> normalize(const Vec3<T>& v) { return v / length(v); }
+    template<typename T> inline Vec3<T> min(const Vec3<T>& a, const Vec3<T>& b) { return Vec3<T>(std::fmin(a.x, b.x), std::fmin(a.y, b.y), std::fmin(a.z, b.z)); }
+    template<typename T> inline Vec3<T> max(const Vec3<T>& a, const Vec3<T>& b) { return Vec3<T>(std::fmax(a.x, b.x), std::fmax(a.y, b.y), std::fmax(a.z, b.z)); }
+    template<typename T> inline T saturate(T v) { return v < T(0) ? T(0) : (v > T(1) ? T(1) : v); }
+    template<typename T> inline T clamp(T v, T lo, T hi) { return v < lo ? lo : (v > hi ? hi : v); }
+    template<typename T> inline T lerp(T a, T b, T t) { return a + (b - a) * t; }
+
+    template<typename T>
+    inline Vec3<T> mul(const Mat3<T>& m, const Vec3<T>& v)
+    {
+        return Vec3<T>(dot(m.r[0], v), dot(m.r[1], v), dot(m.r[2], v));
+    }
+
+    template<typename T>
+    inline Mat3<T> transpose(const Mat3<T>& m)
+    {
+        return Mat3<T>(m.r[0].x, m.r[1].x, m.r[2].x,
+                       m.r[0].y, m.r[1].y, m.r[2].y,
+                       m.r[0].z, m.r[1].z, m.r[2].z);
+    }
+
+    template<typename T>
+    inline Mat3<T> mul(const Mat3<T>& a, const Mat3<T>& b)
+    {
+        Mat3<T> bt = transpose(b);
+        Mat3<T> res;
+        for (int i = 0; i < 3; i++)
+        {
+            res.r[i] = Vec3<T>(dot(a.r[i], bt.r[0]), dot(a.r[i], bt.r[1]), dot(a.r[i], bt.r[2]));
+        }
+        return res;
+    }
+
+    template<typename T>
+    inline T determinant(const Mat3<T>& m)
+    {
+        return dot(m.r[0], cross(m.r[1], m.r[2]));
+    }
+
+    template<typename T>
+    inline Mat3<T> inverse(const Mat3<T>& m)
+    {
+        T invDet = T(1) / determinant(m);
+        Vec3<T> c0 = cross(m.r[1], m.r[2]);
+        Vec3<T> c1 = cross(m.r[2], m.r[0]);
+        Vec3<T> c2 = cross(m.r[0], m.r[1]);
+        return transpose(Mat3<T>(c0 * invDet, c1 * invDet, c2 * invDet));
+    }
+
+    template<typename T>
+    inline Vec4<T> mul(const Mat4<T>& m, const Vec4<T>& v)
+    {
+        Vec4<T> res;
+        T* out = &res.x;
+        for (int i = 0; i < 4; i++)
+        {
+            out[i] = m.r[i].x * v.x + m.r[i].y * v.y + m.r[i].z * v.z + m.r[i].w * v.w;
+        }
+        return res;
+    }
+}
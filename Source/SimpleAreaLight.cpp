@@ -1,10 +1,9 @@
 #include "SimpleAreaLight.h"
-#include "PolygonUtil.h"
 
-// A simple area light consists 4 vertices in the xy plane, a position and a direction. 
+// A simple area light consists of 3 to AREA_LIGHT_MAX_VERTICES vertices in the xy plane, a position and a direction.
 // The position transforms the origin of the xy plane to specified worldspace position.
 // The direction is the normal of the planar polygon.
-// In theory, the technique supports arbitrary planar polygons, but only polygons with 4 vertices are supported by the shader implementation.
+// The polygon may be concave, the shaders clip it to the horizon edge by edge and the sampler ear clips it.
 
 // Code for simple area lights.
 SimpleAreaLight::SharedPtr SimpleAreaLight::create()
@@ -22,6 +21,7 @@ SimpleAreaLight::SimpleAreaLight()
         glm::vec2(1.f, -1.f),
         glm::vec2(1.f, 1.f),
     });
+    mShape = PolygonShape(&mVertices2d[0].x, (uint32_t)mVertices2d.size());
 
     mScaling = vec3(1, 1, 1);
     mData.dirW = glm::normalize(glm::vec3(0.f, 0.f, -1.f));
@@ -31,6 +31,17 @@ SimpleAreaLight::SimpleAreaLight()
 
 SimpleAreaLight::~SimpleAreaLight() = default;
 
+void SimpleAreaLight::setVertices2d(const std::vector<glm::vec2>& vertices)
+{
+    if (vertices.size() < 3 || vertices.size() > AREA_LIGHT_MAX_VERTICES)
+    {
+        throw std::runtime_error("An area light must have 3 to " + std::to_string(AREA_LIGHT_MAX_VERTICES) + " vertices");
+    }
+    mVertices2d = vertices;
+    mShape = PolygonShape(&mVertices2d[0].x, (uint32_t)mVertices2d.size());
+    update();
+}
+
 float SimpleAreaLight::getPower() const
 {
     return luminance(mData.intensity) * (float)M_PI * mData.surfaceArea;
@@ -76,17 +87,15 @@ void SimpleAreaLight::update()
     // calculate surface area (ref: https://web.archive.org/web/20100405070507/http://valis.cs.uiuc.edu/~sariel/research/CG/compgeom/msg00831.html)
     // note that vertices must be counter clockwise or else the result will be negative
     mData.surfaceArea = 0.f;
-    for (int i = 0; i < NUM_VERTICES; ++i)
+    for (size_t i = 0; i < mVertices2d.size(); ++i)
     {
-        int j = (i + 1) % NUM_VERTICES;
+        size_t j = (i + 1) % mVertices2d.size();
         mData.surfaceArea += mVertices2d[i].x * mVertices2d[j].y * mScaling.x * mScaling.y;
         mData.surfaceArea -= mVertices2d[i].y * mVertices2d[j].x * mScaling.x * mScaling.y;
     }
     mData.surfaceArea = mData.surfaceArea / 2.f;
 
-    // calculate the transformed vertices in worldspace, also find min and max
-    mMin = glm::vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
-    mMax = glm::vec2(std::numeric_limits<float>::min(), std::numeric_limits<float>::min());
+    // calculate the transformed vertices in worldspace
     std::vector<glm::vec3> vertices_3d = std::vector<glm::vec3>();
     mTransformedVertices3d.clear();
     mScaledVertices2d.clear();
@@ -95,9 +104,6 @@ void SimpleAreaLight::update()
         vertices_3d.emplace_back(glm::vec3(vert_2d.x, vert_2d.y, 0.f));
         auto scaling2d = glm::vec2(mScaling.x, mScaling.y);
         mScaledVertices2d.emplace_back(vert_2d * scaling2d);
-        // unscaled min and max, scaling is applied later
-        mMin = glm::min(vert_2d, mMin);
-        mMax = glm::max(vert_2d, mMax);
     }
 
     for (auto vert_3d : vertices_3d)
@@ -105,10 +111,10 @@ void SimpleAreaLight::update()
         mTransformedVertices3d.emplace_back(glm::vec3(mData.transMat * glm::vec4(vert_3d, 1.f)));
     }
 
-    // create new samples if ground truth rendering is enabled
+    // update the samples if ground truth rendering is enabled, moving the light only re-transforms them
     if (mSampleCreation) 
     {
-        this->createSamples();
+        updateSamples();
     }
 }
 
@@ -119,35 +125,15 @@ void SimpleAreaLight::move(const glm::vec3 & position, const glm::vec3 & target,
     update();
 }
 
-// simple rejection sampling
 void SimpleAreaLight::createSamples()
 {
-    glm::vec2 extent = mMax - mMin;
-
-    for (int i = 0; i < 4; i++)
-    {
-        int sampleCount = 0;
-        while (sampleCount < NUM_SAMPLES)
-        {
-            // get two random values in [0, 1]
-            glm::vec2 sample = glm::vec2((float)std::rand() / RAND_MAX, (float)std::rand() / RAND_MAX);
-            // move sample to polygon space
-            sample = sample * extent + mMin;
-            if (PolygonUtil::isInside(mVertices2d, NUM_VERTICES, sample))
-            {
-                mSamples[i][sampleCount] = float4(sample.x, sample.y, 0.f, 1.f);
-                mTransformedSamples[i][sampleCount] = mData.transMat * mSamples[i][sampleCount];
-                sampleCount++;
-            }
-        }
-    }
+    mSamples.invalidate();
+    updateSamples();
 }
 
-void SimpleAreaLight::setSamplesIntoProgramVars(ConstantBuffer* pCb, const std::string &varName, int i)
+void SimpleAreaLight::updateSamples()
 {
-    size_t offset = pCb->getVariableOffset(varName);
-
-    pCb->setBlob(&mTransformedSamples[i], offset, sizeof(mTransformedSamples[i]));
+    mSamples.update(&mVertices2d[0].x, (uint32_t)mVertices2d.size(), mSampleSeed, &mData.transMat[0][0]);
 }
 
 void SimpleAreaLight::setPolygonIntoDeferred(ConstantBuffer* pCb)
@@ -156,22 +142,43 @@ void SimpleAreaLight::setPolygonIntoDeferred(ConstantBuffer* pCb)
     pCb->setBlob(&mData.transMat, offset, sizeof(mData.transMat));
     offset = pCb->getVariableOffset("transMatIT");
     pCb->setBlob(&mData.transMatIT, offset, sizeof(mData.transMatIT));
-    float4 polygon[4];
-    for (int i = 0; i < 4; i++)
+    float4 polygon[AREA_LIGHT_MAX_VERTICES] = {};
+    for (size_t i = 0; i < mVertices2d.size(); i++)
     {
         polygon[i] = float4(mVertices2d[i], 0, 0);
     }
     offset = pCb->getVariableOffset("polygon");
     pCb->setBlob(&polygon, offset, sizeof(polygon));
+    pCb->setVariable("polygonVertexCount", (uint32_t)mVertices2d.size());
+
+    // the point in polygon test of the deferred pass uses the cached edge planes instead of intersecting edges
+    float4 edges[AREA_LIGHT_MAX_VERTICES] = {};
+    const std::vector<EdgePlane>& planes = mShape.getEdgePlanes();
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        edges[i] = float4(planes[i].a, planes[i].b, planes[i].c, planes[i].dy);
+    }
+    offset = pCb->getVariableOffset("polygonEdges");
+    pCb->setBlob(&edges, offset, sizeof(edges));
+    pCb->setVariable("polygonConvex", (uint32_t)mShape.isConvex());
 }
 
-void SimpleAreaLight::setPolygonIntoLighting(ConstantBuffer* pCb, const std::string& varName)
+PackedAreaLight SimpleAreaLight::getPackedData() const
 {
-    float4 polygon[4];
-    for (int i = 0; i < 4; i++)
+    PackedAreaLight packed;
+    for (size_t i = 0; i < mTransformedVertices3d.size(); i++)
     {
-        polygon[i] = float4(mTransformedVertices3d[i], 0);
+        packed.posW[i][0] = mTransformedVertices3d[i].x;
+        packed.posW[i][1] = mTransformedVertices3d[i].y;
+        packed.posW[i][2] = mTransformedVertices3d[i].z;
+        packed.posW[i][3] = 0.f;
     }
-    size_t offset = pCb->getVariableOffset(varName);
-    pCb->setBlob(&polygon, offset, sizeof(polygon));
+    for (int c = 0; c < 3; c++)
+    {
+        packed.intensity[c] = mData.intensity[c];
+        packed.dirW[c] = mData.dirW[c];
+    }
+    packed.surfaceArea = mData.surfaceArea;
+    packed.numVertices = (uint32_t)mTransformedVertices3d.size();
+    return packed;
 }
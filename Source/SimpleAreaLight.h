@@ -2,9 +2,9 @@
 #include <Falcor.h>
 #include <Graphics/Light.h>
 #include <Data/HostDeviceSharedMacros.h>
-
-#define NUM_SAMPLES 4096
-#define NUM_VERTICES 4
+#include "AreaLightCollection.h"
+#include "AreaLightSamples.h"
+#include "PolygonShape.h"
 
 using namespace Falcor;
 
@@ -36,6 +36,10 @@ public:
     */
     std::vector<glm::vec2> getVertices2d() { return mVertices2d; }
 
+    /** Get the triangulation, convex pieces and edge planes of the polygon, rebuilt when the vertices change
+    */
+    const PolygonShape& getShape() const { return mShape; }
+
     /** Get the transformed vertices.
     */
     std::vector<glm::vec3> getTransformedVertices() { return mTransformedVertices3d; }
@@ -57,25 +61,42 @@ public:
     */
     void setTransformMatrix(const glm::mat4& mtx) { mTransformMatrix = mtx; update(); }
 
-    /** Set vertices of area light polygon (must be closed and without crossings, speciefied in CCW order)
+    /** Set vertices of area light polygon (must be closed and without crossings, speciefied in CCW order). The
+        polygon may be concave and have 3 to AREA_LIGHT_MAX_VERTICES vertices.
         \param[in] vertices of the polygon in 2D-XY space
     */
-    void setVertices2d(const std::vector<glm::vec2>& vertices) { mVertices2d = vertices; update(); }
+    void setVertices2d(const std::vector<glm::vec2>& vertices);
 
     /** Get transform matrix
     */
     glm::mat4 getTransformMatrix() const { return mTransformMatrix; }
 
-    /** Get a vector with n samples inside the polygon. Those samples are in model space and need to be transformed to worldspace for lighting.
-        \param[in] n Number of samples
-        \param[out] sampels Vector containing the sampled points
+    /** Set the seed of the ground truth samples, every seed gives a different but reproducible set of samples
+    */
+    void setSampleSeed(uint32_t seed) { mSampleSeed = seed; update(); }
+
+    /** Get the seed of the ground truth samples
+    */
+    uint32_t getSampleSeed() const { return mSampleSeed; }
+
+    /** Create 4 sets of NUM_SAMPLES samples inside the polygon without rejection, see PolygonSampler.
+        The samples are created in model space and transformed to world space for lighting. This always regenerates
+        both, update() only redoes what the change invalidated.
     */
     void createSamples();
 
-    /** Set the light intensity.
+    /** World space samples for the ground truth modes
+    */
+    const AreaLightSamples& getSamples() const { return mSamples; }
+
+    /** Changes whenever the world space samples change, the sample buffer only needs an upload then
+    */
+    uint64_t getSampleGeneration() const { return mSamples.getGeneration(); }
+
+    /** Set the light intensity. Does not affect geometry or samples, so nothing is recomputed.
         \param[in] intensity Vec3 corresponding to RGB intensity
     */
-    void setIntensity(const glm::vec3& intensity) { mData.intensity = intensity; update(); }
+    void setIntensity(const glm::vec3& intensity) { mData.intensity = intensity; }
 
     /** Render UI elements for this light.
         \param[in] pGui The GUI to create the elements with
@@ -87,23 +108,28 @@ public:
     */
     void move(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up) override;
 
-    void setSamplesIntoProgramVars(ConstantBuffer* pCb, const std::string& varName, int i);
-
     void setPolygonIntoDeferred(ConstantBuffer* pCb);
 
-    void setPolygonIntoLighting(ConstantBuffer* pCb, const std::string& varName);
+    /** World space polygon, intensity and area in the layout of the lighting pass' area light buffer
+    */
+    PackedAreaLight getPackedData() const;
 
 private:
     void update();
 
+    /** Bring the samples up to date: regenerate the model space samples if the polygon or seed changed since they
+        were created, then re-transform them if they were regenerated or the transform changed
+    */
+    void updateSamples();
+
     // since we only support planar polygons they must be specified in 2d (x, y) and later be translated
     std::vector<glm::vec2> mVertices2d;
+    PolygonShape mShape;
     std::vector<glm::vec2> mScaledVertices2d;
     std::vector<glm::vec3> mTransformedVertices3d;
     glm::mat4 mTransformMatrix;
     glm::vec3 mScaling;
-    glm::vec2 mMin, mMax;
-    float4 mSamples[4][NUM_SAMPLES];
-    float4 mTransformedSamples[4][NUM_SAMPLES];
+    AreaLightSamples mSamples;
     bool mSampleCreation;
+    uint32_t mSampleSeed = 0;
 };
\ No newline at end of file
@@ -28,6 +28,9 @@
 #include "SimpleDeferred.h"
 #include "PolygonUtil.h"
 #include "Numpy.hpp"
+#include "LutBundle.h"
+#include "Reference/GBuffer.h"
+#include <cstring>
 
 //const std::string SimpleDeferred::skDefaultModel = "Media/SunTemple/SunTemple.fbx";
 //const std::string SimpleDeferred::skDefaultModel = "Media/sponza/sponza.dae";
@@ -36,76 +39,29 @@ const std::string SimpleDeferred::skDefaultModel = "Media/Arcade/Arcade.fbx";
 
 const int legendre_res = 10000;
 
-// convert matrix data read from .npy file to a buffer which can written in the texture
-void convertFloat32ToFloat16(const std::vector<float>& in, std::vector<glm::detail::hdata>& out)
+namespace
 {
-    out.clear();
-    for (auto val : in)
+    /** Writes the samples straight into the GPU buffer, like the dirty ranges of the area light buffer
+    */
+    class StructuredBufferUploadSink : public SampleUploadSink
     {
-        out.push_back(glm::detail::toFloat16(float(val)));
-    }
-}
+    public:
+        explicit StructuredBufferUploadSink(StructuredBuffer* pBuffer) : mpBuffer(pBuffer) {}
+        void upload(const void* pData, size_t offset, size_t size) override { mpBuffer->updateData(pData, offset, size); }
 
-void convertDoubleToFloat16(const std::vector<double>& in, std::vector<glm::detail::hdata>& out)
-{
-    out.clear();
-    for (auto val : in)
-    {
-        out.push_back(glm::detail::toFloat16(float(val)));
-    }
+    private:
+        StructuredBuffer* mpBuffer;
+    };
 }
 
-// convert ltsh coefficient data read from .npy file to a buffer which can written in the texture, differs from ltc becaus ltsh has more coefficients
-void convertLtshCoeff(const std::vector<double>& in, std::vector<glm::detail::hdata>& out)
-{
-    // we only need 25 coefficients but to fit the RGBA texture we pad to 28, this gives 7 64x64 fields containing 4(RGBA) coefficients
-    out = std::vector<glm::detail::hdata>(64 * 64 * 28);
-    for (size_t i = 0; i < 64; i++)
-    {
-        for (size_t j = 0; j < 64; j++)
-        {
-            for (size_t k = 0; k < 28; k++)
-            {
-                // (k / 4) * 4 seems unnecessary but since it is integer division it gives us the right offset
-                size_t offset = (k / 4) * 64 * 4;
-                // add pad value
-                if (k > 24)
-                {
-                    out[i * 64 * 28 + j * 4 + (k % 4) + offset] = glm::detail::toFloat16(0.f);
-                    continue;
-                }
-                // order has to be rewritten to match texture format
-                out[i * 64 * 28 + j * 4 + (k % 4) + offset] = glm::detail::toFloat16(float(in[j * 64 * 25 + i * 25 + k]));
-            }
-        }
-    }
-}
+// values of gAccumulate in LightingPass.ps.hlsl
+static const uint32_t kAccumulateOff = 0;
+static const uint32_t kAccumulateAdd = 1;
+static const uint32_t kAccumulateShow = 2;
 
-// convert ltsh coefficient data read from .npy file to a buffer which can written in the texture, differs from ltc becaus ltsh has more coefficients
-void convertLtshCoeffN2(const std::vector<double>& in, std::vector<glm::detail::hdata>& out)
-{
-    // we only need 9 coefficients but to fit the RGBA texture we pad to 12, this gives 3 64x64 fields containing 4(RGBA) coefficients
-    out = std::vector<glm::detail::hdata>(64 * 64 * 12);
-    for (size_t i = 0; i < 64; i++)
-    {
-        for (size_t j = 0; j < 64; j++)
-        {
-            for (size_t k = 0; k < 12; k++)
-            {
-                // (k / 4) * 4 seems unnecessary but since it is integer division it gives us the right offset
-                size_t offset = (k / 4) * 64 * 4;
-                // add pad value
-                if (k > 8)
-                {
-                    out[i * 64 * 12 + j * 4 + (k % 4) + offset] = glm::detail::toFloat16(0.f);
-                    continue;
-                }
-                // order has to be rewritten to match texture format
-                out[i * 64 * 12 + j * 4 + (k % 4) + offset] = glm::detail::toFloat16(float(in[j * 64 * 9 + i * 9 + k]));
-            }
-        }
-    }
-}
+// names of AreaLightRenderMode and DebugMode in the frame time log
+static const char* kAreaLightRenderModeNames[] = { "GroundTruth", "LTC", "LTSH_N4", "None", "LtcBrdf", "LtshBrdf", "LTSH_N2" };
+static const char* kDebugModeNames[] = { "Disabled", "Positions", "Normals", "Albedo", "Illumination", "Diffuse", "Specular" };
 
 SimpleDeferred::~SimpleDeferred()
 {
@@ -191,6 +147,70 @@ void SimpleDeferred::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
     areaLightRenderModeList.push_back({ 5, "GT with LTSH_N4 BRDF" });
     pGui->addDropdown("Area Light Render Mode", areaLightRenderModeList, (uint32_t&)mAreaLightRenderMode);
 
+    Gui::DropdownList ltshLookupList;
+    ltshLookupList.push_back({ 0, "Dithered" });
+    ltshLookupList.push_back({ 1, "Bilinear" });
+    pGui->addDropdown("LTSH Lookup", ltshLookupList, (uint32_t&)mLtshLookup);
+
+    if (mAreaLightRenderMode == AreaLightRenderMode::LTC || mAreaLightRenderMode == AreaLightRenderMode::LTSH || mAreaLightRenderMode == AreaLightRenderMode::LTSH_N2)
+    {
+        Gui::DropdownList trigPrecisionList;
+        trigPrecisionList.push_back({ 0, "Exact" });
+        trigPrecisionList.push_back({ 1, "Medium" });
+        trigPrecisionList.push_back({ 2, "Fast" });
+        pGui->addDropdown("Trig Precision", trigPrecisionList, (uint32_t&)mTrigPrecision[(uint32_t)mAreaLightRenderMode]);
+    }
+
+    if (isGroundTruthMode())
+    {
+        pGui->addCheckBox("Progressive Ground Truth", mProgressiveGroundTruth);
+        if (mProgressiveGroundTruth)
+        {
+            if (pGui->addIntVar("Samples per Frame", (int&)mProgressiveSamples, 1, NUM_SAMPLES))
+            {
+                mProgressive.setSamplesPerFrame(mProgressiveSamples);
+                mProgressiveSamples = mProgressive.getSamplesPerFrame();
+            }
+            std::string spp = "Samples per Pixel: " + std::to_string(mProgressive.getSamplesPerPixel()) + " / " + std::to_string(mProgressive.getMaxSamplesPerPixel());
+            pGui->addText(spp.c_str());
+            if (pGui->addButton("Restart")) mProgressive.reset();
+        }
+    }
+
+    if (pGui->addButton("Reload Lookup Tables"))
+    {
+        try
+        {
+            loadLookupTables();
+            // the LtcBrdf and LtshBrdf modes would keep averaging the old tables into the new ones
+            mProgressive.reset();
+        }
+        catch (const std::exception& e)
+        {
+            logError(std::string("Failed to reload the lookup tables: ") + e.what());
+        }
+    }
+
+    if (pGui->beginGroup("Frame Times"))
+    {
+        bool record = mRecordFrameTimes;
+        if (pGui->addCheckBox("Record Frame Times", record))
+        {
+            setFrameTimeRecording(record);
+        }
+        const char* mode = kAreaLightRenderModeNames[(uint32_t)mAreaLightRenderMode];
+        for (uint32_t s = 0; s < (uint32_t)FrameStage::Count; s++)
+        {
+            FrameProfiler::Percentiles cpu = mpFrameProfiler->getPercentiles(FrameStage(s), false, mode);
+            if (cpu.count == 0) continue;
+            FrameProfiler::Percentiles gpu = mpFrameProfiler->getPercentiles(FrameStage(s), true, mode);
+            char line[160];
+            snprintf(line, sizeof(line), "%-14s cpu %.2f / %.2f ms  gpu %.2f / %.2f ms (p50 / p99)", getFrameStageName(FrameStage(s)), cpu.p50, cpu.p99, gpu.p50, gpu.p99);
+            pGui->addText(line);
+        }
+        pGui->endGroup();
+    }
+
     Gui::DropdownList cullList;
     cullList.push_back({0, "No Culling"});
     cullList.push_back({1, "Backface Culling"});
@@ -276,6 +296,27 @@ void SimpleDeferred::onLoad(SampleCallbacks* pSample, RenderContext* pRenderCont
 
     mpLightingPass = FullScreenPass::create("LightingPass.ps.hlsl");
 
+    mpTimerBackend = std::make_unique<GpuTimerBackend>();
+    if (mBenchmark.isEnabled())
+    {
+        // keep every timed frame of the benchmark for the summary
+        const BenchmarkSettings& settings = mBenchmark.getSettings();
+        uint32_t historySize = std::max(512u, settings.timedFrames * (uint32_t)settings.modes.size());
+        mpFrameProfiler = std::make_unique<FrameProfiler>(*mpTimerBackend, historySize);
+        mBenchmarkLog.open(settings.outputFile);
+        if (!mBenchmarkLog)
+        {
+            logError("Can't write " + settings.outputFile);
+        }
+        mpFrameProfiler->setJsonStream(&mBenchmarkLog);
+        mChangeModeFrames = mBenchmark.getModeStartFrames();
+        mChangeModeIt = mChangeModeFrames.begin();
+    }
+    else
+    {
+        mpFrameProfiler = std::make_unique<FrameProfiler>(*mpTimerBackend);
+    }
+
     // create rasterizer state
     RasterizerState::Desc rsDesc;
     mpCullRastState[0] = RasterizerState::create(rsDesc);
@@ -314,6 +355,7 @@ void SimpleDeferred::onLoad(SampleCallbacks* pSample, RenderContext* pRenderCont
     glm::vec3 up = glm::vec3(0.f, 1.f, 0.f);
     mpAreaLight->move(pos, pivot, up);
     mpAreaLight->setIntensity(glm::vec3(150.f, 150.f, 150.f));
+    mAreaLights.add(mpAreaLight->getPackedData());
 
     mAreaLightRenderMode = AreaLightRenderMode::LTSH;
     mDebugMode = DebugMode::Specular;
@@ -321,52 +363,7 @@ void SimpleDeferred::onLoad(SampleCallbacks* pSample, RenderContext* pRenderCont
     mpDeferredVars = GraphicsVars::create(mpDeferredPassProgram->getReflector());
     mpLightingVars = GraphicsVars::create(mpLightingPass->getProgram()->getReflector());
 
-    std::vector<double> d_temp = std::vector<double>();
-    std::vector<float> f_temp = std::vector<float>();
-    std::vector<glm::detail::hdata> data = std::vector<glm::detail::hdata>();
-
-
-    // Load LTC matrices
-    aoba::LoadArrayFromNumpy("Data/Params/inv_cos_mat_t128.npy", d_temp);
-    convertDoubleToFloat16(d_temp, data);
-    //aoba::LoadArrayFromNumpy("Data/Params/inv_cos_mat.npy", f_temp);
-    //convertFloat32ToFloat16(f_temp, data);
-    mLtcMInv = Texture::create2D(64, 64, ResourceFormat::RGBA16Float, 1, 1, data.data(), Resource::BindFlags::ShaderResource);
-
-    // Load LTC coefficients
-    aoba::LoadArrayFromNumpy("Data/Params/cos_coeff_t128.npy", d_temp);
-    convertDoubleToFloat16(d_temp, data);
-    //aoba::LoadArrayFromNumpy("Data/Params/cos_coeff.npy", f_temp);
-    //convertFloat32ToFloat16(f_temp, data);
-    mLtcCoeff = Texture::create2D(64, 64, ResourceFormat::R16Float, 1, 1, data.data(), Resource::BindFlags::ShaderResource);
-
-    // Load LTSH matrices for N=4
-    aoba::LoadArrayFromNumpy("Data/Params/inv_sh_mat_n4_t128.npy", d_temp);
-    convertDoubleToFloat16(d_temp, data);
-    //aoba::LoadArrayFromNumpy("Data/Params/inv_sh_n4_mat.npy", f_temp);
-    //convertFloat32ToFloat16(f_temp, data);
-    mLtshMInv = Texture::create2D(64, 64, ResourceFormat::RGBA16Float, 1, 1, data.data(), Resource::BindFlags::ShaderResource);
-
-    // Load LTSH coefficients for N=4
-    aoba::LoadArrayFromNumpy("Data/Params/sh_coeff_n4_t128.npy", d_temp);
-    convertLtshCoeff(d_temp, data);
-    //aoba::LoadArrayFromNumpy("Data/Params/sh_n4_coeff.npy", f_temp);
-    //convertLtshCoeff(f_temp, data);
-    mLtshCoeff = Texture::create2D(64 * 7, 64, ResourceFormat::RGBA16Float, 1, 1, data.data(), Resource::BindFlags::ShaderResource);
-
-    // Load LTSH matrices for N=2
-    aoba::LoadArrayFromNumpy("Data/Params/inv_sh_mat_n2_t128.npy", d_temp);
-    convertDoubleToFloat16(d_temp, data);
-    //aoba::LoadArrayFromNumpy("Data/Params/inv_sh_n2_mat.npy", f_temp);
-    //convertFloat32ToFloat16(f_temp, data);
-    mLtshMInvN2 = Texture::create2D(64, 64, ResourceFormat::RGBA16Float, 1, 1, data.data(), Resource::BindFlags::ShaderResource);
-
-    // Load LTSH coefficients for N=2
-    aoba::LoadArrayFromNumpy("Data/Params/sh_coeff_n2_t128.npy", d_temp);
-    convertLtshCoeffN2(d_temp, data);
-    //aoba::LoadArrayFromNumpy("Data/Params/sh_n2_coeff.npy", f_temp);
-    //convertLtshCoeffN2(f_temp, data);
-    mLtshCoeffN2 = Texture::create2D(64 * 3, 64, ResourceFormat::RGBA16Float, 1, 1, data.data(), Resource::BindFlags::ShaderResource);
+    loadLookupTables();
 
     // Create Sampler
     Sampler::Desc desc;
@@ -377,6 +374,172 @@ void SimpleDeferred::onLoad(SampleCallbacks* pSample, RenderContext* pRenderCont
     loadModelFromFile(skDefaultModel, pSample->getCurrentFbo().get());
 }
 
+void SimpleDeferred::uploadAreaLights()
+{
+    // grow the buffer geometrically, a new buffer needs a full upload
+    if (!mpAreaLightBuffer || mpAreaLightBuffer->getElementCount() < mAreaLights.getCount())
+    {
+        size_t capacity = std::max<size_t>(16, 2 * mAreaLights.getCount());
+        mpAreaLightBuffer = StructuredBuffer::create(mpLightingPass->getProgram(), "gAreaLights", capacity);
+        mAreaLights.markAllDirty();
+    }
+
+    // write the ranges straight into the GPU buffer, StructuredBuffer's own CPU copy would be uploaded as a whole
+    for (const AreaLightCollection::Range& range : mAreaLights.getDirtyRanges(4))
+    {
+        mpAreaLightBuffer->updateData(mAreaLights.getData() + range.first, range.first * sizeof(PackedAreaLight), range.count * sizeof(PackedAreaLight));
+    }
+    mAreaLights.clearDirty();
+}
+
+void SimpleDeferred::uploadLightSamples()
+{
+    if (!mpLightSampleBuffer)
+    {
+        mpLightSampleBuffer = StructuredBuffer::create(mpLightingPass->getProgram(), "gLightSamples", NUM_SAMPLE_SETS * NUM_SAMPLES);
+        mLightSampleUploader.invalidate();
+    }
+
+    // a static light keeps its samples, only the first frame and frames after a change upload the 4 sets
+    StructuredBufferUploadSink sink(mpLightSampleBuffer.get());
+    mLightSampleUploader.update(mpAreaLight->getSamples(), sink);
+}
+
+bool SimpleDeferred::isGroundTruthMode() const
+{
+    return mAreaLightRenderMode == AreaLightRenderMode::GroundTruth || mAreaLightRenderMode == AreaLightRenderMode::LtcBrdf || mAreaLightRenderMode == AreaLightRenderMode::LtshBrdf;
+}
+
+SampleWindow SimpleDeferred::beginProgressiveFrame(uint32_t& accumulate, uint32_t& framesBefore)
+{
+    // the first NumSamples / 4 samples of every set, like before progressive rendering
+    SampleWindow window;
+    window.count = NUM_SAMPLES / 4;
+    accumulate = kAccumulateOff;
+    framesBefore = 0;
+    if (!isGroundTruthMode() || !mProgressiveGroundTruth)
+    {
+        return window;
+    }
+
+    // everything the image depends on, the accumulation starts over when any of it changes
+    struct State
+    {
+        uint64_t sampleGeneration;
+        glm::mat4 view;
+        glm::mat4 proj;
+        PackedAreaLight light;
+        glm::vec3 ambient;
+        uint32_t mode;
+        uint32_t debugMode;
+        uint32_t ltshLookup;
+        uint32_t width;
+        uint32_t height;
+    } state;
+    std::memset(&state, 0, sizeof(state));
+    state.sampleGeneration = mpAreaLight->getSampleGeneration();
+    state.view = mpCamera->getViewMatrix();
+    state.proj = mpCamera->getProjMatrix();
+    state.light = mAreaLights.get(0);
+    state.ambient = mAmbientIntensity;
+    state.mode = (uint32_t)mAreaLightRenderMode;
+    state.debugMode = (uint32_t)mDebugMode;
+    state.ltshLookup = (uint32_t)mLtshLookup;
+    state.width = mpAccumulationTexture->getWidth();
+    state.height = mpAccumulationTexture->getHeight();
+    mProgressive.setState(&state, sizeof(state));
+    if (mAnimate) mProgressive.reset();
+
+    accumulate = mProgressive.nextFrame(window, framesBefore) ? kAccumulateAdd : kAccumulateShow;
+    return window;
+}
+
+void SimpleDeferred::loadLookupTables()
+{
+    static const std::string paramDir = "Data/Params";
+    static const std::string bundleFile = paramDir + "/luts.bundle";
+
+    // same order as LutTable
+    Texture::SharedPtr* pTextures[LutTableCount] = { &mLtcMInv, &mLtcCoeff, &mLtshMInv, &mLtshCoeff, &mLtshMInvN2, &mLtshCoeffN2 };
+
+    auto createTexture = [](LutFormat format, uint32_t width, uint32_t height, const void* pData)
+    {
+        ResourceFormat resourceFormat = format == LutFormat::R16Float ? ResourceFormat::R16Float : ResourceFormat::RGBA16Float;
+        return Texture::create2D(width, height, resourceFormat, 1, 1, pData, Resource::BindFlags::ShaderResource);
+    };
+
+    // upload straight from the mapped bundle if it was packed from the current .npy files (Source/Tools/LutPack.cpp)
+    bool loaded = false;
+    if (std::ifstream(bundleFile).good())
+    {
+        try
+        {
+            LutBundle bundle(bundleFile);
+            if (!bundle.isUpToDate(paramDir))
+            {
+                throw std::runtime_error("it was packed from other tables than the ones in " + paramDir);
+            }
+#ifdef _DEBUG
+            // release builds trust the stamps and don't read the payloads or the float64 sources
+            bundle.verify(paramDir);
+#endif
+            const LutBundle::Table* pTables[LutTableCount];
+            for (int i = 0; i < LutTableCount; i++)
+            {
+                const LutTableInfo& info = getLutTableInfo(LutTable(i));
+                pTables[i] = bundle.findTable(info.name);
+                // all tables share the resolution of the first one, the shader has a single gLutResolution
+                uint32_t res = pTables[0] ? pTables[0]->height : 0;
+                if (!pTables[i] || pTables[i]->format != info.format || pTables[i]->height != res || pTables[i]->width != getLutTextureWidth(LutTable(i), res))
+                {
+                    throw std::runtime_error(std::string("missing or mismatching table ") + info.name);
+                }
+            }
+            for (int i = 0; i < LutTableCount; i++)
+            {
+                *pTextures[i] = createTexture(pTables[i]->format, pTables[i]->width, pTables[i]->height, pTables[i]->data.data());
+            }
+            mLutResolution = pTables[0]->height;
+            loaded = true;
+        }
+        catch (const std::exception& e)
+        {
+            logWarning(std::string("Ignoring the LUT bundle: ") + e.what());
+        }
+    }
+
+    // otherwise convert the fitted .npy tables and rebuild the bundle for the next start
+    if (!loaded)
+    {
+        std::vector<PackedLut> luts;
+        for (int i = 0; i < LutTableCount; i++)
+        {
+            luts.push_back(packLookupTable(LutTable(i), paramDir));
+            if (luts[i].height != luts[0].height)
+            {
+                throw std::runtime_error(std::string("the lookup tables in ") + paramDir + " have different resolutions");
+            }
+        }
+        for (int i = 0; i < LutTableCount; i++)
+        {
+            *pTextures[i] = createTexture(luts[i].format, luts[i].width, luts[i].height, luts[i].data.data());
+        }
+        mLutResolution = luts[0].height;
+
+        try
+        {
+            writeLutBundle(bundleFile, luts);
+        }
+        catch (const std::exception& e)
+        {
+            logWarning(std::string("Could not rebuild the LUT bundle: ") + e.what());
+        }
+    }
+
+    // rebind the textures in the next frame
+    mInitTextures = true;
+}
+
 // Function to move camera back and forth between start and end points with given camera targets
 void cameraReel(uint64_t frameID, Camera::SharedPtr camera) {
     glm::vec3 startPos = glm::vec3(-1.488, 1.198, 1.764);
@@ -399,6 +562,24 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
 
     const glm::vec4 clearColor(0.38f, 0.52f, 0.10f, 1);
 
+    // the reel stops while the progressive ground truth accumulates, so the camera stays where it is
+    uint64_t frameId = pSample->getFrameID();
+    uint64_t reelFrame = mReelFrame;
+    if (!(isGroundTruthMode() && mProgressiveGroundTruth)) mReelFrame++;
+
+    // the benchmark only times the frames along the reel, warm-up and capture frames are not recorded
+    bool profileFrame = true;
+    if (mBenchmark.isEnabled())
+    {
+        BenchmarkSchedule::Frame benchmarkFrame = beginBenchmarkFrame();
+        frameId = reelFrame = benchmarkFrame.reelFrame;
+        profileFrame = benchmarkFrame.phase == BenchmarkSchedule::Phase::Timed;
+    }
+    if (profileFrame)
+    {
+        mpFrameProfiler->beginFrame(frameId, kAreaLightRenderModeNames[(uint32_t)mAreaLightRenderMode], kDebugModeNames[(uint32_t)mDebugMode]);
+    }
+
     if (mInitTextures)
     {
         mpLightingVars->setTexture("gLtcMinv", mLtcMInv);
@@ -414,10 +595,11 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
     // G-Buffer pass
     if(mpModel)
     {
+        FrameProfiler::Scope gBufferScope(*mpFrameProfiler, FrameStage::GBuffer);
         pRenderContext->clearFbo(mpGBufferFbo.get(), glm::vec4(0), 1.0f, 0, FboAttachmentType::Color | FboAttachmentType::Depth);
         pState->setFbo(mpGBufferFbo);
 
-        cameraReel(pSample->getFrameID(), mpCamera);
+        cameraReel(reelFrame, mpCamera);
 
         mpCamera->setDepthRange(mNearZ, mFarZ);
         CameraController& ActiveController = getActiveCameraController();
@@ -449,6 +631,8 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
     }
 
     // Lighting pass (fullscreen quad)
+    uint32_t accumulate = kAccumulateOff;
+    uint32_t accumulatedFrames = 0;
     {
         pState->setFbo(pTargetFbo);
         pRenderContext->clearFbo(pTargetFbo.get(), clearColor, 1.0f, 0, FboAttachmentType::Color);
@@ -459,12 +643,19 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
         pState->setDepthStencilState(mpNoDepthDS);
 
         // Set lighting params
+        mpFrameProfiler->beginStage(FrameStage::LightUpload);
         ConstantBuffer::SharedPtr pLightCB = mpLightingVars["PerImageCB"];
         pLightCB["gAmbient"] = mAmbientIntensity;
         mpDirLight->setIntoProgramVars(mpLightingVars.get(), pLightCB.get(), "gDirLight");
         mpPointLight->setIntoProgramVars(mpLightingVars.get(), pLightCB.get(), "gPointLight");
         mpAreaLight->setIntoProgramVars(mpLightingVars.get(), pLightCB.get(), "gAreaLight");
-        mpAreaLight->setPolygonIntoLighting(pLightCB.get(), "gAreaLightPosW");
+
+        // only lights that changed since the last frame are uploaded
+        mAreaLights.set(0, mpAreaLight->getPackedData());
+        uploadAreaLights();
+        mpLightingVars->setStructuredBuffer("gAreaLights", mpAreaLightBuffer);
+        pLightCB->setVariable("gAreaLightCount", mAreaLights.getCount());
+        mpFrameProfiler->endStage(FrameStage::LightUpload);
 
         // create new samples if the area light render mode changed to ground truth, stop sample creation if render mode is not ground truth
         if ((mAreaLightRenderMode == AreaLightRenderMode::GroundTruth || mAreaLightRenderMode == AreaLightRenderMode::LtcBrdf || mAreaLightRenderMode == AreaLightRenderMode::LtshBrdf) && !mpAreaLight->getSampleCreation())
@@ -478,13 +669,9 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
 
         if (mAreaLightRenderMode == AreaLightRenderMode::GroundTruth || mAreaLightRenderMode == AreaLightRenderMode::LtcBrdf || mAreaLightRenderMode == AreaLightRenderMode::LtshBrdf)
         {
-            ConstantBuffer::SharedPtr pSampleCB[4] = { mpLightingVars["SampleCB0"], mpLightingVars["SampleCB1"], mpLightingVars["SampleCB2"], mpLightingVars["SampleCB3"] };
-            std::string varNames[4] = { "lightSamples0", "lightSamples1", "lightSamples2", "lightSamples3" };
-
-            for (int i = 0; i < 4; i++)
-            {
-                mpAreaLight->setSamplesIntoProgramVars(pSampleCB[i].get(), varNames[i], i);
-            }
+            FrameProfiler::Scope sampleScope(*mpFrameProfiler, FrameStage::SampleUpload);
+            uploadLightSamples();
+            mpLightingVars->setStructuredBuffer("gLightSamples", mpLightSampleBuffer);
         } 
 
         // Set camera position
@@ -496,6 +683,20 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
         // Area light render mode
         pLightCB->setVariable("gAreaLightRenderMode", (uint32_t)mAreaLightRenderMode);
 
+        // Lookup table resolution and filtering
+        pLightCB->setVariable("gLutResolution", mLutResolution);
+        pLightCB->setVariable("gLtshLookup", (uint32_t)mLtshLookup);
+        pLightCB->setVariable("gTrigPrecision", (uint32_t)mTrigPrecision[(uint32_t)mAreaLightRenderMode]);
+
+        // samples of the ground truth modes and the progressive accumulation
+        SampleWindow window = beginProgressiveFrame(accumulate, accumulatedFrames);
+        pLightCB->setVariable("gSampleFirst", window.first);
+        pLightCB->setVariable("gSampleCount", window.count);
+        pLightCB->setVariable("gSampleSetShift", window.setShift);
+        pLightCB->setVariable("gAccumulate", accumulate);
+        pLightCB->setVariable("gAccumulatedFrames", accumulatedFrames);
+        mpLightingVars->setTexture("gAccumulation", mpAccumulationTexture);
+
         pLightCB->setVariable("gSeed", static_cast<float>(rand()) / (static_cast<float>(RAND_MAX) / 10000000.f));
 
         // Set GBuffer as input
@@ -505,6 +706,7 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
         mpLightingVars->setTexture("gGBuf3", mpGBufferFbo->getColorTexture(3));
 
         PROFILE("LightingPass");
+        FrameProfiler::Scope lightingScope(*mpFrameProfiler, FrameStage::Lighting);
 
         // Kick it off
         pRenderContext->setGraphicsVars(mpLightingVars);
@@ -514,6 +716,9 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
     auto tempTarget = mpCamera->getTarget();
     auto tempPos = mpCamera->getPosition();
 
+    bool capture = mSaveNextFrame || mDumpNextGBuffer;
+    if (capture) mpFrameProfiler->beginStage(FrameStage::Capture);
+
     if (mSaveNextFrame) {
         if (mScreenshotFbo.get() == nullptr) {
             auto desc = pTargetFbo->getDesc();
@@ -522,22 +727,151 @@ void SimpleDeferred::onFrameRender(SampleCallbacks* pSample, RenderContext* pRen
         }
         pState->setFbo(mScreenshotFbo);
         pRenderContext->clearFbo(mScreenshotFbo.get(), clearColor, 1.0f, 0, FboAttachmentType::Color);
+        // this frame is already in the history, don't add it twice
+        if (accumulate == kAccumulateAdd)
+        {
+            ConstantBuffer::SharedPtr pLightCB = mpLightingVars["PerImageCB"];
+            pLightCB->setVariable("gAccumulate", kAccumulateShow);
+        }
         mpLightingPass->execute(pRenderContext);
 
         // save newly rendered HDR image
         auto frame = mScreenshotFbo->getColorTexture(0).get();
-        frame->captureToFile(0, 0, "screenshot" + std::to_string(mSaveCount) + ".exr", Falcor::Bitmap::FileFormat::ExrFile);
+        std::string filename = mSaveName.empty() ? "screenshot" + std::to_string(mSaveCount) : mSaveName;
+        frame->captureToFile(0, 0, filename + ".exr", Falcor::Bitmap::FileFormat::ExrFile);
 
         // save png
         auto png_frame = pTargetFbo->getColorTexture(0).get();
-        png_frame->captureToFile(0, 0, "screenshot" + std::to_string(mSaveCount) + ".png");
+        png_frame->captureToFile(0, 0, filename + ".png");
         mSaveNextFrame = false;
-        mSaveCount++;
+        if (mSaveName.empty()) mSaveCount++;
+        mSaveName.clear();
     }
+
+    if (mDumpNextGBuffer)
+    {
+        dumpGBuffer(pRenderContext);
+        mDumpNextGBuffer = false;
+        mDumpCount++;
+    }
+
+    if (capture) mpFrameProfiler->endStage(FrameStage::Capture);
+    mpFrameProfiler->endFrame();
+
+    if (mBenchmark.isEnabled())
+    {
+        endBenchmarkFrame(pSample);
+    }
+}
+
+BenchmarkSchedule::Frame SimpleDeferred::beginBenchmarkFrame()
+{
+    BenchmarkSchedule::Frame frame = mBenchmark.getFrame(mBenchmarkFrame);
+    if (mChangeModeIt != mChangeModeFrames.end() && mBenchmarkFrame == *mChangeModeIt)
+    {
+        mAreaLightRenderMode = (AreaLightRenderMode)frame.mode;
+        logInfo(std::string("Benchmark: ") + kAreaLightRenderModeNames[frame.mode]);
+        ++mChangeModeIt;
+    }
+    if (frame.phase == BenchmarkSchedule::Phase::Capture)
+    {
+        mSaveNextFrame = true;
+        mSaveName = std::string("benchmark_") + kAreaLightRenderModeNames[frame.mode] + "_" + std::to_string(frame.reelFrame);
+    }
+    return frame;
+}
+
+void SimpleDeferred::endBenchmarkFrame(SampleCallbacks* pSample)
+{
+    mBenchmarkFrame++;
+    if (mBenchmarkFrame < mBenchmark.getTotalFrames()) return;
+
+    // the GPU times of the last timed frames are still pending
+    mpFrameProfiler->flush();
+    for (uint32_t mode : mBenchmark.getSettings().modes)
+    {
+        const char* name = kAreaLightRenderModeNames[mode];
+        mpFrameProfiler->writeSummary(mBenchmarkLog, name);
+        FrameProfiler::Percentiles frame = mpFrameProfiler->getFramePercentiles(name);
+        FrameProfiler::Percentiles lighting = mpFrameProfiler->getPercentiles(FrameStage::Lighting, true, name);
+        char line[192];
+        snprintf(line, sizeof(line), "%-10s frame cpu %.3f / %.3f ms  lighting gpu %.3f / %.3f ms (p50 / p99, %u frames)",
+                 name, frame.p50, frame.p99, lighting.p50, lighting.p99, frame.count);
+        logInfo(line);
+    }
+    mpFrameProfiler->setJsonStream(nullptr);
+    mBenchmarkLog.close();
+    logInfo("Benchmark results written to " + mBenchmark.getSettings().outputFile);
+    pSample->shutdownApp();
+}
+
+void SimpleDeferred::setFrameTimeRecording(bool enabled)
+{
+    // the benchmark owns the JSON stream of the profiler
+    if (enabled == mRecordFrameTimes || mBenchmark.isEnabled()) return;
+    if (enabled)
+    {
+        std::string filename = "frametimes" + std::to_string(mFrameTimeLogCount++) + ".jsonl";
+        mFrameTimeLog.open(filename);
+        if (!mFrameTimeLog)
+        {
+            logError("Can't write " + filename);
+            return;
+        }
+        mpFrameProfiler->setJsonStream(&mFrameTimeLog);
+    }
+    else
+    {
+        // the last frames are still waiting for their GPU times, the summary covers the frames in the history
+        mpFrameProfiler->flush();
+        for (const char* mode : kAreaLightRenderModeNames)
+        {
+            if (mpFrameProfiler->getFramePercentiles(mode).count > 0) mpFrameProfiler->writeSummary(mFrameTimeLog, mode);
+        }
+        mpFrameProfiler->setJsonStream(nullptr);
+        mFrameTimeLog.close();
+    }
+    mRecordFrameTimes = enabled;
+}
+
+void SimpleDeferred::dumpGBuffer(RenderContext* pRenderContext)
+{
+    ltsh::GBufferFrame frame;
+    frame.width = mpGBufferFbo->getWidth();
+    frame.height = mpGBufferFbo->getHeight();
+
+    // the targets are RGBA16F, convert them to float for the .npy files
+    std::vector<ltsh::float4>* buffers[4] = { &frame.posLightFlag, &frame.normalLinearRoughness, &frame.albedo, &frame.specularRoughness };
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        std::vector<uint8_t> texData = pRenderContext->readTextureSubresource(mpGBufferFbo->getColorTexture(i).get(), 0);
+        const glm::detail::hdata* halfData = reinterpret_cast<const glm::detail::hdata*>(texData.data());
+        buffers[i]->resize(frame.getPixelCount());
+        for (size_t p = 0; p < frame.getPixelCount(); p++)
+        {
+            (*buffers[i])[p] = ltsh::float4(glm::detail::toFloat32(halfData[4 * p + 0]), glm::detail::toFloat32(halfData[4 * p + 1]),
+                                            glm::detail::toFloat32(halfData[4 * p + 2]), glm::detail::toFloat32(halfData[4 * p + 3]));
+        }
+    }
+
+    auto toFloat3 = [](const glm::vec3& v) { return ltsh::float3(v.x, v.y, v.z); };
+    const LightData& lightData = mpAreaLight->getData();
+    frame.camPosW = toFloat3(mpCamera->getPosition());
+    frame.areaLight.posW = toFloat3(lightData.posW);
+    frame.areaLight.dirW = toFloat3(lightData.dirW);
+    frame.areaLight.intensity = toFloat3(lightData.intensity);
+    frame.areaLight.surfaceArea = lightData.surfaceArea;
+    for (const glm::vec3& v : mpAreaLight->getTransformedVertices())
+    {
+        frame.areaLightPosW.push_back(toFloat3(v));
+    }
+
+    frame.save("gbuffer" + std::to_string(mDumpCount));
 }
 
 void SimpleDeferred::onShutdown(SampleCallbacks* pSample)
 {
+    setFrameTimeRecording(false);
     mpModel.reset();
 }
 
@@ -556,6 +890,9 @@ bool SimpleDeferred::onKeyEvent(SampleCallbacks* pSample, const KeyboardEvent& k
             case KeyboardEvent::Key::K:
                 mSaveNextFrame = true;
                 break;
+            case KeyboardEvent::Key::G:
+                mDumpNextGBuffer = true;
+                break;
             default:
                 bHandled = false;
             }
@@ -583,6 +920,10 @@ void SimpleDeferred::onResizeSwapChain(SampleCallbacks* pSample, uint32_t width,
         .setColorTarget(3, Falcor::ResourceFormat::RGBA16Float)
         .setDepthStencilTarget(Falcor::ResourceFormat::D32Float);
     mpGBufferFbo = FboHelper::create2D(width, height, fboDesc);
+
+    // running mean of the progressive ground truth in full float precision
+    mpAccumulationTexture = Texture::create2D(width, height, ResourceFormat::RGBA32Float, 1, 1, nullptr, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess);
+    mProgressive.reset();
 }
 
 void SimpleDeferred::resetCamera()
@@ -612,6 +953,18 @@ void SimpleDeferred::resetCamera()
 int main(int argc, char** argv)
 {
     SimpleDeferred::UniquePtr pRenderer = std::make_unique<SimpleDeferred>();
+    try
+    {
+        // LTC against both LTSH variants unless --bench-modes says otherwise
+        std::vector<uint32_t> defaultModes = { 1, 2, 6 };
+        pRenderer->setBenchmark(parseBenchmarkArgs(argc, argv, kAreaLightRenderModeNames, (uint32_t)arraysize(kAreaLightRenderModeNames), defaultModes));
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "%s\nusage: --benchmark [--bench-modes LTC,LTSH_N4,LTSH_N2] [--bench-frames 600] [--bench-warmup 60] "
+                        "[--bench-capture 0,150,300] [--bench-out benchmark.jsonl]\n", e.what());
+        return 1;
+    }
     SampleConfig config;
     config.windowDesc.width = 1280;
     config.windowDesc.height = 720;
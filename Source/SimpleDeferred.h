@@ -28,6 +28,13 @@
 #pragma once
 #include "Falcor.h"
 #include "SimpleAreaLight.h"
+#include "FrameProfiler.h"
+#include "BenchmarkSchedule.h"
+#include "ProgressiveAccumulation.h"
+#include "GpuTimerBackend.h"
+#include <array>
+#include <fstream>
+#include <memory>
 
 using namespace Falcor;
 
@@ -43,11 +50,24 @@ public:
     bool onKeyEvent(SampleCallbacks* pSample, const KeyboardEvent& keyEvent) override;
     bool onMouseEvent(SampleCallbacks* pSample, const MouseEvent& mouseEvent) override;
     void onGuiRender(SampleCallbacks* pSample, Gui* pGui) override;
+
+    /** Run the scripted benchmark instead of the interactive mode, call before Sample::run()
+    */
+    void setBenchmark(const BenchmarkSettings& settings) { mBenchmark = BenchmarkSchedule(settings); }
 private:
     void loadModel(Fbo* pTargetFbo);
     void loadModelFromFile(const std::string& filename, Fbo* pTargetFbo);
     void resetCamera();
     void renderModelUiElements(Gui* pGui);
+    void dumpGBuffer(RenderContext* pRenderContext);
+    void loadLookupTables();
+    void uploadAreaLights();
+    void uploadLightSamples();
+    bool isGroundTruthMode() const;
+    SampleWindow beginProgressiveFrame(uint32_t& accumulate, uint32_t& framesBefore);
+    void setFrameTimeRecording(bool enabled);
+    BenchmarkSchedule::Frame beginBenchmarkFrame();
+    void endBenchmarkFrame(SampleCallbacks* pSample);
 
     Model::SharedPtr mpModel = nullptr;
     ModelViewCameraController mModelViewCameraController;
@@ -104,6 +124,32 @@ private:
         LTSH_N2,
     } mAreaLightRenderMode = AreaLightRenderMode::GroundTruth;
 
+    // how the LTSH modes fetch matrix and coefficients between the (theta, alpha) cells, same values as LightingPass.ps.hlsl
+    enum class LtshLookup: uint32_t
+    {
+        Dithered = 0,
+        Bilinear,
+    } mLtshLookup = LtshLookup::Dithered;
+
+    // approximation of acos, sincos and atan2 in the edge integrals, same values as the Trig* constants in FastMath.slang
+    enum class TrigPrecision: uint32_t
+    {
+        Exact = 0,
+        Medium,
+        Fast,
+    };
+    // chosen per render mode, only LTC, LTSH_N4 and LTSH_N2 integrate over edges
+    std::array<TrigPrecision, (uint32_t)AreaLightRenderMode::LTSH_N2 + 1> mTrigPrecision = {};
+
+    // progressive ground truth: the ground truth modes evaluate mProgressiveSamples samples per frame and average the
+    // frames in mpAccumulationTexture until the camera, the light or the settings change
+    bool mProgressiveGroundTruth = false;
+    uint32_t mProgressiveSamples = 64;
+    ProgressiveAccumulation mProgressive = ProgressiveAccumulation(NUM_SAMPLES, NUM_SAMPLE_SETS, 64);
+    Texture::SharedPtr mpAccumulationTexture;
+    // frame of the camera reel, held while the progressive ground truth accumulates
+    uint64_t mReelFrame = 0;
+
     DepthStencilState::SharedPtr mpNoDepthDS;
     DepthStencilState::SharedPtr mpDepthTestDS;
     BlendState::SharedPtr mpOpaqueBS;
@@ -115,13 +161,25 @@ private:
     PointLight::SharedPtr mpPointLight;
     SimpleAreaLight::SharedPtr mpAreaLight;
 
+    // all area lights of the lighting pass, mpAreaLight is light 0
+    AreaLightCollection mAreaLights;
+    StructuredBuffer::SharedPtr mpAreaLightBuffer;
+
+    // ground truth samples of mpAreaLight, uploaded only when the light's sample generation changes
+    StructuredBuffer::SharedPtr mpLightSampleBuffer;
+    SampleBufferUploader mLightSampleUploader;
+
     float mNearZ = 1e-2f;
     float mFarZ = 1e3f;
 
     static const std::string skDefaultModel;
 
+    // scripted benchmark, the render mode switches at the frames of mChangeModeFrames
+    BenchmarkSchedule mBenchmark;
+    uint64_t mBenchmarkFrame = 0;
     std::vector<uint32_t> mChangeModeFrames;
     std::vector<uint32_t>::iterator mChangeModeIt;
+    std::ofstream mBenchmarkLog;
 
     Texture::SharedPtr mLtcMInv;
     Texture::SharedPtr mLtcCoeff;
@@ -133,8 +191,24 @@ private:
     Texture::SharedPtr mLtshMInvN2;
     Texture::SharedPtr mLtshCoeffN2;
 
+    // cells along theta and alpha of all lookup tables, read from the table files
+    uint32_t mLutResolution = 64;
+
     Fbo::SharedPtr mScreenshotFbo;
     bool mInitTextures = true;
     bool mSaveNextFrame = false;
     int mSaveCount = 0;
+    // file name of the next screenshot without extension, screenshot<mSaveCount> if empty
+    std::string mSaveName;
+
+    // write the G-buffer and light state of the next frame for the CPU renderer (Source/Tools/LtshRender.cpp)
+    bool mDumpNextGBuffer = false;
+    int mDumpCount = 0;
+
+    // per-stage CPU and GPU times of the last frames, written to frametimes<N>.jsonl while recording
+    std::unique_ptr<GpuTimerBackend> mpTimerBackend;
+    std::unique_ptr<FrameProfiler> mpFrameProfiler;
+    bool mRecordFrameTimes = false;
+    std::ofstream mFrameTimeLog;
+    int mFrameTimeLogCount = 0;
 };
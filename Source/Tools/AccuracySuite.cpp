@@ -0,0 +1,505 @@
+// Accuracy regression suite of the render modes. Generates random convex lights with 3 to 8 vertices and random
+// shading points around them (view angle, roughness and normal per point), computes the specular integral of the
+// ground truth BRDF (GGX with F0 0.4 and Schlick's Fresnel, as the lighting pass sets it) in double precision with
+// adaptive quadrature over the light, see Reference/PolygonQuadrature.h, and compares every mode of
+// CpuLightingPass against it. The Lambertian integral of the same quadrature is checked against the closed form.
+//
+// usage: ltsh_accuracy [--params Data/Params] [--lights 256] [--points 32] [--threads 0] [--trig exact|medium|fast]
+//                      [--tolerance 1e-7] [--save file] [--check file] [--slack 0.02] [--convergence 4096]
+//                      [--light-scale 1]
+//
+// --save writes the error table as a baseline, --check compares against one and exits with 2 if the relative RMSE
+// or max. error of any mode grew by more than the slack, so changes of the tables or the kernels can be gated on
+// accuracy, e.g. --trig fast against a baseline saved with exact trig. The configurations depend only on --lights,
+// --points and --light-scale, the baseline records them. Errors are relative to the mean reference of all points,
+// the roughness columns to the mean of their band. The None mode has no specular term and is not listed.
+//
+// --convergence prints the error of the ground truth (uniform light samples) and of gt_mis (light samples and LTC
+// lobe samples combined by multiple importance sampling) for sample budgets of 4, 16, 64, ... up to the given count
+// per point. gt_mis splits the budget evenly between its two strategies, so both columns cost the same number of BRDF
+// evaluations. --light-scale scales the light polygons; light sampling is already close to optimal for the default
+// lights, the lobe samples pay off once a light is large against the GGX lobe, e.g. --light-scale 2 or 4.
+
+#include "Reference/LightingPass.h"
+#include "Reference/LtshFitter.h"
+#include "Reference/LTC.h"
+#include "Reference/PolygonQuadrature.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    typedef CpuLightingPass::AreaLightRenderMode Mode;
+    typedef CpuLightingPass::LtshLookup Lookup;
+
+    struct ModeConfig
+    {
+        const char* name;
+        Mode mode;
+        Lookup lookup;
+    };
+
+    const ModeConfig kModes[] =
+    {
+        { "gt", Mode::GroundTruth, Lookup::Dithered },
+        { "ltc", Mode::LTC, Lookup::Dithered },
+        { "ltsh", Mode::LTSH, Lookup::Dithered },
+        { "ltsh_bilinear", Mode::LTSH, Lookup::Bilinear },
+        { "ltsh_n2", Mode::LTSH_N2, Lookup::Dithered },
+        { "ltsh_n2_bilinear", Mode::LTSH_N2, Lookup::Bilinear },
+        { "ltc_brdf", Mode::LtcBrdf, Lookup::Dithered },
+        { "ltsh_brdf", Mode::LtshBrdf, Lookup::Dithered },
+        { "gt_mis", Mode::GroundTruthMis, Lookup::Dithered },
+    };
+    const size_t kNumModes = sizeof(kModes) / sizeof(kModes[0]);
+
+    // roughness of the points, the ground truth clamps to 0.1
+    const float kMinRoughness = 0.1f;
+    const float kMaxRoughness = 1.f;
+    // upper bounds of the roughness bands of the error table
+    const float kBands[] = { 0.3f, 0.6f, 1.f };
+    const int kNumBands = 3;
+
+    void printUsage()
+    {
+        std::printf("usage: ltsh_accuracy [--params Data/Params] [--lights 256] [--points 32] [--threads 0] [--trig exact|medium|fast]\n"
+                    "                     [--tolerance 1e-7] [--save file] [--check file] [--slack 0.02] [--convergence 4096]\n"
+                    "                     [--light-scale 1]\n");
+    }
+
+    float3 randomDirection(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+        float z = 2.f * u(rng) - 1.f;
+        float phi = 2.f * float(kPi) * u(rng);
+        float r = std::sqrt(std::max(1.f - z * z, 0.f));
+        return float3(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    /** Any two unit vectors orthogonal to n and each other
+    */
+    void buildFrame(const float3& n, float3& t1, float3& t2)
+    {
+        t1 = normalize(cross(std::abs(n.z) < 0.9f ? float3(0.f, 0.f, 1.f) : float3(1.f, 0.f, 0.f), n));
+        t2 = cross(n, t1);
+    }
+
+    /** One light around the origin and a row of shading points, each with its own normal and roughness
+        \param[in] lightScale Scales the semi-axes of the light, the shading points stay where they are
+    */
+    GBufferFrame generateFrame(uint32_t lightIndex, uint32_t numPoints, float lightScale)
+    {
+        std::mt19937 rng(9176u + 7919u * lightIndex);
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+
+        GBufferFrame frame;
+        frame.width = numPoints;
+        frame.height = 1;
+        frame.posLightFlag.resize(numPoints);
+        frame.normalLinearRoughness.resize(numPoints);
+        frame.albedo.resize(numPoints);
+        frame.specularRoughness.resize(numPoints);
+
+        // a convex polygon on an ellipse, the vertex angles are jittered within their sector
+        float3 lightN = randomDirection(rng);
+        float3 axisX, axisY;
+        buildFrame(lightN, axisX, axisY);
+        int numVertices = 3 + int(rng() % (kMaxPolygonVertices - 2));
+        float sx = lightScale * (0.3f + 0.9f * u(rng)), sy = lightScale * (0.3f + 0.9f * u(rng));
+        float phi0 = 2.f * float(kPi) * u(rng);
+        frame.areaLightPosW.resize(numVertices);
+        for (int i = 0; i < numVertices; i++)
+        {
+            float phi = phi0 + 2.f * float(kPi) * (i + 0.8f * (u(rng) - 0.5f)) / numVertices;
+            frame.areaLightPosW[i] = axisX * (sx * std::cos(phi)) + axisY * (sy * std::sin(phi));
+        }
+        float3 areaVector;
+        for (int i = 0; i < numVertices; i++)
+        {
+            areaVector += cross(frame.areaLightPosW[i], frame.areaLightPosW[(i + 1) % numVertices]);
+        }
+        frame.areaLight.posW = float3(0.f);
+        frame.areaLight.dirW = lightN;
+        frame.areaLight.intensity = float3(1.f);
+        frame.areaLight.surfaceArea = 0.5f * length(areaVector);
+
+        frame.camPosW = randomDirection(rng) * (4.f + 4.f * u(rng));
+        for (uint32_t i = 0; i < numPoints; i++)
+        {
+            float3 posW, N;
+            for (bool found = false; !found;)
+            {
+                posW = randomDirection(rng) * (1.5f + 3.f * u(rng));
+                float3 V = normalize(frame.camPosW - posW);
+                float3 t1, t2;
+                buildFrame(V, t1, t2);
+                // view angles up to 87 degrees, the normal is rotated around V until the light center is at most
+                // slightly below the horizon, so most points see at least part of the light
+                float theta = 0.4775f * float(kPi) * u(rng);
+                for (int attempt = 0; attempt < 16 && !found; attempt++)
+                {
+                    float phi = 2.f * float(kPi) * u(rng);
+                    N = V * std::cos(theta) + (t1 * std::cos(phi) + t2 * std::sin(phi)) * std::sin(theta);
+                    found = dot(N, normalize(-posW)) > -0.3f;
+                }
+            }
+            float t = std::sqrt(kMinRoughness) + (1.f - std::sqrt(kMinRoughness)) * u(rng);
+            float roughness = std::min(t * t, kMaxRoughness);
+            frame.posLightFlag[i] = float4(posW, 0.f);
+            frame.normalLinearRoughness[i] = float4(N, std::sqrt(roughness));
+            frame.albedo[i] = float4(0.5f, 0.5f, 0.5f, 1.f);
+            // white specular color, so the specular term is the integral of the BRDF alone
+            frame.specularRoughness[i] = float4(float3(1.f), roughness);
+        }
+        return frame;
+    }
+
+    struct Reference
+    {
+        double specular = 0;
+        double roughness = 0;
+        double cosine = 0;          // quadrature of the Lambertian lobe
+        double cosineClosedForm = 0;
+        QuadratureStats stats;
+    };
+
+    /** Specular integral of the shading point as CpuLightingPass::shadePixel() sets it up, in double precision
+    */
+    Reference computeReference(const GBufferFrame& frame, uint32_t index, const QuadratureSettings& settings)
+    {
+        double3 posW(frame.posLightFlag[index].xyz());
+        double3 N(frame.normalLinearRoughness[index].xyz());
+        double3 V = normalize(double3(frame.camPosW) - posW);
+        double NdotV = std::abs(dot(V, N));
+        double3 T1 = normalize(V - N * NdotV);
+        double3 T2 = cross(N, T1);
+
+        double3 polygon[kMaxPolygonVertices];
+        int numVertices = int(frame.areaLightPosW.size());
+        for (int i = 0; i < numVertices; i++)
+        {
+            double3 p = double3(frame.areaLightPosW[i]) - posW;
+            polygon[i] = double3(dot(T1, p), dot(T2, p), dot(N, p));
+        }
+
+        Reference ref;
+        GgxLobe lobe;
+        lobe.alpha = std::max(double(frame.specularRoughness[index].w), 0.1);
+        lobe.f0 = 0.4;
+        lobe.schlickFresnel = true;
+        lobe.V = double3(std::sqrt(std::max(1.0 - NdotV * NdotV, 0.0)), 0.0, NdotV);
+        ref.roughness = lobe.alpha;
+        ref.specular = integratePolygon(polygon, numVertices, [&](const double3& L) { return lobe.eval(L); }, settings, &ref.stats);
+
+        // the Lambertian lobe against the closed form of the LTC edge integral, which is 2 pi times the form factor
+        QuadratureStats cosineStats;
+        ref.cosine = integratePolygon(polygon, numVertices, [](const double3& L) { return L.z * kInvPi; }, settings, &cosineStats);
+        ref.cosineClosedForm = ltcEvaluate(double3(0, 0, 1), double3(1, 0, 0), double3(0), double3x3(), polygon, numVertices, true, double3(1)).x / (2.0 * kPi);
+        return ref;
+    }
+
+    struct ModeError
+    {
+        double rmse = 0;            // relative to the mean reference
+        double max = 0;             // relative to the mean reference
+        double bias = 0;            // relative to the mean reference
+        double bandRmse[kNumBands] = {};
+    };
+
+    ModeError measure(const std::vector<Reference>& refs, const std::vector<float>& values)
+    {
+        ModeError err;
+        double sumRef = 0, sumSq = 0, sum = 0, maxErr = 0;
+        double bandRef[kNumBands] = {}, bandSq[kNumBands] = {};
+        size_t bandCount[kNumBands] = {};
+        for (size_t i = 0; i < refs.size(); i++)
+        {
+            double d = values[i] - refs[i].specular;
+            sumRef += refs[i].specular;
+            sumSq += d * d;
+            sum += d;
+            maxErr = std::max(maxErr, std::abs(d));
+            int band = 0;
+            while (band + 1 < kNumBands && refs[i].roughness >= kBands[band]) band++;
+            bandRef[band] += refs[i].specular;
+            bandSq[band] += d * d;
+            bandCount[band]++;
+        }
+        double n = double(std::max<size_t>(refs.size(), 1));
+        double mean = std::max(sumRef / n, 1e-30);
+        err.rmse = std::sqrt(sumSq / n) / mean;
+        err.max = maxErr / mean;
+        err.bias = sum / n / mean;
+        for (int b = 0; b < kNumBands; b++)
+        {
+            double count = double(std::max<size_t>(bandCount[b], 1));
+            err.bandRmse[b] = std::sqrt(bandSq[b] / count) / std::max(bandRef[b] / count, 1e-30);
+        }
+        return err;
+    }
+
+    std::string configLine(uint32_t numLights, uint32_t numPoints, float lightScale)
+    {
+        std::string line = "config lights " + std::to_string(numLights) + " points " + std::to_string(numPoints);
+        if (lightScale != 1.f)
+        {
+            char scale[32];
+            std::snprintf(scale, sizeof(scale), " light scale %g", lightScale);
+            line += scale;
+        }
+        return line;
+    }
+
+    void saveBaseline(const std::string& path, const std::string& config, const ModeError* errors)
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("can't write " + path);
+        }
+        file << config << "\n";
+        char line[256];
+        for (size_t m = 0; m < kNumModes; m++)
+        {
+            std::snprintf(line, sizeof(line), "%s %.6e %.6e\n", kModes[m].name, errors[m].rmse, errors[m].max);
+            file << line;
+        }
+    }
+
+    /** \return Number of modes whose error exceeds the baseline by more than the slack
+    */
+    int checkBaseline(const std::string& path, const std::string& config, const ModeError* errors, double slack)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("can't read " + path);
+        }
+        std::string line;
+        std::getline(file, line);
+        if (line != config)
+        {
+            throw std::runtime_error(path + " was made with \"" + line + "\", this run is \"" + config + "\"");
+        }
+
+        int regressions = 0;
+        while (std::getline(file, line))
+        {
+            std::istringstream in(line);
+            std::string name;
+            double rmse, max;
+            if (!(in >> name >> rmse >> max)) continue;
+            for (size_t m = 0; m < kNumModes; m++)
+            {
+                if (name != kModes[m].name) continue;
+                // the absolute term keeps modes at the rounding error from failing on compiler differences
+                bool rmseFailed = errors[m].rmse > rmse * (1 + slack) + 1e-6;
+                bool maxFailed = errors[m].max > max * (1 + slack) + 1e-6;
+                if (rmseFailed || maxFailed)
+                {
+                    std::printf("REGRESSION %-18s rmse %.3e (baseline %.3e), max %.3e (baseline %.3e)\n", name.c_str(), errors[m].rmse, rmse,
+                                errors[m].max, max);
+                    regressions++;
+                }
+            }
+        }
+        return regressions;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string paramDir = "Data/Params";
+    std::string savePath, checkPath;
+    std::string trigName = "exact";
+    uint32_t numLights = 256;
+    uint32_t numPoints = 32;
+    uint32_t numThreads = 0;
+    uint32_t maxConvergenceSamples = 0;
+    float lightScale = 1.f;
+    double slack = 0.02;
+    QuadratureSettings settings;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--params") paramDir = value;
+        else if (arg == "--lights") numLights = (uint32_t)std::atoi(value);
+        else if (arg == "--points") numPoints = (uint32_t)std::atoi(value);
+        else if (arg == "--threads") numThreads = (uint32_t)std::atoi(value);
+        else if (arg == "--trig") trigName = value;
+        else if (arg == "--tolerance") settings.relTolerance = std::atof(value);
+        else if (arg == "--save") savePath = value;
+        else if (arg == "--check") checkPath = value;
+        else if (arg == "--slack") slack = std::atof(value);
+        else if (arg == "--convergence") maxConvergenceSamples = (uint32_t)std::atoi(value);
+        else if (arg == "--light-scale") lightScale = float(std::atof(value));
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    TrigPrecision trig;
+    if (trigName == "exact") trig = TrigPrecision::Exact;
+    else if (trigName == "medium") trig = TrigPrecision::Medium;
+    else if (trigName == "fast") trig = TrigPrecision::Fast;
+    else
+    {
+        printUsage();
+        return 1;
+    }
+    if (numLights == 0 || numPoints == 0 || maxConvergenceSamples > uint32_t(CpuLightingPass::kNumSamples) || !(lightScale > 0))
+    {
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        LutTables tables;
+        tables.load(paramDir);
+        ThreadPool pool(numThreads);
+
+        size_t count = size_t(numLights) * numPoints;
+        std::vector<Reference> refs(count);
+        std::vector<std::vector<float>> values(kNumModes, std::vector<float>(count));
+
+        // sample budgets of the convergence table, the values of gt and gt_mis per budget
+        std::vector<uint32_t> budgets;
+        for (uint32_t budget = 4; budget <= maxConvergenceSamples; budget *= 4)
+        {
+            budgets.push_back(budget);
+        }
+        std::vector<std::vector<float>> convergence(2 * budgets.size(), std::vector<float>(count));
+
+        auto start = std::chrono::high_resolution_clock::now();
+        pool.parallelFor(numLights, [&](size_t lightIndex, uint32_t)
+        {
+            GBufferFrame frame = generateFrame(uint32_t(lightIndex), numPoints, lightScale);
+            CpuLightingPass pass(tables);
+            for (size_t m = 0; m < kNumModes; m++)
+            {
+                pass.setTrigPrecision(kModes[m].mode, trig);
+            }
+            pass.setFrame(frame);
+
+            for (uint32_t i = 0; i < numPoints; i++)
+            {
+                size_t index = lightIndex * numPoints + i;
+                refs[index] = computeReference(frame, i, settings);
+                for (size_t m = 0; m < kNumModes; m++)
+                {
+                    pass.setLtshLookup(kModes[m].lookup);
+                    values[m][index] = pass.shadePixel(i, 0, kModes[m].mode, CpuLightingPass::DebugMode::ShowSpecular).x;
+                }
+            }
+
+            SampleWindow defaultWindow = pass.getSampleWindow();
+            for (size_t b = 0; b < budgets.size(); b++)
+            {
+                SampleWindow window;
+                window.count = budgets[b];
+                pass.setSampleWindow(window);
+                for (uint32_t i = 0; i < numPoints; i++)
+                {
+                    convergence[2 * b][lightIndex * numPoints + i] = pass.shadePixel(i, 0, Mode::GroundTruth, CpuLightingPass::DebugMode::ShowSpecular).x;
+                }
+                window.count = budgets[b] / 2;
+                pass.setSampleWindow(window);
+                for (uint32_t i = 0; i < numPoints; i++)
+                {
+                    convergence[2 * b + 1][lightIndex * numPoints + i] = pass.shadePixel(i, 0, Mode::GroundTruthMis, CpuLightingPass::DebugMode::ShowSpecular).x;
+                }
+            }
+            pass.setSampleWindow(defaultWindow);
+        });
+        auto end = std::chrono::high_resolution_clock::now();
+
+        uint64_t evaluations = 0;
+        double maxEstimate = 0, maxCosineError = 0, sumRef = 0, sumCosine = 0;
+        size_t unconverged = 0, visible = 0;
+        for (const Reference& ref : refs)
+        {
+            evaluations += ref.stats.evaluations;
+            maxEstimate = std::max(maxEstimate, ref.stats.errorEstimate);
+            maxCosineError = std::max(maxCosineError, std::abs(ref.cosine - ref.cosineClosedForm));
+            unconverged += ref.stats.converged ? 0 : 1;
+            visible += ref.specular > 0 ? 1 : 0;
+            sumRef += ref.specular;
+            sumCosine += ref.cosineClosedForm;
+        }
+        double meanRef = std::max(sumRef / count, 1e-30);
+        double meanCosine = std::max(sumCosine / count, 1e-30);
+
+        std::printf("%zu shading points (%zu see the light), %u lights with 3 to %d vertices, roughness %.1f to %.1f, trig %s\n", count, visible,
+                    numLights, kMaxPolygonVertices, kMinRoughness, kMaxRoughness, trigName.c_str());
+        std::printf("reference: %.3g evaluations, %.1f s including the modes, %zu points above the tolerance\n", double(evaluations),
+                    std::chrono::duration<double>(end - start).count(), unconverged);
+        std::printf("max. estimated error %.1e, max. error of the Lambertian lobe against its closed form %.1e (relative to the mean)\n",
+                    maxEstimate / meanRef, maxCosineError / meanCosine);
+        std::printf("mean specular %.4g, errors relative to the mean\n\n", meanRef);
+
+        ModeError errors[kNumModes];
+        std::printf("%-18s %10s %10s %10s %12s %12s %12s\n", "mode", "rel rmse", "rel max", "bias", "rmse a<0.3", "rmse a<0.6", "rmse a>=0.6");
+        for (size_t m = 0; m < kNumModes; m++)
+        {
+            errors[m] = measure(refs, values[m]);
+            std::printf("%-18s %10.4f %10.4f %10.4f %12.4f %12.4f %12.4f\n", kModes[m].name, errors[m].rmse, errors[m].max, errors[m].bias,
+                        errors[m].bandRmse[0], errors[m].bandRmse[1], errors[m].bandRmse[2]);
+        }
+
+        if (!budgets.empty())
+        {
+            std::printf("\n%-18s %10s %10s %10s\n", "samples per point", "gt rmse", "mis rmse", "gain");
+            for (size_t b = 0; b < budgets.size(); b++)
+            {
+                double gt = measure(refs, convergence[2 * b]).rmse;
+                double mis = measure(refs, convergence[2 * b + 1]).rmse;
+                std::printf("%-18u %10.4f %10.4f %10.1f\n", budgets[b], gt, mis, gt / std::max(mis, 1e-30));
+            }
+        }
+
+        std::string config = configLine(numLights, numPoints, lightScale);
+        if (!savePath.empty())
+        {
+            saveBaseline(savePath, config, errors);
+            std::printf("\nbaseline written to %s\n", savePath.c_str());
+        }
+        if (!checkPath.empty())
+        {
+            int regressions = checkBaseline(checkPath, config, errors, slack);
+            if (regressions > 0)
+            {
+                std::printf("\n%d of %zu modes are less accurate than %s\n", regressions, kNumModes, checkPath.c_str());
+                return 2;
+            }
+            std::printf("\nall modes within %.0f%% of %s\n", slack * 100, checkPath.c_str());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
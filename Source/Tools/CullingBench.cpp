@@ -0,0 +1,307 @@
+// Efficiency of the tiled area light culling. Generates a G-buffer of a large room with pillars seen from one
+// end, lit by panel lights on the ceiling, the walls and the pillars, and reports how many lights survive per tile for several tile sizes
+// and distance thresholds, the culling time, and the shading time and error with and without culling.
+//
+// usage: culling_bench [lights=128] [params=Data/Params] [threads=0] [width=320] [height=180]
+
+#include "Reference/LightingPass.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    typedef CpuLightingPass::AreaLightRenderMode Mode;
+
+    // the room spans [-kRoomHalfWidth, kRoomHalfWidth] in x and z and [0, kRoomHeight] in y
+    const float kRoomHalfWidth = 12.f;
+    const float kRoomHeight = 4.f;
+    // square pillars from floor to ceiling on a 3 x 3 grid, they hide lights from the surfaces behind them
+    const float kPillarSpacing = 6.f;
+    const float kPillarHalfWidth = 0.6f;
+
+    float3 getPillarCenter(int i)
+    {
+        return float3(float(i % 3 - 1) * kPillarSpacing, 0.5f * kRoomHeight, float(i / 3 - 1) * kPillarSpacing);
+    }
+
+    /** Ray cast the inside of the room from a camera at one end, every pixel hits a wall, the floor, the ceiling
+        or a pillar
+    */
+    GBufferFrame generateRoom(uint32_t width, uint32_t height)
+    {
+        GBufferFrame frame;
+        frame.width = width;
+        frame.height = height;
+        frame.posLightFlag.resize(frame.getPixelCount());
+        frame.normalLinearRoughness.resize(frame.getPixelCount());
+        frame.albedo.resize(frame.getPixelCount());
+        frame.specularRoughness.resize(frame.getPixelCount());
+
+        frame.camPosW = float3(0.f, 1.7f, -kRoomHalfWidth + 0.5f);
+        float3 forward = normalize(float3(0.f, -0.15f, 1.f));
+        float3 right = normalize(cross(float3(0.f, 1.f, 0.f), forward));
+        float3 up = cross(forward, right);
+        float tanHalfFov = std::tan(0.5f * 70.f * float(kPi) / 180.f);
+        float aspect = float(width) / float(height);
+
+        const float3 lo(-kRoomHalfWidth, 0.f, -kRoomHalfWidth), hi(kRoomHalfWidth, kRoomHeight, kRoomHalfWidth);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                float sx = (2.f * (x + 0.5f) / width - 1.f) * tanHalfFov * aspect;
+                float sy = (1.f - 2.f * (y + 0.5f) / height) * tanHalfFov;
+                float3 dir = normalize(forward + right * sx + up * sy);
+
+                // exit point of the box, the face with the smallest exit distance is hit
+                float tHit = INFINITY;
+                float3 normal;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    if (dir[axis] == 0.f) continue;
+                    float bound = dir[axis] > 0 ? hi[axis] : lo[axis];
+                    float t = (bound - frame.camPosW[axis]) / dir[axis];
+                    if (t < tHit)
+                    {
+                        tHit = t;
+                        normal = float3(0.f);
+                        normal[axis] = dir[axis] > 0 ? -1.f : 1.f;
+                    }
+                }
+
+                // entry point of the pillars
+                for (int p = 0; p < 9; p++)
+                {
+                    float3 center = getPillarCenter(p);
+                    float3 half(kPillarHalfWidth, 0.5f * kRoomHeight, kPillarHalfWidth);
+                    float tNear = -INFINITY, tFar = INFINITY;
+                    int nearAxis = 0;
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        if (dir[axis] == 0.f) continue;
+                        float t0 = (center[axis] - half[axis] - frame.camPosW[axis]) / dir[axis];
+                        float t1 = (center[axis] + half[axis] - frame.camPosW[axis]) / dir[axis];
+                        if (t0 > t1) std::swap(t0, t1);
+                        if (t0 > tNear)
+                        {
+                            tNear = t0;
+                            nearAxis = axis;
+                        }
+                        tFar = std::min(tFar, t1);
+                    }
+                    if (tNear <= tFar && tNear > 0 && tNear < tHit)
+                    {
+                        tHit = tNear;
+                        normal = float3(0.f);
+                        normal[nearAxis] = dir[nearAxis] > 0 ? -1.f : 1.f;
+                    }
+                }
+                float3 posW = frame.camPosW + dir * tHit;
+
+                size_t index = size_t(y) * width + x;
+                // floor glossy, walls and ceiling rough
+                bool floor = normal.y > 0.5f;
+                float roughness = floor ? 0.25f : 0.7f;
+                frame.posLightFlag[index] = float4(posW, 0.f);
+                frame.normalLinearRoughness[index] = float4(normal, roughness * roughness);
+                frame.albedo[index] = float4(0.6f, 0.55f, 0.5f, 1.f);
+                frame.specularRoughness[index] = float4(float3(0.04f), roughness);
+            }
+        }
+        return frame;
+    }
+
+    PackedAreaLight createPanel(const float3& center, const float3& normal, const float3& tangent, float size, const float3& intensity)
+    {
+        float3 bitangent = cross(normal, tangent);
+        // counter-clockwise seen from the lit side
+        const float corners[4][2] = { { -1.f, 1.f }, { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f } };
+        PackedAreaLight light;
+        for (int v = 0; v < 4; v++)
+        {
+            float3 p = center + tangent * (corners[v][0] * size) + bitangent * (corners[v][1] * size);
+            light.posW[v][0] = p.x;
+            light.posW[v][1] = p.y;
+            light.posW[v][2] = p.z;
+            light.posW[v][3] = 0.f;
+        }
+        light.numVertices = 4;
+        for (int c = 0; c < 3; c++)
+        {
+            light.intensity[c] = intensity[c];
+            light.dirW[c] = normal[c];
+        }
+        light.surfaceArea = 4.f * size * size;
+        return light;
+    }
+
+    /** Half of the lights on the ceiling facing down, the rest on the walls facing into the room and on the
+        pillars facing out
+    */
+    AreaLightCollection generateLights(uint32_t count)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+        AreaLightCollection lights;
+        const float margin = 0.5f;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float size = 0.1f + 0.2f * u(rng);
+            float3 intensity = float3(4.f + 8.f * u(rng), 4.f + 8.f * u(rng), 4.f + 8.f * u(rng));
+            float a = (2.f * u(rng) - 1.f) * (kRoomHalfWidth - margin);
+            float b = (2.f * u(rng) - 1.f) * (kRoomHalfWidth - margin);
+            float h = 1.f + (kRoomHeight - 2.f) * u(rng);
+            if (i % 4 < 2)
+            {
+                lights.add(createPanel(float3(a, kRoomHeight - 0.01f, b), float3(0.f, -1.f, 0.f), float3(1.f, 0.f, 0.f), size, intensity));
+            }
+            else if (i % 4 == 3)
+            {
+                float3 pillar = getPillarCenter(int(u(rng) * 9.f) % 9);
+                int face = int(u(rng) * 4.f) & 3;
+                float sign = (face & 1) ? 1.f : -1.f;
+                float3 normal = (face & 2) ? float3(sign, 0.f, 0.f) : float3(0.f, 0.f, sign);
+                float3 center = float3(pillar.x, h, pillar.z) + normal * (kPillarHalfWidth + 0.01f);
+                lights.add(createPanel(center, normal, float3(0.f, 1.f, 0.f), std::min(size, 0.5f * kPillarHalfWidth), intensity));
+            }
+            else
+            {
+                int wall = int(u(rng) * 4.f) & 3;
+                float side = (wall & 1) ? kRoomHalfWidth - 0.01f : -kRoomHalfWidth + 0.01f;
+                float3 normal = (wall & 2) ? float3(side > 0 ? -1.f : 1.f, 0.f, 0.f) : float3(0.f, 0.f, side > 0 ? -1.f : 1.f);
+                float3 center = (wall & 2) ? float3(side, h, b) : float3(a, h, side);
+                lights.add(createPanel(center, normal, float3(0.f, 1.f, 0.f), size, intensity));
+            }
+        }
+        return lights;
+    }
+
+    double maxDifference(const Image& a, const Image& b, double& maxValue)
+    {
+        double diff = 0;
+        maxValue = 0;
+        for (uint32_t y = 0; y < a.height; y++)
+        {
+            for (uint32_t x = 0; x < a.width; x++)
+            {
+                float3 d = a.at(x, y) - b.at(x, y);
+                diff = std::max(diff, double(std::max(std::max(std::abs(d.x), std::abs(d.y)), std::abs(d.z))));
+                maxValue = std::max(maxValue, double(std::max(std::max(a.at(x, y).x, a.at(x, y).y), a.at(x, y).z)));
+            }
+        }
+        return diff;
+    }
+
+    template<typename Func>
+    double timeIt(Func func)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numLights = argc > 1 ? (uint32_t)std::atoi(argv[1]) : 128;
+    std::string paramDir = argc > 2 ? argv[2] : "Data/Params";
+    uint32_t numThreads = argc > 3 ? (uint32_t)std::atoi(argv[3]) : 0;
+    uint32_t width = argc > 4 ? (uint32_t)std::atoi(argv[4]) : 320;
+    uint32_t height = argc > 5 ? (uint32_t)std::atoi(argv[5]) : 180;
+
+    try
+    {
+        GBufferFrame frame = generateRoom(width, height);
+        AreaLightCollection lights = generateLights(numLights);
+
+        // the frame needs a light of its own, setLights() replaces it
+        const PackedAreaLight& first = lights.get(0);
+        frame.areaLight.intensity = float3(first.intensity[0], first.intensity[1], first.intensity[2]);
+        frame.areaLight.dirW = float3(first.dirW[0], first.dirW[1], first.dirW[2]);
+        frame.areaLight.surfaceArea = first.surfaceArea;
+        for (uint32_t v = 0; v < first.numVertices; v++) frame.areaLightPosW.push_back(float3(first.posW[v][0], first.posW[v][1], first.posW[v][2]));
+
+        ThreadPool pool(numThreads);
+        std::printf("%ux%u pixels, %u lights, %u threads\n\n", width, height, numLights, pool.getThreadCount());
+
+        // culling only
+        std::printf("%-6s %10s %8s %12s %12s %10s %10s %10s\n", "tile", "threshold", "sided", "cull [ms]", "lights/tile", "distance", "side", "horizon");
+        const uint32_t tileSizes[] = { 8, 16, 32 };
+        const float thresholds[] = { 0.f, 0.01f, 0.1f };
+        for (uint32_t tileSize : tileSizes)
+        {
+            for (float threshold : thresholds)
+            {
+                for (int oneSided = 0; oneSided < 2; oneSided++)
+                {
+                    CullingSettings settings;
+                    settings.irradianceThreshold = threshold;
+                    settings.oneSidedLights = oneSided != 0;
+                    std::vector<LightBounds> bounds;
+                    for (uint32_t i = 0; i < lights.getCount(); i++)
+                    {
+                        const PackedAreaLight& l = lights.get(i);
+                        float3 polygon[AREA_LIGHT_MAX_VERTICES];
+                        for (uint32_t v = 0; v < l.numVertices; v++) polygon[v] = float3(l.posW[v][0], l.posW[v][1], l.posW[v][2]);
+                        bounds.push_back(computeLightBounds(polygon, int(l.numVertices), float3(l.dirW[0], l.dirW[1], l.dirW[2]),
+                                                            float3(l.intensity[0], l.intensity[1], l.intensity[2]), l.surfaceArea, settings));
+                    }
+
+                    TiledLightCuller culler;
+                    double t = timeIt([&]() { culler.build(pool, frame, bounds, tileSize); });
+                    const TiledLightCuller::Stats& s = culler.getStats();
+                    double tests = double(std::max<uint64_t>(s.tests, 1));
+                    std::printf("%-6u %10g %8s %12.3f %12.1f %9.1f%% %9.1f%% %9.1f%%\n", tileSize, threshold, oneSided ? "one" : "two", t * 1e3,
+                                double(s.visible) / double(std::max(1u, s.tiles - s.emptyTiles)),
+                                100.0 * s.culledByDistance / tests, 100.0 * s.culledBySide / tests, 100.0 * s.culledByHorizon / tests);
+                }
+            }
+        }
+
+        // shading with and without culling, the exact tests must not change the image
+        LutTables tables;
+        tables.load(paramDir);
+        CpuLightingPass pass(tables);
+        pass.setFrame(frame);
+        pass.setLights(lights);
+
+        std::printf("\n%-6s %10s %12s %12s %12s\n", "mode", "threshold", "shade [s]", "max diff", "max value");
+        const Mode modes[] = { Mode::LTC, Mode::LTSH };
+        const char* modeNames[] = { "ltc", "ltsh" };
+        for (int m = 0; m < 2; m++)
+        {
+            Image reference, culled;
+            pass.setCulling(false);
+            double tAll = timeIt([&]() { pass.render(pool, modes[m], CpuLightingPass::DebugMode::Disabled, 16, reference); });
+            std::printf("%-6s %10s %12.3f %12s %12s\n", modeNames[m], "off", tAll, "-", "-");
+
+            for (float threshold : thresholds)
+            {
+                CullingSettings settings;
+                settings.irradianceThreshold = threshold;
+                pass.setCulling(true, settings);
+                pass.setLights(lights);
+                double t = timeIt([&]() { pass.render(pool, modes[m], CpuLightingPass::DebugMode::Disabled, 16, culled); });
+                double maxValue;
+                double diff = maxDifference(reference, culled, maxValue);
+                std::printf("%-6s %10g %12.3f %12.3g %12.3g\n", modeNames[m], threshold, t, diff, maxValue);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
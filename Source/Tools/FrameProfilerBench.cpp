@@ -0,0 +1,174 @@
+// Cost and correctness of FrameProfiler. Times beginFrame(), two stages and endFrame() with CpuTimerBackend, then
+// replays scripted frames on a MockTimerBackend and checks the nearest rank percentiles of the CPU and device times
+// against values computed by hand, that frames whose device times are still in flight are neither in the percentiles
+// nor in the JSON lines until endFrame() or flush() completes them, the JSON lines themselves and that
+// clearHistory() drops pending frames. Exits with 1 if a check fails.
+//
+// usage: frame_profiler_bench [frames=100000]
+
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int gFailures = 0;
+
+    void expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            gFailures++;
+        }
+    }
+
+    void expectPercentiles(const FrameProfiler::Percentiles& p, uint32_t count, double mean, double p50, double p90, double p99, double max, const char* what)
+    {
+        if (p.count != count || p.mean != mean || p.p50 != p50 || p.p90 != p90 || p.p99 != p99 || p.max != max)
+        {
+            std::printf("FAILED: %s, got count %u mean %g p50 %g p90 %g p99 %g max %g, expected %u %g %g %g %g %g\n", what,
+                        p.count, p.mean, p.p50, p.p90, p.p99, p.max, count, mean, p50, p90, p99, max);
+            gFailures++;
+        }
+    }
+
+    std::vector<std::string> splitLines(const std::string& text)
+    {
+        std::vector<std::string> lines;
+        std::istringstream stream(text);
+        std::string line;
+        while (std::getline(stream, line)) lines.push_back(line);
+        return lines;
+    }
+
+    /** One frame: 0.25 ms outside of the stages, a light upload of 0.5 ms CPU and 0.25 ms device time and a lighting
+        stage of lightingMs CPU and 10 * lightingMs device time
+    */
+    void runFrame(FrameProfiler& profiler, MockTimerBackend& backend, uint64_t frameId, const char* mode, double lightingMs)
+    {
+        profiler.beginFrame(frameId, mode, "none");
+        backend.advance(0.25);
+        backend.setGpuCost(FrameStage::LightUpload, 0.25);
+        {
+            FrameProfiler::Scope scope(profiler, FrameStage::LightUpload);
+            backend.advance(0.5);
+        }
+        backend.setGpuCost(FrameStage::Lighting, 10.0 * lightingMs);
+        {
+            FrameProfiler::Scope scope(profiler, FrameStage::Lighting);
+            backend.advance(lightingMs);
+        }
+        profiler.endFrame();
+    }
+
+    void check()
+    {
+        // 10 frames with the lighting times 1 to 10 ms, a latency of 2 frames leaves the last two in flight
+        MockTimerBackend backend(2);
+        FrameProfiler profiler(backend, 128);
+        std::ostringstream json;
+        profiler.setJsonStream(&json);
+        const double lighting[10] = { 7, 3, 10, 1, 5, 9, 2, 8, 4, 6 };
+        for (uint64_t f = 0; f < 10; f++) runFrame(profiler, backend, f, "ltc", lighting[f]);
+
+        // frames 0 to 7: 1, 2, 3, 5, 7, 8, 9, 10, nearest rank 4 for p50 and 8 for p90 and p99
+        expectPercentiles(profiler.getPercentiles(FrameStage::Lighting, false, "ltc"), 8, 45.0 / 8, 5, 10, 10, 10, "CPU lighting without the frames in flight");
+        expectPercentiles(profiler.getPercentiles(FrameStage::Lighting, true, "ltc"), 8, 450.0 / 8, 50, 100, 100, 100, "device lighting without the frames in flight");
+        expectPercentiles(profiler.getPercentiles(FrameStage::LightUpload, true), 8, 0.25, 0.25, 0.25, 0.25, 0.25, "device light upload");
+        expectPercentiles(profiler.getFramePercentiles("ltc"), 8, 45.0 / 8 + 0.75, 5.75, 10.75, 10.75, 10.75, "frame CPU time");
+        expect(profiler.getPercentiles(FrameStage::GBuffer, false).count == 0, "a stage that never ran has no frames");
+
+        std::vector<std::string> lines = splitLines(json.str());
+        expect(lines.size() == 8, "one JSON line per completed frame, none for the frames in flight");
+        expect(!lines.empty() && lines[0] == "{\"frame\":0,\"mode\":\"ltc\",\"debug\":\"none\",\"frame_cpu_ms\":7.7500,"
+               "\"cpu_ms\":{\"light_upload\":0.5000,\"lighting\":7.0000},\"gpu_ms\":{\"light_upload\":0.2500,\"lighting\":70.0000}}",
+               "JSON line of frame 0");
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            expect(lines[i].compare(0, 10 + std::to_string(i).size(), "{\"frame\":" + std::to_string(i) + ",") == 0, "JSON lines in frame order");
+        }
+
+        // a frame in progress is not in the percentiles either
+        profiler.beginFrame(10, "ltsh", "none");
+        expect(profiler.getPercentiles(FrameStage::Lighting, false).count == 8, "the current frame is not in the percentiles");
+        backend.advance(1.0);
+        profiler.endFrame();
+        expect(profiler.getPercentiles(FrameStage::Lighting, false, "ltc").count == 9, "endFrame() completes the frame that left the latency");
+        expect(profiler.getFramePercentiles("ltsh").count == 0, "the last frame is still in flight");
+
+        // flush() reads the remaining frames: 1 to 10, nearest rank 5, 9 and 10
+        profiler.flush();
+        expectPercentiles(profiler.getPercentiles(FrameStage::Lighting, false, "ltc"), 10, 5.5, 5, 9, 10, 10, "CPU lighting after flush()");
+        expectPercentiles(profiler.getFramePercentiles("ltsh"), 1, 1.0, 1.0, 1.0, 1.0, 1.0, "frame without stages after flush()");
+        lines = splitLines(json.str());
+        expect(lines.size() == 11, "flush() writes the frames in flight");
+        expect(lines.size() == 11 && lines[10] == "{\"frame\":10,\"mode\":\"ltsh\",\"debug\":\"none\",\"frame_cpu_ms\":1.0000,\"cpu_ms\":{},\"gpu_ms\":{}}",
+               "JSON line of a frame without stages");
+
+        // 100 frames with 1 to 100 ms in random order, nearest rank gives the values themselves
+        std::vector<double> values;
+        for (int i = 1; i <= 100; i++) values.push_back(double(i));
+        std::mt19937 rng(3);
+        std::shuffle(values.begin(), values.end(), rng);
+        for (uint64_t f = 0; f < values.size(); f++) runFrame(profiler, backend, 11 + f, "ltsh_n2", values[f]);
+        profiler.flush();
+        expectPercentiles(profiler.getPercentiles(FrameStage::Lighting, false, "ltsh_n2"), 100, 50.5, 50, 90, 99, 100, "CPU lighting of 100 frames");
+        expect(profiler.getPercentiles(FrameStage::Lighting, false).count == 110, "all modes together");
+
+        // the ring buffer keeps the last 128 frames
+        for (uint64_t f = 0; f < 40; f++) runFrame(profiler, backend, 111 + f, "ltc", 1.0);
+        expect(profiler.getPercentiles(FrameStage::Lighting, false).count == 126, "history limited to its size minus the frames in flight");
+
+        // pending frames are dropped, not written
+        size_t linesBefore = splitLines(json.str()).size();
+        profiler.clearHistory();
+        profiler.flush();
+        expect(profiler.getFramePercentiles().count == 0, "clearHistory() forgets all frames");
+        expect(splitLines(json.str()).size() == linesBefore, "clearHistory() drops the frames in flight");
+        runFrame(profiler, backend, 151, "ltc", 2.0);
+        profiler.flush();
+        expectPercentiles(profiler.getPercentiles(FrameStage::Lighting, true), 1, 20, 20, 20, 20, 20, "first frame after clearHistory()");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    CpuTimerBackend timer;
+    FrameProfiler profiler(timer);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < frames; f++)
+    {
+        profiler.beginFrame(uint64_t(f), "ltsh", "none");
+        {
+            FrameProfiler::Scope scope(profiler, FrameStage::LightUpload);
+        }
+        {
+            FrameProfiler::Scope scope(profiler, FrameStage::Lighting);
+        }
+        profiler.endFrame();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    auto percentileStart = std::chrono::high_resolution_clock::now();
+    FrameProfiler::Percentiles p = profiler.getPercentiles(FrameStage::Lighting, false, "ltsh");
+    double percentileSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - percentileStart).count();
+    std::printf("%d frames: %.1f ns per frame with 2 stages, percentiles of %u frames in %.1f us\n", frames, seconds * 1e9 / frames, p.count, percentileSeconds * 1e6);
+
+    check();
+    if (gFailures)
+    {
+        std::printf("%d checks FAILED\n", gFailures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Microbenchmark for the LUT conversion kernels. Compares the element-wise push_back converters and the strided
+// repacking loops that SimpleDeferred used to have against the bulk converters and packCoeffTiles<>, and checks
+// that both produce the same bits.
+//
+// usage: half_convert_bench [paramDir=Data/Params] [repetitions=200]
+
+#include "HalfConversion.h"
+#include "LutPacking.h"
+#include "Reference/Half.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // ---- previous implementation, glm::detail::toFloat16 replaced by the bit-compatible ltsh::floatToHalf ----
+
+    void legacyConvertDoubleToFloat16(const std::vector<double>& in, std::vector<uint16_t>& out)
+    {
+        out.clear();
+        for (auto val : in)
+        {
+            out.push_back(ltsh::floatToHalf(float(val)));
+        }
+    }
+
+    void legacyConvertLtshCoeff(const std::vector<double>& in, std::vector<uint16_t>& out, size_t numCoeffs)
+    {
+        const size_t padded = (numCoeffs + 3) / 4 * 4;
+        out = std::vector<uint16_t>(64 * 64 * padded);
+        for (size_t i = 0; i < 64; i++)
+        {
+            for (size_t j = 0; j < 64; j++)
+            {
+                for (size_t k = 0; k < padded; k++)
+                {
+                    size_t offset = (k / 4) * 64 * 4;
+                    if (k >= numCoeffs)
+                    {
+                        out[i * 64 * padded + j * 4 + (k % 4) + offset] = ltsh::floatToHalf(0.f);
+                        continue;
+                    }
+                    out[i * 64 * padded + j * 4 + (k % 4) + offset] = ltsh::floatToHalf(float(in[j * 64 * numCoeffs + i * numCoeffs + k]));
+                }
+            }
+        }
+    }
+
+    template<typename Func>
+    double timeIt(Func func, int repetitions)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repetitions; r++)
+        {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(end - start).count() / repetitions;
+    }
+
+    void report(const char* name, size_t elements, double legacy, double current, bool equal)
+    {
+        std::printf("%-26s %10.1f us %10.1f us %7.2fx  %6.2f ns/elem  %s\n", name, legacy * 1e6, current * 1e6, legacy / current,
+                    current * 1e9 / elements, equal ? "bit-exact" : "MISMATCH");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string paramDir = argc > 1 ? argv[1] : "Data/Params";
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 200;
+    bool allEqual = true;
+
+    try
+    {
+        std::printf("backend: %s, %d repetitions\n", getHalfConversionBackend(), repetitions);
+        std::printf("%-26s %13s %13s %8s\n", "", "legacy", "current", "speedup");
+
+        // plain conversion of a matrix table
+        {
+            MappedNumpyArray file(paramDir + "/inv_cos_mat_t128.npy");
+            ArraySpan<double> span = file.getData<double>();
+            std::vector<double> in(span.begin(), span.end());
+            std::vector<uint16_t> legacy, current;
+            double tLegacy = timeIt([&]() { legacyConvertDoubleToFloat16(in, legacy); }, repetitions);
+            double tCurrent = timeIt([&]() { convertToHalf(span, current); }, repetitions);
+            bool equal = legacy == current;
+            allEqual &= equal;
+            report("double -> half (16384)", in.size(), tLegacy, tCurrent, equal);
+        }
+
+        // reorder + pad of the coefficient tables
+        const struct { const char* file; uint32_t numCoeffs; const char* name; } coeffTables[] =
+        {
+            { "/sh_coeff_n4_t128.npy", 25, "repack N=4 (25 coeffs)" },
+            { "/sh_coeff_n2_t128.npy", 9, "repack N=2 (9 coeffs)" },
+        };
+        for (const auto& table : coeffTables)
+        {
+            MappedNumpyArray file(paramDir + table.file);
+            ArraySpan<double> span = file.getData<double>();
+            std::vector<double> in(span.begin(), span.end());
+            std::vector<uint16_t> legacy, current;
+            double tLegacy = timeIt([&]() { legacyConvertLtshCoeff(in, legacy, table.numCoeffs); }, repetitions);
+            double tCurrent = timeIt([&]() { packLtshCoeffs(span, getLutResolution(file.getShape(), table.numCoeffs), table.numCoeffs, current); }, repetitions);
+            bool equal = legacy == current;
+            allEqual &= equal;
+            report(table.name, in.size(), tLegacy, tCurrent, equal);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return allEqual ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+// Cost of keeping the area light buffer up to date. Animates a fraction of a large set of panel lights per frame
+// and reports the time to write the lights into the AreaLightCollection and to collect the dirty ranges, as well
+// as how many bytes the upload of the ranges copies compared to uploading the whole buffer. Checks that the ranges
+// cover every changed light.
+//
+// --check only runs the functional checks of the collection: coalescing with maxGap, remove with the last light moved
+// into the slot, markAllDirty and set() with identical data. Exits with 1 if one of them fails, as does the benchmark
+// if a range misses a changed light.
+//
+// usage: light_collection_bench [lights=4096] [frames=200]
+//        light_collection_bench --check
+
+#include "AreaLightCollection.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    PackedAreaLight createPanel(float x, float y, float z, float size)
+    {
+        PackedAreaLight light;
+        const float corners[4][2] = { { -1.f, 1.f }, { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f } };
+        for (int v = 0; v < 4; v++)
+        {
+            light.posW[v][0] = x + corners[v][0] * size;
+            light.posW[v][1] = y;
+            light.posW[v][2] = z + corners[v][1] * size;
+            light.posW[v][3] = 1.f;
+        }
+        light.numVertices = 4;
+        light.intensity[0] = light.intensity[1] = light.intensity[2] = 10.f;
+        light.surfaceArea = 4.f * size * size;
+        light.dirW[0] = 0.f;
+        light.dirW[1] = -1.f;
+        light.dirW[2] = 0.f;
+        return light;
+    }
+
+    struct Result
+    {
+        double seconds = 0;
+        size_t ranges = 0;
+        size_t uploadedBytes = 0;
+        bool covered = true;
+    };
+
+    /** Run the animation, every frame the lights in moving are shifted and the lights in dimmed change intensity
+    */
+    Result run(std::vector<PackedAreaLight> panels, const std::vector<uint32_t>& moving, const std::vector<uint32_t>& dimmed, int frames, uint32_t maxGap)
+    {
+        AreaLightCollection lights;
+        for (const PackedAreaLight& p : panels) lights.add(p);
+        lights.clearDirty();
+
+        Result result;
+        std::vector<char> changed(panels.size());
+        for (int f = 0; f < frames; f++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            float offset = 0.01f * std::sin(0.1f * float(f));
+            for (uint32_t i : moving)
+            {
+                for (int v = 0; v < 4; v++) panels[i].posW[v][1] += offset;
+            }
+            // the app writes all lights every frame, set() filters the unchanged ones
+            for (uint32_t i = 0; i < lights.getCount(); i++)
+            {
+                lights.set(i, panels[i]);
+            }
+            float intensity[3] = { 11.f + float(f % 7), 10.f, 10.f };
+            for (uint32_t i : dimmed)
+            {
+                lights.setIntensity(i, intensity);
+            }
+            std::vector<AreaLightCollection::Range> ranges = lights.getDirtyRanges(maxGap);
+            auto end = std::chrono::high_resolution_clock::now();
+            result.seconds += std::chrono::duration<double>(end - start).count();
+
+            // check that every light that changed this frame is uploaded
+            std::fill(changed.begin(), changed.end(), 0);
+            if (offset != 0) for (uint32_t i : moving) changed[i] = 1;
+            for (uint32_t i : dimmed) changed[i] = 1;
+            for (const AreaLightCollection::Range& r : ranges)
+            {
+                for (uint32_t i = r.first; i < r.first + r.count; i++) changed[i] = 0;
+                result.uploadedBytes += r.count * sizeof(PackedAreaLight);
+            }
+            for (char c : changed) result.covered = result.covered && !c;
+            result.ranges += ranges.size();
+            lights.clearDirty();
+        }
+        result.seconds /= frames;
+        result.ranges /= frames;
+        result.uploadedBytes /= frames;
+        return result;
+    }
+
+    bool expect(bool condition, const char* what)
+    {
+        if (!condition) std::printf("FAILED: %s\n", what);
+        return condition;
+    }
+
+    bool expectRanges(const AreaLightCollection& lights, uint32_t maxGap, std::vector<AreaLightCollection::Range> expected, const char* what)
+    {
+        std::vector<AreaLightCollection::Range> ranges = lights.getDirtyRanges(maxGap);
+        bool equal = ranges.size() == expected.size();
+        for (size_t i = 0; equal && i < ranges.size(); i++)
+        {
+            equal = ranges[i].first == expected[i].first && ranges[i].count == expected[i].count;
+        }
+        if (!equal)
+        {
+            std::printf("FAILED: %s, maxGap %u gave", what, maxGap);
+            for (const AreaLightCollection::Range& r : ranges) std::printf(" {%u, %u}", r.first, r.count);
+            std::printf("\n");
+        }
+        return equal;
+    }
+
+    /** Functional checks of the dirty tracking, returns the number of failures
+    */
+    int check()
+    {
+        int failures = 0;
+        AreaLightCollection lights;
+        for (uint32_t i = 0; i < 200; i++) lights.add(createPanel(float(i), 3.f, 0.f, 0.25f));
+        failures += !expectRanges(lights, 0, { { 0, 200 } }, "added lights are dirty");
+        lights.clearDirty();
+        failures += !expect(!lights.isDirty() && lights.getDirtyRanges().empty(), "clearDirty leaves no dirty lights");
+
+        // set() with identical data, setIntensity() with the current intensity
+        for (uint32_t i = 0; i < lights.getCount(); i++)
+        {
+            PackedAreaLight same = lights.get(i);
+            lights.set(i, same);
+            lights.setIntensity(i, same.intensity);
+        }
+        failures += !expect(!lights.isDirty() && lights.getDirtyCount() == 0, "set() of identical data marks no light dirty");
+
+        // coalescing, dirty lights 3, 5, 10 and 70 (the last one in the second bit word)
+        const uint32_t dirty[] = { 3, 5, 10, 70 };
+        for (uint32_t i : dirty)
+        {
+            PackedAreaLight moved = lights.get(i);
+            moved.posW[0][1] += 1.f;
+            lights.set(i, moved);
+        }
+        const float intensity[3] = { 20.f, 10.f, 10.f };
+        lights.setIntensity(5, intensity);
+        failures += !expect(lights.getDirtyCount() == 4, "setting a dirty light again counts it once");
+        failures += !expectRanges(lights, 0, { { 3, 1 }, { 5, 1 }, { 10, 1 }, { 70, 1 } }, "separate ranges");
+        failures += !expectRanges(lights, 1, { { 3, 3 }, { 10, 1 }, { 70, 1 } }, "gap of one merged");
+        failures += !expectRanges(lights, 4, { { 3, 8 }, { 70, 1 } }, "gaps up to four merged");
+        failures += !expectRanges(lights, 59, { { 3, 68 } }, "gap of 59 merged across the word boundary");
+        failures += !expectRanges(lights, 58, { { 3, 8 }, { 70, 1 } }, "gap of 59 kept with maxGap 58");
+        lights.clearDirty();
+
+        // remove a light in the middle, the last light moves into its slot and is dirty there
+        PackedAreaLight last = lights.get(199);
+        failures += !expect(lights.remove(20) == 199, "remove returns the previous index of the moved light");
+        failures += !expect(lights.getCount() == 199, "remove shrinks the collection");
+        failures += !expect(std::memcmp(&lights.get(20), &last, sizeof(PackedAreaLight)) == 0, "last light moved into the slot");
+        failures += !expectRanges(lights, 0, { { 20, 1 } }, "moved light is dirty");
+
+        // a dirty last light takes its dirty bit along when it is removed
+        lights.clearDirty();
+        PackedAreaLight moved = lights.get(198);
+        moved.posW[0][1] += 1.f;
+        lights.set(198, moved);
+        failures += !expect(lights.remove(198) == 198, "removing the last light returns the new count");
+        failures += !expect(!lights.isDirty() && lights.getDirtyRanges().empty(), "removed last light is no longer dirty");
+
+        // a dirty last light moved into a dirty slot is counted once
+        lights.set(100, moved);
+        moved.posW[0][1] += 1.f;
+        lights.set(197, moved);
+        lights.remove(100);
+        failures += !expect(lights.getDirtyCount() == 1, "moving a dirty light into a dirty slot counts it once");
+        failures += !expectRanges(lights, 0, { { 100, 1 } }, "only the filled slot is dirty after remove");
+
+        // markAllDirty with a count that is not a multiple of 64
+        while (lights.getCount() > 130) lights.remove(lights.getCount() - 1);
+        lights.clearDirty();
+        lights.markAllDirty();
+        failures += !expect(lights.getDirtyCount() == 130, "markAllDirty counts every light");
+        failures += !expectRanges(lights, 0, { { 0, 130 } }, "markAllDirty covers every light and nothing past the end");
+        lights.add(createPanel(0.f, 3.f, 0.f, 0.25f));
+        lights.clearDirty();
+        lights.markAllDirty();
+        failures += !expectRanges(lights, 0, { { 0, 131 } }, "markAllDirty after add");
+        lights.clearDirty();
+        failures += !expect(!lights.isDirty() && lights.getDirtyRanges(1000).empty(), "clearDirty after markAllDirty");
+
+        lights.clear();
+        failures += !expect(lights.getCount() == 0 && !lights.isDirty(), "clear empties the collection");
+        return failures;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--check")
+    {
+        int failures = check();
+        if (failures) return 1;
+        std::printf("all checks passed\n");
+        return 0;
+    }
+
+    uint32_t count = argc > 1 ? (uint32_t)std::atoi(argv[1]) : 4096;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> u(-20.f, 20.f);
+    std::vector<PackedAreaLight> panels;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        panels.push_back(createPanel(u(rng), 3.f, u(rng), 0.25f));
+    }
+
+    std::printf("%u lights, %zu bytes each, full upload %zu bytes\n", count, sizeof(PackedAreaLight), count * sizeof(PackedAreaLight));
+    std::printf("%-24s %8s %12s %10s %14s %8s\n", "changed per frame", "maxGap", "update [us]", "ranges", "uploaded [B]", "covered");
+
+    const double fractions[] = { 0.0, 0.01, 0.1, 1.0 };
+    const uint32_t gaps[] = { 0, 8 };
+    bool covered = true;
+    for (double fraction : fractions)
+    {
+        // scattered moving lights plus a contiguous block that only changes intensity
+        std::vector<uint32_t> moving, dimmed;
+        uint32_t numChanged = uint32_t(fraction * count);
+        for (uint32_t i = 0; i < numChanged / 2; i++) moving.push_back(uint32_t(rng() % count));
+        for (uint32_t i = 0; i < numChanged - numChanged / 2; i++) dimmed.push_back(i);
+
+        for (uint32_t gap : gaps)
+        {
+            Result r = run(panels, moving, dimmed, frames, gap);
+            char label[32];
+            std::snprintf(label, sizeof(label), "%.0f%%", fraction * 100.0);
+            std::printf("%-24s %8u %12.1f %10zu %14zu %8s\n", label, gap, r.seconds * 1e6, r.ranges, r.uploadedBytes, r.covered ? "yes" : "NO");
+            covered = covered && r.covered;
+        }
+    }
+    if (!covered)
+    {
+        std::printf("FAILED: the dirty ranges missed changed lights\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+// Throughput baseline for the CPU port of polygonSH(). Projects a fixed set of random clipped polygons with the
+// scalar float path, the batched SIMD path and the double precision path and reports polygons per second and the
+// deviation of the float paths from the double result.
+//
+// The second table shades a tile of floor points below a light that crosses the floor, once per point the way
+// CpuLightingPass does (frame change, clip, MInv, polygonSH) and once through polygonSHTile(), and reports the
+// coefficients per second of both.
+//
+// Exits with 1 if the batched or the tiled path deviates from the scalar float path by more than kMaxBatchDeviation,
+// so the batched path stays usable as an oracle for the shaders.
+//
+// usage: ltsh_bench [polygons=65536] [repetitions=5] [tileSize=64]
+
+#include "Reference/LTSHSimd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    // random quads in front of the shading point, shaped like the ones the lighting pass sees after clipping
+    void createPolygons(size_t count, std::vector<float3>& polygons, std::vector<int>& numVerts)
+    {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> u(-1.f, 1.f);
+        polygons.resize(count * kMaxBatchVertices);
+        numVerts.resize(count);
+        for (size_t p = 0; p < count; p++)
+        {
+            float3 center(u(rng), u(rng), 1.5f + u(rng));
+            int n = 3 + int(p % 3);
+            for (int i = 0; i < kMaxBatchVertices; i++)
+            {
+                float a = -6.2831853f * float(i % n) / float(n);
+                polygons[p * kMaxBatchVertices + i] = normalize(center + float3(0.5f * std::cos(a), 0.5f * std::sin(a), 0.2f * u(rng)));
+            }
+            numVerts[p] = n;
+        }
+    }
+
+    // floor points on a tileSize x tileSize grid, with random LTSH-like matrices [[1, 0, z], [0, y, 0], [x, 0, w]]
+    std::vector<TilePoint> createTile(uint32_t tileSize)
+    {
+        std::mt19937 rng(5678);
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+        const float3 camPosW(0.f, 1.5f, -3.f);
+        const float3 N(0.f, 1.f, 0.f);
+        std::vector<TilePoint> points(size_t(tileSize) * tileSize);
+        for (uint32_t y = 0; y < tileSize; y++)
+        {
+            for (uint32_t x = 0; x < tileSize; x++)
+            {
+                TilePoint& p = points[size_t(y) * tileSize + x];
+                p.posW = float3(-2.f + 4.f * (x + 0.5f) / tileSize, 0.f, -1.f + 3.f * (y + 0.5f) / tileSize);
+                float3 V = normalize(camPosW - p.posW);
+                float3 T1 = normalize(V - N * dot(N, V));
+                p.frame = float3x3(T1, cross(N, T1), N);
+                p.MInv = float3x3(1.f, 0.f, 0.6f * u(rng) - 0.3f, 0.f, 0.5f + 4.f * u(rng), 0.f, 0.6f * u(rng) - 0.3f, 0.f, 0.5f + 4.f * u(rng));
+            }
+        }
+        return points;
+    }
+
+    // CpuLightingPass::evalAreaLightLTSH() up to the projection
+    template<typename Real>
+    void shadePoint(const float3* light, int numVertices, const TilePoint& p, Real Lcoeff[kNumCoeffsN4])
+    {
+        typedef Vec3<Real> Vec;
+        Mat3<Real> frame(p.frame), MInv(p.MInv);
+        Vec polygon[kMaxPolygonVertices];
+        for (int i = 0; i < numVertices; i++)
+        {
+            polygon[i] = mul(frame, Vec(light[i]) - Vec(p.posW));
+        }
+        Vec L[kMaxClippedVertices];
+        int n = clipPolygonToHorizon(polygon, numVertices, L);
+        for (int i = 0; i < n; i++)
+        {
+            L[i] = normalize(mul(MInv, L[i]));
+        }
+        if (n == 0)
+        {
+            std::fill(Lcoeff, Lcoeff + kNumCoeffsN4, Real(0));
+            return;
+        }
+        polygonSH(L, n, Lcoeff);
+    }
+
+    template<typename Func>
+    double timeIt(Func func, int repetitions)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repetitions; r++)
+        {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(end - start).count() / repetitions;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? (size_t)std::atoll(argv[1]) : 1 << 16;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    uint32_t tileSize = argc > 3 ? (uint32_t)std::atoi(argv[3]) : 64;
+
+    std::vector<float3> polygons;
+    std::vector<int> numVerts;
+    createPolygons(count, polygons, numVerts);
+
+    std::vector<float> scalar(count * kNumCoeffsN4);
+    std::vector<float> batched(count * kNumCoeffsN4);
+    std::vector<double> reference(count * kNumCoeffsN4);
+
+    double tScalar = timeIt([&]()
+    {
+        for (size_t p = 0; p < count; p++)
+        {
+            polygonSH(&polygons[p * kMaxBatchVertices], numVerts[p], &scalar[p * kNumCoeffsN4]);
+        }
+    }, repetitions);
+
+    double tBatched = timeIt([&]()
+    {
+        polygonSHArray(polygons.data(), numVerts.data(), count, batched.data());
+    }, repetitions);
+
+    double tDouble = timeIt([&]()
+    {
+        for (size_t p = 0; p < count; p++)
+        {
+            double3 L[kMaxBatchVertices];
+            for (int i = 0; i < kMaxBatchVertices; i++)
+            {
+                L[i] = double3(polygons[p * kMaxBatchVertices + i]);
+            }
+            polygonSH(L, numVerts[p], &reference[p * kNumCoeffsN4]);
+        }
+    }, repetitions);
+
+    double errScalar = 0, errBatched = 0, devBatched = 0;
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        errScalar = std::max(errScalar, std::abs(scalar[i] - reference[i]));
+        errBatched = std::max(errBatched, std::abs(batched[i] - reference[i]));
+        devBatched = std::max(devBatched, double(std::abs(batched[i] - scalar[i])));
+    }
+
+    std::printf("polygons: %zu, simd backend: %s\n", count, simd::backendName());
+    std::printf("%-8s %14s %14s %14s\n", "path", "polygons/s", "max abs err", "vs scalar");
+    std::printf("%-8s %14.0f %14.3g %14s\n", "scalar", count / tScalar, errScalar, "-");
+    std::printf("%-8s %14.0f %14.3g %14.3g\n", "batched", count / tBatched, errBatched, devBatched);
+    std::printf("%-8s %14.0f %14s %14s\n", "double", count / tDouble, "-", "-");
+
+    // a 2 x 2 quad standing on the floor in front of the tile, the points close to it see it clipped
+    const float3 light[4] = { float3(-1.f, -0.5f, 2.5f), float3(1.f, -0.5f, 2.5f), float3(1.f, 1.5f, 2.f), float3(-1.f, 1.5f, 2.f) };
+    std::vector<TilePoint> tile = createTile(tileSize);
+    size_t numPoints = tile.size();
+    std::vector<float> perPoint(numPoints * kNumCoeffsN4);
+    std::vector<float> tiled(numPoints * kNumCoeffsN4);
+    std::vector<double> tileReference(numPoints * kNumCoeffsN4);
+
+    double tPerPoint = timeIt([&]()
+    {
+        for (size_t p = 0; p < numPoints; p++)
+        {
+            shadePoint(light, 4, tile[p], &perPoint[p * kNumCoeffsN4]);
+        }
+    }, repetitions);
+
+    size_t numScalar = 0;
+    double tTiled = timeIt([&]()
+    {
+        numScalar = polygonSHTile(light, 4, tile.data(), numPoints, tiled.data());
+    }, repetitions);
+
+    for (size_t p = 0; p < numPoints; p++)
+    {
+        shadePoint(light, 4, tile[p], &tileReference[p * kNumCoeffsN4]);
+    }
+
+    double errPerPoint = 0, errTiled = 0;
+    for (size_t i = 0; i < tileReference.size(); i++)
+    {
+        errPerPoint = std::max(errPerPoint, std::abs(perPoint[i] - tileReference[i]));
+        errTiled = std::max(errTiled, std::abs(tiled[i] - tileReference[i]));
+    }
+
+    std::printf("\ntile: %ux%u points, %zu on the scalar path\n", tileSize, tileSize, numScalar);
+    std::printf("%-10s %14s %14s\n", "path", "coeffs/s", "max abs err");
+    std::printf("%-10s %14.0f %14.3g\n", "per point", numPoints * kNumCoeffsN4 / tPerPoint, errPerPoint);
+    std::printf("%-10s %14.0f %14.3g\n", "tile", numPoints * kNumCoeffsN4 / tTiled, errTiled);
+
+    double devTiled = 0;
+    for (size_t i = 0; i < perPoint.size(); i++)
+    {
+        devTiled = std::max(devTiled, double(std::abs(tiled[i] - perPoint[i])));
+    }
+    if (devBatched > kMaxBatchDeviation || devTiled > kMaxBatchDeviation)
+    {
+        std::printf("\nFAILED: the batched path deviates %.3g and the tiled path %.3g from the scalar path, the tolerance is %.3g\n",
+                    devBatched, devTiled, double(kMaxBatchDeviation));
+        return 1;
+    }
+    std::printf("\nbatched and tiled path within %.3g of the scalar path\n", double(kMaxBatchDeviation));
+    return 0;
+}
@@ -0,0 +1,125 @@
+// Offline encoder for compressed LTSH coefficient tables, see Reference/LtshCompression.h. Encodes the table with
+// 8-bit block quantization and with PCA bases of several sizes, decodes every cell again and reports the texture
+// memory, the fetches per pixel and the error against the raw .npy file. With --out the encoded tables are written
+// next to each other as <out>/sh_coeff_n<order>_q8.npy and <out>/sh_coeff_n<order>_pca<k>_{basis,weights}.npy.
+//
+// usage: ltsh_compress [paramDir=Data/Params] [--order 4|2] [--components 4,8,12,15] [--out dir]
+
+#include "Reference/LtshCompression.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    void printUsage()
+    {
+        std::printf("usage: ltsh_compress [paramDir] [--order 4|2] [--components 4,8,12,15] [--out dir]\n");
+    }
+
+    std::vector<uint32_t> parseList(const char* value)
+    {
+        std::vector<uint32_t> list;
+        for (const char* p = value; *p;)
+        {
+            char* end;
+            long v = std::strtol(p, &end, 10);
+            if (end == p) break;
+            list.push_back(uint32_t(v));
+            p = *end == ',' ? end + 1 : end;
+        }
+        return list;
+    }
+
+    void printRow(const char* name, size_t bytes, uint32_t fetches, const CoeffError& err)
+    {
+        std::printf("%-12s %9.1f KB %8u %12.3g %10.4f %10.4f %10.4f %10.4f\n", name, bytes / 1024.0, fetches, err.rmse, err.relativeRmse,
+                    err.medianCellError, err.p95CellError, err.maxCellError);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string paramDir = "Data/Params";
+    std::string outDir;
+    int order = 4;
+    std::vector<uint32_t> components = { 4, 8, 12, 15 };
+
+    int first = 1;
+    if (argc > 1 && argv[1][0] != '-')
+    {
+        paramDir = argv[1];
+        first = 2;
+    }
+    for (int i = first; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--order") order = std::atoi(value);
+        else if (arg == "--components") components = parseList(value);
+        else if (arg == "--out") outDir = value;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    if (order != 2 && order != 4)
+    {
+        std::printf("only the N=2 and N=4 tables exist\n");
+        return 1;
+    }
+
+    try
+    {
+        const uint32_t K = uint32_t((order + 1) * (order + 1));
+        std::string name = "sh_coeff_n" + std::to_string(order);
+        std::string dir = paramDir.empty() || paramDir.back() == '/' || paramDir.back() == '\\' ? paramDir : paramDir + "/";
+        std::string outPrefix = outDir.empty() ? std::string() : (outDir.back() == '/' ? outDir : outDir + "/") + name;
+
+        CoeffTable table = loadCoeffTable(dir + name + "_t128.npy", K);
+        std::printf("%s_t128.npy: %ux%u cells, %u coefficients\n", name.c_str(), table.resolution, table.resolution, K);
+
+        std::printf("%-12s %12s %8s %12s %10s %10s %10s %10s\n", "encoding", "memory", "fetches", "rmse", "rel rmse",
+                    "median", "p95", "max cell");
+
+        CoeffError err = measureError(table, [&](size_t cell, float* coeffs)
+        {
+            for (uint32_t k = 0; k < K; k++) coeffs[k] = quantizeToHalf(float(table.getCell(cell)[k]));
+        });
+        printRow("raw half", getRawByteSize(table), (K + 3) / 4, err);
+
+        QuantizedCoeffTable quantized = quantizeCoeffs(table);
+        err = measureError(table, [&](size_t cell, float* coeffs) { quantized.decode(cell, coeffs); });
+        printRow("q8", quantized.getByteSize(), quantized.getTexelsPerCell(), err);
+        if (!outPrefix.empty()) saveQuantized(outPrefix, quantized);
+
+        for (uint32_t k : components)
+        {
+            if (k < 1 || k > K) continue;
+            PcaCoeffTable pca = encodePca(table, k);
+            err = measureError(table, [&](size_t cell, float* coeffs) { pca.decode(cell, coeffs); });
+            std::string label = "pca " + std::to_string(k);
+            printRow(label.c_str(), pca.getByteSize(), pca.getTexelsPerCell(), err);
+            if (!outPrefix.empty()) savePca(outPrefix, pca);
+        }
+        std::printf("%zu cells with a norm beyond the half float range are not counted\n", err.numSkipped);
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
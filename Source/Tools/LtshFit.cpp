@@ -0,0 +1,141 @@
+// Offline fit of the LTC and LTSH lookup tables. Fits the inverse matrices and the normalization (LTC) or SH
+// coefficients (LTSH) of every (theta, alpha) cell to GGX in parallel and writes the .npy files the app and
+// LutTables read, so the tables can be refitted for other BRDFs and resolutions.
+//
+// usage: ltsh_fit <outDir> [--tables ltc,n2,n4] [--resolution 64] [--samples 2048] [--iterations 400]
+//                 [--f0 0.4] [--fresnel schlick|constant] [--threads N] [--compare Data/Params]
+//
+// --compare evaluates the tables in another directory with the same BRDF and samples and reports their error next
+// to the new fit. The shipped tables were fitted to GGX scaled by a constant 0.4, compare them with --fresnel constant.
+
+#include "Reference/LtshFitter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    void printUsage()
+    {
+        std::printf("usage: ltsh_fit <outDir> [--tables ltc,n2,n4] [--resolution N] [--samples N] [--iterations N]\n"
+                    "                [--f0 F] [--fresnel schlick|constant] [--threads N] [--compare dir]\n");
+    }
+
+    /** Parse a list like "ltc,n2,n4" to SH orders, 0 stands for LTC
+    */
+    bool parseTables(const std::string& value, std::vector<int>& orders)
+    {
+        orders.clear();
+        size_t begin = 0;
+        while (begin <= value.size())
+        {
+            size_t end = value.find(',', begin);
+            if (end == std::string::npos) end = value.size();
+            std::string name = value.substr(begin, end - begin);
+            if (name == "ltc") orders.push_back(0);
+            else if (name.size() == 2 && name[0] == 'n' && name[1] >= '2' && name[1] <= '8') orders.push_back(name[1] - '0');
+            else return false;
+            begin = end + 1;
+        }
+        return !orders.empty();
+    }
+
+    std::string tableName(int order)
+    {
+        return order == 0 ? "ltc" : "ltsh_n" + std::to_string(order);
+    }
+
+    size_t countAbove(const FitTable& table, double threshold)
+    {
+        size_t count = 0;
+        for (double e : table.errors) count += e > threshold ? 1 : 0;
+        return count;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::string outDir = argv[1];
+    std::string compareDir;
+    std::vector<int> orders = { 0, 2, 4 };
+    FitSettings settings;
+
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--tables")
+        {
+            if (!parseTables(value, orders))
+            {
+                std::printf("unknown table list %s\n", value);
+                return 1;
+            }
+        }
+        else if (arg == "--resolution") settings.resolution = (uint32_t)std::atoi(value);
+        else if (arg == "--samples") settings.numSamples = (uint32_t)std::atoi(value);
+        else if (arg == "--iterations") settings.maxIterations = (uint32_t)std::atoi(value);
+        else if (arg == "--f0") settings.f0 = std::atof(value);
+        else if (arg == "--fresnel") settings.schlickFresnel = std::strcmp(value, "constant") != 0;
+        else if (arg == "--threads") settings.numThreads = (uint32_t)std::atoi(value);
+        else if (arg == "--compare") compareDir = value;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    try
+    {
+        LtshFitter fitter(settings);
+        std::printf("%ux%u cells, %u samples, %u iterations, F0 %.3f %s Fresnel\n", settings.resolution, settings.resolution,
+                    settings.numSamples, settings.maxIterations, settings.f0, settings.schlickFresnel ? "Schlick" : "constant");
+
+        for (int order : orders)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            FitTable table = order == 0 ? fitter.fitLtc() : fitter.fitLtsh(order);
+            auto end = std::chrono::high_resolution_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+
+            if (order == 0) saveLtcTables(outDir, table);
+            else saveLtshTables(outDir, order, table);
+
+            std::printf("%-8s %8.1f s  relative L2 error mean %.4f max %.4f, %zu cells above 0.1\n", tableName(order).c_str(), seconds,
+                        table.meanError(), table.maxError(), countAbove(table, 0.1));
+
+            if (!compareDir.empty())
+            {
+                FitTable previous = order == 0 ? loadLtcTables(compareDir, settings.resolution) : loadLtshTables(compareDir, order, settings.resolution);
+                fitter.evaluateTable(order, previous);
+                std::printf("%-8s            %s: mean %.4f max %.4f, %zu cells above 0.1\n", "", compareDir.c_str(),
+                            previous.meanError(), previous.maxError(), countAbove(previous, 0.1));
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+// Dithered against bilinear LTSH table lookup. Generates a G-buffer of a floor below a quad light whose roughness
+// grows from left to right, renders the specular term of the ground truth, LTC and both LTSH orders with either
+// lookup, and reports the shading time, the error against the ground truth and the pixel to pixel noise.
+//
+// usage: ltsh_lookup_bench [params=Data/Params] [threads=0] [width=320] [height=180]
+//
+// The noise is the RMS of the discrete Laplacian of the image relative to its mean, it grows with the dithering
+// pattern that TAA has to resolve. The ground truth is noisy itself (four sample sets picked per pixel), so its
+// error floor is shown next to the LTC baseline.
+
+#include "Reference/LightingPass.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+using namespace ltsh;
+
+namespace
+{
+    typedef CpuLightingPass::AreaLightRenderMode Mode;
+    typedef CpuLightingPass::LtshLookup Lookup;
+
+    const float kMinRoughness = 0.1f;
+    const float kMaxRoughness = 0.9f;
+
+    /** Ray cast the plane y = 0 from a camera looking down at it, the roughness is a ramp along x
+    */
+    GBufferFrame generateFloor(uint32_t width, uint32_t height)
+    {
+        GBufferFrame frame;
+        frame.width = width;
+        frame.height = height;
+        frame.posLightFlag.resize(frame.getPixelCount());
+        frame.normalLinearRoughness.resize(frame.getPixelCount());
+        frame.albedo.resize(frame.getPixelCount());
+        frame.specularRoughness.resize(frame.getPixelCount());
+
+        frame.camPosW = float3(0.f, 1.5f, -4.f);
+        float3 forward = normalize(float3(0.f, -0.45f, 1.f));
+        float3 right = normalize(cross(float3(0.f, 1.f, 0.f), forward));
+        float3 up = cross(forward, right);
+        float tanHalfFov = std::tan(0.5f * 60.f * float(kPi) / 180.f);
+        float aspect = float(width) / float(height);
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                float sx = (2.f * (x + 0.5f) / width - 1.f) * tanHalfFov * aspect;
+                float sy = (1.f - 2.f * (y + 0.5f) / height) * tanHalfFov;
+                float3 dir = normalize(forward + right * sx + up * sy);
+
+                size_t index = size_t(y) * width + x;
+                // pixels above the horizon stay empty
+                if (dir.y >= 0.f) continue;
+                float3 posW = frame.camPosW + dir * (-frame.camPosW.y / dir.y);
+
+                float roughness = kMinRoughness + (kMaxRoughness - kMinRoughness) * (x + 0.5f) / width;
+                frame.posLightFlag[index] = float4(posW, 0.f);
+                frame.normalLinearRoughness[index] = float4(0.f, 1.f, 0.f, roughness * roughness);
+                frame.albedo[index] = float4(0.5f, 0.5f, 0.5f, 1.f);
+                frame.specularRoughness[index] = float4(float3(0.04f), roughness);
+            }
+        }
+
+        // a 2 x 1 quad light facing down, tilted towards the camera
+        const float3 center(0.f, 1.2f, 2.f);
+        const float3 axisX(1.f, 0.f, 0.f);
+        const float3 axisY = normalize(float3(0.f, 0.3f, 1.f)) * 0.5f;
+        frame.areaLightPosW = { center - axisX + axisY, center - axisX - axisY, center + axisX - axisY, center + axisX + axisY };
+        frame.areaLight.posW = center;
+        frame.areaLight.dirW = normalize(cross(axisY, axisX));
+        frame.areaLight.intensity = float3(4.f);
+        frame.areaLight.surfaceArea = 4.f * length(axisX) * length(axisY);
+        return frame;
+    }
+
+    struct ImageStats
+    {
+        double rmse = 0;     // relative to the mean of the reference
+        double noise = 0;    // RMS Laplacian relative to the mean of the image
+    };
+
+    ImageStats computeStats(const GBufferFrame& frame, const Image& image, const Image& reference)
+    {
+        double sumSq = 0, sumRef = 0, sum = 0, lapSq = 0;
+        size_t count = 0, lapCount = 0;
+        for (uint32_t y = 1; y + 1 < image.height; y++)
+        {
+            for (uint32_t x = 1; x + 1 < image.width; x++)
+            {
+                // interior pixels of the floor only
+                bool inside = true;
+                for (int d = -1; d <= 1 && inside; d++)
+                {
+                    inside = frame.albedo[size_t(y + d) * frame.width + x].w > 0 && frame.albedo[size_t(y) * frame.width + x + d].w > 0;
+                }
+                if (!inside) continue;
+
+                for (int c = 0; c < 3; c++)
+                {
+                    double v = image.at(x, y)[c];
+                    double d = v - reference.at(x, y)[c];
+                    double lap = 4 * v - image.at(x - 1, y)[c] - image.at(x + 1, y)[c] - image.at(x, y - 1)[c] - image.at(x, y + 1)[c];
+                    sumSq += d * d;
+                    sumRef += reference.at(x, y)[c];
+                    sum += v;
+                    lapSq += lap * lap;
+                }
+                count += 3;
+                lapCount += 3;
+            }
+        }
+        ImageStats stats;
+        if (count == 0) return stats;
+        stats.rmse = std::sqrt(sumSq / count) / std::max(sumRef / count, 1e-12);
+        stats.noise = std::sqrt(lapSq / lapCount) / std::max(sum / count, 1e-12);
+        return stats;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string paramDir = argc > 1 ? argv[1] : "Data/Params";
+    uint32_t numThreads = argc > 2 ? (uint32_t)std::atoi(argv[2]) : 0;
+    uint32_t width = argc > 3 ? (uint32_t)std::atoi(argv[3]) : 320;
+    uint32_t height = argc > 4 ? (uint32_t)std::atoi(argv[4]) : 180;
+
+    try
+    {
+        LutTables tables;
+        tables.load(paramDir);
+
+        GBufferFrame frame = generateFloor(width, height);
+        CpuLightingPass pass(tables);
+        pass.setFrame(frame);
+
+        ThreadPool pool(numThreads);
+        const CpuLightingPass::DebugMode specular = CpuLightingPass::DebugMode::ShowSpecular;
+        std::printf("%ux%u pixels, %u threads, %ux%u tables, roughness %.1f to %.1f\n", width, height, pool.getThreadCount(),
+                    tables.getResolution(), tables.getResolution(), kMinRoughness, kMaxRoughness);
+
+        Image reference;
+        pass.render(pool, Mode::GroundTruth, specular, 16, reference);
+
+        struct Config
+        {
+            const char* name;
+            Mode mode;
+            Lookup lookup;
+        };
+        const Config configs[] =
+        {
+            { "gt", Mode::GroundTruth, Lookup::Dithered },
+            { "ltc", Mode::LTC, Lookup::Dithered },
+            { "ltsh dithered", Mode::LTSH, Lookup::Dithered },
+            { "ltsh bilinear", Mode::LTSH, Lookup::Bilinear },
+            { "ltsh_n2 dithered", Mode::LTSH_N2, Lookup::Dithered },
+            { "ltsh_n2 bilinear", Mode::LTSH_N2, Lookup::Bilinear },
+        };
+
+        std::printf("%-18s %10s %14s %10s %10s\n", "mode", "time ms", "pixels/s", "rel rmse", "noise");
+        for (const Config& config : configs)
+        {
+            pass.setLtshLookup(config.lookup);
+            Image image;
+            auto start = std::chrono::high_resolution_clock::now();
+            pass.render(pool, config.mode, specular, 16, image);
+            auto end = std::chrono::high_resolution_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+
+            ImageStats stats = computeStats(frame, image, reference);
+            std::printf("%-18s %10.2f %14.0f %10.4f %10.4f\n", config.name, seconds * 1e3, double(frame.getPixelCount()) / seconds,
+                        stats.rmse, stats.noise);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,343 @@
+// Offline CPU renderer for the lighting pass. Shades a G-buffer frame dumped by SimpleDeferred (key G) with one or
+// all area light render modes, writes one HDR image per mode and reports the shading throughput.
+//
+// usage: ltsh_render <gbuffer prefix> [--params Data/Params] [--mode all|gt|gt_mis|ltc|ltsh|ltsh_n2|ltc_brdf|ltsh_brdf|none]
+//                    [--debug 0-6] [--threads N] [--tile N] [--seed N] [--out prefix] [--format exr|pfm]
+//                    [--polygon x0,y0,x1,y1,...] [--lookup dithered|bilinear] [--trig exact|medium|fast]
+//                    [--frames N] [--profile file.jsonl] [--progressive samplesPerFrame]
+//
+// --polygon replaces the quad light of the frame by a polygon in its plane, given in the model space of
+// SimpleAreaLight where the quad spans [-1, 1]^2, e.g. a hexagon or a concave L-shape. Up to 8 vertices in CCW order.
+// --lookup selects how the LTSH modes fetch the tables, like the "LTSH Lookup" setting of the app.
+// --trig selects the acos/sincos/atan2 approximation of all modes with edge integrals, see Reference/FastMath.h.
+// --frames shades every mode N times and reports the median. --profile writes the light setup, lighting and capture
+// time of every frame and a summary per mode as JSON lines, in the format of the app's frame time log.
+// gt_mis is the ground truth with multiple importance sampling of the light and the LTC lobe, it has no GPU counterpart yet.
+// --progressive renders the ground truth modes (gt, gt_mis, ltc_brdf, ltsh_brdf) like the progressive ground truth of the app:
+// every frame evaluates the given number of samples and is averaged into a float32 history, until all 4 x 4096
+// samples are used or --frames frames are rendered. Reports the relative RMS difference of the image at every power
+// of two samples per pixel to the final image.
+
+#include "Reference/LightingPass.h"
+#include "FrameProfiler.h"
+#include "ProgressiveAccumulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    typedef CpuLightingPass::AreaLightRenderMode Mode;
+
+    struct ModeName
+    {
+        const char* name;
+        Mode mode;
+    };
+
+    // names of CpuLightingPass::DebugMode in the frame time log
+    const char* kDebugModeNames[] = { "disabled", "pos", "normals", "albedo", "lighting", "diffuse", "specular" };
+
+    const ModeName kModes[] =
+    {
+        { "gt", Mode::GroundTruth },
+        { "ltc", Mode::LTC },
+        { "ltsh", Mode::LTSH },
+        { "none", Mode::None },
+        { "ltc_brdf", Mode::LtcBrdf },
+        { "ltsh_brdf", Mode::LtshBrdf },
+        { "ltsh_n2", Mode::LTSH_N2 },
+        { "gt_mis", Mode::GroundTruthMis },
+    };
+
+    void printUsage()
+    {
+        std::printf("usage: ltsh_render <gbuffer prefix> [--params dir] [--mode all|gt|gt_mis|ltc|ltsh|ltsh_n2|ltc_brdf|ltsh_brdf|none]\n"
+                    "                   [--debug 0-6] [--threads N] [--tile N] [--seed N] [--out prefix] [--format exr|pfm]\n"
+                    "                   [--polygon x0,y0,x1,y1,...] [--lookup dithered|bilinear] [--trig exact|medium|fast]\n"
+                    "                   [--frames N] [--profile file.jsonl] [--progressive samplesPerFrame]\n");
+    }
+
+    /** Replace the quad light of the frame by a polygon given in the model space of the quad
+    */
+    void reshapeAreaLight(GBufferFrame& frame, const std::vector<float2>& polygon)
+    {
+        if (frame.areaLightPosW.size() != 4)
+        {
+            throw std::runtime_error("--polygon needs a frame with a quad light");
+        }
+        if (polygon.size() < 3 || polygon.size() > size_t(kMaxPolygonVertices))
+        {
+            throw std::runtime_error("--polygon needs 3 to " + std::to_string(kMaxPolygonVertices) + " vertices");
+        }
+        // the quad vertices are (-1, 1), (-1, -1), (1, -1), (1, 1) in model space
+        const std::vector<float3>& quad = frame.areaLightPosW;
+        float3 center = (quad[0] + quad[1] + quad[2] + quad[3]) * 0.25f;
+        float3 axisX = (quad[2] - quad[1]) * 0.5f;
+        float3 axisY = (quad[0] - quad[1]) * 0.5f;
+
+        float area = 0;
+        std::vector<float3> vertices;
+        for (size_t i = 0; i < polygon.size(); i++)
+        {
+            const float2& a = polygon[i];
+            const float2& b = polygon[(i + 1) % polygon.size()];
+            area += 0.5f * (a.x * b.y - a.y * b.x);
+            vertices.push_back(center + axisX * a.x + axisY * a.y);
+        }
+        frame.areaLight.surfaceArea = area * length(cross(axisX, axisY));
+        frame.areaLightPosW = vertices;
+    }
+
+    bool isGroundTruthMode(Mode mode)
+    {
+        return mode == Mode::GroundTruth || mode == Mode::LtcBrdf || mode == Mode::LtshBrdf || mode == Mode::GroundTruthMis;
+    }
+
+    /** Relative RMS difference of the pixel values of a to the reference, over all channels
+    */
+    double relativeRms(const Image& a, const Image& reference)
+    {
+        double sqError = 0, sqReference = 0;
+        for (size_t i = 0; i < a.pixels.size(); i++)
+        {
+            float3 d = a.pixels[i] - reference.pixels[i];
+            sqError += double(dot(d, d));
+            sqReference += double(dot(reference.pixels[i], reference.pixels[i]));
+        }
+        return sqReference > 0 ? std::sqrt(sqError / sqReference) : 0.0;
+    }
+
+    std::vector<float2> parsePolygon(const char* value)
+    {
+        std::vector<float> coords;
+        for (const char* p = value; *p;)
+        {
+            char* end;
+            coords.push_back(std::strtof(p, &end));
+            if (end == p) break;
+            p = *end == ',' ? end + 1 : end;
+        }
+        std::vector<float2> polygon;
+        for (size_t i = 0; i + 1 < coords.size(); i += 2)
+        {
+            polygon.push_back(float2(coords[i], coords[i + 1]));
+        }
+        return polygon;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::string prefix = argv[1];
+    std::string paramDir = "Data/Params";
+    std::string modeName = "all";
+    std::string outPrefix;
+    std::string format = "exr";
+    int debugMode = 0;
+    uint32_t numThreads = 0;
+    uint32_t tileSize = 16;
+    uint32_t seed = 0;
+    uint32_t numFrames = 1;
+    bool framesGiven = false;
+    uint32_t progressiveSamples = 0;
+    std::string profilePath;
+    std::vector<float2> polygon;
+    CpuLightingPass::LtshLookup lookup = CpuLightingPass::LtshLookup::Dithered;
+    TrigPrecision trig = TrigPrecision::Exact;
+
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--params") paramDir = value;
+        else if (arg == "--mode") modeName = value;
+        else if (arg == "--debug") debugMode = std::atoi(value);
+        else if (arg == "--threads") numThreads = (uint32_t)std::atoi(value);
+        else if (arg == "--tile") tileSize = (uint32_t)std::atoi(value);
+        else if (arg == "--seed") seed = (uint32_t)std::atoi(value);
+        else if (arg == "--out") outPrefix = value;
+        else if (arg == "--frames")
+        {
+            numFrames = std::max(std::atoi(value), 1);
+            framesGiven = true;
+        }
+        else if (arg == "--progressive") progressiveSamples = (uint32_t)std::max(std::atoi(value), 1);
+        else if (arg == "--profile") profilePath = value;
+        else if (arg == "--format") format = value;
+        else if (arg == "--polygon") polygon = parsePolygon(value);
+        else if (arg == "--lookup") lookup = std::strcmp(value, "bilinear") == 0 ? CpuLightingPass::LtshLookup::Bilinear : CpuLightingPass::LtshLookup::Dithered;
+        else if (arg == "--trig") trig = std::strcmp(value, "fast") == 0 ? TrigPrecision::Fast : std::strcmp(value, "medium") == 0 ? TrigPrecision::Medium : TrigPrecision::Exact;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    if (outPrefix.empty()) outPrefix = prefix;
+    if (debugMode < 0 || debugMode > 6)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<ModeName> modes;
+    for (const ModeName& m : kModes)
+    {
+        if (modeName == "all" || modeName == m.name) modes.push_back(m);
+    }
+    if (modes.empty())
+    {
+        std::printf("unknown mode %s\n", modeName.c_str());
+        return 1;
+    }
+
+    try
+    {
+        LutTables tables;
+        tables.load(paramDir);
+
+        GBufferFrame frame;
+        frame.load(prefix);
+        if (!polygon.empty())
+        {
+            reshapeAreaLight(frame, polygon);
+        }
+
+        CpuLightingPass pass(tables, seed);
+        pass.setLtshLookup(lookup);
+        for (const ModeName& m : kModes)
+        {
+            pass.setTrigPrecision(m.mode, trig);
+        }
+
+        ThreadPool pool(numThreads);
+        std::printf("%ux%u pixels, %u threads, %ux%u tiles\n", frame.width, frame.height, pool.getThreadCount(), tileSize, tileSize);
+
+        std::ofstream profileLog;
+        CpuTimerBackend timer;
+        uint32_t framesPerMode = numFrames;
+        if (progressiveSamples > 0)
+        {
+            ProgressiveAccumulation accumulation(CpuLightingPass::kNumSamples, CpuLightingPass::kNumSampleSets, progressiveSamples);
+            framesPerMode = std::max(framesPerMode, accumulation.getMaxSamplesPerPixel() / accumulation.getSamplesPerFrame());
+        }
+        FrameProfiler profiler(timer, framesPerMode * uint32_t(modes.size()));
+        if (!profilePath.empty())
+        {
+            profileLog.open(profilePath);
+            if (!profileLog)
+            {
+                throw std::runtime_error("can't write " + profilePath);
+            }
+            profiler.setJsonStream(&profileLog);
+        }
+
+        Image image;
+        uint64_t frameId = 0;
+        for (const ModeName& m : modes)
+        {
+            std::string filename = outPrefix + "_" + m.name + "." + format;
+            if (progressiveSamples > 0 && isGroundTruthMode(m.mode))
+            {
+                ProgressiveAccumulation accumulation(CpuLightingPass::kNumSamples, CpuLightingPass::kNumSampleSets, progressiveSamples);
+                uint32_t maxFrames = accumulation.getMaxSamplesPerPixel() / accumulation.getSamplesPerFrame();
+                uint32_t frames = framesGiven ? std::min(numFrames, maxFrames) : maxFrames;
+
+                // the history at every power of two samples per pixel, compared to the final one at the end
+                Image history;
+                std::vector<std::pair<uint32_t, Image>> snapshots;
+                SampleWindow window;
+                uint32_t framesBefore;
+                for (uint32_t i = 0; i < frames && accumulation.nextFrame(window, framesBefore); i++)
+                {
+                    profiler.beginFrame(frameId++, m.name, kDebugModeNames[debugMode]);
+                    {
+                        FrameProfiler::Scope scope(profiler, FrameStage::LightUpload);
+                        pass.setFrame(frame);
+                        pass.setSampleWindow(window);
+                    }
+                    {
+                        FrameProfiler::Scope scope(profiler, FrameStage::Lighting);
+                        pass.render(pool, m.mode, (CpuLightingPass::DebugMode)debugMode, tileSize, image);
+                        if (framesBefore == 0) history = image;
+                        else accumulateFrame(&history.pixels[0].x, &image.pixels[0].x, 3 * history.pixels.size(), framesBefore);
+                    }
+                    uint32_t spp = accumulation.getSamplesPerPixel();
+                    if ((spp & (spp - 1)) == 0) snapshots.emplace_back(spp, history);
+                    if (i + 1 == frames)
+                    {
+                        FrameProfiler::Scope scope(profiler, FrameStage::Capture);
+                        writeImage(filename, history);
+                    }
+                    profiler.endFrame();
+                }
+                pass.setSampleWindow(SampleWindow{ 0, CpuLightingPass::kNumSamples / CpuLightingPass::kSampleReductionFactor, 0 });
+
+                double ms = profiler.getPercentiles(FrameStage::Lighting, false, m.name).p50;
+                std::printf("%-10s %u spp in %u frames of %u samples, %.1f ms per frame  -> %s\n", m.name, accumulation.getSamplesPerPixel(),
+                            frames, accumulation.getSamplesPerFrame(), ms, filename.c_str());
+                for (const auto& snapshot : snapshots)
+                {
+                    if (snapshot.first < accumulation.getSamplesPerPixel())
+                    {
+                        std::printf("  %6u spp  rel. rms to %u spp %.3e\n", snapshot.first, accumulation.getSamplesPerPixel(), relativeRms(snapshot.second, history));
+                    }
+                }
+                if (profileLog.is_open()) profiler.writeSummary(profileLog, m.name);
+                continue;
+            }
+
+            for (uint32_t i = 0; i < numFrames; i++)
+            {
+                profiler.beginFrame(frameId++, m.name, kDebugModeNames[debugMode]);
+                {
+                    // the light and its ground truth samples are set up every frame like the app uploads them
+                    FrameProfiler::Scope scope(profiler, FrameStage::LightUpload);
+                    pass.setFrame(frame);
+                }
+                {
+                    FrameProfiler::Scope scope(profiler, FrameStage::Lighting);
+                    pass.render(pool, m.mode, (CpuLightingPass::DebugMode)debugMode, tileSize, image);
+                }
+                if (i + 1 == numFrames)
+                {
+                    FrameProfiler::Scope scope(profiler, FrameStage::Capture);
+                    writeImage(filename, image);
+                }
+                profiler.endFrame();
+            }
+            double seconds = profiler.getPercentiles(FrameStage::Lighting, false, m.name).p50 * 1e-3;
+            std::printf("%-10s %8.3f s %12.0f pixels/s  -> %s\n", m.name, seconds, double(frame.getPixelCount()) / seconds, filename.c_str());
+            if (profileLog.is_open()) profiler.writeSummary(profileLog, m.name);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
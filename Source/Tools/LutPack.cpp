@@ -0,0 +1,68 @@
+// Offline packer for the lookup tables. Converts the fitted float64 .npy tables into the texture-ready half float
+// layout once and stores them in a single bundle that SimpleDeferred maps at startup.
+// --check does not write anything, it verifies the payload checksums of an existing bundle and the checksums of the
+// .npy files it was packed from, which startup skips, and exits with 1 if they don't match.
+//
+// usage: lut_pack [--check] [paramDir=Data/Params] [bundle=<paramDir>/luts.bundle]
+
+#include "LutBundle.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    bool check = argc > 1 && std::string(argv[1]) == "--check";
+    if (check)
+    {
+        argc--;
+        argv++;
+    }
+    std::string paramDir = argc > 1 ? argv[1] : "Data/Params";
+    std::string bundleFile = argc > 2 ? argv[2] : paramDir + "/luts.bundle";
+
+    try
+    {
+        if (check)
+        {
+            LutBundle bundle(bundleFile);
+            bundle.verify(paramDir);
+            std::printf("%s matches the tables in %s%s\n", bundleFile.c_str(), paramDir.c_str(),
+                        bundle.isUpToDate(paramDir) ? "" : ", but the stamps differ (e.g. touched files), the app will rebuild it once");
+            return 0;
+        }
+
+        std::vector<PackedLut> tables;
+        size_t sourceBytes = 0;
+        for (int i = 0; i < LutTableCount; i++)
+        {
+            tables.push_back(packLookupTable(LutTable(i), paramDir));
+            sourceBytes += MappedFile(paramDir + "/" + getLutTableInfo(LutTable(i)).filename).size();
+        }
+        writeLutBundle(bundleFile, tables);
+
+        // read the bundle back to make sure it validates and matches what was packed
+        LutBundle bundle(bundleFile);
+        bundle.verify(paramDir);
+        for (const PackedLut& packed : tables)
+        {
+            const LutBundle::Table* pTable = bundle.findTable(packed.name);
+            if (!pTable || pTable->data.size() != packed.data.size() || !std::equal(packed.data.begin(), packed.data.end(), pTable->data.begin()))
+            {
+                std::printf("verification of %s failed\n", packed.name.c_str());
+                return 1;
+            }
+            std::printf("%-12s %4ux%-4u %s\n", pTable->name.c_str(), pTable->width, pTable->height, pTable->format == LutFormat::R16Float ? "R16F" : "RGBA16F");
+        }
+        std::printf("wrote %s: %zu bytes (sources %zu bytes)\n", bundleFile.c_str(), MappedFile(bundleFile).size(), sourceBytes);
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+// Cost and accuracy of PolygonSH<Order> for every supported order, to pick the cheapest order that meets an error
+// budget. For random clipped polygons it reports the float throughput, the float error against the double
+// projection, the coefficient error against brute force quadrature, and the relative error of lighting a
+// normalized cosine power lobe with the truncated expansion, i.e. the error a material of that glossiness would see.
+//
+// usage: polygon_sh_error [polygons=256] [quadraturePoints=1000000]
+
+#include "Reference/LTSHn2.h"
+#include "Reference/PolygonSH.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    static const int kMaxCoeffs = (kPolygonSHMaxOrder + 1) * (kPolygonSHMaxOrder + 1);
+    static const double kLobeExponents[] = { 1, 4, 16, 64 };
+    static const int kNumLobeExponents = sizeof(kLobeExponents) / sizeof(kLobeExponents[0]);
+
+    struct Polygon
+    {
+        double3 v[kMaxClippedVertices];
+        int numVerts;
+    };
+
+    // random regular polygons in front of the shading point. Unlike LtshBench the vertices are not jittered, the
+    // closed form solid angle (and the inside test below) need convex spherical polygons.
+    std::vector<Polygon> createPolygons(size_t count)
+    {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<double> u(-1.0, 1.0);
+        std::vector<Polygon> polygons(count);
+        for (size_t p = 0; p < count; p++)
+        {
+            double3 center(u(rng), u(rng), 1.5 + u(rng));
+            int n = 3 + int(p % 3);
+            for (int i = 0; i < n; i++)
+            {
+                double a = -2.0 * kPi * double(i) / double(n);
+                polygons[p].v[i] = normalize(center + double3(0.5 * std::cos(a), 0.5 * std::sin(a), 0.0));
+            }
+            polygons[p].numVerts = n;
+        }
+        return polygons;
+    }
+
+    // evenly distributed directions, every point represents 4 pi / count steradian
+    std::vector<double3> fibonacciSphere(size_t count)
+    {
+        std::vector<double3> points(count);
+        const double golden = kPi * (3.0 - std::sqrt(5.0));
+        for (size_t i = 0; i < count; i++)
+        {
+            double z = 1.0 - (2.0 * double(i) + 1.0) / double(count);
+            double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+            points[i] = double3(r * std::cos(golden * double(i)), r * std::sin(golden * double(i)), z);
+        }
+        return points;
+    }
+
+    /** Real SH basis of all bands up to kPolygonSHMaxOrder, evaluated through PolygonSH<>::evaluate with unit vectors
+    */
+    void shBasis(const double3& dir, double Y[kMaxCoeffs])
+    {
+        double unit[kMaxCoeffs] = {};
+        for (int i = 0; i < kMaxCoeffs; i++)
+        {
+            unit[i] = 1.0;
+            Y[i] = PolygonSH<kPolygonSHMaxOrder>::evaluate(dir, unit);
+            unit[i] = 0.0;
+        }
+    }
+
+    /** Whether a quadrature point lies in the polygon, signed with the orientation like solidAngle()
+    */
+    double insideSign(const Polygon& poly, const double3& d)
+    {
+        // counter-clockwise polygons have inward edge normals and a positive solid angle, clockwise ones both flipped.
+        // The orientation has to be fixed up front, the antipodal polygon is on the same side of every edge plane.
+        double sign = determinant(double3x3(poly.v[0], poly.v[1], poly.v[2])) > 0 ? 1.0 : -1.0;
+        for (int i = 0; i < poly.numVerts; i++)
+        {
+            if (sign * dot(d, cross(poly.v[i], poly.v[(i + 1) % poly.numVerts])) <= 0) return 0;
+        }
+        return sign;
+    }
+
+    template<typename Func>
+    double timeIt(Func func)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    struct OrderStats
+    {
+        double polygonsPerSecond = 0;
+        double floatError = 0;
+        double quadratureError = 0;
+        double lobeError[kNumLobeExponents] = {};
+    };
+
+    template<int Order>
+    OrderStats measure(const std::vector<Polygon>& polygons, const std::vector<std::vector<double>>& reference,
+                       const std::vector<std::vector<double>>& lobeCoeffs, const std::vector<std::vector<double>>& lobeReference)
+    {
+        typedef PolygonSH<Order> SH;
+        OrderStats stats;
+        std::vector<float> single(polygons.size() * SH::kNumCoeffs);
+        std::vector<double> full(polygons.size() * SH::kNumCoeffs);
+
+        std::vector<float3> verts(polygons.size() * kMaxClippedVertices);
+        for (size_t p = 0; p < polygons.size(); p++)
+        {
+            for (int i = 0; i < polygons[p].numVerts; i++) verts[p * kMaxClippedVertices + i] = float3(polygons[p].v[i]);
+        }
+
+        // repeat the small set so the timing is not dominated by the clock resolution
+        const int repetitions = 16;
+        double t = timeIt([&]()
+        {
+            for (int r = 0; r < repetitions; r++)
+            {
+                for (size_t p = 0; p < polygons.size(); p++)
+                {
+                    SH::project(&verts[p * kMaxClippedVertices], polygons[p].numVerts, &single[p * SH::kNumCoeffs]);
+                }
+            }
+        });
+        stats.polygonsPerSecond = double(polygons.size() * repetitions) / t;
+
+        for (size_t p = 0; p < polygons.size(); p++)
+        {
+            double* coeffs = &full[p * SH::kNumCoeffs];
+            SH::project(polygons[p].v, polygons[p].numVerts, coeffs);
+            for (int i = 0; i < SH::kNumCoeffs; i++)
+            {
+                stats.floatError = std::max(stats.floatError, std::abs(double(single[p * SH::kNumCoeffs + i]) - coeffs[i]));
+                stats.quadratureError = std::max(stats.quadratureError, std::abs(reference[p][i] - coeffs[i]));
+            }
+
+            // lighting with a cosine power lobe around the polygon center, relative to the exact integral
+            for (int e = 0; e < kNumLobeExponents; e++)
+            {
+                const std::vector<double>& lobe = lobeCoeffs[p * kNumLobeExponents + e];
+                double shaded = 0;
+                for (int i = 0; i < SH::kNumCoeffs; i++) shaded += coeffs[i] * lobe[i];
+                double exact = lobeReference[p][e];
+                stats.lobeError[e] = std::max(stats.lobeError[e], std::abs(shaded - exact) / std::abs(exact));
+            }
+        }
+        return stats;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? (size_t)std::atoll(argv[1]) : 256;
+    size_t numPoints = argc > 2 ? (size_t)std::atoll(argv[2]) : 1000000;
+
+    std::vector<Polygon> polygons = createPolygons(count);
+    std::vector<double3> points = fibonacciSphere(numPoints);
+    const double dOmega = 4.0 * kPi / double(numPoints);
+
+    // a lobe around axis a has the SH coefficients sqrt(4 pi / (2l + 1)) * z_l * Y_lm(a), where z_l are the zonal
+    // coefficients of the same lobe around +z, so only those have to be integrated
+    std::vector<std::vector<double>> reference(count, std::vector<double>(kMaxCoeffs, 0.0));
+    std::vector<std::vector<double>> lobeReference(count, std::vector<double>(kNumLobeExponents, 0.0));
+    std::vector<double3> axes(count);
+    for (size_t p = 0; p < count; p++)
+    {
+        double3 sum(0.0);
+        for (int i = 0; i < polygons[p].numVerts; i++) sum += polygons[p].v[i];
+        axes[p] = normalize(sum);
+    }
+
+    auto lobe = [](int e, double cosTheta)
+    {
+        // normalized so the lobe integrates to one over the hemisphere
+        return (kLobeExponents[e] + 1.0) / (2.0 * kPi) * std::pow(std::max(0.0, cosTheta), kLobeExponents[e]);
+    };
+
+    double zonal[kNumLobeExponents][kPolygonSHMaxOrder + 1] = {};
+    double Y[kMaxCoeffs];
+    for (const double3& d : points)
+    {
+        shBasis(d, Y);
+        for (int e = 0; e < kNumLobeExponents; e++)
+        {
+            for (int l = 0; l <= kPolygonSHMaxOrder; l++) zonal[e][l] += lobe(e, d.z) * Y[l * l + l] * dOmega;
+        }
+
+        for (size_t p = 0; p < count; p++)
+        {
+            double inside = insideSign(polygons[p], d);
+            if (inside == 0) continue;
+            for (int i = 0; i < kMaxCoeffs; i++) reference[p][i] += inside * Y[i] * dOmega;
+            for (int e = 0; e < kNumLobeExponents; e++) lobeReference[p][e] += inside * lobe(e, dot(d, axes[p])) * dOmega;
+        }
+    }
+
+    // per polygon lobe coefficients, indexed [p * kNumLobeExponents + e]
+    std::vector<std::vector<double>> lobeCoeffs(count * kNumLobeExponents, std::vector<double>(kMaxCoeffs));
+    for (size_t p = 0; p < count; p++)
+    {
+        shBasis(axes[p], Y);
+        for (int e = 0; e < kNumLobeExponents; e++)
+        {
+            for (int l = 0; l <= kPolygonSHMaxOrder; l++)
+            {
+                for (int i = l * l; i < (l + 1) * (l + 1); i++)
+                {
+                    lobeCoeffs[p * kNumLobeExponents + e][i] = std::sqrt(4.0 * kPi / (2.0 * l + 1.0)) * zonal[e][l] * Y[i];
+                }
+            }
+        }
+    }
+
+    OrderStats stats[kPolygonSHMaxOrder + 1];
+    stats[2] = measure<2>(polygons, reference, lobeCoeffs, lobeReference);
+    stats[3] = measure<3>(polygons, reference, lobeCoeffs, lobeReference);
+    stats[4] = measure<4>(polygons, reference, lobeCoeffs, lobeReference);
+    stats[5] = measure<5>(polygons, reference, lobeCoeffs, lobeReference);
+    stats[6] = measure<6>(polygons, reference, lobeCoeffs, lobeReference);
+    stats[7] = measure<7>(polygons, reference, lobeCoeffs, lobeReference);
+    stats[8] = measure<8>(polygons, reference, lobeCoeffs, lobeReference);
+
+    // the hand-written variants for comparison, they have to agree with PolygonSH<2> and PolygonSH<4>
+    double legacyError[2] = {};
+    for (size_t p = 0; p < count; p++)
+    {
+        double legacy[kNumCoeffsN4], generic[kNumCoeffsN4];
+        polygonSHN2(polygons[p].v, polygons[p].numVerts, legacy);
+        PolygonSH<2>::project(polygons[p].v, polygons[p].numVerts, generic);
+        for (int i = 0; i < kNumCoeffsN2; i++) legacyError[0] = std::max(legacyError[0], std::abs(legacy[i] - generic[i]));
+        polygonSH(polygons[p].v, polygons[p].numVerts, legacy);
+        PolygonSH<4>::project(polygons[p].v, polygons[p].numVerts, generic);
+        for (int i = 0; i < kNumCoeffsN4; i++) legacyError[1] = std::max(legacyError[1], std::abs(legacy[i] - generic[i]));
+    }
+
+    std::printf("polygons: %zu, quadrature points: %zu\n", count, numPoints);
+    std::printf("%-6s %7s %12s %11s %11s", "order", "coeffs", "polygons/s", "float err", "quad err");
+    for (int e = 0; e < kNumLobeExponents; e++) std::printf("   cos^%-4g", kLobeExponents[e]);
+    std::printf("\n");
+    for (int order = 2; order <= kPolygonSHMaxOrder; order++)
+    {
+        const OrderStats& s = stats[order];
+        std::printf("%-6d %7d %12.0f %11.3g %11.3g", order, (order + 1) * (order + 1), s.polygonsPerSecond, s.floatError, s.quadratureError);
+        for (int e = 0; e < kNumLobeExponents; e++) std::printf(" %10.3g", s.lobeError[e]);
+        std::printf("\n");
+    }
+    std::printf("max deviation from polygonSHN2: %.3g, from polygonSH: %.3g\n", legacyError[0], legacyError[1]);
+    return 0;
+}
@@ -0,0 +1,468 @@
+// Generator for the order-N polygon SH projection. Picks the lobe directions, inverts the per band zonal to SH
+// matrices in double precision and writes them as constexpr tables for PolygonSH<Order> plus a Slang module with
+// the matching unrolled shader code. The first 9 lobes are the ones of the hand-written N=4 code in LTSH.slang, the
+// extra lobes for orders 5 to 8 are chosen to keep the projection matrices well conditioned.
+//
+// usage: polygon_sh_gen [header=Source/Reference/PolygonSHTables.h] [shader=Data/PolygonSH.slang]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const int kMaxOrder = 8;
+    const int kNumLobes = 2 * kMaxOrder + 1;
+    const double kPi = 3.14159265358979323846;
+
+    struct Dir
+    {
+        double x, y, z;
+    };
+
+    // lobes of the N=4 code, their projection keeps working for orders 2 to 4
+    const Dir kLegacyLobes[9] =
+    {
+        { 0.866025, -0.500001, -0.000004 },
+        { -0.759553, 0.438522, -0.480394 },
+        { -0.000002, 0.638694, 0.769461 },
+        { -0.000004, -1.000000, -0.000004 },
+        { -0.000007, 0.000003, -1.000000 },
+        { -0.000002, -0.638694, 0.769461 },
+        { -0.974097, 0.000007, -0.226131 },
+        { -0.000003, 0.907079, -0.420960 },
+        { -0.960778, 0.000007, -0.277320 },
+    };
+
+    typedef std::vector<std::vector<double>> Matrix;
+
+    double factorial(int n)
+    {
+        double f = 1;
+        for (int i = 2; i <= n; i++) f *= i;
+        return f;
+    }
+
+    /** Normalization of the real SH basis Y_lm = K_lm * P_l^|m|(z) * {cos, sin}(|m| phi), including the sqrt(2) of m != 0
+    */
+    double shNormalization(int l, int m)
+    {
+        int am = std::abs(m);
+        double k = std::sqrt((2 * l + 1) / (4 * kPi) * factorial(l - am) / factorial(l + am));
+        return m == 0 ? k : std::sqrt(2.0) * k;
+    }
+
+    /** Real SH basis function in the convention of evaluateSH(), i.e. without the Condon-Shortley phase
+    */
+    double shBasis(int l, int m, const Dir& d)
+    {
+        double len = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+        double x = d.x / len, y = d.y / len, z = d.z / len;
+        int am = std::abs(m);
+
+        // (x + iy)^|m| = sin^|m|(theta) * (cos(|m| phi) + i sin(|m| phi))
+        double c = 1, s = 0;
+        for (int i = 0; i < am; i++)
+        {
+            double t = x * c - y * s;
+            s = x * s + y * c;
+            c = t;
+        }
+
+        // associated Legendre polynomial without the sin^|m| factor
+        double pmm = 1;
+        for (int i = 1; i <= am; i++) pmm *= 2 * i - 1;
+        double p = pmm;
+        if (l > am)
+        {
+            double prev = pmm;
+            p = (2 * am + 1) * z * pmm;
+            for (int n = am + 2; n <= l; n++)
+            {
+                double next = ((2 * n - 1) * z * p - (n + am - 1) * prev) / (n - am);
+                prev = p;
+                p = next;
+            }
+        }
+        return shNormalization(l, m) * p * (m < 0 ? s : c);
+    }
+
+    /** Gauss-Jordan inversion with partial pivoting, returns false for a singular matrix
+    */
+    bool invert(Matrix a, Matrix& inv)
+    {
+        size_t n = a.size();
+        inv.assign(n, std::vector<double>(n, 0.0));
+        for (size_t i = 0; i < n; i++) inv[i][i] = 1;
+
+        for (size_t col = 0; col < n; col++)
+        {
+            size_t pivot = col;
+            for (size_t r = col + 1; r < n; r++)
+            {
+                if (std::abs(a[r][col]) > std::abs(a[pivot][col])) pivot = r;
+            }
+            if (std::abs(a[pivot][col]) < 1e-12) return false;
+            std::swap(a[col], a[pivot]);
+            std::swap(inv[col], inv[pivot]);
+
+            double scale = 1.0 / a[col][col];
+            for (size_t c = 0; c < n; c++)
+            {
+                a[col][c] *= scale;
+                inv[col][c] *= scale;
+            }
+            for (size_t r = 0; r < n; r++)
+            {
+                if (r == col || a[r][col] == 0) continue;
+                double f = a[r][col];
+                for (size_t c = 0; c < n; c++)
+                {
+                    a[r][c] -= f * a[col][c];
+                    inv[r][c] -= f * inv[col][c];
+                }
+            }
+        }
+        return true;
+    }
+
+    /** Matrix mapping the SH coefficients of band l to the unnormalized zonal integrals int P_l(dot(w_j, s)) ds of the
+        first 2l + 1 lobes, by the addition theorem row j is 4 pi / (2l + 1) * Y_lm(w_j)
+    */
+    Matrix zonalMatrix(int l, const std::vector<Dir>& lobes)
+    {
+        int n = 2 * l + 1;
+        Matrix m(n, std::vector<double>(n));
+        for (int j = 0; j < n; j++)
+        {
+            for (int k = 0; k < n; k++)
+            {
+                m[j][k] = 4 * kPi / n * shBasis(l, k - l, lobes[j]);
+            }
+        }
+        return m;
+    }
+
+    double frobeniusNorm(const Matrix& m)
+    {
+        double sum = 0;
+        for (const auto& row : m)
+        {
+            for (double v : row) sum += v * v;
+        }
+        return std::sqrt(sum);
+    }
+
+    Dir roundLobe(Dir d)
+    {
+        // same precision as the legacy lobes so the printed values are exactly the ones the matrices were built from
+        double len = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+        d.x = std::round(d.x / len * 1e6) / 1e6;
+        d.y = std::round(d.y / len * 1e6) / 1e6;
+        d.z = std::round(d.z / len * 1e6) / 1e6;
+        return d;
+    }
+
+    /** Add two lobes per band above 4. Every band only sees its first 2l + 1 lobes, so the bands can be handled one
+        after the other. The pair is picked from random candidates to minimize the norm of the inverse, which bounds
+        how much the float error of the zonal integrals is amplified.
+    */
+    std::vector<Dir> chooseLobes()
+    {
+        std::vector<Dir> lobes(kLegacyLobes, kLegacyLobes + 9);
+        std::mt19937 rng(20180716);
+        std::normal_distribution<double> n01;
+        auto randomDir = [&]() { return roundLobe({ n01(rng), n01(rng), n01(rng) }); };
+
+        for (int l = 5; l <= kMaxOrder; l++)
+        {
+            double bestNorm = 1e300;
+            Dir best[2] = {};
+            for (int trial = 0; trial < 20000; trial++)
+            {
+                lobes.resize(2 * l - 1);
+                lobes.push_back(randomDir());
+                lobes.push_back(randomDir());
+                Matrix inv;
+                if (!invert(zonalMatrix(l, lobes), inv)) continue;
+                double norm = frobeniusNorm(inv);
+                if (norm < bestNorm)
+                {
+                    bestNorm = norm;
+                    best[0] = lobes[2 * l - 1];
+                    best[1] = lobes[2 * l];
+                }
+            }
+            lobes.resize(2 * l - 1);
+            lobes.push_back(best[0]);
+            lobes.push_back(best[1]);
+        }
+        return lobes;
+    }
+
+    /** Coefficients of the zonal recurrence S_l = A_l * total_{l-1} + B_l * S_{l-2}
+    */
+    double zonalA(int l) { return double(2 * l - 1) / double(l * (l + 1)); }
+    double zonalB(int l) { return double((l - 2) * (l - 1)) / double(l * (l + 1)); }
+
+    std::string fmt(const char* format, double v)
+    {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), format, v);
+        return buf;
+    }
+
+    void writeFile(const std::string& filename, const std::string& text)
+    {
+        FILE* pFile = std::fopen(filename.c_str(), "wb");
+        if (!pFile) throw std::runtime_error("io error: could not create " + filename);
+        bool ok = std::fwrite(text.data(), 1, text.size(), pFile) == text.size();
+        ok &= std::fclose(pFile) == 0;
+        if (!ok) throw std::runtime_error("io error: could not write " + filename);
+    }
+
+    std::string generateHeader(const std::vector<Dir>& lobes, const std::vector<Matrix>& projection)
+    {
+        std::string s;
+        s += "#pragma once\n\n";
+        s += "// Generated by polygon_sh_gen (Source/Tools/PolygonSHGen.cpp), do not edit.\n";
+        s += "// Lobe directions and per band zonal to SH projection matrices for PolygonSH<Order> in PolygonSH.h.\n\n";
+        s += "namespace ltsh\n{\n";
+        s += "    // Highest order the tables cover\n";
+        s += "    static const int kPolygonSHMaxOrder = " + std::to_string(kMaxOrder) + ";\n\n";
+        s += "    /** Lobe directions, order N uses the first 2N + 1\n    */\n";
+        s += "    constexpr double kPolygonSHLobes[" + std::to_string(kNumLobes) + "][3] =\n    {\n";
+        for (const Dir& d : lobes)
+        {
+            s += "        { " + fmt("%.6f", d.x) + ", " + fmt("%.6f", d.y) + ", " + fmt("%.6f", d.z) + " },\n";
+        }
+        s += "    };\n\n";
+
+        s += "    /** Offset of band l in kPolygonSHProjection, bands 1 to kPolygonSHMaxOrder are stored back to back\n    */\n";
+        s += "    constexpr int polygonSHProjectionOffset(int l)\n    {\n";
+        s += "        return l <= 1 ? 0 : polygonSHProjectionOffset(l - 1) + (2 * l - 1) * (2 * l - 1);\n    }\n\n";
+
+        size_t total = 0;
+        for (int l = 1; l <= kMaxOrder; l++) total += (2 * l + 1) * (2 * l + 1);
+        s += "    /** Row-major (2l + 1) x (2l + 1) matrix per band l mapping the unnormalized zonal integrals of the first\n";
+        s += "        2l + 1 lobes to the SH coefficients l * l .. l * l + 2l\n    */\n";
+        s += "    constexpr double kPolygonSHProjection[" + std::to_string(total) + "] =\n    {\n";
+        for (int l = 1; l <= kMaxOrder; l++)
+        {
+            s += "        // band " + std::to_string(l) + "\n";
+            for (const auto& row : projection[l])
+            {
+                s += "       ";
+                for (double v : row) s += " " + fmt("%.17g", v) + ",";
+                s += "\n";
+            }
+        }
+        s += "    };\n\n";
+
+        s += "    /** Normalization of the real SH basis, including the sqrt(2) of the non-zonal functions\n    */\n";
+        s += "    constexpr double kPolygonSHNormalization[" + std::to_string((kMaxOrder + 1) * (kMaxOrder + 1)) + "] =\n    {\n";
+        for (int l = 0; l <= kMaxOrder; l++)
+        {
+            s += "       ";
+            for (int m = -l; m <= l; m++) s += " " + fmt("%.17g", shNormalization(l, m)) + ",";
+            s += "\n";
+        }
+        s += "    };\n}\n";
+        return s;
+    }
+
+    std::string generateShader(const std::vector<Dir>& lobes, const std::vector<Matrix>& projection)
+    {
+        std::string s;
+        s += "// Generated by polygon_sh_gen (Source/Tools/PolygonSHGen.cpp), do not edit.\n";
+        s += "// Closed-form SH projection of polygonal lights for orders 2 to " + std::to_string(kMaxOrder) + ", the shader counterpart of\n";
+        s += "// PolygonSH<Order> in Source/Reference/PolygonSH.h. The order is selected with POLYGON_SH_ORDER.\n\n";
+        s += "#ifndef _FALCOR_POLYGON_SH_SLANG_\n#define _FALCOR_POLYGON_SH_SLANG_\n\n";
+        s += "__import LTSH;\n__import Polygon;\n\n";
+        s += "#ifndef POLYGON_SH_ORDER\n#define POLYGON_SH_ORDER 4\n#endif\n\n";
+        s += "#if POLYGON_SH_ORDER < 2 || POLYGON_SH_ORDER > " + std::to_string(kMaxOrder) + "\n";
+        s += "#error POLYGON_SH_ORDER has to be between 2 and " + std::to_string(kMaxOrder) + "\n#endif\n\n";
+        s += "#define POLYGON_SH_NUM_BANDS (POLYGON_SH_ORDER + 1)\n";
+        s += "#define POLYGON_SH_NUM_COEFFS (POLYGON_SH_NUM_BANDS * POLYGON_SH_NUM_BANDS)\n";
+        s += "#define POLYGON_SH_NUM_LOBES (2 * POLYGON_SH_ORDER + 1)\n\n";
+
+        // boundary integrals, the recurrence is unrolled with the constants folded in
+        s += "void boundaryOrder(float a, float b, float x, float cosX, float sinX, inout float B_n[POLYGON_SH_ORDER]) {\n";
+        s += "    float z = a*cosX + b*sinX;\n";
+        s += "    float tmp1 = a*sinX - b*cosX;\n";
+        s += "    float tmp2 = a*a+b*b-1.0;\n\n";
+        s += "    B_n[0] = x;\n";
+        s += "    B_n[1] = tmp1 + b;\n\n";
+        s += "    float D_next = 3.0 * B_n[1];\n";
+        s += "    float D_prev = x;\n";
+        s += "    float P_prev = 1.0, P = z;\n";
+        s += "    float Pa_prev = 1.0, Pa = a;\n";
+        s += "    float C_n, temp;\n";
+        for (int i = 2; i < kMaxOrder; i++)
+        {
+            s += "\n#if POLYGON_SH_ORDER > " + std::to_string(i) + "\n";
+            if (i > 2)
+            {
+                // advance the Legendre polynomials to P_{i-1}
+                int k = i - 1;
+                std::string a = fmt("%.9g", double(2 * k - 1) / k), b = fmt("%.9g", double(k - 1) / k);
+                s += "    temp = " + a + " * z * P - " + b + " * P_prev; P_prev = P; P = temp;\n";
+                s += "    temp = " + a + " * a * Pa - " + b + " * Pa_prev; Pa_prev = Pa; Pa = temp;\n";
+            }
+            s += "    C_n = ((tmp1 * P) + (tmp2 * D_prev) + (" + fmt("%.1f", double(i - 1)) + " * B_n[" + std::to_string(i - 2) + "]) + (b * Pa)) * " + fmt("%.9g", 1.0 / i) + ";\n";
+            s += "    B_n[" + std::to_string(i) + "] = (" + fmt("%.1f", double(2 * i - 1)) + " * C_n - " + fmt("%.1f", double(i - 1)) + " * B_n[" + std::to_string(i - 2) + "]) * " + fmt("%.9g", 1.0 / i) + ";\n";
+            s += "    temp = D_next;\n";
+            s += "    D_next = " + fmt("%.1f", double(2 * i + 1)) + " * B_n[" + std::to_string(i) + "] + D_prev;\n";
+            s += "    D_prev = temp;\n";
+        }
+        for (int i = 2; i < kMaxOrder; i++) s += "#endif\n";
+        s += "}\n\n";
+
+        // zonal integrals of all bands for one lobe, edge data is shared between the lobes
+        s += "void evalLightOrder(float3 dir, float3 verts[MaxClippedVertices], float3 gam[MaxClippedVertices], float3 gamP[MaxClippedVertices], float arc[MaxClippedVertices], float cosArc[MaxClippedVertices], float sinArc[MaxClippedVertices], int numVerts, inout float surf[POLYGON_SH_NUM_BANDS]) {\n";
+        s += "    float total[POLYGON_SH_ORDER];\n";
+        s += "    float bound[POLYGON_SH_ORDER];\n";
+        s += "    for (int n = 0; n < POLYGON_SH_ORDER; n++) {\n        total[n] = 0;\n    }\n";
+        s += "    for (int i = 0; i < numVerts; i++) {\n";
+        s += "        boundaryOrder(dot(dir, verts[i]), dot(dir, gamP[i]), arc[i], cosArc[i], sinArc[i], bound);\n";
+        s += "        float w = dot(dir, gam[i]);\n";
+        s += "        for (int n = 0; n < POLYGON_SH_ORDER; n++) {\n            total[n] += bound[n] * w;\n        }\n";
+        s += "    }\n\n";
+        s += "    surf[0] = 0;\n";
+        for (int l = 1; l <= kMaxOrder; l++)
+        {
+            if (l > 2) s += "#if POLYGON_SH_ORDER >= " + std::to_string(l) + "\n";
+            s += "    surf[" + std::to_string(l) + "] = " + fmt("%.9g", zonalA(l)) + " * total[" + std::to_string(l - 1) + "]";
+            if (l > 2) s += " + " + fmt("%.9g", zonalB(l)) + " * surf[" + std::to_string(l - 2) + "]";
+            s += ";\n";
+            if (l > 2) s += "#endif\n";
+        }
+        s += "}\n\n";
+
+        // projection, one function per band with the zero entries dropped
+        for (int l = 1; l <= kMaxOrder; l++)
+        {
+            if (l > 2) s += "#if POLYGON_SH_ORDER >= " + std::to_string(l) + "\n";
+            s += "void projectBand" + std::to_string(l) + "(float w[POLYGON_SH_NUM_LOBES][POLYGON_SH_NUM_BANDS], inout float Lcoeff[POLYGON_SH_NUM_COEFFS]) {\n";
+            for (int m = 0; m < 2 * l + 1; m++)
+            {
+                std::string line = "    Lcoeff[" + std::to_string(l * l + m) + "] =";
+                bool first = true;
+                for (int j = 0; j < 2 * l + 1; j++)
+                {
+                    double v = projection[l][m][j];
+                    if (std::abs(v) < 1e-9) continue;
+                    line += std::string(first ? (v < 0 ? " -" : " ") : (v < 0 ? " - " : " + ")) + fmt("%.9g", std::abs(v)) + " * w[" + std::to_string(j) + "][" + std::to_string(l) + "]";
+                    first = false;
+                }
+                if (first) line += " 0";
+                s += line + ";\n";
+            }
+            s += "}\n";
+            if (l > 2) s += "#endif\n";
+            s += "\n";
+        }
+
+        s += "void polygonSHOrder(float3 L[MaxClippedVertices], int numVerts, inout float Lcoeff[POLYGON_SH_NUM_COEFFS]) {\n";
+        s += "    float3 G[MaxClippedVertices];\n    float3 Gp[MaxClippedVertices];\n    float arc[MaxClippedVertices];\n    float cosArc[MaxClippedVertices];\n    float sinArc[MaxClippedVertices];\n";
+        s += "    for (int i = 0; i < numVerts; i++) {\n";
+        s += "        float3 next = L[(i + 1) % numVerts];\n";
+        s += "        G[i] = normalize(cross(L[i], next));\n";
+        s += "        Gp[i] = cross(G[i], L[i]);\n";
+        s += "        arc[i] = acos(dot(L[i], next));\n";
+        s += "        sincos(arc[i], sinArc[i], cosArc[i]);\n";
+        s += "    }\n\n";
+        s += "    Lcoeff[0] = " + fmt("%.9g", 0.5 / std::sqrt(kPi)) + " * solid_angle(L, numVerts);\n\n";
+        s += "    float w[POLYGON_SH_NUM_LOBES][POLYGON_SH_NUM_BANDS];\n";
+        for (int j = 0; j < kNumLobes; j++)
+        {
+            // lobes 2l - 1 and 2l are first used by band l, orders 2 and up use lobes 0 to 4
+            int order = std::max(2, (j + 1) / 2);
+            if (order > 2 && j % 2 == 1) s += "#if POLYGON_SH_ORDER >= " + std::to_string(order) + "\n";
+            s += "    evalLightOrder(float3(" + fmt("%.6f", lobes[j].x) + ", " + fmt("%.6f", lobes[j].y) + ", " + fmt("%.6f", lobes[j].z) + "), L, G, Gp, arc, cosArc, sinArc, numVerts, w[" + std::to_string(j) + "]);\n";
+            if (order > 2 && j % 2 == 0) s += "#endif\n";
+        }
+        s += "\n";
+        for (int l = 1; l <= kMaxOrder; l++)
+        {
+            if (l > 2) s += "#if POLYGON_SH_ORDER >= " + std::to_string(l) + "\n";
+            s += "    projectBand" + std::to_string(l) + "(w, Lcoeff);\n";
+            if (l > 2) s += "#endif\n";
+        }
+        s += "}\n\n";
+
+        // basis evaluation, same recurrences as evaluateSH() in LTSH.slang
+        s += "float evaluateSHOrder(float3 dir, float coefficients[POLYGON_SH_NUM_COEFFS]) {\n";
+        s += "    float x = dir.x, y = dir.y, z = dir.z;\n";
+        s += "    float cosine[POLYGON_SH_NUM_BANDS];\n    float sine[POLYGON_SH_NUM_BANDS];\n";
+        s += "    cosine[0] = 1.0;\n    sine[0] = 0.0;\n";
+        s += "    for (int m = 1; m < POLYGON_SH_NUM_BANDS; m++) {\n";
+        s += "        cosine[m] = x * cosine[m - 1] - y * sine[m - 1];\n";
+        s += "        sine[m] = x * sine[m - 1] + y * cosine[m - 1];\n";
+        s += "    }\n\n";
+        s += "    float sum = 0;\n";
+        s += "    float pmm = 1.0;\n";
+        s += "    for (int m = 0; m < POLYGON_SH_NUM_BANDS; m++) {\n";
+        s += "        if (m > 0) pmm *= 2.0 * float(m) - 1.0;\n";
+        s += "        float prev = 0;\n        float p = pmm;\n";
+        s += "        for (int l = m; l < POLYGON_SH_NUM_BANDS; l++) {\n";
+        s += "            if (l > m) {\n";
+        s += "                float next = ((2.0 * float(l) - 1.0) * z * p - float(l + m - 1) * prev) / float(l - m);\n";
+        s += "                prev = p;\n                p = next;\n";
+        s += "            }\n";
+        s += "            float k = gPolygonSHNormalization[l * l + l + m] * p;\n";
+        s += "            sum += k * cosine[m] * coefficients[l * l + l + m];\n";
+        s += "            if (m > 0) sum += k * sine[m] * coefficients[l * l + l - m];\n";
+        s += "        }\n";
+        s += "    }\n";
+        s += "    return sum;\n}\n\n";
+        s += "#endif\t// _FALCOR_POLYGON_SH_SLANG_\n";
+
+        // the normalization table goes before the function that uses it
+        std::string table = "static const float gPolygonSHNormalization[" + std::to_string((kMaxOrder + 1) * (kMaxOrder + 1)) + "] = {\n";
+        for (int l = 0; l <= kMaxOrder; l++)
+        {
+            table += "   ";
+            for (int m = -l; m <= l; m++) table += " " + fmt("%.9g", shNormalization(l, m)) + ",";
+            table += "\n";
+        }
+        table += "};\n\n";
+        size_t pos = s.find("float evaluateSHOrder");
+        s.insert(pos, table);
+        return s;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string headerFile = argc > 1 ? argv[1] : "Source/Reference/PolygonSHTables.h";
+    std::string shaderFile = argc > 2 ? argv[2] : "Data/PolygonSH.slang";
+
+    try
+    {
+        std::vector<Dir> lobes = chooseLobes();
+        std::vector<Matrix> projection(kMaxOrder + 1);
+        for (int l = 1; l <= kMaxOrder; l++)
+        {
+            if (!invert(zonalMatrix(l, lobes), projection[l]))
+            {
+                throw std::runtime_error("lobes of band " + std::to_string(l) + " are degenerate");
+            }
+            std::printf("band %d: %2d lobes, |P|_F = %8.3f\n", l, 2 * l + 1, frobeniusNorm(projection[l]));
+        }
+
+        writeFile(headerFile, generateHeader(lobes, projection));
+        writeFile(shaderFile, generateShader(lobes, projection));
+        std::printf("wrote %s and %s\n", headerFile.c_str(), shaderFile.c_str());
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
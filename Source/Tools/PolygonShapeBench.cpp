@@ -0,0 +1,314 @@
+// Point-in-polygon and sampling cost of PolygonShape against the ray crossing test of PolygonUtil::isInside(), for
+// convex regular polygons and concave stars of 4 to 256 vertices. Reports the preprocessing time, the size of the
+// triangulation and convex decomposition, the time per point of both tests and of the batched classifyPoints(), the
+// number of points on which contains() disagrees with the crossing test and classifyPoints() with the exact scalar
+// test, and the time to draw the 4 x 4096 ground truth samples from PolygonSampler. Then checks all tests on points
+// that lie exactly on the edges of a polygon or on their extensions, on a grid over a concave polygon with runs of
+// collinear vertices and on the vertices of the test polygons. contains(), containsExact() and classifyPoints() must
+// classify all of them correctly, otherwise the tool exits with 1; the crossing test is only reported.
+//
+// usage: polygon_shape_bench [points=1048576]
+
+#include "PolygonSampler.h"
+#include "PolygonShape.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // ---- PolygonUtil::isInside(), without the Falcor dependency ----
+
+    int orientation(const float* p, const float* q, const float* r)
+    {
+        float val = (q[1] - p[1]) * (r[0] - q[0]) - (q[0] - p[0]) * (r[1] - q[1]);
+        if (std::abs(val) < std::numeric_limits<float>::epsilon()) return 0;
+        return (val > 0) ? 1 : 2;
+    }
+
+    bool onSegment(const float* p, const float* q, const float* r)
+    {
+        return q[0] <= std::max(p[0], r[0]) && q[0] >= std::min(p[0], r[0]) && q[1] <= std::max(p[1], r[1]) && q[1] >= std::min(p[1], r[1]);
+    }
+
+    bool doIntersect(const float* p1, const float* q1, const float* p2, const float* q2)
+    {
+        int o1 = orientation(p1, q1, p2);
+        int o2 = orientation(p1, q1, q2);
+        int o3 = orientation(p2, q2, p1);
+        int o4 = orientation(p2, q2, q1);
+        if (o1 != o2 && o3 != o4) return true;
+        if (o1 == 0 && onSegment(p1, p2, q1)) return true;
+        if (o2 == 0 && onSegment(p1, q2, q1)) return true;
+        if (o3 == 0 && onSegment(p2, p1, q2)) return true;
+        if (o4 == 0 && onSegment(p2, q1, q2)) return true;
+        return false;
+    }
+
+    bool isInside(const std::vector<float>& polygon, const float* p)
+    {
+        int n = int(polygon.size() / 2);
+        float extreme[2] = { std::numeric_limits<float>::max(), p[1] };
+        int count = 0, i = 0;
+        do
+        {
+            int next = (i + 1) % n;
+            if (doIntersect(&polygon[i * 2], &polygon[next * 2], p, extreme))
+            {
+                if (orientation(&polygon[i * 2], p, &polygon[next * 2]) == 0) return onSegment(&polygon[i * 2], p, &polygon[next * 2]);
+                count++;
+            }
+            i = next;
+        } while (i != 0);
+        return count & 1;
+    }
+
+    // ---- test polygons ----
+
+    std::vector<float> regularPolygon(int n)
+    {
+        std::vector<float> v;
+        for (int i = 0; i < n; i++)
+        {
+            double phi = 2.0 * 3.14159265358979 * (i + 0.5) / n;
+            v.push_back(float(std::cos(phi)));
+            v.push_back(float(std::sin(phi)));
+        }
+        return v;
+    }
+
+    // every other vertex pulled in to half the radius
+    std::vector<float> star(int n)
+    {
+        std::vector<float> v = regularPolygon(n);
+        for (int i = 1; i < n; i += 2)
+        {
+            v[i * 2] *= 0.5f;
+            v[i * 2 + 1] *= 0.5f;
+        }
+        return v;
+    }
+
+    template<typename Func>
+    double timeIt(Func func, int repetitions)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repetitions; r++)
+        {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(end - start).count() / repetitions;
+    }
+
+    /** Points p = a + t (b - a) on every edge of a counter-clockwise convex polygon, exactly representable: t in
+        [0, 1] on the edge, t < 0 and t > 1 on its extension, which lies outside. Plus the points on the edge moved
+        outwards by nudge times the edge normal, which lie outside as well.
+        \return Number of points that contains(), containsExact() or classifyPoints() got wrong
+    */
+    size_t collinearTest(const char* name, const std::vector<float>& polygon, float nudge)
+    {
+        uint32_t n = uint32_t(polygon.size() / 2);
+        PolygonShape shape(polygon.data(), n);
+        std::vector<float> points;
+        std::vector<char> expected;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            const float* a = &polygon[i * 2];
+            const float* b = &polygon[((i + 1) % n) * 2];
+            for (int k = -8; k <= 24; k++)
+            {
+                float t = float(k) / 16.f;
+                points.push_back(a[0] + t * (b[0] - a[0]));
+                points.push_back(a[1] + t * (b[1] - a[1]));
+                expected.push_back(k >= 0 && k <= 16);
+                if (k > 0 && k < 16)
+                {
+                    points.push_back(a[0] + t * (b[0] - a[0]) + nudge * (b[1] - a[1]));
+                    points.push_back(a[1] + t * (b[1] - a[1]) - nudge * (b[0] - a[0]));
+                    expected.push_back(false);
+                }
+            }
+        }
+        size_t numPoints = expected.size();
+        std::vector<uint8_t> mask((numPoints + 7) / 8);
+        shape.classifyPoints(points.data(), numPoints, mask.data());
+        size_t wrongLegacy = 0, wrongContains = 0, wrongExact = 0, wrongBatched = 0;
+        for (size_t i = 0; i < numPoints; i++)
+        {
+            wrongLegacy += isInside(polygon, &points[i * 2]) != bool(expected[i]);
+            wrongContains += shape.contains(points[i * 2], points[i * 2 + 1]) != bool(expected[i]);
+            wrongExact += shape.containsExact(points[i * 2], points[i * 2 + 1]) != bool(expected[i]);
+            wrongBatched += bool((mask[i / 8] >> (i % 8)) & 1) != bool(expected[i]);
+        }
+        std::printf("%-22s %8zu %10zu %10zu %10zu %10zu\n", name, numPoints, wrongLegacy, wrongContains, wrongBatched, wrongExact);
+        return wrongContains + wrongExact + wrongBatched;
+    }
+
+    /** Every point of a grid with spacing 1/8 over the L shape [0, 4] x [0, 2] + [0, 2] x [0, 4] and a margin of 1,
+        transformed by p * scale + offset. All vertices lie on the grid, the polygon has a vertex in the middle of
+        every edge and the reflex corner sits in a run of three collinear vertices, so many points lie on edges, on
+        vertices and on the extensions of edges into the polygon. The expected result is the union of the two closed
+        rectangles.
+        \return Number of points that contains(), containsExact() or classifyPoints() got wrong
+    */
+    size_t lShapeTest(const char* name, float scale, float offset, bool clockwise)
+    {
+        const float corners[][2] = { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 4, 0 }, { 4, 1 }, { 4, 2 }, { 3, 2 }, { 2, 2 }, { 2, 3 }, { 2, 4 }, { 1, 4 }, { 0, 4 }, { 0, 2 }, { 0, 1 } };
+        const uint32_t n = uint32_t(sizeof(corners) / sizeof(corners[0]));
+        std::vector<float> polygon;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            const float* c = corners[clockwise ? n - 1 - i : i];
+            polygon.push_back(c[0] * scale + offset);
+            polygon.push_back(c[1] * scale + offset);
+        }
+        PolygonShape shape(polygon.data(), n);
+
+        std::vector<float> points;
+        std::vector<char> expected;
+        for (int i = -8; i <= 40; i++)
+        {
+            for (int j = -8; j <= 40; j++)
+            {
+                float x = float(i) / 8.f, y = float(j) / 8.f;
+                points.push_back(x * scale + offset);
+                points.push_back(y * scale + offset);
+                bool inLower = x >= 0.f && x <= 4.f && y >= 0.f && y <= 2.f;
+                bool inLeft = x >= 0.f && x <= 2.f && y >= 0.f && y <= 4.f;
+                expected.push_back(inLower || inLeft);
+            }
+        }
+        size_t numPoints = expected.size();
+        std::vector<uint8_t> mask((numPoints + 7) / 8);
+        shape.classifyPoints(points.data(), numPoints, mask.data());
+        size_t wrongLegacy = 0, wrongContains = 0, wrongExact = 0, wrongBatched = 0;
+        for (size_t i = 0; i < numPoints; i++)
+        {
+            float x = points[i * 2], y = points[i * 2 + 1];
+            wrongLegacy += isInside(polygon, &points[i * 2]) != bool(expected[i]);
+            wrongContains += shape.contains(x, y) != bool(expected[i]);
+            wrongExact += shape.containsExact(x, y) != bool(expected[i]);
+            wrongBatched += bool((mask[i / 8] >> (i % 8)) & 1) != bool(expected[i]);
+        }
+        std::printf("%-22s %8zu %10zu %10zu %10zu %10zu\n", name, numPoints, wrongLegacy, wrongContains, wrongBatched, wrongExact);
+        return wrongContains + wrongExact + wrongBatched;
+    }
+
+    /** All vertices of a polygon are inside
+        \return Number of vertices that contains(), containsExact() or classifyPoints() got wrong
+    */
+    size_t vertexTest(const std::vector<float>& polygon)
+    {
+        uint32_t n = uint32_t(polygon.size() / 2);
+        PolygonShape shape(polygon.data(), n);
+        std::vector<uint8_t> mask((n + 7) / 8);
+        shape.classifyPoints(polygon.data(), n, mask.data());
+        size_t wrong = 0;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            float x = polygon[i * 2], y = polygon[i * 2 + 1];
+            wrong += !shape.contains(x, y) + !shape.containsExact(x, y) + !((mask[i / 8] >> (i % 8)) & 1);
+        }
+        return wrong;
+    }
+
+    void run(const char* name, const std::vector<float>& polygon, const std::vector<float>& points)
+    {
+        uint32_t n = uint32_t(polygon.size() / 2);
+        PolygonShape shape;
+        double buildTime = timeIt([&]() { shape = PolygonShape(polygon.data(), n); }, 20);
+
+        size_t numPoints = points.size() / 2;
+        std::vector<char> legacy(numPoints), cached(numPoints);
+        double legacyTime = timeIt([&]()
+        {
+            for (size_t i = 0; i < numPoints; i++) legacy[i] = isInside(polygon, &points[i * 2]);
+        }, 1);
+        double cachedTime = timeIt([&]()
+        {
+            for (size_t i = 0; i < numPoints; i++) cached[i] = shape.contains(points[i * 2], points[i * 2 + 1]);
+        }, 1);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < numPoints; i++) mismatches += legacy[i] != cached[i];
+
+        std::vector<uint8_t> mask((numPoints + 7) / 8);
+        size_t fallbacks = 0;
+        double batchedTime = timeIt([&]() { fallbacks = shape.classifyPoints(points.data(), numPoints, mask.data()); }, 1);
+        size_t batchedMismatches = 0;
+        for (size_t i = 0; i < numPoints; i++)
+        {
+            bool inside = (mask[i / 8] >> (i % 8)) & 1;
+            batchedMismatches += inside != shape.containsExact(points[i * 2], points[i * 2 + 1]);
+        }
+
+        PolygonSampler sampler(polygon.data(), n, 2);
+        std::vector<float> samples(4096 * 2);
+        double sampleTime = timeIt([&]()
+        {
+            for (uint32_t set = 0; set < 4; set++) sampler.generate(SampleSequence::Sobol, set, 0, 4096, samples.data(), 2);
+        }, 20);
+
+        std::printf("%-8s %5u %10.1f %6zu %6u %12.1f %12.1f %8zu %12.1f %9zu %8zu %12.1f\n", name, n, buildTime * 1e6, shape.getTriangles().size() / 3, shape.getPieceCount(),
+            legacyTime / numPoints * 1e9, cachedTime / numPoints * 1e9, mismatches, batchedTime / numPoints * 1e9, fallbacks, batchedMismatches, sampleTime * 1e6);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t numPoints = argc > 1 ? (size_t)std::atoll(argv[1]) : 1u << 20;
+
+    // uniform in the bounding square with a margin, so both the bounding box rejection and the inside test are hit
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> u(-1.2f, 1.2f);
+    std::vector<float> points(numPoints * 2);
+    for (float& p : points) p = u(rng);
+
+    std::printf("%zu points per polygon\n", numPoints);
+    std::printf("%-8s %5s %10s %6s %6s %12s %12s %8s %12s %9s %8s %12s\n", "shape", "n", "build [us]", "tris", "pieces", "crossing [ns]", "cached [ns]", "differ",
+        "batched [ns]", "fallback", "differ", "4x4096 [us]");
+    const int sizes[] = { 4, 8, 16, 32, 64, 128, 256 };
+    for (int n : sizes)
+    {
+        run("regular", regularPolygon(n), points);
+        run("star", star(n), points);
+    }
+
+    std::printf("\nwrong results on points on the boundary (inside), on the extension of an edge and just outside an edge\n");
+    std::printf("%-22s %8s %10s %10s %10s %10s\n", "polygon", "points", "crossing", "contains", "batched", "exact");
+    // a tilted quad with integer corners at the origin, far from it and scaled down, where the fixed epsilon of the
+    // crossing test no longer matches the magnitude of the cross products
+    const std::vector<float> quad = { 0.f, 0.f, 3.f, 1.f, 2.f, 4.f, -1.f, 3.f };
+    std::vector<float> farQuad = quad, tinyQuad = quad;
+    for (float& c : farQuad) c += 4096.f;
+    for (float& c : tinyQuad) c *= 1.f / 1024.f;
+    size_t failures = 0;
+    failures += collinearTest("quad", quad, 1.f / 65536.f);
+    failures += collinearTest("quad + 4096", farQuad, 1.f / 256.f);
+    failures += collinearTest("quad / 1024", tinyQuad, 1.f / 65536.f);
+    failures += lShapeTest("L", 1.f, 0.f, false);
+    failures += lShapeTest("L clockwise", 1.f, 0.f, true);
+    failures += lShapeTest("L + 4096", 1.f, 4096.f, false);
+    failures += lShapeTest("L / 1024", 1.f / 1024.f, 0.f, false);
+
+    size_t wrongVertices = 0;
+    for (int n : sizes)
+    {
+        wrongVertices += vertexTest(regularPolygon(n)) + vertexTest(star(n));
+    }
+    std::printf("vertices outside: %zu\n", wrongVertices);
+    failures += wrongVertices;
+
+    if (failures)
+    {
+        std::printf("FAILED: %zu points on or next to the boundary misclassified\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,279 @@
+// Compares the rejection sampler of SimpleAreaLight::createSamples() with PolygonSampler. Reports the time to fill
+// the 4 x 4096 ground truth sample sets and the error of the ground truth estimate the shader makes with the first
+// 1024 samples of a set, measured as the RMS relative error of the irradiance from the light at a few shading points
+// over many seeds, against Lambert's closed form. Also times the re-transform SimpleAreaLight does when only the
+// transform of the light changes. Finally it replays a sequence of frames with a static, moving and reshaped light
+// through AreaLightSamples and a CountingUploadSink and reports the bytes the sample buffer upload of the app costs.
+// The replay checks every frame: nothing is uploaded while the polygon, seed and transform stay the same, including
+// a change of the intensity, which is not an input of the samples, and all sets are uploaded after a change of the
+// transform, the polygon or the seed and after the buffer was recreated. Exits with 1 if a frame uploads anything
+// else.
+//
+// usage: sampler_bench [seeds=512] [threads=0]
+
+#include "AreaLightSamples.h"
+#include "PolygonSampler.h"
+#include "Reference/ThreadPool.h"
+#include "Reference/VecMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    const int kNumSampleSets = 4;
+    const int kNumSamples = 4096;
+    const int kShaderSamples = kNumSamples / 4;
+
+    // ---- previous implementation: rejection sampling in the bounding box with std::rand() and PolygonUtil::isInside ----
+
+    int orientation(const float2& p, const float2& q, const float2& r)
+    {
+        float val = (q.y - p.y) * (r.x - q.x) - (q.x - p.x) * (r.y - q.y);
+        if (std::abs(val) < std::numeric_limits<float>::epsilon()) return 0;
+        return (val > 0) ? 1 : 2;
+    }
+
+    bool onSegment(const float2& p, const float2& q, const float2& r)
+    {
+        return q.x <= std::max(p.x, r.x) && q.x >= std::min(p.x, r.x) && q.y <= std::max(p.y, r.y) && q.y >= std::min(p.y, r.y);
+    }
+
+    bool doIntersect(const float2& p1, const float2& q1, const float2& p2, const float2& q2)
+    {
+        int o1 = orientation(p1, q1, p2);
+        int o2 = orientation(p1, q1, q2);
+        int o3 = orientation(p2, q2, p1);
+        int o4 = orientation(p2, q2, q1);
+        if (o1 != o2 && o3 != o4) return true;
+        if (o1 == 0 && onSegment(p1, p2, q1)) return true;
+        if (o2 == 0 && onSegment(p1, q2, q1)) return true;
+        if (o3 == 0 && onSegment(p2, p1, q2)) return true;
+        if (o4 == 0 && onSegment(p2, q1, q2)) return true;
+        return false;
+    }
+
+    bool isInside(const std::vector<float2>& polygon, int n, const float2& p)
+    {
+        float2 extreme(std::numeric_limits<float>::max(), p.y);
+        int count = 0, i = 0;
+        do
+        {
+            int next = (i + 1) % n;
+            if (doIntersect(polygon[i], polygon[next], p, extreme))
+            {
+                if (orientation(polygon[i], p, polygon[next]) == 0) return onSegment(polygon[i], p, polygon[next]);
+                count++;
+            }
+            i = next;
+        } while (i != 0);
+        return count & 1;
+    }
+
+    void legacyCreateSamples(const std::vector<float2>& polygon, float4 samples[kNumSampleSets][kNumSamples])
+    {
+        float2 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+        for (const float2& v : polygon)
+        {
+            lo = float2(std::min(lo.x, v.x), std::min(lo.y, v.y));
+            hi = float2(std::max(hi.x, v.x), std::max(hi.y, v.y));
+        }
+        float2 extent = hi - lo;
+        for (int i = 0; i < kNumSampleSets; i++)
+        {
+            int sampleCount = 0;
+            while (sampleCount < kNumSamples)
+            {
+                float2 sample = float2((float)std::rand() / RAND_MAX, (float)std::rand() / RAND_MAX) * extent + lo;
+                if (isInside(polygon, int(polygon.size()), sample))
+                {
+                    samples[i][sampleCount++] = float4(sample.x, sample.y, 0.f, 1.f);
+                }
+            }
+        }
+    }
+
+    // ---- new implementation ----
+
+    void createSamples(const PolygonSampler& sampler, SampleSequence sequence, uint32_t seed, float4 samples[kNumSampleSets][kNumSamples])
+    {
+        for (int i = 0; i < kNumSampleSets; i++)
+        {
+            sampler.generate(sequence, seed * kNumSampleSets + i, 0, kNumSamples, &samples[i][0].x, 4);
+        }
+    }
+
+    template<typename Func>
+    double timeIt(Func func, int repetitions)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repetitions; r++)
+        {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(end - start).count() / repetitions;
+    }
+
+    /** Irradiance at p with normal +z from a unit radiance polygon in the z = 0 plane, Lambert's formula
+    */
+    double exactIrradiance(const std::vector<float2>& polygon, const double3& p)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < polygon.size(); i++)
+        {
+            const float2& a = polygon[i];
+            const float2& b = polygon[(i + 1) % polygon.size()];
+            double3 ra = normalize(double3(a.x, a.y, 0.0) - p);
+            double3 rb = normalize(double3(b.x, b.y, 0.0) - p);
+            double3 n = cross(ra, rb);
+            double len = length(n);
+            if (len > 0) sum += std::acos(std::max(-1.0, std::min(1.0, dot(ra, rb)))) * n.z / len;
+        }
+        return 0.5 * std::abs(sum);
+    }
+
+    /** The ground truth estimator of the shader: area / N * sum of cos * cos / r^2 over the first kShaderSamples
+    */
+    double estimateIrradiance(const float4* samples, float area, const double3& p)
+    {
+        double sum = 0;
+        for (int i = 0; i < kShaderSamples; i++)
+        {
+            double3 d = double3(samples[i].x, samples[i].y, 0.0) - p;
+            double r2 = dot(d, d);
+            double cosLight = std::abs(d.z) / std::sqrt(r2);
+            sum += cosLight * cosLight / r2;
+        }
+        return sum * area / kShaderSamples;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int numSeeds = argc > 1 ? std::atoi(argv[1]) : 512;
+    uint32_t numThreads = argc > 2 ? (uint32_t)std::atoi(argv[2]) : 0;
+
+    struct TestPolygon { const char* name; std::vector<float2> vertices; };
+    const TestPolygon polygons[] =
+    {
+        { "default quad", { float2(-1.f, 1.f), float2(-1.f, -1.f), float2(1.f, -1.f), float2(1.f, 1.f) } },
+        { "kite", { float2(0.f, 1.f), float2(-0.3f, 0.f), float2(0.f, -1.f), float2(0.3f, 0.f) } },
+        { "sliver", { float2(-1.f, 0.05f), float2(-1.f, -0.05f), float2(1.f, -0.15f), float2(1.f, 0.15f) } },
+    };
+    const double3 shadingPoints[] =
+    {
+        double3(0.0, 0.0, -1.0),
+        double3(0.5, 0.3, -0.5),
+        double3(2.0, -1.0, -1.5),
+        double3(0.2, 0.1, -0.1),
+    };
+
+    static float4 samples[kNumSampleSets][kNumSamples];
+    ThreadPool pool(numThreads);
+
+    for (const TestPolygon& polygon : polygons)
+    {
+        PolygonSampler sampler(&polygon.vertices[0].x, uint32_t(polygon.vertices.size()), 2);
+        std::printf("%s, area %.3f\n", polygon.name, sampler.getArea());
+
+        double tLegacy = timeIt([&]() { legacyCreateSamples(polygon.vertices, samples); }, 20);
+        double tUniform = timeIt([&]() { createSamples(sampler, SampleSequence::Uniform, 1, samples); }, 20);
+        double tSobol = timeIt([&]() { createSamples(sampler, SampleSequence::Sobol, 1, samples); }, 20);
+
+        // any split of the index range gives the same samples, here one task per 256 samples
+        const uint32_t chunk = 256;
+        double tParallel = timeIt([&]()
+        {
+            pool.parallelFor(kNumSampleSets * kNumSamples / chunk, [&](size_t task, uint32_t)
+            {
+                uint32_t set = uint32_t(task * chunk / kNumSamples);
+                uint32_t first = uint32_t(task * chunk % kNumSamples);
+                sampler.generate(SampleSequence::Sobol, 1 * kNumSampleSets + set, first, chunk, &samples[set][first].x, 4);
+            });
+        }, 20);
+
+        // moving the light only re-transforms the cached model space samples
+        static float4 transformed[kNumSampleSets][kNumSamples];
+        const float matrix[16] = { 0.f, 0.f, -1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 2.f, 0.f, 0.f, 0.f, 1.f, 2.f, 3.f, 1.f };
+        double tTransform = timeIt([&]() { transformPoints(matrix, &samples[0][0].x, kNumSampleSets * kNumSamples, &transformed[0][0].x); }, 20);
+
+        // RMS relative error of the estimate over the seeds, per shading point
+        double rms[3] = {};
+        for (const double3& p : shadingPoints)
+        {
+            double exact = exactIrradiance(polygon.vertices, p);
+            double sq[3] = {};
+            for (int seed = 0; seed < numSeeds; seed++)
+            {
+                std::srand(seed);
+                legacyCreateSamples(polygon.vertices, samples);
+                double e = estimateIrradiance(samples[0], sampler.getArea(), p) / exact - 1.0;
+                sq[0] += e * e;
+                for (int s = 0; s < 2; s++)
+                {
+                    sampler.generate(s == 0 ? SampleSequence::Uniform : SampleSequence::Sobol, seed, 0, kShaderSamples, &samples[0][0].x, 4);
+                    e = estimateIrradiance(samples[0], sampler.getArea(), p) / exact - 1.0;
+                    sq[s + 1] += e * e;
+                }
+            }
+            for (int m = 0; m < 3; m++) rms[m] += std::sqrt(sq[m] / numSeeds) / (sizeof(shadingPoints) / sizeof(shadingPoints[0]));
+        }
+
+        std::printf("  %-22s %10s %14s\n", "", "4x4096 [us]", "rms rel err");
+        std::printf("  %-22s %10.1f %14.3e\n", "rejection + std::rand", tLegacy * 1e6, rms[0]);
+        std::printf("  %-22s %10.1f %14.3e\n", "fan, uniform", tUniform * 1e6, rms[1]);
+        std::printf("  %-22s %10.1f %14.3e\n", "fan, sobol", tSobol * 1e6, rms[2]);
+        std::printf("  %-22s %10.1f %14s\n", "fan, sobol, parallel", tParallel * 1e6, "-");
+        std::printf("  %-22s %10.1f %14s\n", "re-transform only", tTransform * 1e6, "-");
+    }
+    std::printf("%u threads, %d seeds, estimates use the first %d samples\n", pool.getThreadCount(), numSeeds, kShaderSamples);
+
+    // 100 static frames, 50 frames moving the light, static frames with a change of the intensity at 200 and of the
+    // seed at 220, a new polygon at 250 and a recreated buffer at 270
+    AreaLightSamples lightSamples;
+    SampleBufferUploader uploader;
+    CountingUploadSink sink;
+    const int kFrames = 300;
+    const size_t fullBytes = size_t(NUM_SAMPLE_SETS) * NUM_SAMPLES * 4 * sizeof(float);
+    int uploadFrames = 0, failures = 0;
+    size_t maxFrameBytes = 0;
+    float previousOffset = 0.f;
+    auto tUpload = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < kFrames; frame++)
+    {
+        const std::vector<float2>& vertices = polygons[frame < 250 ? 0 : 1].vertices;
+        uint32_t seed = frame < 220 ? 0 : 1;
+        float offset = float(std::min(std::max(frame - 100, 0), 50)) * 0.01f;
+        const float matrix[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, offset, 1.f, 0.f, 1.f };
+        // frame 200 only changes the intensity, SimpleAreaLight::setIntensity() keeps it out of the samples, so
+        // update() gets the same polygon, seed and transform as in the frame before
+        if (frame == 270) uploader.invalidate();
+
+        sink.beginFrame();
+        lightSamples.update(&vertices[0].x, uint32_t(vertices.size()), seed, matrix);
+        if (uploader.update(lightSamples, sink)) uploadFrames++;
+        maxFrameBytes = std::max(maxFrameBytes, sink.getFrameBytes());
+
+        bool changed = frame == 0 || offset != previousOffset || frame == 220 || frame == 250 || frame == 270;
+        size_t expectedBytes = changed ? fullBytes : 0;
+        if (sink.getFrameBytes() != expectedBytes)
+        {
+            std::printf("FAILED: frame %d uploaded %zu sample bytes, expected %zu\n", frame, sink.getFrameBytes(), expectedBytes);
+            failures++;
+        }
+        previousOffset = offset;
+    }
+    double tFrames = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tUpload).count();
+    const double perFrameBytes = double(kNumSampleSets) * kNumSamples * sizeof(float4);
+    std::printf("sample upload over %d frames: %d uploads, %.1f KB per frame on average, %.1f KB max (constant buffers every frame: %.1f KB), %.1f us per frame\n",
+                kFrames, uploadFrames, sink.getTotalBytes() / 1024.0 / kFrames, maxFrameBytes / 1024.0, perFrameBytes / 1024.0, tFrames * 1e6 / kFrames);
+    if (failures) return 1;
+    return 0;
+}
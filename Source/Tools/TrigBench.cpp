@@ -0,0 +1,298 @@
+// Accuracy and cost of the transcendental approximations in Reference/FastMath.h. Reports the max. error of every
+// kernel on its domain, the error each precision adds to the LTC, LTSH N=4 and LTSH N=2 specular integrals of random
+// lights and table cells against the exact double precision result, and the throughput of the scalar and batched
+// LTSH projection.
+//
+// usage: ltsh_trig_bench [params=Data/Params] [configs=20000]
+//
+// The errors of the integrals are relative to the mean magnitude of the reference, so a few near zero results can't
+// dominate them. Exact in float is the floor the approximations are compared with.
+
+#include "Reference/LTC.h"
+#include "Reference/LTSHn2.h"
+#include "Reference/LTSHSimd.h"
+#include "Reference/LutTables.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ltsh;
+
+namespace
+{
+    const TrigPrecision kPrecisions[] = { TrigPrecision::Exact, TrigPrecision::Medium, TrigPrecision::Fast };
+    const char* kPrecisionNames[] = { "exact", "medium", "fast" };
+
+    struct KernelError
+    {
+        double acos = 0, sin = 0, cos = 0, atan2 = 0, thetaOverSin = 0;
+    };
+
+    /** Max. abs. error of the float kernels on a dense grid, theta / sin(theta) relative to its value inside the clamp
+    */
+    KernelError measureKernels(TrigPrecision precision)
+    {
+        const int kSteps = 1 << 20;
+        KernelError err;
+        for (int i = 0; i <= kSteps; i++)
+        {
+            double t = double(i) / kSteps;
+            double x = 2.0 * t - 1.0;
+            err.acos = std::max(err.acos, std::abs(acosApprox(float(x), precision) - std::acos(double(float(x)))));
+
+            double angle = kPi * t;
+            float s, c;
+            sinCosApprox(float(angle), s, c, precision);
+            err.sin = std::max(err.sin, std::abs(s - std::sin(double(float(angle)))));
+            err.cos = std::max(err.cos, std::abs(c - std::cos(double(float(angle)))));
+
+            double phi = 2.0 * kPi * (t - 0.5);
+            float y = float(std::sin(phi)), xa = float(std::cos(phi));
+            // the two ends of the grid are the same point on either side of the branch cut
+            if (i > 0 && i < kSteps)
+            {
+                err.atan2 = std::max(err.atan2, std::abs(atan2Approx(y, xa, precision) - std::atan2(double(y), double(xa))));
+            }
+
+            float cosTheta = std::max(std::min(float(x), 0.9999f), -0.9999f);
+            double theta = std::acos(double(cosTheta));
+            double ref = theta / std::sin(theta);
+            err.thetaOverSin = std::max(err.thetaOverSin, std::abs(thetaOverSinTheta(cosTheta, precision) - ref) / ref);
+        }
+        return err;
+    }
+
+    struct Config
+    {
+        float3 polygon[4];      // light in the shading frame, N = z
+        float3 V;
+        float2 uv;              // unbiased table coordinate for LTC
+        int2 cell;              // table cell for LTSH
+    };
+
+    std::vector<Config> createConfigs(size_t count, int resolution)
+    {
+        std::mt19937 rng(4321);
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+        std::vector<Config> configs(count);
+        for (Config& c : configs)
+        {
+            // a quad facing the shading point, some cross the horizon
+            float phi = 2.f * float(kPi) * u(rng);
+            float cosT = 1.2f * u(rng) - 0.2f;
+            float sinT = std::sqrt(std::max(1.f - cosT * cosT, 0.f));
+            float3 center = float3(std::cos(phi) * sinT, std::sin(phi) * sinT, cosT) * (1.f + 3.f * u(rng));
+            float3 axisZ = normalize(-center);
+            float3 axisX = normalize(cross(std::abs(axisZ.z) < 0.9f ? float3(0.f, 0.f, 1.f) : float3(1.f, 0.f, 0.f), axisZ));
+            float3 axisY = cross(axisZ, axisX);
+            float sx = 0.2f + 1.5f * u(rng), sy = 0.2f + 1.5f * u(rng);
+            c.polygon[0] = center - axisX * sx - axisY * sy;
+            c.polygon[1] = center + axisX * sx - axisY * sy;
+            c.polygon[2] = center + axisX * sx + axisY * sy;
+            c.polygon[3] = center - axisX * sx + axisY * sy;
+
+            float cosV = 0.02f + 0.98f * u(rng);
+            c.V = float3(std::sqrt(1.f - cosV * cosV), 0.f, cosV);
+            float roughness = 0.05f + 0.95f * u(rng);
+            float2 uv = cosThetaRoughnessToUv(cosV, roughness);
+            c.uv = float2((uv.x * (resolution - 1) + 0.5f) / resolution, (uv.y * (resolution - 1) + 0.5f) / resolution);
+            c.cell = { int(uv.x * (resolution - 1) + 0.5f), int(uv.y * (resolution - 1) + 0.5f) };
+        }
+        return configs;
+    }
+
+    // the specular integral of evalAreaLightLTSH() / evalAreaLightLTSH_N2() without the light color
+    template<typename Real, int K>
+    Real ltshIntegral(const Config& c, const float3x3& MInv, const float* coeffs, TrigPrecision precision)
+    {
+        typedef Vec3<Real> Vec;
+        Vec polygon[4];
+        for (int i = 0; i < 4; i++)
+        {
+            polygon[i] = Vec(c.polygon[i]);
+        }
+        Vec L[kMaxClippedVertices];
+        int n = clipPolygonToHorizon(polygon, 4, L);
+        if (n == 0) return Real(0);
+
+        Mat3<Real> M(MInv);
+        for (int i = 0; i < n; i++)
+        {
+            L[i] = normalize(mul(M, L[i]));
+        }
+        Real Lc[K];
+        if (K == kNumCoeffsN4) polygonSH(L, n, Lc, precision);
+        else polygonSHN2(L, n, Lc, precision);
+
+        Real result = 0;
+        for (int k = 0; k < K; k++)
+        {
+            result += Lc[k] * Real(coeffs[k]);
+        }
+        return std::abs(result);
+    }
+
+    // the specular integral of evalAreaLightLTC() without normalization and light color
+    template<typename Real>
+    Real ltcIntegral(const Config& c, const float3x3& MInv, TrigPrecision precision)
+    {
+        typedef Vec3<Real> Vec;
+        Vec points[4];
+        for (int i = 0; i < 4; i++)
+        {
+            points[i] = Vec(c.polygon[i]);
+        }
+        return ltcEvaluate(Vec(0, 0, 1), Vec(c.V), Vec(0), Mat3<Real>(MInv), points, 4, true, Vec(1), precision).x;
+    }
+
+    struct IntegralError
+    {
+        double rmse = 0;    // relative to the mean reference
+        double max = 0;     // relative to the mean reference
+        double seconds = 0;
+    };
+
+    template<typename Func>
+    IntegralError compare(const std::vector<double>& reference, Func evaluate)
+    {
+        std::vector<float> values(reference.size());
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            values[i] = evaluate(i);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double mean = 0, sumSq = 0, maxErr = 0;
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            double d = values[i] - reference[i];
+            mean += std::abs(reference[i]);
+            sumSq += d * d;
+            maxErr = std::max(maxErr, std::abs(d));
+        }
+        mean = std::max(mean / reference.size(), 1e-30);
+        IntegralError err;
+        err.rmse = std::sqrt(sumSq / reference.size()) / mean;
+        err.max = maxErr / mean;
+        err.seconds = std::chrono::duration<double>(end - start).count();
+        return err;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string paramDir = argc > 1 ? argv[1] : "Data/Params";
+    size_t count = argc > 2 ? (size_t)std::atoll(argv[2]) : 20000;
+
+    std::printf("kernel max. abs. error (theta/sin(theta): relative)\n");
+    std::printf("%-8s %10s %10s %10s %10s %14s\n", "", "acos", "sin", "cos", "atan2", "theta/sin");
+    for (int p = 0; p < 3; p++)
+    {
+        KernelError err = measureKernels(kPrecisions[p]);
+        std::printf("%-8s %10.2e %10.2e %10.2e %10.2e %14.2e\n", kPrecisionNames[p], err.acos, err.sin, err.cos, err.atan2, err.thetaOverSin);
+    }
+
+    try
+    {
+        LutTables tables;
+        tables.load(paramDir);
+        std::vector<Config> configs = createConfigs(count, tables.getResolution());
+
+        std::vector<float3x3> ltcMInv(count), ltshMInv(count), ltshMInvN2(count);
+        std::vector<float> coeffs(count * kNumCoeffsN4), coeffsN2(count * kNumCoeffsN2);
+        std::vector<double> refLtc(count), refLtsh(count), refLtshN2(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const Config& c = configs[i];
+            ltcMInv[i] = tables.getLtcMatrix(c.uv);
+            ltshMInv[i] = tables.getLtshMatrix(c.cell);
+            ltshMInvN2[i] = tables.getLtshMatrixN2(c.cell);
+            tables.getLtshCoeffs(c.cell, &coeffs[i * kNumCoeffsN4]);
+            tables.getLtshCoeffsN2(c.cell, &coeffsN2[i * kNumCoeffsN2]);
+            refLtc[i] = ltcIntegral<double>(c, ltcMInv[i], TrigPrecision::Exact);
+            refLtsh[i] = ltshIntegral<double, kNumCoeffsN4>(c, ltshMInv[i], &coeffs[i * kNumCoeffsN4], TrigPrecision::Exact);
+            refLtshN2[i] = ltshIntegral<double, kNumCoeffsN2>(c, ltshMInvN2[i], &coeffsN2[i * kNumCoeffsN2], TrigPrecision::Exact);
+        }
+
+        std::printf("\n%zu lights, error of the float integral against exact double, relative to the mean\n", count);
+        std::printf("%-8s %-8s %12s %12s %14s\n", "mode", "trig", "rel rmse", "rel max", "evals/s");
+        for (int mode = 0; mode < 3; mode++)
+        {
+            for (int p = 0; p < 3; p++)
+            {
+                TrigPrecision precision = kPrecisions[p];
+                IntegralError err;
+                const char* name;
+                if (mode == 0)
+                {
+                    name = "ltc";
+                    err = compare(refLtc, [&](size_t i) { return ltcIntegral<float>(configs[i], ltcMInv[i], precision); });
+                }
+                else if (mode == 1)
+                {
+                    name = "ltsh";
+                    err = compare(refLtsh, [&](size_t i) { return ltshIntegral<float, kNumCoeffsN4>(configs[i], ltshMInv[i], &coeffs[i * kNumCoeffsN4], precision); });
+                }
+                else
+                {
+                    name = "ltsh_n2";
+                    err = compare(refLtshN2, [&](size_t i) { return ltshIntegral<float, kNumCoeffsN2>(configs[i], ltshMInvN2[i], &coeffsN2[i * kNumCoeffsN2], precision); });
+                }
+                std::printf("%-8s %-8s %12.2e %12.2e %14.0f\n", name, kPrecisionNames[p], err.rmse, err.max, count / err.seconds);
+            }
+        }
+
+        // throughput of the SH projection alone, the integrals above include clipping and the table product
+        std::vector<float3> polygons(count * kMaxBatchVertices);
+        std::vector<int> numVerts(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            float3 L[kMaxClippedVertices];
+            int n = clipPolygonToHorizon(configs[i].polygon, 4, L);
+            for (int v = 0; v < n; v++)
+            {
+                L[v] = normalize(mul(ltshMInv[i], L[v]));
+            }
+            // invisible lights become tiny triangles around the normal so every polygon is projected
+            if (n == 0)
+            {
+                n = 3;
+                L[0] = normalize(float3(0.01f, 0.f, 1.f));
+                L[1] = normalize(float3(0.f, 0.01f, 1.f));
+                L[2] = normalize(float3(-0.01f, 0.f, 1.f));
+            }
+            n = std::min(n, kMaxBatchVertices);
+            std::copy(L, L + n, &polygons[i * kMaxBatchVertices]);
+            numVerts[i] = n;
+        }
+        std::vector<float> Lcoeff(count * kNumCoeffsN4);
+        std::printf("\n%-8s %16s %16s   (polygonSH, simd backend: %s)\n", "trig", "scalar poly/s", "batched poly/s", simd::backendName());
+        for (int p = 0; p < 3; p++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < count; i++)
+            {
+                polygonSH(&polygons[i * kMaxBatchVertices], numVerts[i], &Lcoeff[i * kNumCoeffsN4], kPrecisions[p]);
+            }
+            auto mid = std::chrono::high_resolution_clock::now();
+            polygonSHArray(polygons.data(), numVerts.data(), count, Lcoeff.data(), kPrecisions[p]);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::printf("%-8s %16.0f %16.0f\n", kPrecisionNames[p], count / std::chrono::duration<double>(mid - start).count(),
+                        count / std::chrono::duration<double>(end - mid).count());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}